@@ -26,7 +26,9 @@ LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/include
 LOCAL_EXPORT_CUSTOM_VARIABLES := LIBVIDEOMETADATA_HEADERS=$\
 	$(LOCAL_PATH)/include/video-metadata/vmeta.h:$\
 	$(LOCAL_PATH)/include/video-metadata/vmeta_frame.h:$\
+	$(LOCAL_PATH)/include/video-metadata/vmeta_frame_archive.h:$\
 	$(LOCAL_PATH)/include/video-metadata/vmeta_frame_proto.h:$\
+	$(LOCAL_PATH)/include/video-metadata/vmeta_frame_table.h:$\
 	$(LOCAL_PATH)/include/video-metadata/vmeta_frame_v1.h:$\
 	$(LOCAL_PATH)/include/video-metadata/vmeta_frame_v2.h:$\
 	$(LOCAL_PATH)/include/video-metadata/vmeta_frame_v3.h:$\
@@ -37,7 +39,14 @@ LOCAL_CFLAGS := -DVMETA_API_EXPORTS -fvisibility=hidden -std=gnu99
 
 LOCAL_SRC_FILES := \
 	src/vmeta_csv.c \
+	src/vmeta_decode.c \
+	src/vmeta_dtoa.c \
+	src/vmeta_frame_archive.c \
+	src/vmeta_frame_pool.c \
 	src/vmeta_frame_proto.c \
+	src/vmeta_frame_proto_delta.c \
+	src/vmeta_frame_proto_scan.c \
+	src/vmeta_frame_table.c \
 	src/vmeta_frame_v1.c \
 	src/vmeta_frame_v2.c \
 	src/vmeta_frame_v3.c \
@@ -45,8 +54,10 @@ LOCAL_SRC_FILES := \
 	src/vmeta_json_proto.c \
 	src/vmeta_json.c \
 	src/vmeta_proto.c \
+	src/vmeta_proto_wire.c \
 	src/vmeta_session_proto.c \
 	src/vmeta_session.c \
+	src/vmeta_session_serialized.c \
 	src/vmeta_utils.c
 
 LOCAL_LIBRARIES := \
@@ -94,6 +105,8 @@ LOCAL_CONDITIONAL_LIBRARIES := \
 	OPTIONAL:libmp4 \
 	OPTIONAL:libpcap
 
+LOCAL_LDLIBS := -lpthread
+
 ifeq ("$(TARGET_OS)","windows")
   LOCAL_LDLIBS += -lws2_32
 endif
@@ -122,7 +135,9 @@ LOCAL_EXPORT_CUSTOM_VARIABLES := LIBVIDEOMETADATAEXTRACT_HEADERS=$\
 	$(LOCAL_PATH)libvideo-metadata-extract/include/video-metadata/vmeta_extract.h:$\
 LOCAL_CFLAGS := -DVMETAEXTRACT_API_EXPORTS -fvisibility=hidden -std=gnu99
 LOCAL_SRC_FILES := \
-	libvideo-metadata-extract/src/vmeta_extract.c
+	libvideo-metadata-extract/src/vmeta_extract.c \
+	libvideo-metadata-extract/src/vmeta_extract_frame_iter.c \
+	libvideo-metadata-extract/src/vmeta_extract_index.c
 LOCAL_LIBRARIES := \
 	libmp4 \
 	libfutils \
@@ -132,6 +147,8 @@ LOCAL_LIBRARIES := \
 	libvideo-metadata \
 	libvideo-streaming
 
+LOCAL_LDLIBS := -lpthread
+
 ifeq ("$(TARGET_OS)","windows")
   LOCAL_LDLIBS += -lws2_32
 endif
@@ -147,6 +164,7 @@ LOCAL_C_INCLUDES := $(LOCAL_PATH)/src
 LOCAL_SRC_FILES := \
 	tests/vmeta_test.c \
 	tests/vmeta_test_compare.c \
+	tests/vmeta_test_extract.c \
 	tests/vmeta_test_proto.c \
 	tests/vmeta_test_session.c \
 	tests/vmeta_test_utils.c \
@@ -156,6 +174,25 @@ LOCAL_LIBRARIES := \
 	libcunit \
 	libfutils \
 	libulog \
+	libvideo-metadata \
+	libvideo-metadata-extract
+
+include $(BUILD_EXECUTABLE)
+
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := bench-vmeta
+LOCAL_DESCRIPTION := Parrot Drones video metadata library benchmarks
+
+LOCAL_SRC_FILES := \
+	tests/vmeta_bench.c \
+	tests/vmeta_bench_frame.c \
+	tests/vmeta_bench_session.c
+
+LOCAL_LIBRARIES := \
+	json \
+	libfutils \
+	libulog \
 	libvideo-metadata
 
 include $(BUILD_EXECUTABLE)
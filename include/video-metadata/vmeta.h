@@ -53,6 +53,17 @@ extern "C" {
 struct json_object;
 
 
+/**
+ * JSON text output callback function, see vmeta_frame_to_json_stream().
+ * @param data: chunk of JSON text (not null-terminated)
+ * @param len: length of the chunk in bytes
+ * @param userdata: user data pointer
+ * @return 0 on success, negative errno value in case of error (the error
+ *         aborts the output and is returned to the caller)
+ */
+typedef int (*vmeta_json_sink_t)(const char *data, size_t len, void *userdata);
+
+
 /* Camera type */
 enum vmeta_camera_type {
 	/* Unknown camera type */
@@ -636,7 +647,9 @@ VMETA_API const char *vmeta_tone_mapping_to_str(enum vmeta_tone_mapping val);
 
 
 #include "video-metadata/vmeta_frame.h"
+#include "video-metadata/vmeta_frame_table.h"
 #include "video-metadata/vmeta_session.h"
+#include "video-metadata/vmeta_frame_archive.h"
 
 
 #ifdef __cplusplus
@@ -416,6 +416,125 @@ const char *vmeta_frame_type_str(enum vmeta_frame_type val);
 #endif
 
 
+/* Frame metadata fields (see vmeta_frame_get_fields()) */
+enum vmeta_frame_field {
+	VMETA_FRAME_FIELD_TIMESTAMP = (1u << 0),
+	VMETA_FRAME_FIELD_UTC_TIMESTAMP = (1u << 1),
+	VMETA_FRAME_FIELD_LOCATION = (1u << 2),
+	VMETA_FRAME_FIELD_SPEED_NED = (1u << 3),
+	VMETA_FRAME_FIELD_GROUND_DISTANCE = (1u << 4),
+	VMETA_FRAME_FIELD_ALTITUDE_ATO = (1u << 5),
+	VMETA_FRAME_FIELD_DRONE_QUAT = (1u << 6),
+	VMETA_FRAME_FIELD_FRAME_QUAT = (1u << 7),
+	VMETA_FRAME_FIELD_FRAME_BASE_QUAT = (1u << 8),
+	VMETA_FRAME_FIELD_EXPOSURE_TIME = (1u << 9),
+	VMETA_FRAME_FIELD_GAIN = (1u << 10),
+	VMETA_FRAME_FIELD_AWB_R_GAIN = (1u << 11),
+	VMETA_FRAME_FIELD_AWB_B_GAIN = (1u << 12),
+	VMETA_FRAME_FIELD_PICTURE_H_FOV = (1u << 13),
+	VMETA_FRAME_FIELD_PICTURE_V_FOV = (1u << 14),
+	VMETA_FRAME_FIELD_ZOOM_LEVEL = (1u << 15),
+	VMETA_FRAME_FIELD_BATTERY_PERCENTAGE = (1u << 16),
+	VMETA_FRAME_FIELD_FLYING_STATE = (1u << 17),
+	VMETA_FRAME_FIELD_PILOTING_MODE = (1u << 18),
+	VMETA_FRAME_FIELD_LINK_GOODPUT = (1u << 19),
+	VMETA_FRAME_FIELD_LINK_QUALITY = (1u << 20),
+	VMETA_FRAME_FIELD_WIFI_RSSI = (1u << 21),
+
+	VMETA_FRAME_FIELD_ALL = (1u << 22) - 1,
+};
+
+
+/* Flat frame metadata telemetry; each field has the same value as
+ * returned by the corresponding vmeta_frame_get_*() function */
+struct vmeta_frame_flat {
+	/* Fields available in the structure (enum vmeta_frame_field bits) */
+	uint32_t present;
+
+	/* Frame timestamp (us, monotonic) */
+	uint64_t timestamp;
+
+	/* Frame UTC timestamp (us since the Epoch) */
+	uint64_t utc_timestamp;
+
+	/* Drone location */
+	struct vmeta_location location;
+
+	/* Drone speed in NED (m/s) */
+	struct vmeta_ned speed;
+
+	/* Ground distance (m) */
+	double ground_distance;
+
+	/* Altitude above take-off (m) */
+	double altitude_ato;
+
+	/* Drone orientation */
+	struct vmeta_quaternion drone_quat;
+
+	/* Frame orientation */
+	struct vmeta_quaternion frame_quat;
+
+	/* Frame base orientation */
+	struct vmeta_quaternion frame_base_quat;
+
+	/* Exposure time (ms) */
+	float exposure_time;
+
+	/* Gain (ISO) */
+	uint16_t gain;
+
+	/* White balance gains */
+	float awb_r_gain;
+	float awb_b_gain;
+
+	/* Picture horizontal and vertical field of view (deg) */
+	float picture_h_fov;
+	float picture_v_fov;
+
+	/* Camera zoom level */
+	float zoom_level;
+
+	/* Battery charge percentage */
+	uint8_t battery_percentage;
+
+	/* Flying state */
+	enum vmeta_flying_state flying_state;
+
+	/* Piloting mode */
+	enum vmeta_piloting_mode piloting_mode;
+
+	/* Link goodput (throughput estimation) */
+	uint32_t link_goodput;
+
+	/* Link quality (0 to 5, 5 is best) */
+	uint8_t link_quality;
+
+	/* Wifi RSSI (dBm) */
+	int8_t wifi_rssi;
+};
+
+
+/* Growable string for CSV output (see vmeta_frame_csv_append()); the
+ * structure must be zero-initialized before its first use, and the str
+ * member must be freed with free() when no longer needed */
+struct vmeta_csv_buf {
+	/* Null-terminated string (can be NULL when empty) */
+	char *str;
+
+	/* String length in bytes, without the null terminator; can be reset
+	 * to 0 to reuse the buffer */
+	size_t len;
+
+	/* Allocated size in bytes */
+	size_t size;
+};
+
+
+/* Frame metadata pool */
+struct vmeta_frame_pool;
+
+
 /* Frame metadata */
 struct vmeta_frame {
 	/* Frame metadata */
@@ -446,6 +565,11 @@ struct vmeta_frame {
 	 * Use vmeta_frame_ref()/vmeta_frame_unref() to modify it, or
 	 * vmeta_frame_get_ref_count() to read it. */
 	unsigned int ref_count;
+
+	/* Pool the frame metadata is returned to when the reference count
+	 * reaches zero (NULL if the structure was not allocated from a pool).
+	 * DO NOT USE THIS FIELD! */
+	struct vmeta_frame_pool *pool;
 };
 
 
@@ -467,6 +591,26 @@ VMETA_API
 int vmeta_frame_write(struct vmeta_buffer *buf, struct vmeta_frame *meta);
 
 
+/**
+ * Write frame metadata, optionally keeping the serialized data in the frame.
+ * This function has the same behavior as vmeta_frame_write(). For
+ * protobuf-based metadata that is not already serialized, the data is by
+ * default serialized straight into the supplied buffer; if cache is set to a
+ * non-zero value, the serialized data is instead kept in the frame and then
+ * copied to the buffer, so that following writes or
+ * vmeta_frame_proto_get_buffer() calls do not serialize it again.
+ * The cache parameter is ignored for other metadata types.
+ * @param buf: pointer to the buffer structure (output)
+ * @param meta: pointer to the frame metadata structure
+ * @param cache: if non-zero, keep the serialized data in the frame
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_write2(struct vmeta_buffer *buf,
+		       struct vmeta_frame *meta,
+		       int cache);
+
+
 /**
  * Read frame metadata.
  * This function allocates a new metadata structure, deserializing data from
@@ -524,6 +668,49 @@ int vmeta_frame_read2(struct vmeta_buffer *buf,
 		      struct vmeta_frame **ret_obj);
 
 
+/**
+ * Borrowed buffer release callback function.
+ * See the vmeta_frame_read_borrowed() function.
+ * @param data: pointer to the borrowed data (as given in the buf structure)
+ * @param userdata: user data pointer
+ */
+typedef void (*vmeta_frame_buffer_release_cb_t)(const uint8_t *data,
+						void *userdata);
+
+
+/**
+ * Read frame metadata without copying the input data.
+ * This function behaves like vmeta_frame_read2(), except that protobuf-based
+ * metadata directly references the data in the provided buffer instead of
+ * keeping a private copy. The data must therefore remain valid and unmodified
+ * until the release callback function is called.
+ * On success, the release callback function is called exactly once, when the
+ * data is no longer needed by the library: before this function returns if
+ * the metadata does not keep a reference to the data (e.g. non-protobuf-based
+ * or converted metadata), or when the returned metadata is destroyed or
+ * re-packed otherwise. On error, the release callback function is not called
+ * and the ownership of the data stays with the caller.
+ * @param buf: pointer to the buffer structure
+ * @param mime_type: pointer to the metadata MIME type, if known;
+ *                   if NULL, the type will be automatically detected when
+ *                   possible.
+ * @param convert: if non-zero, ret_obj will be converted to protobuf-based
+ *                 metadata, when possible.
+ * @param release: borrowed data release callback function (optional, can be
+ *                 NULL if the data is guaranteed to outlive the metadata)
+ * @param userdata: release callback function user data pointer
+ * @param ret_obj: pointer filled with the new vmeta_frame structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_read_borrowed(struct vmeta_buffer *buf,
+			      const char *mime_type,
+			      int convert,
+			      vmeta_frame_buffer_release_cb_t release,
+			      void *userdata,
+			      struct vmeta_frame **ret_obj);
+
+
 /**
  * Create a vmeta_frame structure for writing.
  * The returned structure has a reference count of 1.
@@ -535,6 +722,179 @@ VMETA_API int vmeta_frame_new(enum vmeta_frame_type type,
 			      struct vmeta_frame **ret_obj);
 
 
+/**
+ * Create a frame metadata pool.
+ * Frame metadata structures allocated from a pool (see the
+ * vmeta_frame_pool_frame_new(), vmeta_frame_pool_frame_read() and
+ * vmeta_frame_pool_frame_read_borrowed() functions) are returned to the pool
+ * when their reference count reaches zero instead of being freed; the
+ * protobuf-based metadata internal objects (lock, encoded buffer and unpacking
+ * memory) are also kept for reuse. Up to capacity idle structures of each
+ * kind are kept in the pool, the others are freed.
+ * The pool is thread-safe.
+ * @param capacity: maximum number of idle structures kept in the pool
+ * @param ret_obj: pointer filled with the new pool
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_pool_new(unsigned int capacity,
+			 struct vmeta_frame_pool **ret_obj);
+
+
+/**
+ * Destroy a frame metadata pool.
+ * The idle structures are freed. Frame metadata structures allocated from the
+ * pool that are still referenced remain valid: they are freed when their
+ * reference count reaches zero, and the pool memory is released once the last
+ * one is freed.
+ * @param pool: pointer to the pool
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_pool_destroy(struct vmeta_frame_pool *pool);
+
+
+/**
+ * Create a vmeta_frame structure for writing from a pool.
+ * This function behaves like vmeta_frame_new(), except that the structure is
+ * taken from the pool when possible.
+ * @param pool: pointer to the pool
+ * @param type: vmeta_frame type to create.
+ * @param ret_obj: pointer filled with the new vmeta_frame structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_pool_frame_new(struct vmeta_frame_pool *pool,
+			       enum vmeta_frame_type type,
+			       struct vmeta_frame **ret_obj);
+
+
+/**
+ * Read frame metadata into a structure from a pool.
+ * This function behaves like vmeta_frame_read2(), except that the structure is
+ * taken from the pool when possible. When converting to protobuf-based
+ * metadata, the converted structure is also taken from the pool.
+ * @param pool: pointer to the pool
+ * @param buf: pointer to the buffer structure
+ * @param mime_type: pointer to the metadata MIME type, if known;
+ *                   if NULL, the type will be automatically detected when
+ *                   possible.
+ * @param convert: if non-zero, ret_obj will be converted to protobuf-based
+ *                 metadata, when possible.
+ * @param ret_obj: pointer filled with the new vmeta_frame structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_pool_frame_read(struct vmeta_frame_pool *pool,
+				struct vmeta_buffer *buf,
+				const char *mime_type,
+				int convert,
+				struct vmeta_frame **ret_obj);
+
+
+/**
+ * Read frame metadata without copying the input data into a structure from a
+ * pool.
+ * This function behaves like vmeta_frame_read_borrowed(), except that the
+ * structure is taken from the pool when possible.
+ * @param pool: pointer to the pool
+ * @param buf: pointer to the buffer structure
+ * @param mime_type: pointer to the metadata MIME type, if known;
+ *                   if NULL, the type will be automatically detected when
+ *                   possible.
+ * @param convert: if non-zero, ret_obj will be converted to protobuf-based
+ *                 metadata, when possible.
+ * @param release: borrowed data release callback function (optional, can be
+ *                 NULL if the data is guaranteed to outlive the metadata)
+ * @param userdata: release callback function user data pointer
+ * @param ret_obj: pointer filled with the new vmeta_frame structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_pool_frame_read_borrowed(
+	struct vmeta_frame_pool *pool,
+	struct vmeta_buffer *buf,
+	const char *mime_type,
+	int convert,
+	vmeta_frame_buffer_release_cb_t release,
+	void *userdata,
+	struct vmeta_frame **ret_obj);
+
+
+/* Frame metadata reader */
+struct vmeta_frame_reader;
+
+
+/**
+ * Create a frame metadata reader.
+ * A reader resolves the metadata MIME type once, and then reads all the
+ * samples of a track or stream with that type, without looking up the MIME
+ * type again for each sample. If the MIME type is NULL, the metadata type is
+ * guessed from each buffer, as in vmeta_frame_read2().
+ * The MIME type string does not need to outlive the reader.
+ * @param mime_type: pointer to the metadata MIME type, if known
+ * @param convert: if non-zero, the frames read will be converted to
+ *                 protobuf-based metadata, when possible
+ *                 (see vmeta_frame_read2())
+ * @param pool: optional frame metadata pool to take the frames from (can be
+ *              NULL); the pool must outlive the reader
+ * @param ret_obj: pointer filled with the new reader
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_reader_new(const char *mime_type,
+			   int convert,
+			   struct vmeta_frame_pool *pool,
+			   struct vmeta_frame_reader **ret_obj);
+
+
+/**
+ * Destroy a frame metadata reader.
+ * The frames already read are not affected.
+ * @param reader: pointer to the reader
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_reader_destroy(struct vmeta_frame_reader *reader);
+
+
+/**
+ * Read frame metadata using a reader.
+ * This function behaves like vmeta_frame_read2() with the MIME type, convert
+ * flag and pool of the reader.
+ * @param reader: pointer to the reader
+ * @param buf: pointer to the buffer structure
+ * @param ret_obj: pointer filled with the new vmeta_frame structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_reader_read(struct vmeta_frame_reader *reader,
+			    struct vmeta_buffer *buf,
+			    struct vmeta_frame **ret_obj);
+
+
+/**
+ * Read a batch of frame metadata using a reader.
+ * Each buffer of the bufs array is read as with vmeta_frame_reader_read(),
+ * and the resulting frame is stored at the same index in the frames array;
+ * if a buffer cannot be read (or is an empty sample), NULL is stored instead.
+ * Read errors are logged once for the whole batch.
+ * The caller must unref each non-NULL frame.
+ * @param reader: pointer to the reader
+ * @param bufs: array of buffer structures
+ * @param count: number of buffers in the bufs array
+ * @param frames: array of at least count frame pointers, filled with the
+ *                new vmeta_frame structures
+ * @return the number of frames successfully read on success,
+ *         negative errno value in case of error
+ */
+VMETA_API
+ssize_t vmeta_frame_read_batch(struct vmeta_frame_reader *reader,
+			       struct vmeta_buffer *bufs,
+			       size_t count,
+			       struct vmeta_frame **frames);
+
+
 /**
  * Increment the reference counter of a vmeta_frame structure.
  * @param meta: pointer to the frame metadata structure
@@ -578,7 +938,8 @@ int vmeta_frame_to_json(struct vmeta_frame *meta, struct json_object *jobj);
 
 /**
  * Write frame metadata to a JSON string.
- * This function fills the str array with the null-terminated JSON string.
+ * This function fills the str array with the null-terminated JSON string
+ * (see vmeta_frame_to_json_buf()).
  * The string must have been previously allocated. The function writes
  * up to len characters.
  * @param meta: pointer to a frame metadata structure
@@ -592,10 +953,51 @@ int vmeta_frame_to_json_str(struct vmeta_frame *meta,
 			    unsigned int len);
 
 
+/**
+ * Write frame metadata as JSON text to a buffer.
+ * The JSON text is written directly, without building a JSON object tree;
+ * the keys and layout are the same as the json_object_to_json_string()
+ * output of the vmeta_frame_to_json() object. Floating-point values are
+ * written with the shortest representation that reads back as the same
+ * double value (e.g. "0.1" instead of "0.10000000000000001").
+ * The str string must have been previously allocated. The function writes
+ * up to maxlen characters, including the null terminator.
+ * @param meta: pointer to a frame metadata structure
+ * @param str: pointer to the string to write to (output)
+ * @param maxlen: maximum length of the string
+ * @return the length of the JSON string (without the null terminator) on
+ *         success, negative errno value in case of error (-ENOBUFS if the
+ *         string does not fit in maxlen characters)
+ */
+VMETA_API
+ssize_t vmeta_frame_to_json_buf(struct vmeta_frame *meta,
+				char *str,
+				size_t maxlen);
+
+
+/**
+ * Write frame metadata as JSON text to a callback function.
+ * The JSON text is the same as the vmeta_frame_to_json_buf() output; it is
+ * given to the sink function in chunks of up to a few hundred bytes (not
+ * null-terminated), without any memory allocation.
+ * @param meta: pointer to a frame metadata structure
+ * @param sink: JSON text output function
+ * @param userdata: user data pointer passed to the sink function
+ * @return the total length of the JSON text on success, negative errno value
+ *         in case of error (including errors returned by the sink function)
+ */
+VMETA_API
+ssize_t vmeta_frame_to_json_stream(struct vmeta_frame *meta,
+				   vmeta_json_sink_t sink,
+				   void *userdata);
+
+
 /**
  * Write frame metadata as a CSV string.
  * The str string must have been previously allocated. The function writes
  * up to maxlen characters. The CSV separator is a space character.
+ * For protobuf-based metadata, the values are the vmeta_frame_get_fields()
+ * fields, zero when not available.
  * @param meta: pointer to a frame metadata structure
  * @param str: pointer to the string to write to (output)
  * @param maxlen: maximum length of the string
@@ -611,6 +1013,11 @@ vmeta_frame_to_csv(const struct vmeta_frame *meta, char *str, size_t maxlen);
  * Write a frame metadata CSV file header string for the given type.
  * The str string must have been previously allocated. The function writes
  * up to maxlen characters. The CSV separator is a space character.
+ * The columns match the values written by vmeta_frame_to_csv(): every
+ * location has 8 columns (valid flag, latitude, longitude, both altitudes,
+ * horizontal and vertical accuracy, satellite count) and every thermal spot
+ * 5 columns (valid flag, x, y, temperature, value), whether they are valid
+ * or not.
  * @param type: frame metadata type
  * @param str: pointer to the string to write to (output)
  * @param maxlen: maximum length of the string
@@ -622,6 +1029,38 @@ ssize_t
 vmeta_frame_csv_header(enum vmeta_frame_type type, char *str, size_t maxlen);
 
 
+/**
+ * Append the CSV line of frame metadata to a growable buffer.
+ * The values follow the vmeta_frame_csv_header_append() layout for the
+ * metadata type and are separated by a space character; the line ends with
+ * a line feed. Unlike vmeta_frame_to_csv(), floating-point values are
+ * written with the shortest representation that reads back to the same
+ * value, without using printf. Protobuf-based metadata is supported: the
+ * values are then the vmeta_frame_get_fields() fields, zero when not
+ * available.
+ * @param meta: pointer to a frame metadata structure
+ * @param buf: pointer to the buffer to append to
+ * @return the number of characters appended on success, negative errno value
+ *         in case of error (the buffer is then left unchanged)
+ */
+VMETA_API
+ssize_t vmeta_frame_csv_append(struct vmeta_frame *meta,
+			       struct vmeta_csv_buf *buf);
+
+
+/**
+ * Append a frame metadata CSV file header line for the given type to a
+ * growable buffer (see vmeta_frame_csv_append()).
+ * @param type: frame metadata type
+ * @param buf: pointer to the buffer to append to
+ * @return the number of characters appended on success, negative errno value
+ *         in case of error
+ */
+VMETA_API
+ssize_t vmeta_frame_csv_header_append(enum vmeta_frame_type type,
+				      struct vmeta_csv_buf *buf);
+
+
 /**
  * Get the recording metadata MIME type.
  * The function returns the MIME type string for a given recording frame
@@ -1061,6 +1500,26 @@ int vmeta_frame_get_piloting_mode(struct vmeta_frame *meta,
 				  enum vmeta_piloting_mode *mode);
 
 
+/**
+ * Get several fields from a frame metadata structure at once.
+ * The function fills the out structure with the fields requested in the
+ * mask that are available according to the metadata type, and sets the
+ * corresponding bits in its present field. The metadata is only accessed
+ * once, which is much cheaper than calling the individual getters for
+ * protobuf-based metadata. Each field has the same value as returned by
+ * the corresponding vmeta_frame_get_*() function.
+ * @param meta: pointer to a frame metadata structure
+ * @param mask: requested fields (enum vmeta_frame_field bits)
+ * @param out: pointer to a flat metadata structure (output)
+ * @return 0 on success (even if some requested fields are not available),
+ *         negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_get_fields(struct vmeta_frame *meta,
+			   uint32_t mask,
+			   struct vmeta_frame_flat *out);
+
+
 /**
  * Get the first location from image coordinates data of CoT type from a frame
  * metadata structure. The function fills the loc structure and other parameters
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VMETA_FRAME_ARCHIVE_H_
+#define _VMETA_FRAME_ARCHIVE_H_
+
+
+/* Frame metadata archive: a file holding session metadata and the frame
+ * metadata table columns (see vmeta_frame_table.h) of a recording.
+ * The rows are stored in fixed-size blocks; in each block, every column is
+ * a contiguous array of values, followed by a presence bitmap. The values
+ * are stored in the host byte order, so that a reader can map the file in
+ * memory and use the columns without any parsing; the archive can be
+ * appended to while being read. */
+
+
+/* Frame metadata archive writer */
+struct vmeta_frame_archive_writer;
+
+
+/* Frame metadata archive reader */
+struct vmeta_frame_archive;
+
+
+/**
+ * Create a frame metadata archive file.
+ * An existing file is truncated. The writer must be destroyed using
+ * vmeta_frame_archive_writer_destroy().
+ * @param path: path to the archive file
+ * @param session: session metadata to store in the archive (optional, can
+ *                 be NULL)
+ * @param block_rows: number of rows per block (0 for a default value)
+ * @param ret_obj: pointer to the writer (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_archive_writer_new(const char *path,
+				   const struct vmeta_session *session,
+				   size_t block_rows,
+				   struct vmeta_frame_archive_writer **ret_obj);
+
+
+/**
+ * Open an existing frame metadata archive file for appending.
+ * The rows are appended after the last flushed row.
+ * The writer must be destroyed using vmeta_frame_archive_writer_destroy().
+ * @param path: path to the archive file
+ * @param ret_obj: pointer to the writer (output)
+ * @return 0 on success, -EPROTO if the file is not a valid archive for the
+ *         host, negative errno value in case of other errors
+ */
+VMETA_API
+int vmeta_frame_archive_writer_open(
+	const char *path,
+	struct vmeta_frame_archive_writer **ret_obj);
+
+
+/**
+ * Flush and destroy a frame metadata archive writer.
+ * @param writer: pointer to the writer
+ * @return 0 on success, negative errno value in case of error (the writer
+ *         is destroyed anyway)
+ */
+VMETA_API
+int vmeta_frame_archive_writer_destroy(
+	struct vmeta_frame_archive_writer *writer);
+
+
+/**
+ * Append a row to a frame metadata archive.
+ * The fields of the frame metadata are copied as for
+ * vmeta_frame_table_append(). The row is written to the file when its block
+ * is full or on the next call to vmeta_frame_archive_writer_flush().
+ * @param writer: pointer to the writer
+ * @param meta: pointer to a frame metadata structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_archive_writer_append(struct vmeta_frame_archive_writer *writer,
+				      struct vmeta_frame *meta);
+
+
+/**
+ * Flush a frame metadata archive writer.
+ * The pending rows are written to the file, then the row count of the file
+ * header is updated, so that readers never see partially written rows.
+ * @param writer: pointer to the writer
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_archive_writer_flush(struct vmeta_frame_archive_writer *writer);
+
+
+/**
+ * Open a frame metadata archive file for reading.
+ * The file is mapped in memory when possible (read into memory otherwise).
+ * The archive must be closed using vmeta_frame_archive_close().
+ * @param path: path to the archive file
+ * @param ret_obj: pointer to the archive (output)
+ * @return 0 on success, -EPROTO if the file is not a valid archive for the
+ *         host, negative errno value in case of other errors
+ */
+VMETA_API
+int vmeta_frame_archive_open(const char *path,
+			     struct vmeta_frame_archive **ret_obj);
+
+
+/**
+ * Close a frame metadata archive.
+ * The column pointers are invalidated.
+ * @param archive: pointer to the archive
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_archive_close(struct vmeta_frame_archive *archive);
+
+
+/**
+ * Update a frame metadata archive with the rows appended by a writer since
+ * the archive was opened or last refreshed.
+ * The column pointers are invalidated.
+ * @param archive: pointer to the archive
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_archive_refresh(struct vmeta_frame_archive *archive);
+
+
+/**
+ * Get the session metadata of a frame metadata archive.
+ * @param archive: pointer to the archive
+ * @param session: pointer to the session metadata structure to fill (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_archive_get_session(struct vmeta_frame_archive *archive,
+				    struct vmeta_session *session);
+
+
+/**
+ * Get the number of rows of a frame metadata archive.
+ * @param archive: pointer to the archive
+ * @param count: pointer to the row count (output)
+ * @param block_rows: pointer to the number of rows per block (output,
+ *                    optional); row n is at index n % block_rows of the
+ *                    block n / block_rows
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_archive_get_count(struct vmeta_frame_archive *archive,
+				  size_t *count,
+				  size_t *block_rows);
+
+
+/**
+ * Get a column of a block of a frame metadata archive.
+ * The data pointer is filled with the column values of the block, of the
+ * type given in the enum vmeta_frame_table_column definition; the presence
+ * pointer is filled with the column presence bitmap of the block (see
+ * VMETA_FRAME_TABLE_IS_PRESENT()). The pointers remain valid until the
+ * archive is refreshed or closed.
+ * @param archive: pointer to the archive
+ * @param block: block index
+ * @param column: column to get
+ * @param data: pointer to the column values (output, optional)
+ * @param presence: pointer to the column presence bitmap (output, optional)
+ * @param count: pointer to the number of rows in the block (output,
+ *               optional)
+ * @return 0 on success, -ENOENT if the block or the column is not in the
+ *         archive, negative errno value in case of other errors
+ */
+VMETA_API
+int vmeta_frame_archive_get_column(struct vmeta_frame_archive *archive,
+				   size_t block,
+				   enum vmeta_frame_table_column column,
+				   const void **data,
+				   const uint8_t **presence,
+				   size_t *count);
+
+
+#endif /* !_VMETA_FRAME_ARCHIVE_H_ */
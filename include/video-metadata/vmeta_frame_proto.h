@@ -50,6 +50,42 @@ struct vmeta_frame_proto;
 struct vmeta_frame;
 
 
+/* Top-level parts of the protobuf-based metadata (Vmeta__TimedMetadata
+ * fields), used as a bitfield to report the modified parts, see
+ * vmeta_frame_proto_release_unpacked_rw2() */
+enum vmeta_frame_proto_part {
+	/* Drone metadata */
+	VMETA_FRAME_PROTO_PART_DRONE = (1 << 0),
+
+	/* Camera metadata */
+	VMETA_FRAME_PROTO_PART_CAMERA = (1 << 1),
+
+	/* Links metadata */
+	VMETA_FRAME_PROTO_PART_LINKS = (1 << 2),
+
+	/* Tracking metadata */
+	VMETA_FRAME_PROTO_PART_TRACKING = (1 << 3),
+
+	/* Tracking proposal metadata */
+	VMETA_FRAME_PROTO_PART_PROPOSAL = (1 << 4),
+
+	/* Automation metadata */
+	VMETA_FRAME_PROTO_PART_AUTOMATION = (1 << 5),
+
+	/* Thermal metadata */
+	VMETA_FRAME_PROTO_PART_THERMAL = (1 << 6),
+
+	/* LFIC metadata */
+	VMETA_FRAME_PROTO_PART_LFIC = (1 << 7),
+
+	/* User metadata */
+	VMETA_FRAME_PROTO_PART_USER = (1 << 8),
+
+	/* All parts */
+	VMETA_FRAME_PROTO_PART_ALL = (1 << 9) - 1,
+};
+
+
 /**
  * Field getters
  */
@@ -123,6 +159,27 @@ VMETA_API int
 vmeta_frame_proto_release_unpacked_rw(struct vmeta_frame *meta,
 				      Vmeta__TimedMetadata *proto_meta);
 
+/**
+ * Release the read-write protobuf structure to the metadata, reporting the
+ * modified parts.
+ * This function has the same behavior as
+ * vmeta_frame_proto_release_unpacked_rw(), but only the parts set in the
+ * dirty bitfield (see enum vmeta_frame_proto_part) are considered modified:
+ * the serialized data of the other parts is kept and reused for the next
+ * packing and packed size computation. If dirty is 0, the packed view of the
+ * metadata, if any, is kept.
+ * The caller must report all the parts that have been modified, including
+ * added or removed parts.
+ * @param meta: the frame metadata
+ * @param proto_meta: pointer to the protobuf structure
+ * @param dirty: bitfield of the modified parts
+ * @return 0 on success, negative errno on error.
+ */
+VMETA_API int
+vmeta_frame_proto_release_unpacked_rw2(struct vmeta_frame *meta,
+				       Vmeta__TimedMetadata *proto_meta,
+				       uint32_t dirty);
+
 /**
  * Get the packed protobuf data representing this metadata.
  * This function only works with packed buffers (either created from
@@ -157,7 +214,9 @@ VMETA_API int vmeta_frame_proto_release_buffer(struct vmeta_frame *meta,
 
 /**
  * Get the packed size of the metadata.
- * On an unpacked metadata, the result is computed at each call.
+ * On an unpacked metadata, the result is computed from the serialized data
+ * of each part, which is only computed again for the parts that have been
+ * modified (see vmeta_frame_proto_release_unpacked_rw2()).
  * On a previously packed metadata, this function returns the size of the
  * current packed buffer.
  * @param meta: the metadata
@@ -166,6 +225,121 @@ VMETA_API int vmeta_frame_proto_release_buffer(struct vmeta_frame *meta,
 VMETA_API ssize_t vmeta_frame_proto_get_packed_size(struct vmeta_frame *meta);
 
 
+/**
+ * Delta encoding
+ * In delta mode, periodic keyframes carry the full metadata, and the other
+ * frames only carry the top-level parts (see enum vmeta_frame_proto_part)
+ * that differ from the last keyframe; losing a delta frame therefore does not
+ * affect the following frames. Both keyframes and delta frames start with a
+ * VMETA_FRAME_PROTO_DELTA_HEADER_SIZE bytes header (big-endian magic number,
+ * flags, keyframe identifier and bitfield of the parts kept from the
+ * keyframe), followed by a packed Vmeta__TimedMetadata message.
+ * Delta-encoded metadata cannot be read with vmeta_frame_read(), so this
+ * mode must only be used when the receiver supports it; this is advertised
+ * in the session metadata (see the proto_delta field of struct vmeta_session
+ * and VMETA_STRM_SDP_KEY_PROTO_DELTA).
+ */
+
+/* Delta-encoded frame metadata magic number ("PbDf" in ASCII) */
+#define VMETA_FRAME_PROTO_DELTA_MAGIC (UINT32_C(0x50624466))
+
+/* Delta-encoded frame metadata header size in bytes */
+#define VMETA_FRAME_PROTO_DELTA_HEADER_SIZE 10
+
+/* Delta-encoded frame metadata header flags: keyframe */
+#define VMETA_FRAME_PROTO_DELTA_FLAG_KEYFRAME (1 << 0)
+
+struct vmeta_frame_proto_delta_enc;
+struct vmeta_frame_proto_delta_dec;
+
+
+/**
+ * Create a delta encoder.
+ * A keyframe is written every keyframe_interval frames (including the
+ * keyframe), or only for the first frame and on request if keyframe_interval
+ * is 0 (see vmeta_frame_proto_delta_enc_request_keyframe()).
+ * The encoder must be destroyed using vmeta_frame_proto_delta_enc_destroy().
+ * @param keyframe_interval: keyframe interval in frames
+ * @param ret_obj: pointer to the new encoder (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API int vmeta_frame_proto_delta_enc_new(
+	unsigned int keyframe_interval,
+	struct vmeta_frame_proto_delta_enc **ret_obj);
+
+
+/**
+ * Destroy a delta encoder.
+ * @param enc: encoder
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API int
+vmeta_frame_proto_delta_enc_destroy(struct vmeta_frame_proto_delta_enc *enc);
+
+
+/**
+ * Request a keyframe for the next frame written by a delta encoder (for
+ * example when a new receiver joins the stream).
+ * @param enc: encoder
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API int vmeta_frame_proto_delta_enc_request_keyframe(
+	struct vmeta_frame_proto_delta_enc *enc);
+
+
+/**
+ * Write protobuf-based frame metadata with a delta encoder.
+ * This function has the same behavior as vmeta_frame_write(), but writes
+ * a keyframe or a delta frame (see above). If the buffer is too small,
+ * -ENOBUFS is returned and the encoder state is left unchanged.
+ * @param enc: encoder
+ * @param buf: pointer to the buffer structure (output)
+ * @param meta: pointer to the frame metadata structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API int
+vmeta_frame_proto_delta_enc_write(struct vmeta_frame_proto_delta_enc *enc,
+				  struct vmeta_buffer *buf,
+				  struct vmeta_frame *meta);
+
+
+/**
+ * Create a delta decoder.
+ * The decoder must be destroyed using vmeta_frame_proto_delta_dec_destroy().
+ * @param ret_obj: pointer to the new decoder (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API int
+vmeta_frame_proto_delta_dec_new(struct vmeta_frame_proto_delta_dec **ret_obj);
+
+
+/**
+ * Destroy a delta decoder.
+ * @param dec: decoder
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API int
+vmeta_frame_proto_delta_dec_destroy(struct vmeta_frame_proto_delta_dec *dec);
+
+
+/**
+ * Read protobuf-based frame metadata with a delta decoder.
+ * This function has the same behavior as vmeta_frame_read() with the
+ * protobuf-based MIME type, and returns the full frame metadata for both
+ * keyframes and delta frames. Metadata without the delta header is read as
+ * is. For a delta frame whose keyframe has not been received, -EAGAIN is
+ * returned and the next keyframe must be waited for.
+ * @param dec: decoder
+ * @param buf: pointer to the buffer structure
+ * @param ret_obj: pointer filled with the new vmeta_frame structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API int
+vmeta_frame_proto_delta_dec_read(struct vmeta_frame_proto_delta_dec *dec,
+				 struct vmeta_buffer *buf,
+				 struct vmeta_frame **ret_obj);
+
+
 /**
  * Writer API (to initialize subfields)
  * Those functions must operate on pointers from a previous
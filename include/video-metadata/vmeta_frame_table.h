@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VMETA_FRAME_TABLE_H_
+#define _VMETA_FRAME_TABLE_H_
+
+
+/* Frame metadata table: accumulates fields of many frames into per-field
+ * contiguous columns (structure of arrays) */
+struct vmeta_frame_table;
+
+
+/* Frame metadata table column */
+enum vmeta_frame_table_column {
+	/* Frame timestamp (us, monotonic), uint64_t */
+	VMETA_FRAME_TABLE_COLUMN_TIMESTAMP = 0,
+
+	/* Drone latitude (deg), double */
+	VMETA_FRAME_TABLE_COLUMN_LATITUDE,
+
+	/* Drone longitude (deg), double */
+	VMETA_FRAME_TABLE_COLUMN_LONGITUDE,
+
+	/* Drone altitude above the WGS84 ellipsoid (m), double */
+	VMETA_FRAME_TABLE_COLUMN_ALTITUDE_WGS84ELLIPSOID,
+
+	/* Drone altitude above the EGM96 geoid (AMSL) (m), double */
+	VMETA_FRAME_TABLE_COLUMN_ALTITUDE_EGM96AMSL,
+
+	/* Drone speed in NED (m/s), float */
+	VMETA_FRAME_TABLE_COLUMN_SPEED_NORTH,
+	VMETA_FRAME_TABLE_COLUMN_SPEED_EAST,
+	VMETA_FRAME_TABLE_COLUMN_SPEED_DOWN,
+
+	/* Drone orientation quaternion, float */
+	VMETA_FRAME_TABLE_COLUMN_DRONE_QUAT_W,
+	VMETA_FRAME_TABLE_COLUMN_DRONE_QUAT_X,
+	VMETA_FRAME_TABLE_COLUMN_DRONE_QUAT_Y,
+	VMETA_FRAME_TABLE_COLUMN_DRONE_QUAT_Z,
+
+	/* Frame orientation quaternion, float */
+	VMETA_FRAME_TABLE_COLUMN_FRAME_QUAT_W,
+	VMETA_FRAME_TABLE_COLUMN_FRAME_QUAT_X,
+	VMETA_FRAME_TABLE_COLUMN_FRAME_QUAT_Y,
+	VMETA_FRAME_TABLE_COLUMN_FRAME_QUAT_Z,
+
+	/* Exposure time (ms), float */
+	VMETA_FRAME_TABLE_COLUMN_EXPOSURE_TIME,
+
+	/* Gain (ISO), uint16_t */
+	VMETA_FRAME_TABLE_COLUMN_GAIN,
+
+	/* Link quality (0 to 5, 5 is best), uint8_t */
+	VMETA_FRAME_TABLE_COLUMN_LINK_QUALITY,
+
+	/* Enum values count (invalid value) */
+	VMETA_FRAME_TABLE_COLUMN_COUNT,
+};
+
+
+/* Check whether a row is present in a column presence bitmap */
+#define VMETA_FRAME_TABLE_IS_PRESENT(_presence, _row)                          \
+	(((_presence)[(_row) / 8] >> ((_row) % 8)) & 1)
+
+
+/**
+ * Create a frame metadata table.
+ * The table must be destroyed using vmeta_frame_table_destroy().
+ * @param capacity: initial number of rows to allocate (the table grows as
+ *                  needed; 0 for a default value)
+ * @param ret: pointer to the table (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_table_new(size_t capacity, struct vmeta_frame_table **ret);
+
+
+/**
+ * Destroy a frame metadata table.
+ * @param table: pointer to the table
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_table_destroy(struct vmeta_frame_table *table);
+
+
+/**
+ * Append a row to a frame metadata table.
+ * The fields of the frame metadata are copied into the table columns (see
+ * vmeta_frame_get_fields()); the frame is not referenced by the table and
+ * can be released right away. Fields that are not available for the frame
+ * are marked as absent in the column presence bitmaps, and their value is
+ * NaN for floating-point columns and 0 otherwise.
+ * Appending a row can reallocate the columns: pointers previously returned
+ * by vmeta_frame_table_get_column() are invalidated.
+ * @param table: pointer to the table
+ * @param meta: pointer to a frame metadata structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_table_append(struct vmeta_frame_table *table,
+			     struct vmeta_frame *meta);
+
+
+/**
+ * Remove all rows from a frame metadata table.
+ * The memory of the columns is kept for reuse.
+ * @param table: pointer to the table
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_table_clear(struct vmeta_frame_table *table);
+
+
+/**
+ * Get the number of rows of a frame metadata table.
+ * @param table: pointer to the table
+ * @param count: pointer to the row count (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_table_get_count(struct vmeta_frame_table *table,
+				size_t *count);
+
+
+/**
+ * Get a column of a frame metadata table.
+ * The data pointer is filled with the column values, one per row, of the
+ * type given in the enum vmeta_frame_table_column definition. The presence
+ * pointer is filled with the column presence bitmap (one bit per row, see
+ * VMETA_FRAME_TABLE_IS_PRESENT()). The pointers remain valid until the next
+ * call to vmeta_frame_table_append() or vmeta_frame_table_destroy().
+ * @param table: pointer to the table
+ * @param column: column to get
+ * @param data: pointer to the column values (output, optional)
+ * @param presence: pointer to the column presence bitmap (output, optional)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_table_get_column(struct vmeta_frame_table *table,
+				 enum vmeta_frame_table_column column,
+				 const void **data,
+				 const uint8_t **presence);
+
+
+#endif /* !_VMETA_FRAME_TABLE_H_ */
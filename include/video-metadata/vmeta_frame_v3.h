@@ -164,6 +164,26 @@ int vmeta_frame_v3_write(struct vmeta_buffer *buf,
 			 const struct vmeta_frame_v3 *meta);
 
 
+/**
+ * Write "Parrot Video Metadata" v3 frame metadata as protobuf frame metadata.
+ * This function directly writes the serialized vmeta.TimedMetadata protobuf
+ * message that a conversion to a proto frame (see vmeta_frame_read())
+ * followed by vmeta_frame_write() would produce, without creating an
+ * intermediate proto frame and without any memory allocation.
+ * As for vmeta_frame_v3_write(), the data is written at the current position
+ * in the buffer and the pos field in the buf structure is updated with the
+ * size of the data written. If the buffer is too small, -ENOBUFS is returned
+ * and the pos field is left unchanged. The ownership of the buffer stays
+ * with the caller.
+ * @param buf: pointer to the buffer structure (output)
+ * @param meta: pointer to the frame metadata structure
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_frame_v3_write_proto(struct vmeta_buffer *buf,
+			       const struct vmeta_frame_v3 *meta);
+
+
 /**
  * Read "Parrot Video Metadata" v3 frame metadata.
  * This function fills the supplied structure with the deserialized metadata.
@@ -466,6 +466,9 @@ enum vmeta_stream_sdp_type {
 /* Default media */
 #define VMETA_STRM_SDP_KEY_DEFAULT_MEDIA "X-com-parrot-default-media"
 
+/* Delta-encoded protobuf-based frame metadata */
+#define VMETA_STRM_SDP_KEY_PROTO_DELTA "X-com-parrot-proto-delta"
+
 /* Camera type */
 #define VMETA_STRM_SDP_KEY_CAMERA_TYPE "X-com-parrot-camera-type"
 
@@ -996,6 +999,11 @@ struct vmeta_session {
 	/* Default media flag (only used in SDP) */
 	uint32_t default_media:1;
 
+	/* Delta-encoded protobuf-based frame metadata flag (1 if the frame
+	 * metadata of the media can be delta-encoded, see
+	 * vmeta_frame_proto_delta_enc_new(); only used in SDP) */
+	uint32_t proto_delta:1;
+
 	/* Camera type */
 	enum vmeta_camera_type camera_type;
 
@@ -1051,6 +1059,57 @@ struct vmeta_session {
 /* clang-format on */
 
 
+/* Session metadata field groups (see vmeta_session_fingerprint()) */
+enum vmeta_session_group {
+	/* Names, product, software and IDs (friendly_name, maker, model,
+	 * model_id, serial_number, software_version, build_id, title,
+	 * comment, copyright, run_id, boot_id, flight_id, custom_id) */
+	VMETA_SESSION_GROUP_IDENTITY = 0,
+
+	/* Dates (media_date, run_date, boot_date, flight_date and their
+	 * GMT offsets) */
+	VMETA_SESSION_GROUP_DATES,
+
+	/* Locations (takeoff_loc, location) */
+	VMETA_SESSION_GROUP_LOCATION,
+
+	/* Camera (picture_fov, camera_type, camera_subtype, camera_spectrum,
+	 * camera_serial_number, camera_model, principal_point) */
+	VMETA_SESSION_GROUP_CAMERA_MODEL,
+
+	/* Thermal camera (has_thermal, thermal) */
+	VMETA_SESSION_GROUP_THERMAL,
+
+	/* Overlay (overlay) */
+	VMETA_SESSION_GROUP_OVERLAY,
+
+	/* Media (default_media, proto_delta, video_mode, video_stop_reason,
+	 * dynamic_range, tone_mapping, first_frame_capture_ts,
+	 * first_frame_sample_index, media_id, resource_index) */
+	VMETA_SESSION_GROUP_MEDIA,
+
+	/* Number of groups */
+	VMETA_SESSION_GROUP_COUNT,
+};
+
+
+/* Session metadata fingerprint; two session metadata structures that are
+ * equal according to vmeta_session_cmp() have the same fingerprint. The
+ * fingerprint only depends on the field values as compared by
+ * vmeta_session_cmp() (e.g. not on the bytes following the string
+ * terminators or on the contents of an invalid location), so it can be
+ * stored and compared across processes. */
+struct vmeta_session_fingerprint {
+	/* 128-bit fingerprint of all the fields; hash[0] can be used alone as
+	 * a 64-bit fingerprint */
+	uint64_t hash[2];
+
+	/* 128-bit fingerprint of the fields of each group (index is
+	 * enum vmeta_session_group) */
+	uint64_t group[VMETA_SESSION_GROUP_COUNT][2];
+};
+
+
 /**
  * Write a date string.
  * The str string must have been previously allocated.
@@ -1603,6 +1662,10 @@ int vmeta_session_to_str(const struct vmeta_session *meta,
 /**
  * Merge common session metadata fields from an array of session metadata into a
  * single one. Erase the duplicated fields from the array.
+ * A field is common if it has the same value in all the session metadata of
+ * the array (NULL entries are ignored); the fields are compared through
+ * their fingerprint (length and 64-bit hash), computed once per session
+ * metadata.
  * @param meta_list: session metadata array to merge
  * @param meta_list_count: size of the meta_list array
  * @param merged_meta: pointer to the merged session metadata (output)
@@ -1625,6 +1688,59 @@ int vmeta_session_cmp(const struct vmeta_session *meta1,
 		      const struct vmeta_session *meta2);
 
 
+/**
+ * Compute the fingerprint of a session metadata structure.
+ * @param meta: pointer to the session metadata structure
+ * @param fp: pointer to the fingerprint (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_session_fingerprint(const struct vmeta_session *meta,
+			      struct vmeta_session_fingerprint *fp);
+
+
+/**
+ * Update the fingerprint of a session metadata structure.
+ * Only the fingerprints of the given groups are computed again, then the
+ * fingerprint of all the fields is updated; the other groups must not have
+ * changed since the fingerprint was computed.
+ * @param meta: pointer to the session metadata structure
+ * @param groups: groups to update (bit field of 1 << enum
+ *                vmeta_session_group values)
+ * @param fp: pointer to the fingerprint to update (input and output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_session_fingerprint_update(const struct vmeta_session *meta,
+				     uint32_t groups,
+				     struct vmeta_session_fingerprint *fp);
+
+
+/**
+ * Compare two session metadata fingerprints.
+ * @param fp1: fingerprint to compare with fp2
+ * @param fp2: fingerprint to compare with fp1
+ * @return 1 if the two are equal, 0 otherwise
+ */
+VMETA_API
+int vmeta_session_fingerprint_cmp(const struct vmeta_session_fingerprint *fp1,
+				  const struct vmeta_session_fingerprint *fp2);
+
+
+/**
+ * Get the groups that differ between two session metadata fingerprints.
+ * @param fp1: fingerprint to compare with fp2
+ * @param fp2: fingerprint to compare with fp1
+ * @return the groups that differ (bit field of 1 << enum
+ *         vmeta_session_group values), 0 if the fingerprints are equal;
+ *         all the groups in case of error
+ */
+VMETA_API
+uint32_t
+vmeta_session_fingerprint_diff(const struct vmeta_session_fingerprint *fp1,
+			       const struct vmeta_session_fingerprint *fp2);
+
+
 /**
  * Check if a session metadata structure is valid.
  * Valid means the friendly name and the model field are not empty and the maker
@@ -1636,4 +1752,100 @@ VMETA_API
 int vmeta_session_is_valid(const struct vmeta_session *meta);
 
 
+/* Serialized session metadata: a cache of the RTCP SDES items, SDP items and
+ * MP4 'meta' or 'udta' items of a session metadata structure. The items are
+ * rendered when the cache is updated, and only for the fields that changed
+ * since the previous update; writing the items afterwards does not format
+ * any value. The cache is not thread-safe. */
+struct vmeta_session_serialized;
+
+
+/**
+ * Create a serialized session metadata cache.
+ * The cache is initially empty (i.e. equivalent to a zeroed session
+ * metadata structure). It must be destroyed using
+ * vmeta_session_serialized_destroy().
+ * @param ret_obj: pointer to the cache (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_session_serialized_new(struct vmeta_session_serialized **ret_obj);
+
+
+/**
+ * Destroy a serialized session metadata cache.
+ * @param ser: pointer to the cache
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_session_serialized_destroy(struct vmeta_session_serialized *ser);
+
+
+/**
+ * Update a serialized session metadata cache.
+ * The fields of meta are compared with the ones of the previous update and
+ * the items are only rendered again for the fields that changed.
+ * @param ser: pointer to the cache
+ * @param meta: pointer to the session metadata structure
+ * @return the number of fields rendered again on success, negative errno
+ *         value in case of error
+ */
+VMETA_API
+int vmeta_session_serialized_update(struct vmeta_session_serialized *ser,
+				    const struct vmeta_session *meta);
+
+
+/**
+ * Write serialized session metadata as RTCP SDES items.
+ * The items are the same, in the same order, as the ones written by
+ * vmeta_session_streaming_sdes_write() for the session metadata of the last
+ * call to vmeta_session_serialized_update().
+ * @param ser: pointer to the cache
+ * @param cb: SDES item writing callback function
+ * @param userdata: SDES item writing callback function user data pointer
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_session_serialized_sdes_write(
+	const struct vmeta_session_serialized *ser,
+	vmeta_session_streaming_sdes_write_cb_t cb,
+	void *userdata);
+
+
+/**
+ * Write serialized session metadata as SDP items.
+ * The items are the same, in the same order, as the ones written by
+ * vmeta_session_streaming_sdp_write() for the session metadata of the last
+ * call to vmeta_session_serialized_update().
+ * @param ser: pointer to the cache
+ * @param media_level: session-level items if 0, media-level otherwise
+ * @param cb: SDP item writing callback function
+ * @param userdata: SDP item writing callback function user data pointer
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_session_serialized_sdp_write(
+	const struct vmeta_session_serialized *ser,
+	int media_level,
+	vmeta_session_streaming_sdp_write_cb_t cb,
+	void *userdata);
+
+
+/**
+ * Write serialized session metadata as MP4 file 'meta' or 'udta' items.
+ * The items are the same, in the same order, as the ones written by
+ * vmeta_session_recording_write() for the session metadata of the last
+ * call to vmeta_session_serialized_update().
+ * @param ser: pointer to the cache
+ * @param cb: 'meta' or 'udta' item writing callback function
+ * @param userdata: 'meta' or 'udta' item writing callback function user data
+ * @return 0 on success, negative errno value in case of error
+ */
+VMETA_API
+int vmeta_session_serialized_recording_write(
+	const struct vmeta_session_serialized *ser,
+	vmeta_session_recording_write_cb_t cb,
+	void *userdata);
+
+
 #endif /* !_VMETA_SESSION_H_ */
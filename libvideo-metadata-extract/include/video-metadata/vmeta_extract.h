@@ -87,4 +87,255 @@ VMETA_EXTRACT_API int vmeta_extract_track(const char *path,
 					  struct mp4_demux *demux);
 
 
+/* Metadata index entry flags */
+
+/* The frame_timestamp field of the entry is valid */
+#define VMETA_EXTRACT_INDEX_FLAG_FRAME_TIMESTAMP (1 << 0)
+
+/* The latitude, longitude and altitude fields of the entry are valid */
+#define VMETA_EXTRACT_INDEX_FLAG_LOCATION (1 << 1)
+
+
+/* Metadata index entry */
+struct vmeta_extract_index_entry {
+	/* Sample index in the track */
+	uint32_t sample;
+
+	/* Entry flags (VMETA_EXTRACT_INDEX_FLAG_*) */
+	uint32_t flags;
+
+	/* Sample decoding timestamp (us) */
+	uint64_t dts;
+
+	/* Sample offset in the MP4 file (bytes) */
+	uint64_t offset;
+
+	/* Metadata size (bytes) */
+	uint32_t size;
+
+	/* Frame capture timestamp from the metadata (us) */
+	uint64_t frame_timestamp;
+
+	/* Drone location from the metadata: latitude and longitude (deg) and
+	 * altitude above the WGS84 ellipsoid (m) (NaN means unknown) */
+	double latitude;
+	double longitude;
+	double altitude;
+};
+
+
+/* Geographic bounding box; if min_longitude is greater than max_longitude,
+ * the box crosses the 180th meridian */
+struct vmeta_extract_bbox {
+	/* Latitude range (deg) */
+	double min_latitude;
+	double max_latitude;
+
+	/* Longitude range (deg) */
+	double min_longitude;
+	double max_longitude;
+};
+
+
+/* Metadata index */
+struct vmeta_extract_index;
+
+
+/**
+ * Build the metadata index of an MP4 file.
+ * The metadata of all the samples of the first video track with timed
+ * metadata are decoded once; the index then allows looking up samples by
+ * time or by location without decoding the metadata again.
+ * If a demuxer is given, the track samples are read from it: its current
+ * position in the track is modified.
+ * The index must be destroyed using vmeta_extract_index_destroy().
+ * @param path: path to the MP4 file (unused if demux is given)
+ * @param demux: demuxer to use (optional)
+ * @param ret_obj: pointer filled with the new index
+ * @return: 0 on success, -ENOENT if the file has no video track with timed
+ *          metadata, negative errno on other failures
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_index_new(const char *path,
+			struct mp4_demux *demux,
+			struct vmeta_extract_index **ret_obj);
+
+
+/**
+ * Destroy a metadata index.
+ * @param index: pointer to the index
+ * @return: 0 on success, negative errno on failure
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_index_destroy(struct vmeta_extract_index *index);
+
+
+/**
+ * Save a metadata index to a sidecar file.
+ * The file format is independent of the host endianness.
+ * @param index: pointer to the index
+ * @param path: path to the sidecar file
+ * @return: 0 on success, negative errno on failure
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_index_save(struct vmeta_extract_index *index, const char *path);
+
+
+/**
+ * Load a metadata index from a sidecar file.
+ * The index must be destroyed using vmeta_extract_index_destroy().
+ * @param path: path to the sidecar file
+ * @param ret_obj: pointer filled with the new index
+ * @return: 0 on success, -EPROTO if the file is not a valid index sidecar
+ *          file, negative errno on other failures
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_index_load(const char *path,
+			 struct vmeta_extract_index **ret_obj);
+
+
+/**
+ * Get the ID of the indexed track.
+ * @param index: pointer to the index
+ * @return: the track ID on success, 0 on failure
+ */
+VMETA_EXTRACT_API uint32_t
+vmeta_extract_index_get_track_id(struct vmeta_extract_index *index);
+
+
+/**
+ * Get the number of entries of a metadata index.
+ * Entries are sorted by increasing sample index and decoding timestamp;
+ * samples without metadata have no entry.
+ * @param index: pointer to the index
+ * @return: the entry count on success, negative errno on failure
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_index_get_count(struct vmeta_extract_index *index);
+
+
+/**
+ * Get an entry of a metadata index.
+ * @param index: pointer to the index
+ * @param idx: entry index
+ * @return: a pointer to the entry (valid until the index is destroyed) on
+ *          success, NULL on failure
+ */
+VMETA_EXTRACT_API const struct vmeta_extract_index_entry *
+vmeta_extract_index_get_entry(struct vmeta_extract_index *index,
+			      unsigned int idx);
+
+
+/**
+ * Find the entry of a metadata index at a given time.
+ * The entry found is the last one with a decoding timestamp lower than or
+ * equal to the given time.
+ * The lookup is done in O(log n).
+ * @param index: pointer to the index
+ * @param dts: decoding timestamp to look up (us)
+ * @return: the entry index on success, -ENOENT if the index is empty or if
+ *          the time is before the first entry, negative errno on other
+ *          failures
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_index_find_by_time(struct vmeta_extract_index *index,
+				 uint64_t dts);
+
+
+/**
+ * Find the entries of a metadata index located in a bounding box.
+ * Only the entries with a location (VMETA_EXTRACT_INDEX_FLAG_LOCATION) are
+ * considered. The lookup uses a k-d tree built with the index; the entry
+ * indexes are written to the idx array in no particular order.
+ * @param index: pointer to the index
+ * @param bbox: bounding box to look up
+ * @param idx: array filled with the matching entry indexes (output,
+ *             optional if max_count is 0)
+ * @param max_count: size of the idx array
+ * @return: the total number of matching entries (which can be greater than
+ *          max_count) on success, negative errno on failure
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_index_find_in_bbox(struct vmeta_extract_index *index,
+				 const struct vmeta_extract_bbox *bbox,
+				 unsigned int *idx,
+				 unsigned int max_count);
+
+
+/* Frame metadata iterator flags */
+
+/* Read and decode the samples ahead on a background thread */
+#define VMETA_EXTRACT_FRAME_ITER_FLAG_PREFETCH (1 << 0)
+
+
+/* Frame metadata iterator */
+struct vmeta_extract_frame_iter;
+
+
+/**
+ * Create a frame metadata iterator on an MP4 file.
+ * The iterator returns the frame metadata of the samples of the first video
+ * track with timed metadata, in decoding order; samples without metadata
+ * are skipped. The read buffer and the frame metadata structures are reused
+ * from one sample to the next.
+ * If a demuxer is given, the track samples are read from it: its current
+ * position in the track is used as a starting point and is modified; with
+ * the VMETA_EXTRACT_FRAME_ITER_FLAG_PREFETCH flag, the demuxer must not be
+ * used by the caller until the iterator is destroyed.
+ * The iterator must be destroyed using vmeta_extract_frame_iter_destroy().
+ * @param path: path to the MP4 file (unused if demux is given)
+ * @param demux: demuxer to use (optional)
+ * @param flags: iterator flags (VMETA_EXTRACT_FRAME_ITER_FLAG_*)
+ * @param ret_obj: pointer filled with the new iterator
+ * @return: 0 on success, -ENOENT if the file has no video track with timed
+ *          metadata, negative errno on other failures
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_frame_iter_new(const char *path,
+			     struct mp4_demux *demux,
+			     unsigned int flags,
+			     struct vmeta_extract_frame_iter **ret_obj);
+
+
+/**
+ * Destroy a frame metadata iterator.
+ * The frame metadata structures already returned are not affected.
+ * @param iter: pointer to the iterator
+ * @return: 0 on success, negative errno on failure
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_frame_iter_destroy(struct vmeta_extract_frame_iter *iter);
+
+
+/**
+ * Get the frame metadata of the next sample.
+ * The caller must unref the frame metadata structure using
+ * vmeta_frame_unref().
+ * @param iter: pointer to the iterator
+ * @param timestamp: pointer to the sample decoding timestamp in
+ *                   microseconds (output, optional)
+ * @param ret_meta: pointer filled with the frame metadata structure
+ * @return: 0 on success, -ENOENT at the end of the track, negative errno on
+ *          other failures
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_frame_iter_next(struct vmeta_extract_frame_iter *iter,
+			      uint64_t *timestamp,
+			      struct vmeta_frame **ret_meta);
+
+
+/**
+ * Seek a frame metadata iterator to a given time.
+ * The next sample returned is the last one with a decoding timestamp lower
+ * than or equal to the given time. All the tracks of the demuxer are
+ * seeked (see mp4_demux_seek()).
+ * @param iter: pointer to the iterator
+ * @param timestamp: decoding timestamp to seek to (us)
+ * @return: 0 on success, negative errno on failure
+ */
+VMETA_EXTRACT_API int
+vmeta_extract_frame_iter_seek(struct vmeta_extract_frame_iter *iter,
+			      uint64_t timestamp);
+
+
 #endif /*_VMETA_EXTRACT_H_*/
@@ -24,20 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <video-metadata/vmeta.h>
-#include <video-metadata/vmeta_extract.h>
+#include "vmeta_extract_priv.h"
 
-#include <errno.h>
 #include <getopt.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
 #include <unistd.h>
 
-#include <libmp4.h>
-
-#define ULOG_TAG vmeta_extract
-#include <ulog.h>
 ULOG_DECLARE_TAG(ULOG_TAG);
 
 
@@ -0,0 +1,369 @@
+/**
+ * Copyright (c) 2023 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vmeta_extract_priv.h"
+
+#include <pthread.h>
+
+
+/* Number of frames decoded ahead by the prefetch thread */
+#define FRAME_ITER_PREFETCH_COUNT 16
+
+
+struct frame_iter_item {
+	uint64_t timestamp;
+	struct vmeta_frame *meta;
+};
+
+
+struct vmeta_extract_frame_iter {
+	struct mp4_demux *demux;
+	int own_demux;
+	uint32_t track_id;
+	uint32_t timescale;
+	struct vmeta_frame_pool *pool;
+	struct vmeta_frame_reader *reader;
+	uint8_t *data;
+	size_t data_capacity;
+
+	/* Prefetch thread state, protected by the mutex: the thread owns
+	 * the demuxer, the reader and the read buffer, and the seeks are
+	 * done by the thread */
+	int prefetch;
+	pthread_t thread;
+	int thread_started;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct frame_iter_item items[FRAME_ITER_PREFETCH_COUNT];
+	unsigned int head;
+	unsigned int count;
+	/* 0 while samples are read, -ENOENT at the end of the track,
+	 * negative errno value in case of error */
+	int status;
+	int seek_pending;
+	uint64_t seek_timestamp;
+	int seek_status;
+	int stop;
+};
+
+
+/* Read and decode the next sample with metadata */
+static int frame_iter_read(struct vmeta_extract_frame_iter *iter,
+			   uint64_t *timestamp,
+			   struct vmeta_frame **ret_meta)
+{
+	int ret;
+	struct mp4_track_sample sample;
+	struct vmeta_buffer buf;
+
+	for (;;) {
+		ret = vmeta_extract_read_track_sample(iter->demux,
+						      iter->track_id,
+						      &iter->data,
+						      &iter->data_capacity,
+						      &sample);
+		if (ret < 0)
+			return ret;
+		if (sample.metadata_size == 0)
+			continue;
+		vmeta_buffer_set_cdata(
+			&buf, iter->data, sample.metadata_size, 0);
+		ret = vmeta_frame_reader_read(iter->reader, &buf, ret_meta);
+		if (ret == -ENOMEM)
+			return ret;
+		if (ret < 0) {
+			/* Empty or invalid metadata: skipped */
+			if (ret != -ENODATA)
+				ULOG_ERRNO("vmeta_frame_reader_read", -ret);
+			continue;
+		}
+		*timestamp = mp4_sample_time_to_usec(sample.dts,
+						     iter->timescale);
+		return 0;
+	}
+}
+
+
+static int frame_iter_seek(struct vmeta_extract_frame_iter *iter,
+			   uint64_t timestamp)
+{
+	int ret;
+
+	ret = mp4_demux_seek(iter->demux, timestamp, MP4_SEEK_METHOD_PREVIOUS);
+	if (ret < 0)
+		ULOG_ERRNO("mp4_demux_seek", -ret);
+	return ret;
+}
+
+
+/* Called with the mutex locked */
+static void frame_iter_flush(struct vmeta_extract_frame_iter *iter)
+{
+	while (iter->count > 0) {
+		vmeta_frame_unref(iter->items[iter->head].meta);
+		iter->head = (iter->head + 1) % FRAME_ITER_PREFETCH_COUNT;
+		iter->count--;
+	}
+	iter->head = 0;
+}
+
+
+static void *frame_iter_thread(void *userdata)
+{
+	struct vmeta_extract_frame_iter *iter = userdata;
+	struct frame_iter_item item;
+	uint64_t timestamp;
+	int res;
+
+	pthread_mutex_lock(&iter->mutex);
+	while (!iter->stop) {
+		if (iter->seek_pending) {
+			frame_iter_flush(iter);
+			timestamp = iter->seek_timestamp;
+			pthread_mutex_unlock(&iter->mutex);
+			res = frame_iter_seek(iter, timestamp);
+			pthread_mutex_lock(&iter->mutex);
+			iter->seek_status = res;
+			iter->status = res;
+			iter->seek_pending = 0;
+			pthread_cond_broadcast(&iter->cond);
+			continue;
+		}
+		if ((iter->status != 0) ||
+		    (iter->count == FRAME_ITER_PREFETCH_COUNT)) {
+			pthread_cond_wait(&iter->cond, &iter->mutex);
+			continue;
+		}
+		pthread_mutex_unlock(&iter->mutex);
+		res = frame_iter_read(iter, &item.timestamp, &item.meta);
+		pthread_mutex_lock(&iter->mutex);
+		if (iter->seek_pending) {
+			/* Sample read before the seek: discarded */
+			if (res == 0)
+				vmeta_frame_unref(item.meta);
+			continue;
+		}
+		if (res == 0) {
+			iter->items[(iter->head + iter->count) %
+				    FRAME_ITER_PREFETCH_COUNT] = item;
+			iter->count++;
+		} else {
+			iter->status = res;
+		}
+		pthread_cond_broadcast(&iter->cond);
+	}
+	pthread_mutex_unlock(&iter->mutex);
+
+	return NULL;
+}
+
+
+static int frame_iter_start_prefetch(struct vmeta_extract_frame_iter *iter)
+{
+	int ret;
+
+	ret = pthread_mutex_init(&iter->mutex, NULL);
+	if (ret != 0) {
+		ULOG_ERRNO("pthread_mutex_init", ret);
+		return -ret;
+	}
+	ret = pthread_cond_init(&iter->cond, NULL);
+	if (ret != 0) {
+		ULOG_ERRNO("pthread_cond_init", ret);
+		pthread_mutex_destroy(&iter->mutex);
+		return -ret;
+	}
+	iter->prefetch = 1;
+
+	ret = pthread_create(&iter->thread, NULL, frame_iter_thread, iter);
+	if (ret != 0) {
+		ULOG_ERRNO("pthread_create", ret);
+		return -ret;
+	}
+	iter->thread_started = 1;
+
+	return 0;
+}
+
+
+int vmeta_extract_frame_iter_new(const char *path,
+				 struct mp4_demux *demux,
+				 unsigned int flags,
+				 struct vmeta_extract_frame_iter **ret_obj)
+{
+	int ret;
+	struct vmeta_extract_frame_iter *iter;
+	struct mp4_track_info tk;
+
+	ULOG_ERRNO_RETURN_ERR_IF(path == NULL && demux == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	iter = calloc(1, sizeof(*iter));
+	if (iter == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+
+	if (demux != NULL) {
+		iter->demux = demux;
+	} else {
+		ret = mp4_demux_open(path, &iter->demux);
+		if (ret < 0) {
+			ULOG_ERRNO("mp4_demux_open '%s'", -ret, path);
+			goto error;
+		}
+		iter->own_demux = 1;
+	}
+
+	ret = vmeta_extract_find_metadata_track(iter->demux, &tk);
+	if (ret < 0) {
+		if (ret == -ENOENT)
+			ULOGE("no video track with timed metadata");
+		goto error;
+	}
+	iter->track_id = tk.id;
+	iter->timescale = tk.timescale;
+
+	/* The pool keeps the frames released by the caller (and the ones
+	 * decoded ahead) for reuse */
+	ret = vmeta_frame_pool_new(FRAME_ITER_PREFETCH_COUNT + 2, &iter->pool);
+	if (ret < 0) {
+		ULOG_ERRNO("vmeta_frame_pool_new", -ret);
+		goto error;
+	}
+	ret = vmeta_frame_reader_new(
+		tk.metadata_mime_format, 0, iter->pool, &iter->reader);
+	if (ret < 0) {
+		ULOG_ERRNO("vmeta_frame_reader_new", -ret);
+		goto error;
+	}
+
+	if (flags & VMETA_EXTRACT_FRAME_ITER_FLAG_PREFETCH) {
+		ret = frame_iter_start_prefetch(iter);
+		if (ret < 0)
+			goto error;
+	}
+
+	*ret_obj = iter;
+	return 0;
+
+error:
+	vmeta_extract_frame_iter_destroy(iter);
+	return ret;
+}
+
+
+int vmeta_extract_frame_iter_destroy(struct vmeta_extract_frame_iter *iter)
+{
+	if (iter == NULL)
+		return 0;
+
+	if (iter->prefetch) {
+		if (iter->thread_started) {
+			pthread_mutex_lock(&iter->mutex);
+			iter->stop = 1;
+			pthread_cond_broadcast(&iter->cond);
+			pthread_mutex_unlock(&iter->mutex);
+			pthread_join(iter->thread, NULL);
+		}
+		frame_iter_flush(iter);
+		pthread_cond_destroy(&iter->cond);
+		pthread_mutex_destroy(&iter->mutex);
+	}
+	if (iter->reader != NULL)
+		vmeta_frame_reader_destroy(iter->reader);
+	if (iter->pool != NULL)
+		vmeta_frame_pool_destroy(iter->pool);
+	if (iter->own_demux)
+		mp4_demux_close(iter->demux);
+	free(iter->data);
+	free(iter);
+
+	return 0;
+}
+
+
+int vmeta_extract_frame_iter_next(struct vmeta_extract_frame_iter *iter,
+				  uint64_t *timestamp,
+				  struct vmeta_frame **ret_meta)
+{
+	int ret;
+	struct frame_iter_item item;
+
+	ULOG_ERRNO_RETURN_ERR_IF(iter == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_meta == NULL, EINVAL);
+
+	if (!iter->prefetch) {
+		ret = frame_iter_read(iter, &item.timestamp, &item.meta);
+		if (ret < 0)
+			return ret;
+		goto out;
+	}
+
+	pthread_mutex_lock(&iter->mutex);
+	while ((iter->count == 0) && (iter->status == 0))
+		pthread_cond_wait(&iter->cond, &iter->mutex);
+	if (iter->count == 0) {
+		ret = iter->status;
+		pthread_mutex_unlock(&iter->mutex);
+		return ret;
+	}
+	item = iter->items[iter->head];
+	iter->head = (iter->head + 1) % FRAME_ITER_PREFETCH_COUNT;
+	iter->count--;
+	pthread_cond_broadcast(&iter->cond);
+	pthread_mutex_unlock(&iter->mutex);
+
+out:
+	if (timestamp != NULL)
+		*timestamp = item.timestamp;
+	*ret_meta = item.meta;
+	return 0;
+}
+
+
+int vmeta_extract_frame_iter_seek(struct vmeta_extract_frame_iter *iter,
+				  uint64_t timestamp)
+{
+	int ret;
+
+	ULOG_ERRNO_RETURN_ERR_IF(iter == NULL, EINVAL);
+
+	if (!iter->prefetch)
+		return frame_iter_seek(iter, timestamp);
+
+	pthread_mutex_lock(&iter->mutex);
+	iter->seek_pending = 1;
+	iter->seek_timestamp = timestamp;
+	pthread_cond_broadcast(&iter->cond);
+	while (iter->seek_pending)
+		pthread_cond_wait(&iter->cond, &iter->mutex);
+	ret = iter->seek_status;
+	pthread_mutex_unlock(&iter->mutex);
+
+	return ret;
+}
@@ -0,0 +1,721 @@
+/**
+ * Copyright (c) 2023 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vmeta_extract_priv.h"
+
+
+/* Sidecar file format (little-endian):
+ *   header (32 bytes): magic (4 bytes), version (u16), entry size (u16),
+ *                      track ID (u32), entry count (u32), reserved (16 bytes)
+ *   entries (64 bytes each): sample (u32), flags (u32), DTS (u64),
+ *                            offset (u64), size (u32), reserved (u32),
+ *                            frame timestamp (u64), latitude (f64),
+ *                            longitude (f64), altitude (f64) */
+#define INDEX_FILE_MAGIC "VMXI"
+#define INDEX_FILE_VERSION 1
+#define INDEX_FILE_HEADER_SIZE 32
+#define INDEX_FILE_ENTRY_SIZE 64
+
+
+struct vmeta_extract_index {
+	uint32_t track_id;
+
+	struct vmeta_extract_index_entry *entries;
+	unsigned int count;
+	unsigned int capacity;
+
+	/* k-d tree of the entries with a location: entry indexes, the median
+	 * of each range being the node, splitting alternately by latitude
+	 * and longitude */
+	unsigned int *kd;
+	unsigned int kd_count;
+};
+
+
+static int index_new(struct vmeta_extract_index **ret_obj)
+{
+	struct vmeta_extract_index *index;
+
+	index = calloc(1, sizeof(*index));
+	if (index == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	*ret_obj = index;
+	return 0;
+}
+
+
+static int index_reserve(struct vmeta_extract_index *index,
+			 unsigned int capacity)
+{
+	struct vmeta_extract_index_entry *entries;
+
+	if (capacity <= index->capacity)
+		return 0;
+
+	entries = realloc(index->entries, capacity * sizeof(*entries));
+	if (entries == NULL) {
+		ULOG_ERRNO("realloc", ENOMEM);
+		return -ENOMEM;
+	}
+	index->entries = entries;
+	index->capacity = capacity;
+	return 0;
+}
+
+
+static int index_add(struct vmeta_extract_index *index,
+		     const struct vmeta_extract_index_entry *entry)
+{
+	int ret;
+
+	if (index->count == index->capacity) {
+		ret = index_reserve(
+			index, index->capacity ? 2 * index->capacity : 256);
+		if (ret < 0)
+			return ret;
+	}
+	index->entries[index->count++] = *entry;
+	return 0;
+}
+
+
+static inline double kd_coord(struct vmeta_extract_index *index,
+			      unsigned int kd_idx,
+			      int axis)
+{
+	const struct vmeta_extract_index_entry *e =
+		&index->entries[index->kd[kd_idx]];
+	return axis ? e->longitude : e->latitude;
+}
+
+
+static inline void kd_swap(struct vmeta_extract_index *index,
+			   unsigned int a,
+			   unsigned int b)
+{
+	unsigned int tmp = index->kd[a];
+	index->kd[a] = index->kd[b];
+	index->kd[b] = tmp;
+}
+
+
+/* Partially sort kd[lo, hi[ so that kd[k] is at its sorted position along
+ * the axis, with lower or equal values before and greater or equal values
+ * after it (quickselect, with a three-way partition so that repeated values,
+ * e.g. while the drone is hovering, do not degrade the complexity) */
+static void kd_select(struct vmeta_extract_index *index,
+		      unsigned int lo,
+		      unsigned int hi,
+		      unsigned int k,
+		      int axis)
+{
+	while (hi - lo > 1) {
+		unsigned int lt, gt, i;
+		double pivot = kd_coord(index, lo + (hi - lo) / 2, axis);
+
+		/* kd[lo, lt[ < pivot, kd[lt, i[ == pivot, kd[gt, hi[ > pivot */
+		lt = lo;
+		gt = hi;
+		i = lo;
+		while (i < gt) {
+			double v = kd_coord(index, i, axis);
+			if (v < pivot)
+				kd_swap(index, i++, lt++);
+			else if (v > pivot)
+				kd_swap(index, i, --gt);
+			else
+				i++;
+		}
+
+		if (k < lt)
+			hi = lt;
+		else if (k >= gt)
+			lo = gt;
+		else
+			return;
+	}
+}
+
+
+static void kd_build(struct vmeta_extract_index *index,
+		     unsigned int lo,
+		     unsigned int hi,
+		     int axis)
+{
+	while (hi - lo > 1) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		kd_select(index, lo, hi, mid, axis);
+		kd_build(index, lo, mid, !axis);
+		lo = mid + 1;
+		axis = !axis;
+	}
+}
+
+
+static int index_build_kd(struct vmeta_extract_index *index)
+{
+	unsigned int i;
+
+	free(index->kd);
+	index->kd = NULL;
+	index->kd_count = 0;
+
+	for (i = 0; i < index->count; i++) {
+		if (index->entries[i].flags & VMETA_EXTRACT_INDEX_FLAG_LOCATION)
+			index->kd_count++;
+	}
+	if (index->kd_count == 0)
+		return 0;
+
+	index->kd = malloc(index->kd_count * sizeof(*index->kd));
+	if (index->kd == NULL) {
+		index->kd_count = 0;
+		ULOG_ERRNO("malloc", ENOMEM);
+		return -ENOMEM;
+	}
+	index->kd_count = 0;
+	for (i = 0; i < index->count; i++) {
+		if (index->entries[i].flags & VMETA_EXTRACT_INDEX_FLAG_LOCATION)
+			index->kd[index->kd_count++] = i;
+	}
+
+	kd_build(index, 0, index->kd_count, 0);
+	return 0;
+}
+
+
+struct kd_query {
+	double min[2];
+	double max[2];
+	unsigned int *idx;
+	unsigned int max_count;
+	unsigned int count;
+};
+
+
+static void kd_search(struct vmeta_extract_index *index,
+		      struct kd_query *q,
+		      unsigned int lo,
+		      unsigned int hi,
+		      int axis)
+{
+	while (hi > lo) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		const struct vmeta_extract_index_entry *e =
+			&index->entries[index->kd[mid]];
+		double v = axis ? e->longitude : e->latitude;
+
+		if ((e->latitude >= q->min[0]) && (e->latitude <= q->max[0]) &&
+		    (e->longitude >= q->min[1]) &&
+		    (e->longitude <= q->max[1])) {
+			if (q->count < q->max_count)
+				q->idx[q->count] = index->kd[mid];
+			q->count++;
+		}
+
+		/* Lower values are before the node and greater values after
+		 * it; equal values can be on both sides */
+		if (v >= q->min[axis])
+			kd_search(index, q, lo, mid, !axis);
+		if (v > q->max[axis])
+			return;
+		lo = mid + 1;
+		axis = !axis;
+	}
+}
+
+
+int vmeta_extract_find_metadata_track(struct mp4_demux *demux,
+				      struct mp4_track_info *info)
+{
+	int ret, i, count;
+
+	count = mp4_demux_get_track_count(demux);
+	if (count < 0) {
+		ULOG_ERRNO("mp4_demux_get_track_count", -count);
+		return count;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = mp4_demux_get_track_info(demux, i, info);
+		if (ret < 0) {
+			ULOG_ERRNO("mp4_demux_get_track_info", -ret);
+			continue;
+		}
+		if ((info->type == MP4_TRACK_TYPE_VIDEO) &&
+		    (info->has_metadata) && (info->metadata_mime_format))
+			return 0;
+	}
+
+	return -ENOENT;
+}
+
+
+int vmeta_extract_read_track_sample(struct mp4_demux *demux,
+				    uint32_t track_id,
+				    uint8_t **data,
+				    size_t *data_capacity,
+				    struct mp4_track_sample *sample)
+{
+	int ret;
+
+	/* Retrieve the metadata size without advancing */
+	ret = mp4_demux_get_track_sample(
+		demux, track_id, 0, NULL, 0, NULL, 0, sample);
+	if (ret < 0) {
+		ULOG_ERRNO("mp4_demux_get_track_sample", -ret);
+		return ret;
+	}
+	if (sample->size == 0)
+		return -ENOENT;
+	if (*data_capacity < sample->metadata_size) {
+		uint8_t *tmp = realloc(*data, sample->metadata_size);
+		if (tmp == NULL) {
+			ret = -ENOMEM;
+			ULOG_ERRNO("realloc", -ret);
+			return ret;
+		}
+		*data = tmp;
+		*data_capacity = sample->metadata_size;
+	}
+
+	/* Read the metadata and advance to the next sample */
+	ret = mp4_demux_get_track_sample(
+		demux, track_id, 1, NULL, 0, *data, *data_capacity, sample);
+	if (ret < 0) {
+		ULOG_ERRNO("mp4_demux_get_track_sample", -ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+
+static int index_read_track(struct vmeta_extract_index *index,
+			    struct mp4_demux *demux)
+{
+	int ret, err;
+	struct mp4_track_info tk;
+	struct mp4_track_sample sample;
+	struct vmeta_frame_reader *reader = NULL;
+	struct vmeta_frame_pool *pool = NULL;
+	struct vmeta_frame *meta;
+	struct vmeta_buffer buf;
+	struct vmeta_location loc;
+	uint8_t *data = NULL;
+	size_t data_capacity = 0;
+	uint32_t sample_idx;
+
+	ret = vmeta_extract_find_metadata_track(demux, &tk);
+	if (ret < 0) {
+		if (ret == -ENOENT)
+			ULOGE("no video track with timed metadata");
+		return ret;
+	}
+	index->track_id = tk.id;
+
+	ret = index_reserve(index, tk.sample_count);
+	if (ret < 0)
+		return ret;
+
+	/* A pool of one frame avoids reallocating the frame for each
+	 * sample */
+	ret = vmeta_frame_pool_new(1, &pool);
+	if (ret < 0) {
+		ULOG_ERRNO("vmeta_frame_pool_new", -ret);
+		goto out;
+	}
+	ret = vmeta_frame_reader_new(tk.metadata_mime_format, 0, pool, &reader);
+	if (ret < 0) {
+		ULOG_ERRNO("vmeta_frame_reader_new", -ret);
+		goto out;
+	}
+
+	for (sample_idx = 0;; sample_idx++) {
+		struct vmeta_extract_index_entry entry;
+
+		ret = vmeta_extract_read_track_sample(
+			demux, tk.id, &data, &data_capacity, &sample);
+		if (ret == -ENOENT)
+			break;
+		if (ret < 0)
+			goto out;
+		if (sample.metadata_size == 0)
+			continue;
+
+		vmeta_buffer_set_cdata(&buf, data, sample.metadata_size, 0);
+		err = vmeta_frame_reader_read(reader, &buf, &meta);
+		if (err < 0) {
+			/* Empty or invalid metadata: not indexed */
+			if (err != -ENODATA)
+				ULOG_ERRNO("vmeta_frame_reader_read", -err);
+			continue;
+		}
+
+		memset(&entry, 0, sizeof(entry));
+		entry.sample = sample_idx;
+		entry.dts = mp4_sample_time_to_usec(sample.dts, tk.timescale);
+		entry.offset = sample.offset;
+		entry.size = sample.metadata_size;
+		entry.latitude = NAN;
+		entry.longitude = NAN;
+		entry.altitude = NAN;
+		if (vmeta_frame_get_frame_timestamp(
+			    meta, &entry.frame_timestamp) == 0)
+			entry.flags |= VMETA_EXTRACT_INDEX_FLAG_FRAME_TIMESTAMP;
+		if ((vmeta_frame_get_location(meta, &loc) == 0) && loc.valid) {
+			entry.latitude = loc.latitude;
+			entry.longitude = loc.longitude;
+			entry.altitude = loc.altitude_wgs84ellipsoid;
+			entry.flags |= VMETA_EXTRACT_INDEX_FLAG_LOCATION;
+		}
+		vmeta_frame_unref(meta);
+
+		ret = index_add(index, &entry);
+		if (ret < 0)
+			goto out;
+	}
+
+	ret = index_build_kd(index);
+
+out:
+	if (reader != NULL)
+		vmeta_frame_reader_destroy(reader);
+	if (pool != NULL)
+		vmeta_frame_pool_destroy(pool);
+	free(data);
+	return ret;
+}
+
+
+int vmeta_extract_index_new(const char *path,
+			    struct mp4_demux *demux,
+			    struct vmeta_extract_index **ret_obj)
+{
+	int ret;
+	int create_new_demuxer = !!(demux == NULL);
+	struct mp4_demux *demuxer = NULL;
+	struct vmeta_extract_index *index = NULL;
+
+	ULOG_ERRNO_RETURN_ERR_IF(path == NULL && create_new_demuxer, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	if (!create_new_demuxer) {
+		demuxer = demux;
+		goto skip_mux_creation;
+	}
+
+	ret = mp4_demux_open(path, &demuxer);
+	if (ret < 0) {
+		ULOG_ERRNO("mp4_demux_open '%s'", -ret, path);
+		goto out;
+	}
+
+skip_mux_creation:
+	ret = index_new(&index);
+	if (ret < 0)
+		goto out;
+
+	ret = index_read_track(index, demuxer);
+	if (ret < 0)
+		goto out;
+
+	*ret_obj = index;
+	index = NULL;
+
+out:
+	if (index != NULL)
+		vmeta_extract_index_destroy(index);
+	if (demuxer != NULL && create_new_demuxer)
+		mp4_demux_close(demuxer);
+
+	return ret;
+}
+
+
+int vmeta_extract_index_destroy(struct vmeta_extract_index *index)
+{
+	if (index == NULL)
+		return 0;
+
+	free(index->kd);
+	free(index->entries);
+	free(index);
+
+	return 0;
+}
+
+
+int vmeta_extract_index_save(struct vmeta_extract_index *index,
+			     const char *path)
+{
+	int ret = 0;
+	FILE *f;
+	unsigned int i;
+	uint8_t hdr[INDEX_FILE_HEADER_SIZE];
+	uint8_t rec[INDEX_FILE_ENTRY_SIZE];
+
+	ULOG_ERRNO_RETURN_ERR_IF(index == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(path == NULL, EINVAL);
+
+	f = fopen(path, "wb");
+	if (f == NULL) {
+		ret = -errno;
+		ULOG_ERRNO("fopen '%s'", -ret, path);
+		return ret;
+	}
+
+	memset(hdr, 0, sizeof(hdr));
+	memcpy(hdr, INDEX_FILE_MAGIC, 4);
+	vmeta_extract_write_u16le(hdr + 4, INDEX_FILE_VERSION);
+	vmeta_extract_write_u16le(hdr + 6, INDEX_FILE_ENTRY_SIZE);
+	vmeta_extract_write_u32le(hdr + 8, index->track_id);
+	vmeta_extract_write_u32le(hdr + 12, index->count);
+	if (fwrite(hdr, sizeof(hdr), 1, f) != 1) {
+		ret = -EIO;
+		goto out;
+	}
+
+	memset(rec, 0, sizeof(rec));
+	for (i = 0; i < index->count; i++) {
+		const struct vmeta_extract_index_entry *e = &index->entries[i];
+		vmeta_extract_write_u32le(rec, e->sample);
+		vmeta_extract_write_u32le(rec + 4, e->flags);
+		vmeta_extract_write_u64le(rec + 8, e->dts);
+		vmeta_extract_write_u64le(rec + 16, e->offset);
+		vmeta_extract_write_u32le(rec + 24, e->size);
+		vmeta_extract_write_u64le(rec + 32, e->frame_timestamp);
+		vmeta_extract_write_f64le(rec + 40, e->latitude);
+		vmeta_extract_write_f64le(rec + 48, e->longitude);
+		vmeta_extract_write_f64le(rec + 56, e->altitude);
+		if (fwrite(rec, sizeof(rec), 1, f) != 1) {
+			ret = -EIO;
+			goto out;
+		}
+	}
+
+out:
+	if ((fclose(f) != 0) && (ret == 0))
+		ret = -EIO;
+	if (ret < 0)
+		ULOG_ERRNO("failed to write '%s'", -ret, path);
+	return ret;
+}
+
+
+int vmeta_extract_index_load(const char *path,
+			     struct vmeta_extract_index **ret_obj)
+{
+	int ret;
+	FILE *f;
+	long size;
+	unsigned int i, count, entry_size;
+	uint8_t hdr[INDEX_FILE_HEADER_SIZE];
+	uint8_t rec[INDEX_FILE_ENTRY_SIZE];
+	struct vmeta_extract_index *index = NULL;
+
+	ULOG_ERRNO_RETURN_ERR_IF(path == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	f = fopen(path, "rb");
+	if (f == NULL) {
+		ret = -errno;
+		ULOG_ERRNO("fopen '%s'", -ret, path);
+		return ret;
+	}
+
+	if ((fread(hdr, sizeof(hdr), 1, f) != 1) ||
+	    (memcmp(hdr, INDEX_FILE_MAGIC, 4) != 0) ||
+	    (vmeta_extract_read_u16le(hdr + 4) != INDEX_FILE_VERSION)) {
+		ULOGE("'%s': invalid index file header", path);
+		ret = -EPROTO;
+		goto out;
+	}
+	/* Entries can only grow in later versions: extra fields are
+	 * skipped */
+	entry_size = vmeta_extract_read_u16le(hdr + 6);
+	if (entry_size < INDEX_FILE_ENTRY_SIZE) {
+		ULOGE("'%s': invalid index entry size (%u)", path, entry_size);
+		ret = -EPROTO;
+		goto out;
+	}
+	count = vmeta_extract_read_u32le(hdr + 12);
+
+	/* Check the entry count against the file size before allocating */
+	if ((fseek(f, 0, SEEK_END) != 0) || ((size = ftell(f)) < 0) ||
+	    (fseek(f, INDEX_FILE_HEADER_SIZE, SEEK_SET) != 0)) {
+		ret = -EIO;
+		ULOG_ERRNO("'%s': failed to get the file size", -ret, path);
+		goto out;
+	}
+	if ((count > INT_MAX) ||
+	    ((uint64_t)count * entry_size >
+	     (uint64_t)size - INDEX_FILE_HEADER_SIZE)) {
+		ULOGE("'%s': truncated index file (%u entries)", path, count);
+		ret = -EPROTO;
+		goto out;
+	}
+
+	ret = index_new(&index);
+	if (ret < 0)
+		goto out;
+	index->track_id = vmeta_extract_read_u32le(hdr + 8);
+	ret = index_reserve(index, count);
+	if (ret < 0)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		struct vmeta_extract_index_entry e;
+		if ((fread(rec, sizeof(rec), 1, f) != 1) ||
+		    ((entry_size > sizeof(rec)) &&
+		     (fseek(f, entry_size - sizeof(rec), SEEK_CUR) != 0))) {
+			ULOGE("'%s': truncated index file", path);
+			ret = -EPROTO;
+			goto out;
+		}
+		e.sample = vmeta_extract_read_u32le(rec);
+		e.flags = vmeta_extract_read_u32le(rec + 4);
+		e.dts = vmeta_extract_read_u64le(rec + 8);
+		e.offset = vmeta_extract_read_u64le(rec + 16);
+		e.size = vmeta_extract_read_u32le(rec + 24);
+		e.frame_timestamp = vmeta_extract_read_u64le(rec + 32);
+		e.latitude = vmeta_extract_read_f64le(rec + 40);
+		e.longitude = vmeta_extract_read_f64le(rec + 48);
+		e.altitude = vmeta_extract_read_f64le(rec + 56);
+		/* Time lookups rely on the entries order */
+		if ((i > 0) && (e.dts < index->entries[i - 1].dts)) {
+			ULOGE("'%s': unsorted index entries", path);
+			ret = -EPROTO;
+			goto out;
+		}
+		ret = index_add(index, &e);
+		if (ret < 0)
+			goto out;
+	}
+
+	ret = index_build_kd(index);
+	if (ret < 0)
+		goto out;
+
+	*ret_obj = index;
+	index = NULL;
+
+out:
+	fclose(f);
+	if (index != NULL)
+		vmeta_extract_index_destroy(index);
+	return ret;
+}
+
+
+uint32_t vmeta_extract_index_get_track_id(struct vmeta_extract_index *index)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(index == NULL, EINVAL, 0);
+
+	return index->track_id;
+}
+
+
+int vmeta_extract_index_get_count(struct vmeta_extract_index *index)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(index == NULL, EINVAL);
+
+	return index->count;
+}
+
+
+const struct vmeta_extract_index_entry *
+vmeta_extract_index_get_entry(struct vmeta_extract_index *index,
+			      unsigned int idx)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(index == NULL, EINVAL, NULL);
+	ULOG_ERRNO_RETURN_VAL_IF(idx >= index->count, ENOENT, NULL);
+
+	return &index->entries[idx];
+}
+
+
+int vmeta_extract_index_find_by_time(struct vmeta_extract_index *index,
+				     uint64_t dts)
+{
+	unsigned int lo, hi;
+
+	ULOG_ERRNO_RETURN_ERR_IF(index == NULL, EINVAL);
+
+	if ((index->count == 0) || (dts < index->entries[0].dts))
+		return -ENOENT;
+
+	/* Find the first entry after the time */
+	lo = 0;
+	hi = index->count;
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (index->entries[mid].dts <= dts)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return (int)lo - 1;
+}
+
+
+int vmeta_extract_index_find_in_bbox(struct vmeta_extract_index *index,
+				     const struct vmeta_extract_bbox *bbox,
+				     unsigned int *idx,
+				     unsigned int max_count)
+{
+	struct kd_query q;
+
+	ULOG_ERRNO_RETURN_ERR_IF(index == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(bbox == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(idx == NULL && max_count > 0, EINVAL);
+
+	memset(&q, 0, sizeof(q));
+	q.min[0] = bbox->min_latitude;
+	q.max[0] = bbox->max_latitude;
+	q.idx = idx;
+	q.max_count = max_count;
+
+	if (bbox->min_longitude <= bbox->max_longitude) {
+		q.min[1] = bbox->min_longitude;
+		q.max[1] = bbox->max_longitude;
+		kd_search(index, &q, 0, index->kd_count, 0);
+	} else {
+		/* The box crosses the 180th meridian: look up both sides */
+		q.min[1] = bbox->min_longitude;
+		q.max[1] = 180.;
+		kd_search(index, &q, 0, index->kd_count, 0);
+		q.min[1] = -180.;
+		q.max[1] = bbox->max_longitude;
+		kd_search(index, &q, 0, index->kd_count, 0);
+	}
+
+	return q.count;
+}
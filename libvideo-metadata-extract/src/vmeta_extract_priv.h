@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2023 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VMETA_EXTRACT_PRIV_H_
+#define _VMETA_EXTRACT_PRIV_H_
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libmp4.h>
+
+#define ULOG_TAG vmeta_extract
+#include <ulog.h>
+
+#include <video-metadata/vmeta.h>
+#include <video-metadata/vmeta_extract.h>
+
+
+/**
+ * Find the first video track with timed metadata of an MP4 file.
+ * @param demux: demuxer to use
+ * @param info: track information to fill (output)
+ * @return: 0 on success, -ENOENT if there is no such track, negative errno
+ *          on other failures
+ */
+int vmeta_extract_find_metadata_track(struct mp4_demux *demux,
+				      struct mp4_track_info *info);
+
+
+/**
+ * Read the next sample of a track along with its metadata, and advance the
+ * demuxer to the following sample. The metadata buffer is grown as needed;
+ * samples without metadata are returned with a metadata_size of 0.
+ * @param demux: demuxer to use
+ * @param track_id: track to read
+ * @param data: metadata buffer, reallocated if too small (input/output)
+ * @param data_capacity: metadata buffer size (input/output)
+ * @param sample: sample information to fill (output)
+ * @return: 0 on success, -ENOENT at the end of the track, negative errno
+ *          on other failures
+ */
+int vmeta_extract_read_track_sample(struct mp4_demux *demux,
+				    uint32_t track_id,
+				    uint8_t **data,
+				    size_t *data_capacity,
+				    struct mp4_track_sample *sample);
+
+
+/* Little-endian encoding of the index sidecar files */
+
+static inline void vmeta_extract_write_u16le(uint8_t *p, uint16_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+
+static inline void vmeta_extract_write_u32le(uint8_t *p, uint32_t v)
+{
+	vmeta_extract_write_u16le(p, v & 0xffff);
+	vmeta_extract_write_u16le(p + 2, v >> 16);
+}
+
+
+static inline void vmeta_extract_write_u64le(uint8_t *p, uint64_t v)
+{
+	vmeta_extract_write_u32le(p, v & 0xffffffff);
+	vmeta_extract_write_u32le(p + 4, v >> 32);
+}
+
+
+static inline void vmeta_extract_write_f64le(uint8_t *p, double v)
+{
+	uint64_t u64;
+	memcpy(&u64, &v, sizeof(u64));
+	vmeta_extract_write_u64le(p, u64);
+}
+
+
+static inline uint16_t vmeta_extract_read_u16le(const uint8_t *p)
+{
+	return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+
+static inline uint32_t vmeta_extract_read_u32le(const uint8_t *p)
+{
+	return (uint32_t)vmeta_extract_read_u16le(p) |
+	       ((uint32_t)vmeta_extract_read_u16le(p + 2) << 16);
+}
+
+
+static inline uint64_t vmeta_extract_read_u64le(const uint8_t *p)
+{
+	return (uint64_t)vmeta_extract_read_u32le(p) |
+	       ((uint64_t)vmeta_extract_read_u32le(p + 4) << 32);
+}
+
+
+static inline double vmeta_extract_read_f64le(const uint8_t *p)
+{
+	uint64_t u64 = vmeta_extract_read_u64le(p);
+	double v;
+	memcpy(&v, &u64, sizeof(v));
+	return v;
+}
+
+#endif /* !_VMETA_EXTRACT_PRIV_H_ */
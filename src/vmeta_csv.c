@@ -27,136 +27,314 @@
 #include "vmeta_priv.h"
 
 
-size_t vmeta_csv_add_location(char *str,
-			      size_t maxlen,
-			      const struct vmeta_location *val)
-{
-	size_t len = 0;
-
-	if (val->valid) {
-		VMETA_STR_PRINT(
-			str,
-			len,
-			maxlen,
-			"%d %.8lf %.8lf %.2lf %.2lf %.2f %.2f %d",
-			val->valid,
-			val->latitude,
-			val->longitude,
-			val->altitude_wgs84ellipsoid,
-			val->altitude_egm96amsl,
-			val->horizontal_accuracy,
-			val->vertical_accuracy,
-			(val->sv_count != VMETA_LOCATION_INVALID_SV_COUNT)
-				? val->sv_count
-				: 0);
-	} else {
-		VMETA_STR_PRINT(str,
-				len,
-				maxlen,
-				"%d %.8lf %.8lf %.2lf %.2f %.2f %d",
-				0,
-				0.,
-				0.,
-				0.,
-				0.,
-				0.,
-				0);
-	}
+static const char digits_lut[200] = {
+	'0', '0', '0', '1', '0', '2', '0', '3', '0', '4', '0', '5', '0', '6',
+	'0', '7', '0', '8', '0', '9', '1', '0', '1', '1', '1', '2', '1', '3',
+	'1', '4', '1', '5', '1', '6', '1', '7', '1', '8', '1', '9', '2', '0',
+	'2', '1', '2', '2', '2', '3', '2', '4', '2', '5', '2', '6', '2', '7',
+	'2', '8', '2', '9', '3', '0', '3', '1', '3', '2', '3', '3', '3', '4',
+	'3', '5', '3', '6', '3', '7', '3', '8', '3', '9', '4', '0', '4', '1',
+	'4', '2', '4', '3', '4', '4', '4', '5', '4', '6', '4', '7', '4', '8',
+	'4', '9', '5', '0', '5', '1', '5', '2', '5', '3', '5', '4', '5', '5',
+	'5', '6', '5', '7', '5', '8', '5', '9', '6', '0', '6', '1', '6', '2',
+	'6', '3', '6', '4', '6', '5', '6', '6', '6', '7', '6', '8', '6', '9',
+	'7', '0', '7', '1', '7', '2', '7', '3', '7', '4', '7', '5', '7', '6',
+	'7', '7', '7', '8', '7', '9', '8', '0', '8', '1', '8', '2', '8', '3',
+	'8', '4', '8', '5', '8', '6', '8', '7', '8', '8', '8', '9', '9', '0',
+	'9', '1', '9', '2', '9', '3', '9', '4', '9', '5', '9', '6', '9', '7',
+	'9', '8', '9', '9',
+};
+
+
+int vmeta_csv_buf_reserve(struct vmeta_csv_buf *buf, size_t size)
+{
+	size_t new_size;
+	char *tmp;
 
-	return len;
+	if (size <= buf->size)
+		return 0;
+
+	new_size = (buf->size > 0) ? buf->size : VMETA_CSV_BUF_MIN_SIZE;
+	while (new_size < size)
+		new_size *= 2;
+	tmp = realloc(buf->str, new_size);
+	if (tmp == NULL)
+		return -ENOMEM;
+	buf->str = tmp;
+	buf->size = new_size;
+	return 0;
 }
 
 
-size_t vmeta_csv_add_quaternion(char *str,
-				size_t maxlen,
-				const struct vmeta_quaternion *val)
+void vmeta_csv_writer_init_str(struct vmeta_csv_writer *w,
+			       char *str,
+			       size_t maxlen)
 {
-	size_t len = 0;
+	memset(w, 0, sizeof(*w));
+	w->str = str;
+	w->maxlen = maxlen;
+}
 
-	VMETA_STR_PRINT(str,
-			len,
-			maxlen,
-			"%.5f %.5f %.5f %.5f",
-			val->w,
-			val->x,
-			val->y,
-			val->z);
 
-	return len;
+void vmeta_csv_writer_init_buf(struct vmeta_csv_writer *w,
+			       struct vmeta_csv_buf *buf)
+{
+	memset(w, 0, sizeof(*w));
+	w->buf = buf;
+	w->str = buf->str;
+	w->maxlen = buf->size;
+	w->len = buf->len;
+	w->shortest = 1;
 }
 
 
-size_t
-vmeta_csv_add_euler(char *str, size_t maxlen, const struct vmeta_euler *val)
+ssize_t vmeta_csv_writer_finish(struct vmeta_csv_writer *w)
 {
-	size_t len = 0;
+	struct vmeta_csv_buf *buf = w->buf;
+	size_t start;
 
-	VMETA_STR_PRINT(str,
-			len,
-			maxlen,
-			"%.4f %.4f %.4f",
-			val->yaw,
-			val->pitch,
-			val->roll);
+	if (buf == NULL) {
+		/* Null-terminate the string, even if truncated */
+		if (w->len < w->maxlen)
+			w->str[w->len] = '\0';
+		else if (w->maxlen > 0)
+			w->str[w->maxlen - 1] = '\0';
+		return (ssize_t)w->len;
+	}
 
-	return len;
+	if (w->err == 0) {
+		w->err = vmeta_csv_buf_reserve(buf, w->len + 2);
+		w->str = buf->str;
+	}
+	start = buf->len;
+	if (w->err < 0) {
+		/* Drop the partial line */
+		if (buf->str != NULL)
+			buf->str[buf->len] = '\0';
+		return w->err;
+	}
+	w->str[w->len++] = '\n';
+	w->str[w->len] = '\0';
+	buf->len = w->len;
+	return (ssize_t)(buf->len - start);
 }
 
 
-size_t vmeta_csv_add_xyz(char *str, size_t maxlen, const struct vmeta_xyz *val)
+/* Get the location to write a value to: directly in the output string if
+ * there is enough room, otherwise the tmp array */
+static char *csv_begin(struct vmeta_csv_writer *w, char *tmp)
 {
-	size_t len = 0;
+	int res;
 
-	VMETA_STR_PRINT(
-		str, len, maxlen, "%.3f %.3f %.3f", val->x, val->y, val->z);
+	if (w->buf != NULL) {
+		if (w->err < 0)
+			return tmp;
+		if (w->len + VMETA_CSV_VALUE_MAX_LEN > w->maxlen) {
+			res = vmeta_csv_buf_reserve(
+				w->buf, w->len + VMETA_CSV_VALUE_MAX_LEN);
+			if (res < 0) {
+				w->err = res;
+				return tmp;
+			}
+			w->str = w->buf->str;
+			w->maxlen = w->buf->size;
+		}
+		return w->str + w->len;
+	}
 
-	return len;
+	if (w->len + VMETA_CSV_VALUE_MAX_LEN <= w->maxlen)
+		return w->str + w->len;
+	return tmp;
 }
 
 
-size_t vmeta_csv_add_ned(char *str, size_t maxlen, const struct vmeta_ned *val)
+/* Commit a value written from start to end */
+static void
+csv_end(struct vmeta_csv_writer *w, const char *start, char *end, char *tmp)
 {
-	size_t len = 0;
+	size_t n = (size_t)(end - start);
+	size_t cpy;
 
-	VMETA_STR_PRINT(str,
-			len,
-			maxlen,
-			"%.3f %.3f %.3f",
-			val->north,
-			val->east,
-			val->down);
+	if (start == tmp && w->buf == NULL && w->len < w->maxlen) {
+		/* Truncated output, keep room for the null terminator */
+		cpy = w->maxlen - 1 - w->len;
+		memcpy(w->str + w->len, start, n < cpy ? n : cpy);
+	}
+	w->len += n;
+}
 
-	return len;
+
+static char *csv_put_sep(struct vmeta_csv_writer *w, char *p)
+{
+	if (w->count++ > 0)
+		*p++ = ' ';
+	return p;
 }
 
 
-size_t vmeta_csv_add_thermal_spot(char *str,
-				  size_t maxlen,
-				  const struct vmeta_thermal_spot *val)
+static char *csv_put_uint(char *p, uint64_t val)
 {
-	size_t len = 0;
+	char tmp[20];
+	char *q = tmp + sizeof(tmp);
+	unsigned int i;
+	size_t n;
 
-	if (val->valid) {
-		VMETA_STR_PRINT(str,
-				len,
-				maxlen,
-				"%d %.5f %.5f %.5f %" PRId32,
-				val->valid,
-				val->x,
-				val->y,
-				val->temp,
-				val->value);
+	while (val >= 100) {
+		i = (unsigned int)(val % 100) * 2;
+		val /= 100;
+		*--q = digits_lut[i + 1];
+		*--q = digits_lut[i];
+	}
+	if (val >= 10) {
+		i = (unsigned int)val * 2;
+		*--q = digits_lut[i + 1];
+		*--q = digits_lut[i];
 	} else {
-		VMETA_STR_PRINT(str,
-				len,
-				maxlen,
-				"%d %.5f %.5f %.5f %" PRId32,
-				0,
-				0.,
-				0.,
-				0.,
-				(int32_t)0);
+		*--q = '0' + (char)val;
 	}
 
-	return len;
+	n = (size_t)(tmp + sizeof(tmp) - q);
+	memcpy(p, q, n);
+	return p + n;
+}
+
+
+void vmeta_csv_add_int(struct vmeta_csv_writer *w, int64_t val)
+{
+	char tmp[VMETA_CSV_VALUE_MAX_LEN];
+	char *start = csv_begin(w, tmp);
+	char *p = csv_put_sep(w, start);
+
+	if (val < 0) {
+		*p++ = '-';
+		p = csv_put_uint(p, -(uint64_t)val);
+	} else {
+		p = csv_put_uint(p, (uint64_t)val);
+	}
+	csv_end(w, start, p, tmp);
+}
+
+
+void vmeta_csv_add_uint(struct vmeta_csv_writer *w, uint64_t val)
+{
+	char tmp[VMETA_CSV_VALUE_MAX_LEN];
+	char *start = csv_begin(w, tmp);
+	char *p = csv_put_sep(w, start);
+
+	p = csv_put_uint(p, val);
+	csv_end(w, start, p, tmp);
+}
+
+
+/* Write a value with a fixed number of decimals; values too large for
+ * VMETA_CSV_VALUE_MAX_LEN fall back to the shortest representation */
+static char *csv_put_fixed(char *p, double val, int decimals)
+{
+	const size_t maxlen = VMETA_CSV_VALUE_MAX_LEN - 1;
+	int n = snprintf(p, maxlen, "%.*f", decimals, val);
+
+	if (n < 0 || (size_t)n >= maxlen)
+		n = (int)vmeta_dtoa(val, p);
+	return p + n;
+}
+
+
+void vmeta_csv_add_float(struct vmeta_csv_writer *w, float val, int decimals)
+{
+	char tmp[VMETA_CSV_VALUE_MAX_LEN];
+	char *start = csv_begin(w, tmp);
+	char *p = csv_put_sep(w, start);
+
+	if (w->shortest)
+		p += vmeta_ftoa(val, p);
+	else
+		p = csv_put_fixed(p, val, decimals);
+	csv_end(w, start, p, tmp);
+}
+
+
+void vmeta_csv_add_double(struct vmeta_csv_writer *w,
+			  double val,
+			  int decimals)
+{
+	char tmp[VMETA_CSV_VALUE_MAX_LEN];
+	char *start = csv_begin(w, tmp);
+	char *p = csv_put_sep(w, start);
+
+	if (w->shortest)
+		p += vmeta_dtoa(val, p);
+	else
+		p = csv_put_fixed(p, val, decimals);
+	csv_end(w, start, p, tmp);
+}
+
+
+void vmeta_csv_add_location(struct vmeta_csv_writer *w,
+			    const struct vmeta_location *val)
+{
+	/* Invalid locations are written as zeros */
+	static const struct vmeta_location invalid;
+	const struct vmeta_location *loc = val->valid ? val : &invalid;
+
+	vmeta_csv_add_int(w, loc->valid);
+	vmeta_csv_add_double(w, loc->latitude, 8);
+	vmeta_csv_add_double(w, loc->longitude, 8);
+	vmeta_csv_add_double(w, loc->altitude_wgs84ellipsoid, 2);
+	vmeta_csv_add_double(w, loc->altitude_egm96amsl, 2);
+	vmeta_csv_add_float(w, loc->horizontal_accuracy, 2);
+	vmeta_csv_add_float(w, loc->vertical_accuracy, 2);
+	vmeta_csv_add_int(w,
+			  (loc->sv_count != VMETA_LOCATION_INVALID_SV_COUNT)
+				  ? loc->sv_count
+				  : 0);
+}
+
+
+void vmeta_csv_add_quaternion(struct vmeta_csv_writer *w,
+			      const struct vmeta_quaternion *val)
+{
+	vmeta_csv_add_float(w, val->w, 5);
+	vmeta_csv_add_float(w, val->x, 5);
+	vmeta_csv_add_float(w, val->y, 5);
+	vmeta_csv_add_float(w, val->z, 5);
+}
+
+
+void vmeta_csv_add_euler(struct vmeta_csv_writer *w,
+			 const struct vmeta_euler *val)
+{
+	vmeta_csv_add_float(w, val->yaw, 4);
+	vmeta_csv_add_float(w, val->pitch, 4);
+	vmeta_csv_add_float(w, val->roll, 4);
+}
+
+
+void vmeta_csv_add_xyz(struct vmeta_csv_writer *w, const struct vmeta_xyz *val)
+{
+	vmeta_csv_add_float(w, val->x, 3);
+	vmeta_csv_add_float(w, val->y, 3);
+	vmeta_csv_add_float(w, val->z, 3);
+}
+
+
+void vmeta_csv_add_ned(struct vmeta_csv_writer *w, const struct vmeta_ned *val)
+{
+	vmeta_csv_add_float(w, val->north, 3);
+	vmeta_csv_add_float(w, val->east, 3);
+	vmeta_csv_add_float(w, val->down, 3);
+}
+
+
+void vmeta_csv_add_thermal_spot(struct vmeta_csv_writer *w,
+				const struct vmeta_thermal_spot *val)
+{
+	/* Invalid spots are written as zeros */
+	static const struct vmeta_thermal_spot invalid;
+	const struct vmeta_thermal_spot *spot = val->valid ? val : &invalid;
+
+	vmeta_csv_add_int(w, spot->valid);
+	vmeta_csv_add_float(w, spot->x, 5);
+	vmeta_csv_add_float(w, spot->y, 5);
+	vmeta_csv_add_float(w, spot->temp, 5);
+	vmeta_csv_add_int(w, spot->value);
 }
@@ -28,29 +28,118 @@
 #define _VMETA_CSV_H_
 
 
-size_t vmeta_csv_add_location(char *str,
-			      size_t maxlen,
-			      const struct vmeta_location *val);
+/* Maximum length of a single CSV value, including the separator and the
+ * null terminator */
+#define VMETA_CSV_VALUE_MAX_LEN 48
 
+/* Initial allocated size of a CSV buffer */
+#define VMETA_CSV_BUF_MIN_SIZE 256
 
-size_t vmeta_csv_add_quaternion(char *str,
-				size_t maxlen,
-				const struct vmeta_quaternion *val);
 
+/* CSV writer: writes space-separated values either into a fixed-size string
+ * (with snprintf-like truncation) or at the end of a growable vmeta_csv_buf.
+ * Integers are formatted without printf; floating-point values are written
+ * either with a fixed number of decimals (using printf), or with their
+ * shortest round-trip representation (see vmeta_dtoa() and vmeta_ftoa()). */
+struct vmeta_csv_writer {
+	/* Output string and size (allocated size of the growable buffer) */
+	char *str;
+	size_t maxlen;
 
-size_t
-vmeta_csv_add_euler(char *str, size_t maxlen, const struct vmeta_euler *val);
+	/* Length of the output string; with a fixed-size string, keeps
+	 * counting past the end, so that the required length is known */
+	size_t len;
 
+	/* Growable buffer, NULL when writing to a fixed-size string */
+	struct vmeta_csv_buf *buf;
 
-size_t vmeta_csv_add_xyz(char *str, size_t maxlen, const struct vmeta_xyz *val);
+	/* Number of values written, used to insert the separators */
+	unsigned int count;
 
+	/* Shortest round-trip floating-point values instead of a fixed
+	 * number of decimals */
+	int shortest;
 
-size_t vmeta_csv_add_ned(char *str, size_t maxlen, const struct vmeta_ned *val);
+	int err;
+};
 
 
-size_t vmeta_csv_add_thermal_spot(char *str,
-				  size_t maxlen,
-				  const struct vmeta_thermal_spot *val);
+/**
+ * Make sure that a CSV buffer can hold at least size bytes.
+ * @param buf: pointer to a CSV buffer
+ * @param size: minimum allocated size
+ * @return 0 on success, negative errno value in case of error
+ */
+int vmeta_csv_buf_reserve(struct vmeta_csv_buf *buf, size_t size);
+
+
+/**
+ * Initialize a CSV writer to a fixed-size string, with a fixed number of
+ * decimals for floating-point values.
+ * @param w: pointer to the writer
+ * @param str: output string
+ * @param maxlen: size of the output string
+ */
+void vmeta_csv_writer_init_str(struct vmeta_csv_writer *w,
+			       char *str,
+			       size_t maxlen);
+
+
+/**
+ * Initialize a CSV writer appending to a growable buffer, with the shortest
+ * round-trip representation of floating-point values.
+ * @param w: pointer to the writer
+ * @param buf: output buffer
+ */
+void vmeta_csv_writer_init_buf(struct vmeta_csv_writer *w,
+			       struct vmeta_csv_buf *buf);
+
+
+/**
+ * Terminate the output of a CSV writer. With a growable buffer, a line feed
+ * is appended and the buffer length is updated.
+ * @param w: pointer to the writer
+ * @return the length written (the required length with a fixed-size string)
+ *         on success, negative errno value in case of error
+ */
+ssize_t vmeta_csv_writer_finish(struct vmeta_csv_writer *w);
+
+
+void vmeta_csv_add_int(struct vmeta_csv_writer *w, int64_t val);
+
+
+void vmeta_csv_add_uint(struct vmeta_csv_writer *w, uint64_t val);
+
+
+/* The decimals are only used in fixed-precision mode */
+void vmeta_csv_add_float(struct vmeta_csv_writer *w, float val, int decimals);
+
+
+void vmeta_csv_add_double(struct vmeta_csv_writer *w,
+			  double val,
+			  int decimals);
+
+
+void vmeta_csv_add_location(struct vmeta_csv_writer *w,
+			    const struct vmeta_location *val);
+
+
+void vmeta_csv_add_quaternion(struct vmeta_csv_writer *w,
+			      const struct vmeta_quaternion *val);
+
+
+void vmeta_csv_add_euler(struct vmeta_csv_writer *w,
+			 const struct vmeta_euler *val);
+
+
+void vmeta_csv_add_xyz(struct vmeta_csv_writer *w, const struct vmeta_xyz *val);
+
+
+void vmeta_csv_add_ned(struct vmeta_csv_writer *w, const struct vmeta_ned *val);
+
+
+void vmeta_csv_add_thermal_spot(struct vmeta_csv_writer *w,
+				const struct vmeta_thermal_spot *val);
 
 
 #endif /* !_VMETA_CSV_H_ */
@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#	define VMETA_DECODE_SIMD
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	include <arm_neon.h>
+#	define VMETA_DECODE_SIMD
+#endif
+
+
+/* SIMD helpers: 8 (or 4) big-endian 16-bit values are loaded and
+ * byte-swapped into a vector, whose low and high halves are then widened to
+ * 32 bits and converted to floats */
+
+#if defined(__SSE2__)
+
+typedef __m128i vmeta_decode_v16;
+typedef __m128i vmeta_decode_v32;
+
+
+static inline vmeta_decode_v16 vmeta_decode_bswap(__m128i v)
+{
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+
+static inline vmeta_decode_v16 vmeta_decode_load8(const uint8_t *p)
+{
+	return vmeta_decode_bswap(_mm_loadu_si128((const __m128i *)p));
+}
+
+
+static inline vmeta_decode_v16 vmeta_decode_load4(const uint8_t *p)
+{
+	return vmeta_decode_bswap(_mm_loadl_epi64((const __m128i *)p));
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_lo_i16(vmeta_decode_v16 v)
+{
+	return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_hi_i16(vmeta_decode_v16 v)
+{
+	return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_lo_u16(vmeta_decode_v16 v)
+{
+	return _mm_unpacklo_epi16(v, _mm_setzero_si128());
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_hi_u16(vmeta_decode_v16 v)
+{
+	return _mm_unpackhi_epi16(v, _mm_setzero_si128());
+}
+
+
+static inline void
+vmeta_decode_store(float *dst, const float *scale, vmeta_decode_v32 v)
+{
+	_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_loadu_ps(scale)));
+}
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+typedef uint16x8_t vmeta_decode_v16;
+typedef int32x4_t vmeta_decode_v32;
+
+
+static inline vmeta_decode_v16 vmeta_decode_load8(const uint8_t *p)
+{
+	return vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8(p)));
+}
+
+
+static inline vmeta_decode_v16 vmeta_decode_load4(const uint8_t *p)
+{
+	uint8x16_t v = vcombine_u8(vld1_u8(p), vdup_n_u8(0));
+	return vreinterpretq_u16_u8(vrev16q_u8(v));
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_lo_i16(vmeta_decode_v16 v)
+{
+	return vmovl_s16(vget_low_s16(vreinterpretq_s16_u16(v)));
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_hi_i16(vmeta_decode_v16 v)
+{
+	return vmovl_s16(vget_high_s16(vreinterpretq_s16_u16(v)));
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_lo_u16(vmeta_decode_v16 v)
+{
+	return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v)));
+}
+
+
+static inline vmeta_decode_v32 vmeta_decode_hi_u16(vmeta_decode_v16 v)
+{
+	return vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v)));
+}
+
+
+static inline void
+vmeta_decode_store(float *dst, const float *scale, vmeta_decode_v32 v)
+{
+	vst1q_f32(dst, vmulq_f32(vcvtq_f32_s32(v), vld1q_f32(scale)));
+}
+
+#endif
+
+
+void vmeta_decode_f32_i16(const uint8_t *src,
+			  const float *scale,
+			  float *dst,
+			  size_t count)
+{
+	size_t i = 0;
+
+#ifdef VMETA_DECODE_SIMD
+	vmeta_decode_v16 v;
+
+	for (; i + 8 <= count; i += 8) {
+		v = vmeta_decode_load8(&src[2 * i]);
+		vmeta_decode_store(&dst[i], &scale[i], vmeta_decode_lo_i16(v));
+		vmeta_decode_store(
+			&dst[i + 4], &scale[i + 4], vmeta_decode_hi_i16(v));
+	}
+	if (i + 4 <= count) {
+		v = vmeta_decode_load4(&src[2 * i]);
+		vmeta_decode_store(&dst[i], &scale[i], vmeta_decode_lo_i16(v));
+		i += 4;
+	}
+#endif
+
+	for (; i < count; i++)
+		dst[i] = (float)(int16_t)vmeta_load_u16(&src[2 * i]) * scale[i];
+}
+
+
+void vmeta_decode_f32_u16(const uint8_t *src,
+			  const float *scale,
+			  float *dst,
+			  size_t count)
+{
+	size_t i = 0;
+
+#ifdef VMETA_DECODE_SIMD
+	vmeta_decode_v16 v;
+
+	for (; i + 8 <= count; i += 8) {
+		v = vmeta_decode_load8(&src[2 * i]);
+		vmeta_decode_store(&dst[i], &scale[i], vmeta_decode_lo_u16(v));
+		vmeta_decode_store(
+			&dst[i + 4], &scale[i + 4], vmeta_decode_hi_u16(v));
+	}
+	if (i + 4 <= count) {
+		v = vmeta_decode_load4(&src[2 * i]);
+		vmeta_decode_store(&dst[i], &scale[i], vmeta_decode_lo_u16(v));
+		i += 4;
+	}
+#endif
+
+	for (; i < count; i++)
+		dst[i] = (float)vmeta_load_u16(&src[2 * i]) * scale[i];
+}
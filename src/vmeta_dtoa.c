@@ -0,0 +1,504 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+/* Shortest round-trip floating-point formatting, based on the Grisu2
+ * algorithm (F. Loitsch, "Printing Floating-Point Numbers Quickly and
+ * Accurately with Integers", PLDI 2010). The generated digits always read
+ * back as the exact same value, and are the shortest possible ones in the
+ * vast majority of cases. */
+
+
+#define DP_SIGNIFICAND_SIZE 52
+#define DP_EXPONENT_BIAS (0x3FF + DP_SIGNIFICAND_SIZE)
+#define DP_MIN_EXPONENT (-DP_EXPONENT_BIAS)
+#define DP_EXPONENT_MASK UINT64_C(0x7FF0000000000000)
+#define DP_SIGNIFICAND_MASK UINT64_C(0x000FFFFFFFFFFFFF)
+#define DP_HIDDEN_BIT UINT64_C(0x0010000000000000)
+
+#define SP_SIGNIFICAND_SIZE 23
+#define SP_EXPONENT_BIAS (0x7F + SP_SIGNIFICAND_SIZE)
+#define SP_MIN_EXPONENT (-SP_EXPONENT_BIAS)
+#define SP_EXPONENT_MASK UINT32_C(0x7F800000)
+#define SP_SIGNIFICAND_MASK UINT32_C(0x007FFFFF)
+#define SP_HIDDEN_BIT UINT32_C(0x00800000)
+
+#define CACHED_POWERS_MIN_EXP10 (-348)
+#define CACHED_POWERS_STEP 8
+
+
+struct diy_fp {
+	uint64_t f;
+	int e;
+};
+
+
+/* Normalized 64-bit approximations of 10^k, for k = -348 + 8 * i */
+static const struct diy_fp cached_powers[] = {
+	{UINT64_C(0xfa8fd5a0081c0288), -1220},
+	{UINT64_C(0xbaaee17fa23ebf76), -1193},
+	{UINT64_C(0x8b16fb203055ac76), -1166},
+	{UINT64_C(0xcf42894a5dce35ea), -1140},
+	{UINT64_C(0x9a6bb0aa55653b2d), -1113},
+	{UINT64_C(0xe61acf033d1a45df), -1087},
+	{UINT64_C(0xab70fe17c79ac6ca), -1060},
+	{UINT64_C(0xff77b1fcbebcdc4f), -1034},
+	{UINT64_C(0xbe5691ef416bd60c), -1007},
+	{UINT64_C(0x8dd01fad907ffc3c), -980},
+	{UINT64_C(0xd3515c2831559a83), -954},
+	{UINT64_C(0x9d71ac8fada6c9b5), -927},
+	{UINT64_C(0xea9c227723ee8bcb), -901},
+	{UINT64_C(0xaecc49914078536d), -874},
+	{UINT64_C(0x823c12795db6ce57), -847},
+	{UINT64_C(0xc21094364dfb5637), -821},
+	{UINT64_C(0x9096ea6f3848984f), -794},
+	{UINT64_C(0xd77485cb25823ac7), -768},
+	{UINT64_C(0xa086cfcd97bf97f4), -741},
+	{UINT64_C(0xef340a98172aace5), -715},
+	{UINT64_C(0xb23867fb2a35b28e), -688},
+	{UINT64_C(0x84c8d4dfd2c63f3b), -661},
+	{UINT64_C(0xc5dd44271ad3cdba), -635},
+	{UINT64_C(0x936b9fcebb25c996), -608},
+	{UINT64_C(0xdbac6c247d62a584), -582},
+	{UINT64_C(0xa3ab66580d5fdaf6), -555},
+	{UINT64_C(0xf3e2f893dec3f126), -529},
+	{UINT64_C(0xb5b5ada8aaff80b8), -502},
+	{UINT64_C(0x87625f056c7c4a8b), -475},
+	{UINT64_C(0xc9bcff6034c13053), -449},
+	{UINT64_C(0x964e858c91ba2655), -422},
+	{UINT64_C(0xdff9772470297ebd), -396},
+	{UINT64_C(0xa6dfbd9fb8e5b88f), -369},
+	{UINT64_C(0xf8a95fcf88747d94), -343},
+	{UINT64_C(0xb94470938fa89bcf), -316},
+	{UINT64_C(0x8a08f0f8bf0f156b), -289},
+	{UINT64_C(0xcdb02555653131b6), -263},
+	{UINT64_C(0x993fe2c6d07b7fac), -236},
+	{UINT64_C(0xe45c10c42a2b3b06), -210},
+	{UINT64_C(0xaa242499697392d3), -183},
+	{UINT64_C(0xfd87b5f28300ca0e), -157},
+	{UINT64_C(0xbce5086492111aeb), -130},
+	{UINT64_C(0x8cbccc096f5088cc), -103},
+	{UINT64_C(0xd1b71758e219652c), -77},
+	{UINT64_C(0x9c40000000000000), -50},
+	{UINT64_C(0xe8d4a51000000000), -24},
+	{UINT64_C(0xad78ebc5ac620000), 3},
+	{UINT64_C(0x813f3978f8940984), 30},
+	{UINT64_C(0xc097ce7bc90715b3), 56},
+	{UINT64_C(0x8f7e32ce7bea5c70), 83},
+	{UINT64_C(0xd5d238a4abe98068), 109},
+	{UINT64_C(0x9f4f2726179a2245), 136},
+	{UINT64_C(0xed63a231d4c4fb27), 162},
+	{UINT64_C(0xb0de65388cc8ada8), 189},
+	{UINT64_C(0x83c7088e1aab65db), 216},
+	{UINT64_C(0xc45d1df942711d9a), 242},
+	{UINT64_C(0x924d692ca61be758), 269},
+	{UINT64_C(0xda01ee641a708dea), 295},
+	{UINT64_C(0xa26da3999aef774a), 322},
+	{UINT64_C(0xf209787bb47d6b85), 348},
+	{UINT64_C(0xb454e4a179dd1877), 375},
+	{UINT64_C(0x865b86925b9bc5c2), 402},
+	{UINT64_C(0xc83553c5c8965d3d), 428},
+	{UINT64_C(0x952ab45cfa97a0b3), 455},
+	{UINT64_C(0xde469fbd99a05fe3), 481},
+	{UINT64_C(0xa59bc234db398c25), 508},
+	{UINT64_C(0xf6c69a72a3989f5c), 534},
+	{UINT64_C(0xb7dcbf5354e9bece), 561},
+	{UINT64_C(0x88fcf317f22241e2), 588},
+	{UINT64_C(0xcc20ce9bd35c78a5), 614},
+	{UINT64_C(0x98165af37b2153df), 641},
+	{UINT64_C(0xe2a0b5dc971f303a), 667},
+	{UINT64_C(0xa8d9d1535ce3b396), 694},
+	{UINT64_C(0xfb9b7cd9a4a7443c), 720},
+	{UINT64_C(0xbb764c4ca7a44410), 747},
+	{UINT64_C(0x8bab8eefb6409c1a), 774},
+	{UINT64_C(0xd01fef10a657842c), 800},
+	{UINT64_C(0x9b10a4e5e9913129), 827},
+	{UINT64_C(0xe7109bfba19c0c9d), 853},
+	{UINT64_C(0xac2820d9623bf429), 880},
+	{UINT64_C(0x80444b5e7aa7cf85), 907},
+	{UINT64_C(0xbf21e44003acdd2d), 933},
+	{UINT64_C(0x8e679c2f5e44ff8f), 960},
+	{UINT64_C(0xd433179d9c8cb841), 986},
+	{UINT64_C(0x9e19db92b4e31ba9), 1013},
+	{UINT64_C(0xeb96bf6ebadf77d9), 1039},
+	{UINT64_C(0xaf87023b9bf0ee6b), 1066},
+};
+
+
+static const uint64_t pow10_u64[] = {
+	UINT64_C(1),
+	UINT64_C(10),
+	UINT64_C(100),
+	UINT64_C(1000),
+	UINT64_C(10000),
+	UINT64_C(100000),
+	UINT64_C(1000000),
+	UINT64_C(10000000),
+	UINT64_C(100000000),
+	UINT64_C(1000000000),
+	UINT64_C(10000000000),
+	UINT64_C(100000000000),
+	UINT64_C(1000000000000),
+	UINT64_C(10000000000000),
+	UINT64_C(100000000000000),
+	UINT64_C(1000000000000000),
+	UINT64_C(10000000000000000),
+	UINT64_C(100000000000000000),
+	UINT64_C(1000000000000000000),
+	UINT64_C(10000000000000000000),
+};
+
+
+static struct diy_fp diy_fp_mul(struct diy_fp x, struct diy_fp y)
+{
+	const uint64_t m32 = UINT64_C(0xFFFFFFFF);
+	uint64_t a = x.f >> 32, b = x.f & m32;
+	uint64_t c = y.f >> 32, d = y.f & m32;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+	struct diy_fp r;
+
+	/* Round the 128-bit product to its 64 most significant bits */
+	tmp += UINT64_C(1) << 31;
+	r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+	r.e = x.e + y.e + 64;
+	return r;
+}
+
+
+static struct diy_fp diy_fp_normalize(struct diy_fp x)
+{
+	while (!(x.f & (UINT64_C(1) << 63))) {
+		x.f <<= 1;
+		x.e--;
+	}
+	return x;
+}
+
+
+static void diy_fp_boundaries(struct diy_fp v,
+			      uint64_t hidden_bit,
+			      struct diy_fp *m,
+			      struct diy_fp *p)
+{
+	struct diy_fp pl = {(v.f << 1) + 1, v.e - 1};
+	struct diy_fp mi;
+
+	pl = diy_fp_normalize(pl);
+
+	/* The lower boundary is closer for exact powers of two */
+	if (v.f == hidden_bit) {
+		mi.f = (v.f << 2) - 1;
+		mi.e = v.e - 2;
+	} else {
+		mi.f = (v.f << 1) - 1;
+		mi.e = v.e - 1;
+	}
+	mi.f <<= mi.e - pl.e;
+	mi.e = pl.e;
+
+	*m = mi;
+	*p = pl;
+}
+
+
+static struct diy_fp cached_power(int e, int *k)
+{
+	/* Find a cached power c = 10^-k such that the product of a number
+	 * with binary exponent e by c has its exponent in [-60, -32] */
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int ik = (int)dk;
+	unsigned int index;
+
+	if (dk - ik > 0.0)
+		ik++;
+	index = (unsigned int)((ik >> 3) + 1);
+	*k = -(CACHED_POWERS_MIN_EXP10 + (int)index * CACHED_POWERS_STEP);
+	return cached_powers[index];
+}
+
+
+static int count_decimal_digits(uint32_t n)
+{
+	int i;
+
+	for (i = 1; i < 10; i++) {
+		if (n < pow10_u64[i])
+			return i;
+	}
+	return 10;
+}
+
+
+static void grisu_round(char *digits,
+			int len,
+			uint64_t delta,
+			uint64_t rest,
+			uint64_t ten_kappa,
+			uint64_t wp_w)
+{
+	while (rest < wp_w && delta - rest >= ten_kappa &&
+	       (rest + ten_kappa < wp_w ||
+		wp_w - rest > rest + ten_kappa - wp_w)) {
+		digits[len - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+
+static int digit_gen(struct diy_fp w,
+		     struct diy_fp mp,
+		     uint64_t delta,
+		     char *digits,
+		     int *k)
+{
+	struct diy_fp one = {UINT64_C(1) << -mp.e, mp.e};
+	uint64_t wp_w = mp.f - w.f;
+	uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+	uint64_t p2 = mp.f & (one.f - 1);
+	int kappa = count_decimal_digits(p1);
+	int len = 0;
+	uint64_t tmp;
+	uint32_t d;
+	int index;
+
+	/* Integral part */
+	while (kappa > 0) {
+		d = (uint32_t)(p1 / pow10_u64[kappa - 1]);
+		p1 = (uint32_t)(p1 % pow10_u64[kappa - 1]);
+		if (d != 0 || len != 0)
+			digits[len++] = '0' + d;
+		kappa--;
+		tmp = ((uint64_t)p1 << -one.e) + p2;
+		if (tmp <= delta) {
+			*k += kappa;
+			grisu_round(digits,
+				    len,
+				    delta,
+				    tmp,
+				    pow10_u64[kappa] << -one.e,
+				    wp_w);
+			return len;
+		}
+	}
+
+	/* Fractional part */
+	for (;;) {
+		p2 *= 10;
+		delta *= 10;
+		d = (uint32_t)(p2 >> -one.e);
+		if (d != 0 || len != 0)
+			digits[len++] = '0' + d;
+		p2 &= one.f - 1;
+		kappa--;
+		if (p2 < delta) {
+			*k += kappa;
+			index = -kappa;
+			grisu_round(digits,
+				    len,
+				    delta,
+				    p2,
+				    one.f,
+				    index < 20 ? wp_w * pow10_u64[index] : 0);
+			return len;
+		}
+	}
+}
+
+
+/* Generate the shortest digits of a finite positive value v, such that
+ * v = digits * 10^k; returns the number of digits */
+static int
+grisu2(struct diy_fp v, uint64_t hidden_bit, char *digits, int *k)
+{
+	struct diy_fp w_m, w_p, c_mk, w;
+	int len;
+
+	diy_fp_boundaries(v, hidden_bit, &w_m, &w_p);
+	c_mk = cached_power(w_p.e, k);
+	w = diy_fp_mul(diy_fp_normalize(v), c_mk);
+	w_p = diy_fp_mul(w_p, c_mk);
+	w_m = diy_fp_mul(w_m, c_mk);
+	w_m.f++;
+	w_p.f--;
+
+	len = digit_gen(w, w_p, w_p.f - w_m.f, digits, k);
+
+	/* Drop trailing zeros */
+	while (len > 1 && digits[len - 1] == '0') {
+		len--;
+		(*k)++;
+	}
+	return len;
+}
+
+
+/* Write the digits * 10^k value in the same layout as printf's "%.17g":
+ * scientific notation is used when the decimal exponent is less than -4
+ * or greater than 16 */
+static char *format_digits(char *p, const char *digits, int len, int k)
+{
+	int exp10 = len + k - 1;
+	int i;
+
+	if (exp10 < -4 || exp10 > 16) {
+		*p++ = digits[0];
+		if (len > 1) {
+			*p++ = '.';
+			memcpy(p, digits + 1, len - 1);
+			p += len - 1;
+		}
+		*p++ = 'e';
+		*p++ = exp10 < 0 ? '-' : '+';
+		if (exp10 < 0)
+			exp10 = -exp10;
+		if (exp10 >= 100) {
+			*p++ = '0' + exp10 / 100;
+			exp10 %= 100;
+		}
+		*p++ = '0' + exp10 / 10;
+		*p++ = '0' + exp10 % 10;
+	} else if (k >= 0) {
+		/* Integer */
+		memcpy(p, digits, len);
+		p += len;
+		for (i = 0; i < k; i++)
+			*p++ = '0';
+	} else if (exp10 >= 0) {
+		/* Decimal point inside the digits */
+		memcpy(p, digits, exp10 + 1);
+		p += exp10 + 1;
+		*p++ = '.';
+		memcpy(p, digits + exp10 + 1, len - exp10 - 1);
+		p += len - exp10 - 1;
+	} else {
+		/* Leading zeros after the decimal point */
+		*p++ = '0';
+		*p++ = '.';
+		for (i = 0; i < -exp10 - 1; i++)
+			*p++ = '0';
+		memcpy(p, digits, len);
+		p += len;
+	}
+
+	*p = '\0';
+	return p;
+}
+
+
+/* Format the special values (NaN, infinities and zeros); returns the
+ * number of characters written, or 0 for other values */
+static size_t format_special(double val, char *str)
+{
+	char *p = str;
+
+	if (isnan(val)) {
+		return (size_t)sprintf(
+			str, "%s", signbit(val) ? "-nan" : "nan");
+	}
+	if (!isinf(val) && val != 0.)
+		return 0;
+	if (signbit(val))
+		*p++ = '-';
+	if (isinf(val)) {
+		memcpy(p, "inf", 4);
+		p += 3;
+	} else {
+		memcpy(p, "0", 2);
+		p += 1;
+	}
+	return (size_t)(p - str);
+}
+
+
+size_t vmeta_dtoa(double val, char *str)
+{
+	union {
+		double d;
+		uint64_t u;
+	} u = {.d = val};
+	int biased_e = (int)((u.u & DP_EXPONENT_MASK) >> DP_SIGNIFICAND_SIZE);
+	uint64_t significand = u.u & DP_SIGNIFICAND_MASK;
+	char digits[20];
+	char *p = str;
+	struct diy_fp v;
+	size_t len;
+	int n, k;
+
+	len = format_special(val, str);
+	if (len > 0)
+		return len;
+	if (signbit(val))
+		*p++ = '-';
+
+	if (biased_e != 0) {
+		v.f = significand + DP_HIDDEN_BIT;
+		v.e = biased_e - DP_EXPONENT_BIAS;
+	} else {
+		v.f = significand;
+		v.e = DP_MIN_EXPONENT + 1;
+	}
+
+	n = grisu2(v, DP_HIDDEN_BIT, digits, &k);
+	p = format_digits(p, digits, n, k);
+	return (size_t)(p - str);
+}
+
+
+size_t vmeta_ftoa(float val, char *str)
+{
+	union {
+		float f;
+		uint32_t u;
+	} u = {.f = val};
+	int biased_e = (int)((u.u & SP_EXPONENT_MASK) >> SP_SIGNIFICAND_SIZE);
+	uint32_t significand = u.u & SP_SIGNIFICAND_MASK;
+	char digits[20];
+	char *p = str;
+	struct diy_fp v;
+	size_t len;
+	int n, k;
+
+	len = format_special(val, str);
+	if (len > 0)
+		return len;
+	if (signbit(val))
+		*p++ = '-';
+
+	if (biased_e != 0) {
+		v.f = significand + SP_HIDDEN_BIT;
+		v.e = biased_e - SP_EXPONENT_BIAS;
+	} else {
+		v.f = significand;
+		v.e = SP_MIN_EXPONENT + 1;
+	}
+
+	n = grisu2(v, SP_HIDDEN_BIT, digits, &k);
+	p = format_digits(p, digits, n, k);
+	return (size_t)(p - str);
+}
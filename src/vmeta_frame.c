@@ -192,6 +192,14 @@ const char *vmeta_frame_type_str(enum vmeta_frame_type val)
 
 
 int vmeta_frame_write(struct vmeta_buffer *buf, struct vmeta_frame *meta)
+{
+	return vmeta_frame_write2(buf, meta, 0);
+}
+
+
+int vmeta_frame_write2(struct vmeta_buffer *buf,
+		       struct vmeta_frame *meta,
+		       int cache)
 {
 	int res = 0;
 	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
@@ -225,7 +233,7 @@ int vmeta_frame_write(struct vmeta_buffer *buf, struct vmeta_frame *meta)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_write(buf, meta);
+		res = vmeta_frame_proto_write(buf, meta, cache);
 		break;
 
 	default:
@@ -246,93 +254,135 @@ int vmeta_frame_read(struct vmeta_buffer *buf,
 }
 
 
-int vmeta_frame_read2(struct vmeta_buffer *buf,
-		      const char *mime_type,
-		      int convert,
-		      struct vmeta_frame **ret_obj)
+static int vmeta_frame_alloc(struct vmeta_frame_pool *pool,
+			     struct vmeta_frame **ret_obj)
 {
-	int res = 0;
-	size_t start = 0, len = 0;
-	uint16_t id = 0;
+	int res;
 	struct vmeta_frame *meta = NULL;
 
-	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
-
-	meta = calloc(1, sizeof(*meta));
-	if (!meta) {
-		res = -ENOMEM;
-		ULOG_ERRNO("calloc", -res);
-		goto out;
+	if (pool != NULL) {
+		res = vmeta_frame_pool_get_frame(pool, &meta);
+		if (res != 0) {
+			ULOG_ERRNO("vmeta_frame_pool_get_frame", -res);
+			return res;
+		}
+	} else {
+		meta = calloc(1, sizeof(*meta));
+		if (!meta) {
+			res = -ENOMEM;
+			ULOG_ERRNO("calloc", -res);
+			return res;
+		}
 	}
 	res = vmeta_frame_ref(meta);
 	if (res != 0) {
 		ULOG_ERRNO("vmeta_frame_ref", -res);
-		free(meta);
-		meta = NULL;
-		goto out;
+		if (pool != NULL)
+			vmeta_frame_pool_put_frame(meta);
+		else
+			free(meta);
+		return res;
 	}
 
-	if (mime_type) {
-		/* MIME type is provided. Use it to get metadata type */
+	*ret_obj = meta;
+	return 0;
+}
 
-		/* Determine type */
-		if (strcmp(mime_type, VMETA_FRAME_V1_RECORDING_MIME_TYPE) ==
-		    0) {
-			meta->type = VMETA_FRAME_TYPE_V1_RECORDING;
-		} else if (strcmp(mime_type, VMETA_FRAME_V2_MIME_TYPE) == 0) {
-			meta->type = VMETA_FRAME_TYPE_V2;
-		} else if (strcmp(mime_type, VMETA_FRAME_V3_MIME_TYPE) == 0) {
-			meta->type = VMETA_FRAME_TYPE_V3;
-		} else if (strcmp(mime_type, VMETA_FRAME_PROTO_MIME_TYPE) ==
-			   0) {
-			meta->type = VMETA_FRAME_TYPE_PROTO;
-		} else {
-			ULOGE("unknown metadata MIME type: '%s'", mime_type);
-			res = -ENOSYS;
-			goto out;
-		}
+
+static int vmeta_frame_new_internal(struct vmeta_frame_pool *pool,
+				    enum vmeta_frame_type type,
+				    struct vmeta_frame **ret_obj);
+
+
+static int vmeta_frame_convert_internal(struct vmeta_frame_pool *pool,
+					struct vmeta_frame *in_frame,
+					struct vmeta_frame **out_frame,
+					enum vmeta_frame_type out_type);
+
+
+static int vmeta_frame_type_from_mime(const char *mime_type,
+				      enum vmeta_frame_type *type)
+{
+	if (strcmp(mime_type, VMETA_FRAME_V1_RECORDING_MIME_TYPE) == 0) {
+		*type = VMETA_FRAME_TYPE_V1_RECORDING;
+	} else if (strcmp(mime_type, VMETA_FRAME_V2_MIME_TYPE) == 0) {
+		*type = VMETA_FRAME_TYPE_V2;
+	} else if (strcmp(mime_type, VMETA_FRAME_V3_MIME_TYPE) == 0) {
+		*type = VMETA_FRAME_TYPE_V3;
+	} else if (strcmp(mime_type, VMETA_FRAME_PROTO_MIME_TYPE) == 0) {
+		*type = VMETA_FRAME_TYPE_PROTO;
 	} else {
-		/* MIME type is not provided. Guess type from first 2 bytes */
+		ULOGE("unknown metadata MIME type: '%s'", mime_type);
+		return -ENOSYS;
+	}
 
-		/* Compute buffer size, read Id then rewind */
-		start = buf->pos;
-		len = buf->len - start;
-		CHECK(vmeta_read_u16(buf, &id));
-		buf->pos = start;
-
-		/* Determine type */
-		switch (id) {
-		case VMETA_FRAME_V1_STREAMING_ID:
-			if (len >= VMETA_FRAME_V1_STREAMING_EXTENDED_SIZE) {
-				meta->type =
-					VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED;
-			} else if (len >= VMETA_FRAME_V1_STREAMING_BASIC_SIZE) {
-				meta->type =
-					VMETA_FRAME_TYPE_V1_STREAMING_BASIC;
-			} else {
-				ULOGE("bad metadata streaming v1 length: %zu",
-				      len);
-				res = -EPROTO;
-				goto out;
-			}
-			break;
+	return 0;
+}
 
-		case VMETA_FRAME_V2_BASE_ID:
-			meta->type = VMETA_FRAME_TYPE_V2;
-			break;
 
-		case VMETA_FRAME_V3_BASE_ID:
-			meta->type = VMETA_FRAME_TYPE_V3;
-			break;
+static int vmeta_frame_type_guess(struct vmeta_buffer *buf,
+				  enum vmeta_frame_type *type)
+{
+	int res = 0;
+	size_t start = 0, len = 0;
+	uint16_t id = 0;
 
-		default:
-			ULOGE("unknown metadata id: 0x%04x", id);
+	/* Compute buffer size, read Id then rewind */
+	start = buf->pos;
+	len = buf->len - start;
+	CHECK(vmeta_read_u16(buf, &id));
+	buf->pos = start;
+
+	/* Determine type */
+	switch (id) {
+	case VMETA_FRAME_V1_STREAMING_ID:
+		if (len >= VMETA_FRAME_V1_STREAMING_EXTENDED_SIZE) {
+			*type = VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED;
+		} else if (len >= VMETA_FRAME_V1_STREAMING_BASIC_SIZE) {
+			*type = VMETA_FRAME_TYPE_V1_STREAMING_BASIC;
+		} else {
+			ULOGE("bad metadata streaming v1 length: %zu", len);
 			res = -EPROTO;
-			goto out;
 		}
+		break;
+
+	case VMETA_FRAME_V2_BASE_ID:
+		*type = VMETA_FRAME_TYPE_V2;
+		break;
+
+	case VMETA_FRAME_V3_BASE_ID:
+		*type = VMETA_FRAME_TYPE_V3;
+		break;
+
+	default:
+		ULOGE("unknown metadata id: 0x%04x", id);
+		res = -EPROTO;
+		break;
 	}
 
+out:
+	return res;
+}
+
+
+static int vmeta_frame_read_typed(struct vmeta_frame_pool *pool,
+				  struct vmeta_buffer *buf,
+				  enum vmeta_frame_type type,
+				  int convert,
+				  int borrow,
+				  vmeta_frame_buffer_release_cb_t release,
+				  void *userdata,
+				  struct vmeta_frame **ret_obj)
+{
+	int res = 0;
+	struct vmeta_frame *meta = NULL;
+
+	res = vmeta_frame_alloc(pool, &meta);
+	if (res != 0)
+		goto out;
+
+	meta->type = type;
+
 	switch (meta->type) {
 	case VMETA_FRAME_TYPE_NONE:
 		/* Nothing to do */
@@ -362,7 +412,10 @@ int vmeta_frame_read2(struct vmeta_buffer *buf,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_read(buf, &meta->proto);
+		if (pool != NULL)
+			meta->proto = vmeta_frame_pool_get_proto(pool);
+		res = vmeta_frame_proto_read(
+			buf, borrow, release, userdata, &meta->proto);
 		break;
 
 	default:
@@ -376,7 +429,8 @@ int vmeta_frame_read2(struct vmeta_buffer *buf,
 	/* Convert metadata to PROTO */
 	if (meta->type == VMETA_FRAME_TYPE_V3) {
 		struct vmeta_frame *proto = NULL;
-		res = vmeta_frame_convert(meta, &proto, VMETA_FRAME_TYPE_PROTO);
+		res = vmeta_frame_convert_internal(
+			pool, meta, &proto, VMETA_FRAME_TYPE_PROTO);
 		if (res != 0) {
 			/* If the conversion failed, return the non-converted
 			 * metadata */
@@ -397,26 +451,105 @@ out:
 }
 
 
-int vmeta_frame_new(enum vmeta_frame_type type, struct vmeta_frame **ret_obj)
+static int vmeta_frame_read_internal(struct vmeta_frame_pool *pool,
+				     struct vmeta_buffer *buf,
+				     const char *mime_type,
+				     int convert,
+				     int borrow,
+				     vmeta_frame_buffer_release_cb_t release,
+				     void *userdata,
+				     struct vmeta_frame **ret_obj)
 {
 	int res;
+	enum vmeta_frame_type type = VMETA_FRAME_TYPE_NONE;
 
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
 
-	struct vmeta_frame *meta = calloc(1, sizeof(*meta));
-	if (!meta) {
-		res = -ENOMEM;
-		ULOG_ERRNO("calloc", -res);
-		goto out;
+	if (mime_type) {
+		/* MIME type is provided. Use it to get metadata type */
+		res = vmeta_frame_type_from_mime(mime_type, &type);
+	} else {
+		/* MIME type is not provided. Guess type from first 2 bytes */
+		res = vmeta_frame_type_guess(buf, &type);
 	}
-	res = vmeta_frame_ref(meta);
 	if (res != 0) {
-		ULOG_ERRNO("vmeta_frame_ref", -res);
-		free(meta);
-		meta = NULL;
-		goto out;
+		*ret_obj = NULL;
+		return res;
 	}
 
+	return vmeta_frame_read_typed(
+		pool, buf, type, convert, borrow, release, userdata, ret_obj);
+}
+
+
+int vmeta_frame_read2(struct vmeta_buffer *buf,
+		      const char *mime_type,
+		      int convert,
+		      struct vmeta_frame **ret_obj)
+{
+	return vmeta_frame_read_internal(
+		NULL, buf, mime_type, convert, 0, NULL, NULL, ret_obj);
+}
+
+
+static int vmeta_frame_read_borrowed_internal(
+	struct vmeta_frame_pool *pool,
+	struct vmeta_buffer *buf,
+	const char *mime_type,
+	int convert,
+	vmeta_frame_buffer_release_cb_t release,
+	void *userdata,
+	struct vmeta_frame **ret_obj)
+{
+	int res;
+	const uint8_t *data;
+
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+
+	data = buf->cdata;
+	res = vmeta_frame_read_internal(
+		pool, buf, mime_type, convert, 1, release, userdata, ret_obj);
+	if (res != 0)
+		return res;
+
+	/* The data is only kept by unconverted protobuf-based metadata;
+	 * otherwise it can be released right away */
+	if ((*ret_obj)->type != VMETA_FRAME_TYPE_PROTO ||
+	    !vmeta_frame_proto_is_borrowed((*ret_obj)->proto)) {
+		if (release)
+			release(data, userdata);
+	}
+
+	return 0;
+}
+
+
+int vmeta_frame_read_borrowed(struct vmeta_buffer *buf,
+			      const char *mime_type,
+			      int convert,
+			      vmeta_frame_buffer_release_cb_t release,
+			      void *userdata,
+			      struct vmeta_frame **ret_obj)
+{
+	return vmeta_frame_read_borrowed_internal(
+		NULL, buf, mime_type, convert, release, userdata, ret_obj);
+}
+
+
+static int vmeta_frame_new_internal(struct vmeta_frame_pool *pool,
+				    enum vmeta_frame_type type,
+				    struct vmeta_frame **ret_obj)
+{
+	int res;
+	struct vmeta_frame *meta = NULL;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	res = vmeta_frame_alloc(pool, &meta);
+	if (res != 0)
+		goto out;
+
 	meta->type = type;
 
 	switch (meta->type) {
@@ -430,6 +563,8 @@ int vmeta_frame_new(enum vmeta_frame_type type, struct vmeta_frame **ret_obj)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
+		if (pool != NULL)
+			meta->proto = vmeta_frame_pool_get_proto(pool);
 		res = vmeta_frame_proto_init(&meta->proto);
 		break;
 
@@ -449,6 +584,181 @@ out:
 }
 
 
+int vmeta_frame_new(enum vmeta_frame_type type, struct vmeta_frame **ret_obj)
+{
+	return vmeta_frame_new_internal(NULL, type, ret_obj);
+}
+
+
+int vmeta_frame_pool_frame_new(struct vmeta_frame_pool *pool,
+			       enum vmeta_frame_type type,
+			       struct vmeta_frame **ret_obj)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+
+	return vmeta_frame_new_internal(pool, type, ret_obj);
+}
+
+
+int vmeta_frame_pool_frame_read(struct vmeta_frame_pool *pool,
+				struct vmeta_buffer *buf,
+				const char *mime_type,
+				int convert,
+				struct vmeta_frame **ret_obj)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+
+	return vmeta_frame_read_internal(
+		pool, buf, mime_type, convert, 0, NULL, NULL, ret_obj);
+}
+
+
+int vmeta_frame_pool_frame_read_borrowed(
+	struct vmeta_frame_pool *pool,
+	struct vmeta_buffer *buf,
+	const char *mime_type,
+	int convert,
+	vmeta_frame_buffer_release_cb_t release,
+	void *userdata,
+	struct vmeta_frame **ret_obj)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+
+	return vmeta_frame_read_borrowed_internal(
+		pool, buf, mime_type, convert, release, userdata, ret_obj);
+}
+
+
+struct vmeta_frame_reader {
+	/* Metadata type resolved from the MIME type (if type_resolved is
+	 * not set, the type is guessed from each buffer) */
+	int type_resolved;
+	enum vmeta_frame_type type;
+
+	int convert;
+	struct vmeta_frame_pool *pool;
+};
+
+
+int vmeta_frame_reader_new(const char *mime_type,
+			   int convert,
+			   struct vmeta_frame_pool *pool,
+			   struct vmeta_frame_reader **ret_obj)
+{
+	int res;
+	struct vmeta_frame_reader *reader;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	reader = calloc(1, sizeof(*reader));
+	if (reader == NULL) {
+		res = -ENOMEM;
+		ULOG_ERRNO("calloc", -res);
+		return res;
+	}
+	reader->convert = convert;
+	reader->pool = pool;
+
+	if (mime_type != NULL) {
+		res = vmeta_frame_type_from_mime(mime_type, &reader->type);
+		if (res != 0) {
+			free(reader);
+			return res;
+		}
+		reader->type_resolved = 1;
+	}
+
+	*ret_obj = reader;
+	return 0;
+}
+
+
+int vmeta_frame_reader_destroy(struct vmeta_frame_reader *reader)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(reader == NULL, EINVAL);
+
+	free(reader);
+
+	return 0;
+}
+
+
+int vmeta_frame_reader_read(struct vmeta_frame_reader *reader,
+			    struct vmeta_buffer *buf,
+			    struct vmeta_frame **ret_obj)
+{
+	int res;
+	enum vmeta_frame_type type;
+
+	ULOG_ERRNO_RETURN_ERR_IF(reader == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	if (reader->type_resolved) {
+		type = reader->type;
+	} else {
+		res = vmeta_frame_type_guess(buf, &type);
+		if (res != 0) {
+			*ret_obj = NULL;
+			return res;
+		}
+	}
+
+	return vmeta_frame_read_typed(reader->pool,
+				      buf,
+				      type,
+				      reader->convert,
+				      0,
+				      NULL,
+				      NULL,
+				      ret_obj);
+}
+
+
+ssize_t vmeta_frame_read_batch(struct vmeta_frame_reader *reader,
+			       struct vmeta_buffer *bufs,
+			       size_t count,
+			       struct vmeta_frame **frames)
+{
+	int res, first_err = 0;
+	size_t i, read_count = 0, err_count = 0, first_err_idx = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(reader == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(bufs == NULL && count > 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(frames == NULL && count > 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(count > SSIZE_MAX, EINVAL);
+
+	for (i = 0; i < count; i++) {
+		res = vmeta_frame_reader_read(reader, &bufs[i], &frames[i]);
+		if (res == 0) {
+			read_count++;
+			continue;
+		}
+		frames[i] = NULL;
+		/* Empty samples are not errors */
+		if (res == -ENODATA)
+			continue;
+		if (err_count++ == 0) {
+			first_err = res;
+			first_err_idx = i;
+		}
+	}
+
+	/* Log errors once per batch */
+	if (err_count > 0) {
+		ULOGE("%s: failed to read %zu of %zu frames "
+		      "(first error on frame %zu: %s)",
+		      __func__,
+		      err_count,
+		      count,
+		      first_err_idx,
+		      strerror(-first_err));
+	}
+
+	return (ssize_t)read_count;
+}
+
+
 int vmeta_frame_ref(struct vmeta_frame *meta)
 {
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
@@ -484,6 +794,12 @@ int vmeta_frame_unref(struct vmeta_frame *meta)
 	if (ref > 0)
 		goto out;
 
+	/* Return the structure to its pool */
+	if (meta->pool != NULL) {
+		res = vmeta_frame_pool_put_frame(meta);
+		goto out;
+	}
+
 	switch (meta->type) {
 	case VMETA_FRAME_TYPE_NONE:
 	case VMETA_FRAME_TYPE_V1_RECORDING:
@@ -530,11 +846,10 @@ int vmeta_frame_get_ref_count(struct vmeta_frame *meta)
 }
 
 
-int vmeta_frame_to_json(struct vmeta_frame *meta, struct json_object *jobj)
+int vmeta_frame_to_json_writer(struct vmeta_frame *meta,
+			       struct vmeta_json_writer *w)
 {
 	int res = 0;
-	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(jobj == NULL, EINVAL);
 
 	switch (meta->type) {
 	case VMETA_FRAME_TYPE_NONE:
@@ -542,29 +857,29 @@ int vmeta_frame_to_json(struct vmeta_frame *meta, struct json_object *jobj)
 		break;
 
 	case VMETA_FRAME_TYPE_V1_RECORDING:
-		res = vmeta_frame_v1_recording_to_json(&meta->v1_rec, jobj);
+		res = vmeta_frame_v1_recording_to_json_writer(&meta->v1_rec, w);
 		break;
 
 	case VMETA_FRAME_TYPE_V1_STREAMING_BASIC:
-		res = vmeta_frame_v1_streaming_basic_to_json(
-			&meta->v1_strm_basic, jobj);
+		res = vmeta_frame_v1_streaming_basic_to_json_writer(
+			&meta->v1_strm_basic, w);
 		break;
 
 	case VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED:
-		res = vmeta_frame_v1_streaming_extended_to_json(
-			&meta->v1_strm_ext, jobj);
+		res = vmeta_frame_v1_streaming_extended_to_json_writer(
+			&meta->v1_strm_ext, w);
 		break;
 
 	case VMETA_FRAME_TYPE_V2:
-		res = vmeta_frame_v2_to_json(&meta->v2, jobj);
+		res = vmeta_frame_v2_to_json_writer(&meta->v2, w);
 		break;
 
 	case VMETA_FRAME_TYPE_V3:
-		res = vmeta_frame_v3_to_json(&meta->v3, jobj);
+		res = vmeta_frame_v3_to_json_writer(&meta->v3, w);
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_to_json(meta, jobj);
+		res = vmeta_frame_proto_to_json(meta, w);
 		break;
 
 	default:
@@ -577,38 +892,80 @@ int vmeta_frame_to_json(struct vmeta_frame *meta, struct json_object *jobj)
 }
 
 
+int vmeta_frame_to_json(struct vmeta_frame *meta, struct json_object *jobj)
+{
+	struct vmeta_json_writer w;
+	int res;
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(jobj == NULL, EINVAL);
+
+	vmeta_json_writer_init_object(&w, jobj);
+	res = vmeta_frame_to_json_writer(meta, &w);
+	if (res < 0)
+		return res;
+	return vmeta_json_writer_finish(&w);
+}
+
+
+static ssize_t vmeta_frame_to_json_text(struct vmeta_frame *meta,
+					struct vmeta_json_writer *w)
+{
+	int res;
+
+	vmeta_json_begin_object(w, NULL);
+	res = vmeta_frame_to_json_writer(meta, w);
+	if (res < 0)
+		return res;
+	vmeta_json_end_object(w);
+	return vmeta_json_writer_finish(w);
+}
+
+
 int vmeta_frame_to_json_str(struct vmeta_frame *meta,
 			    char *output,
 			    unsigned int len)
 {
+	ssize_t res;
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(output == NULL, EINVAL);
 
-	const char *jstr;
-	struct json_object *jobj = json_object_new_object();
-	if (jobj == NULL)
-		return -ENOMEM;
-	int ret = vmeta_frame_to_json(meta, jobj);
-	if (ret < 0)
-		goto out;
+	res = vmeta_frame_to_json_buf(meta, output, len);
+	return (res < 0) ? (int)res : 0;
+}
 
-	jstr = json_object_to_json_string(jobj);
-	if (strlen(jstr) + 1 > len) {
-		ret = -ENOBUFS;
-		goto out;
-	}
-	strcpy(output, jstr);
 
-out:
-	json_object_put(jobj);
-	return ret;
+ssize_t vmeta_frame_to_json_buf(struct vmeta_frame *meta,
+				char *str,
+				size_t maxlen)
+{
+	struct vmeta_json_writer w;
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(str == NULL, EINVAL);
+
+	vmeta_json_writer_init_buffer(&w, str, maxlen);
+	return vmeta_frame_to_json_text(meta, &w);
+}
+
+
+ssize_t vmeta_frame_to_json_stream(struct vmeta_frame *meta,
+				   vmeta_json_sink_t sink,
+				   void *userdata)
+{
+	struct vmeta_json_writer w;
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(sink == NULL, EINVAL);
+
+	vmeta_json_writer_init_sink(&w, sink, userdata);
+	return vmeta_frame_to_json_text(meta, &w);
 }
 
 
 ssize_t
 vmeta_frame_to_csv(const struct vmeta_frame *meta, char *str, size_t maxlen)
 {
+	int res;
 	size_t len = 0;
+	struct vmeta_csv_writer w;
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(str == NULL, EINVAL);
 
@@ -641,7 +998,13 @@ vmeta_frame_to_csv(const struct vmeta_frame *meta, char *str, size_t maxlen)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		len = (size_t)-ENOSYS;
+		/* Reading protobuf-based metadata only updates its internal
+		 * unpacking state, the metadata itself is left unchanged */
+		vmeta_csv_writer_init_str(&w, str, maxlen);
+		res = vmeta_frame_proto_to_csv((struct vmeta_frame *)meta, &w);
+		if (res < 0)
+			return res;
+		len = (size_t)vmeta_csv_writer_finish(&w);
 		break;
 
 	default:
@@ -685,7 +1048,7 @@ vmeta_frame_csv_header(enum vmeta_frame_type type, char *str, size_t maxlen)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		len = (size_t)-ENOSYS;
+		len = vmeta_frame_proto_csv_header(str, maxlen);
 		break;
 
 	default:
@@ -697,6 +1060,95 @@ vmeta_frame_csv_header(enum vmeta_frame_type type, char *str, size_t maxlen)
 }
 
 
+ssize_t vmeta_frame_csv_append(struct vmeta_frame *meta,
+			       struct vmeta_csv_buf *buf)
+{
+	int res = 0;
+	struct vmeta_csv_writer w;
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+
+	vmeta_csv_writer_init_buf(&w, buf);
+
+	switch (meta->type) {
+	case VMETA_FRAME_TYPE_NONE:
+		/* Nothing to do */
+		break;
+
+	case VMETA_FRAME_TYPE_V1_RECORDING:
+		vmeta_frame_v1_recording_to_csv_writer(&meta->v1_rec, &w);
+		break;
+
+	case VMETA_FRAME_TYPE_V1_STREAMING_BASIC:
+		vmeta_frame_v1_streaming_basic_to_csv_writer(
+			&meta->v1_strm_basic, &w);
+		break;
+
+	case VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED:
+		vmeta_frame_v1_streaming_extended_to_csv_writer(
+			&meta->v1_strm_ext, &w);
+		break;
+
+	case VMETA_FRAME_TYPE_V2:
+		vmeta_frame_v2_to_csv_writer(&meta->v2, &w);
+		break;
+
+	case VMETA_FRAME_TYPE_V3:
+		vmeta_frame_v3_to_csv_writer(&meta->v3, &w);
+		break;
+
+	case VMETA_FRAME_TYPE_PROTO:
+		res = vmeta_frame_proto_to_csv(meta, &w);
+		break;
+
+	default:
+		ULOGE("unknown metadata type: %u", meta->type);
+		return -ENOSYS;
+	}
+
+	if (res < 0 && w.err == 0)
+		w.err = res;
+
+	return vmeta_csv_writer_finish(&w);
+}
+
+
+ssize_t vmeta_frame_csv_header_append(enum vmeta_frame_type type,
+				      struct vmeta_csv_buf *buf)
+{
+	int res;
+	ssize_t len;
+	size_t avail;
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+
+	res = vmeta_csv_buf_reserve(buf, buf->len + VMETA_CSV_BUF_MIN_SIZE);
+	if (res < 0)
+		return res;
+
+	for (;;) {
+		avail = buf->size - buf->len;
+		len = vmeta_frame_csv_header(type, buf->str + buf->len, avail);
+		if (len < 0) {
+			buf->str[buf->len] = '\0';
+			return len;
+		}
+		/* Keep room for the line feed and the null terminator */
+		if ((size_t)len + 2 <= avail)
+			break;
+		res = vmeta_csv_buf_reserve(buf, buf->len + len + 2);
+		if (res < 0) {
+			buf->str[buf->len] = '\0';
+			return res;
+		}
+	}
+
+	buf->len += len;
+	buf->str[buf->len++] = '\n';
+	buf->str[buf->len] = '\0';
+	return len + 1;
+}
+
+
 const char *vmeta_frame_get_mime_type(enum vmeta_frame_type type)
 {
 	switch (type) {
@@ -1307,6 +1759,16 @@ out:
 int vmeta_frame_convert(struct vmeta_frame *in_frame,
 			struct vmeta_frame **out_frame,
 			enum vmeta_frame_type out_type)
+{
+	return vmeta_frame_convert_internal(
+		NULL, in_frame, out_frame, out_type);
+}
+
+
+static int vmeta_frame_convert_internal(struct vmeta_frame_pool *pool,
+					struct vmeta_frame *in_frame,
+					struct vmeta_frame **out_frame,
+					enum vmeta_frame_type out_type)
 {
 	int res;
 	struct vmeta_frame *new = NULL;
@@ -1330,7 +1792,7 @@ int vmeta_frame_convert(struct vmeta_frame *in_frame,
 	 * test in_frame->type & out_type here since they are checked in the
 	 * ULOG_ERRNO_RETURN_ERR_IF(...) blocks */
 
-	res = vmeta_frame_new(out_type, &new);
+	res = vmeta_frame_new_internal(pool, out_type, &new);
 	if (res != 0)
 		goto out;
 
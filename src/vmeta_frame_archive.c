@@ -0,0 +1,902 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _FILE_OFFSET_BITS
+#	define _FILE_OFFSET_BITS 64
+#endif
+
+#include "vmeta_priv.h"
+
+#ifndef _WIN32
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/types.h>
+#	include <unistd.h>
+#endif /* !_WIN32 */
+
+
+#define VMETA_FRAME_ARCHIVE_MAGIC "VMFA"
+#define VMETA_FRAME_ARCHIVE_VERSION 1
+#define VMETA_FRAME_ARCHIVE_BYTE_ORDER 0x01020304
+#define VMETA_FRAME_ARCHIVE_DEFAULT_BLOCK_ROWS 4096
+
+/* Alignment of the blocks and of the columns in a block */
+#define VMETA_FRAME_ARCHIVE_ALIGN 64
+
+
+/* File header; all values are in the host byte order */
+struct vmeta_frame_archive_header {
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint32_t byte_order;
+	uint32_t column_count;
+	uint64_t block_rows;
+	uint64_t block_size;
+
+	/* Offsets (bytes from the start of the file) and sizes of the column
+	 * schema (column_count vmeta_frame_archive_column entries), the
+	 * session metadata (null-terminated key and value strings of the
+	 * MP4 recording items) and the first block */
+	uint64_t schema_offset;
+	uint64_t session_offset;
+	uint64_t session_size;
+	uint64_t data_offset;
+
+	/* Number of rows; written last when flushing */
+	uint64_t row_count;
+};
+
+
+/* Column schema entry */
+struct vmeta_frame_archive_column {
+	/* Column (enum vmeta_frame_table_column) */
+	uint32_t column;
+
+	/* Value type (enum vmeta_frame_table_type) and size (bytes) */
+	uint32_t type;
+	uint32_t size;
+	uint32_t reserved;
+
+	/* Offsets of the values and of the presence bitmap in a block */
+	uint64_t values_offset;
+	uint64_t presence_offset;
+};
+
+
+struct vmeta_frame_archive_writer {
+	FILE *file;
+	struct vmeta_frame_archive_header hdr;
+	struct vmeta_frame_archive_column
+		columns[VMETA_FRAME_TABLE_COLUMN_COUNT];
+
+	/* Current block, and number of rows including the rows not yet
+	 * written to the file */
+	uint8_t *block;
+	uint64_t row_count;
+};
+
+
+struct vmeta_frame_archive {
+	char *path;
+
+	/* File contents */
+	const uint8_t *data;
+	size_t size;
+	int mapped;
+
+	const struct vmeta_frame_archive_header *hdr;
+	uint64_t row_count;
+
+	/* Schema entry of each column (NULL if not in the archive) */
+	const struct vmeta_frame_archive_column
+		*columns[VMETA_FRAME_TABLE_COLUMN_COUNT];
+};
+
+
+/* Session metadata serialization buffer */
+struct vmeta_frame_archive_session_buf {
+	char *str;
+	size_t len;
+	size_t size;
+	int err;
+};
+
+
+static inline uint64_t align_up(uint64_t val)
+{
+	return (val + VMETA_FRAME_ARCHIVE_ALIGN - 1) &
+	       ~(uint64_t)(VMETA_FRAME_ARCHIVE_ALIGN - 1);
+}
+
+
+static void session_item_cb(enum vmeta_record_type type,
+			    const char *key,
+			    const char *value,
+			    void *userdata)
+{
+	struct vmeta_frame_archive_session_buf *buf = userdata;
+	size_t key_len = strlen(key) + 1;
+	size_t value_len = strlen(value) + 1;
+
+	if (buf->err != 0)
+		return;
+
+	if (buf->len + key_len + value_len > buf->size) {
+		size_t size = 2 * (buf->len + key_len + value_len);
+		char *str = realloc(buf->str, size);
+		if (str == NULL) {
+			buf->err = -ENOMEM;
+			return;
+		}
+		buf->str = str;
+		buf->size = size;
+	}
+	memcpy(buf->str + buf->len, key, key_len);
+	buf->len += key_len;
+	memcpy(buf->str + buf->len, value, value_len);
+	buf->len += value_len;
+}
+
+
+/* Fill the column schema and the block layout of a header */
+static void writer_set_layout(struct vmeta_frame_archive_writer *writer,
+			      uint64_t block_rows)
+{
+	uint64_t offset = 0;
+
+	writer->hdr.block_rows = block_rows;
+	writer->hdr.column_count = VMETA_FRAME_TABLE_COLUMN_COUNT;
+	for (unsigned int i = 0; i < VMETA_FRAME_TABLE_COLUMN_COUNT; i++) {
+		const struct vmeta_frame_table_column_desc *desc =
+			&vmeta_frame_table_columns[i];
+		struct vmeta_frame_archive_column *col = &writer->columns[i];
+
+		col->column = i;
+		col->type = desc->type;
+		col->size = desc->size;
+		col->values_offset = offset;
+		offset = align_up(offset + desc->size * block_rows);
+		col->presence_offset = offset;
+		offset = align_up(offset + (block_rows + 7) / 8);
+	}
+	writer->hdr.block_size = offset;
+}
+
+
+/* Seek to a 64-bit file offset; offsets that the platform file position
+ * type cannot represent are rejected instead of being truncated */
+static int file_seek(FILE *f, uint64_t offset)
+{
+	int res;
+
+#ifndef _WIN32
+	if (offset > ((sizeof(off_t) < 8) ? (uint64_t)INT32_MAX
+					  : (uint64_t)INT64_MAX))
+		return -EFBIG;
+	res = fseeko(f, (off_t)offset, SEEK_SET);
+#else /* _WIN32 */
+	if (offset > (uint64_t)INT64_MAX)
+		return -EFBIG;
+	res = _fseeki64(f, (__int64)offset, SEEK_SET);
+#endif /* _WIN32 */
+	if (res != 0)
+		return -EIO;
+	return 0;
+}
+
+
+/* Get the size of a file and seek back to its start */
+static int file_get_size(FILE *f, uint64_t *size)
+{
+#ifndef _WIN32
+	off_t end;
+
+	if ((fseeko(f, 0, SEEK_END) != 0) || ((end = ftello(f)) < 0) ||
+	    (fseeko(f, 0, SEEK_SET) != 0))
+		return -EIO;
+#else /* _WIN32 */
+	__int64 end;
+
+	if ((_fseeki64(f, 0, SEEK_END) != 0) || ((end = _ftelli64(f)) < 0) ||
+	    (_fseeki64(f, 0, SEEK_SET) != 0))
+		return -EIO;
+#endif /* _WIN32 */
+	*size = (uint64_t)end;
+	return 0;
+}
+
+
+static int writer_write_at(struct vmeta_frame_archive_writer *writer,
+			   uint64_t offset,
+			   const void *data,
+			   size_t size)
+{
+	int res;
+
+	res = file_seek(writer->file, offset);
+	if (res < 0) {
+		ULOG_ERRNO("file_seek", -res);
+		return res;
+	}
+	if (fwrite(data, size, 1, writer->file) != 1) {
+		ULOG_ERRNO("fwrite", EIO);
+		return -EIO;
+	}
+	return 0;
+}
+
+
+/* Write the current block */
+static int writer_write_block(struct vmeta_frame_archive_writer *writer)
+{
+	uint64_t block = (writer->row_count - 1) / writer->hdr.block_rows;
+
+	return writer_write_at(writer,
+			       writer->hdr.data_offset +
+				       block * writer->hdr.block_size,
+			       writer->block,
+			       writer->hdr.block_size);
+}
+
+
+static int writer_alloc_block(struct vmeta_frame_archive_writer *writer)
+{
+	writer->block = calloc(1, writer->hdr.block_size);
+	if (writer->block == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+
+int vmeta_frame_archive_writer_new(const char *path,
+				   const struct vmeta_session *session,
+				   size_t block_rows,
+				   struct vmeta_frame_archive_writer **ret_obj)
+{
+	int res;
+	struct vmeta_frame_archive_writer *writer;
+	struct vmeta_frame_archive_session_buf session_buf = {0};
+
+	ULOG_ERRNO_RETURN_ERR_IF(path == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	if (block_rows == 0)
+		block_rows = VMETA_FRAME_ARCHIVE_DEFAULT_BLOCK_ROWS;
+
+	if (session != NULL) {
+		res = vmeta_session_recording_write(
+			session, session_item_cb, &session_buf);
+		if (res == 0)
+			res = session_buf.err;
+		if (res < 0) {
+			ULOG_ERRNO("vmeta_session_recording_write", -res);
+			free(session_buf.str);
+			return res;
+		}
+	}
+
+	writer = calloc(1, sizeof(*writer));
+	if (writer == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		free(session_buf.str);
+		return -ENOMEM;
+	}
+
+	memcpy(writer->hdr.magic, VMETA_FRAME_ARCHIVE_MAGIC, 4);
+	writer->hdr.version = VMETA_FRAME_ARCHIVE_VERSION;
+	writer->hdr.header_size = sizeof(writer->hdr);
+	writer->hdr.byte_order = VMETA_FRAME_ARCHIVE_BYTE_ORDER;
+	writer_set_layout(writer, block_rows);
+	writer->hdr.schema_offset = align_up(sizeof(writer->hdr));
+	writer->hdr.session_offset =
+		writer->hdr.schema_offset + sizeof(writer->columns);
+	writer->hdr.session_size = session_buf.len;
+	writer->hdr.data_offset = align_up(writer->hdr.session_offset +
+					   writer->hdr.session_size);
+
+	res = writer_alloc_block(writer);
+	if (res < 0)
+		goto error;
+
+	writer->file = fopen(path, "w+b");
+	if (writer->file == NULL) {
+		res = -errno;
+		ULOG_ERRNO("fopen '%s'", -res, path);
+		goto error;
+	}
+
+	res = writer_write_at(writer, 0, &writer->hdr, sizeof(writer->hdr));
+	if (res < 0)
+		goto error;
+	res = writer_write_at(writer,
+			      writer->hdr.schema_offset,
+			      writer->columns,
+			      sizeof(writer->columns));
+	if (res < 0)
+		goto error;
+	if (session_buf.len > 0) {
+		res = writer_write_at(writer,
+				      writer->hdr.session_offset,
+				      session_buf.str,
+				      session_buf.len);
+		if (res < 0)
+			goto error;
+	}
+	if (fflush(writer->file) != 0) {
+		res = -EIO;
+		ULOG_ERRNO("fflush", -res);
+		goto error;
+	}
+
+	free(session_buf.str);
+	*ret_obj = writer;
+	return 0;
+
+error:
+	free(session_buf.str);
+	vmeta_frame_archive_writer_destroy(writer);
+	return res;
+}
+
+
+/* Check the header and the schema of an archive; returns the number of rows
+ * that can be read within the given size */
+static int check_archive(const struct vmeta_frame_archive_header *hdr,
+			 const uint8_t *data,
+			 uint64_t size,
+			 uint64_t *row_count)
+{
+	uint64_t blocks, rows;
+	uint64_t schema_size;
+
+	if ((size < sizeof(*hdr)) ||
+	    (memcmp(hdr->magic, VMETA_FRAME_ARCHIVE_MAGIC, 4) != 0) ||
+	    (hdr->version != VMETA_FRAME_ARCHIVE_VERSION) ||
+	    (hdr->byte_order != VMETA_FRAME_ARCHIVE_BYTE_ORDER)) {
+		ULOGE("invalid archive header (or archive created on a host "
+		      "with a different byte order)");
+		return -EPROTO;
+	}
+
+	schema_size = (uint64_t)hdr->column_count *
+		      sizeof(struct vmeta_frame_archive_column);
+	/* Offsets are compared to the size before adding the lengths to
+	 * avoid overflows with corrupted headers */
+	if ((hdr->block_rows == 0) || (hdr->block_size == 0) ||
+	    (hdr->schema_offset % 8 != 0) || (hdr->schema_offset > size) ||
+	    (schema_size > size - hdr->schema_offset) ||
+	    (hdr->session_offset > size) ||
+	    (hdr->session_size > size - hdr->session_offset) ||
+	    (hdr->data_offset % VMETA_FRAME_ARCHIVE_ALIGN != 0) ||
+	    (hdr->block_size % VMETA_FRAME_ARCHIVE_ALIGN != 0) ||
+	    (hdr->data_offset > size)) {
+		ULOGE("invalid archive layout");
+		return -EPROTO;
+	}
+
+	if (data != NULL) {
+		const struct vmeta_frame_archive_column *cols =
+			(const void *)(data + hdr->schema_offset);
+		for (uint32_t i = 0; i < hdr->column_count; i++) {
+			uint64_t n = hdr->block_rows;
+			if ((cols[i].size == 0) ||
+			    (cols[i].values_offset % cols[i].size != 0) ||
+			    (cols[i].values_offset > hdr->block_size) ||
+			    (n > (hdr->block_size - cols[i].values_offset) /
+					 cols[i].size) ||
+			    (cols[i].presence_offset > hdr->block_size) ||
+			    ((n + 7) / 8 >
+			     hdr->block_size - cols[i].presence_offset)) {
+				ULOGE("invalid archive column %" PRIu32, i);
+				return -EPROTO;
+			}
+		}
+	}
+
+	/* Only the complete blocks are readable */
+	blocks = (size - hdr->data_offset) / hdr->block_size;
+	rows = blocks * hdr->block_rows;
+	*row_count = (hdr->row_count < rows) ? hdr->row_count : rows;
+	return 0;
+}
+
+
+int vmeta_frame_archive_writer_open(const char *path,
+				    struct vmeta_frame_archive_writer **ret_obj)
+{
+	int res;
+	uint64_t size, rows, block_size;
+	uint32_t column_count;
+	struct vmeta_frame_archive_writer *writer;
+	struct vmeta_frame_archive_column
+		columns[VMETA_FRAME_TABLE_COLUMN_COUNT];
+
+	ULOG_ERRNO_RETURN_ERR_IF(path == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	writer = calloc(1, sizeof(*writer));
+	if (writer == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	writer->file = fopen(path, "r+b");
+	if (writer->file == NULL) {
+		res = -errno;
+		ULOG_ERRNO("fopen '%s'", -res, path);
+		goto error;
+	}
+	if ((file_get_size(writer->file, &size) < 0) ||
+	    (fread(&writer->hdr, sizeof(writer->hdr), 1, writer->file) != 1)) {
+		res = -EPROTO;
+		ULOGE("'%s': invalid archive file", path);
+		goto error;
+	}
+	res = check_archive(&writer->hdr, NULL, size, &rows);
+	if (res < 0)
+		goto error;
+
+	/* Rows can only be appended with the same columns; the on-disk
+	 * column count and block size are saved before the layout is
+	 * recomputed into the header */
+	column_count = writer->hdr.column_count;
+	block_size = writer->hdr.block_size;
+	writer_set_layout(writer, writer->hdr.block_rows);
+	if ((column_count != writer->hdr.column_count) ||
+	    (block_size != writer->hdr.block_size) ||
+	    (file_seek(writer->file, writer->hdr.schema_offset) < 0) ||
+	    (fread(columns, sizeof(columns), 1, writer->file) != 1) ||
+	    (memcmp(columns, writer->columns, sizeof(columns)) != 0)) {
+		res = -EPROTO;
+		ULOGE("'%s': incompatible archive columns", path);
+		goto error;
+	}
+
+	res = writer_alloc_block(writer);
+	if (res < 0)
+		goto error;
+
+	/* Read the last incomplete block */
+	writer->row_count = rows;
+	if (rows % writer->hdr.block_rows != 0) {
+		uint64_t block = rows / writer->hdr.block_rows;
+		res = file_seek(writer->file,
+				writer->hdr.data_offset +
+					block * writer->hdr.block_size);
+		if (res < 0) {
+			ULOG_ERRNO("file_seek", -res);
+			goto error;
+		}
+		if (fread(writer->block,
+			  writer->hdr.block_size,
+			  1,
+			  writer->file) != 1) {
+			res = -EIO;
+			ULOG_ERRNO("fread", -res);
+			goto error;
+		}
+	}
+
+	*ret_obj = writer;
+	return 0;
+
+error:
+	vmeta_frame_archive_writer_destroy(writer);
+	return res;
+}
+
+
+int vmeta_frame_archive_writer_destroy(
+	struct vmeta_frame_archive_writer *writer)
+{
+	int res = 0;
+
+	if (writer == NULL)
+		return 0;
+
+	if (writer->file != NULL) {
+		if (writer->block != NULL)
+			res = vmeta_frame_archive_writer_flush(writer);
+		if ((fclose(writer->file) != 0) && (res == 0)) {
+			res = -EIO;
+			ULOG_ERRNO("fclose", -res);
+		}
+	}
+	free(writer->block);
+	free(writer);
+
+	return res;
+}
+
+
+int vmeta_frame_archive_writer_append(struct vmeta_frame_archive_writer *writer,
+				      struct vmeta_frame *meta)
+{
+	int res;
+	size_t row;
+	uint8_t bit;
+	struct vmeta_frame_flat flat;
+
+	ULOG_ERRNO_RETURN_ERR_IF(writer == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+
+	res = vmeta_frame_get_fields(meta, VMETA_FRAME_TABLE_FIELDS, &flat);
+	if (res < 0)
+		return res;
+
+	row = writer->row_count % writer->hdr.block_rows;
+	bit = 1 << (row % 8);
+	for (unsigned int i = 0; i < VMETA_FRAME_TABLE_COLUMN_COUNT; i++) {
+		const struct vmeta_frame_archive_column *col =
+			&writer->columns[i];
+		uint8_t *presence =
+			writer->block + col->presence_offset + row / 8;
+		if (vmeta_frame_table_column_set(
+			    &vmeta_frame_table_columns[i],
+			    &flat,
+			    writer->block + col->values_offset +
+				    row * col->size))
+			*presence |= bit;
+		else
+			*presence &= ~bit;
+	}
+	writer->row_count++;
+
+	/* Write the block once full */
+	if (row + 1 == writer->hdr.block_rows) {
+		res = writer_write_block(writer);
+		if (res < 0) {
+			writer->row_count--;
+			return res;
+		}
+		memset(writer->block, 0, writer->hdr.block_size);
+	}
+
+	return 0;
+}
+
+
+int vmeta_frame_archive_writer_flush(struct vmeta_frame_archive_writer *writer)
+{
+	int res;
+
+	ULOG_ERRNO_RETURN_ERR_IF(writer == NULL, EINVAL);
+
+	if (writer->row_count == writer->hdr.row_count)
+		return 0;
+
+	/* Incomplete block (complete blocks are written by
+	 * vmeta_frame_archive_writer_append()) */
+	if (writer->row_count % writer->hdr.block_rows != 0) {
+		res = writer_write_block(writer);
+		if (res < 0)
+			return res;
+	}
+
+	/* Readers must see the rows before the updated row count */
+	if (fflush(writer->file) != 0) {
+		ULOG_ERRNO("fflush", EIO);
+		return -EIO;
+	}
+	res = writer_write_at(
+		writer,
+		offsetof(struct vmeta_frame_archive_header, row_count),
+		&writer->row_count,
+		sizeof(writer->row_count));
+	if (res < 0)
+		return res;
+	if (fflush(writer->file) != 0) {
+		ULOG_ERRNO("fflush", EIO);
+		return -EIO;
+	}
+	writer->hdr.row_count = writer->row_count;
+
+	return 0;
+}
+
+
+static void archive_unload(struct vmeta_frame_archive *archive)
+{
+	if (archive->data == NULL)
+		return;
+#ifndef _WIN32
+	if (archive->mapped)
+		munmap((void *)archive->data, archive->size);
+	else
+		free((void *)archive->data);
+#else /* _WIN32 */
+	free((void *)archive->data);
+#endif /* _WIN32 */
+	archive->data = NULL;
+	archive->size = 0;
+	archive->mapped = 0;
+	archive->hdr = NULL;
+	archive->row_count = 0;
+	memset(archive->columns, 0, sizeof(archive->columns));
+}
+
+
+/* Read a whole file into memory (when it cannot be mapped) */
+static int archive_read(struct vmeta_frame_archive *archive)
+{
+	int res = 0;
+	uint64_t size;
+	uint8_t *data = NULL;
+	FILE *f;
+
+	f = fopen(archive->path, "rb");
+	if (f == NULL) {
+		res = -errno;
+		ULOG_ERRNO("fopen '%s'", -res, archive->path);
+		return res;
+	}
+	res = file_get_size(f, &size);
+	if (res < 0)
+		goto out;
+	if (size > SIZE_MAX) {
+		res = -EFBIG;
+		goto out;
+	}
+	data = malloc(size > 0 ? (size_t)size : 1);
+	if (data == NULL) {
+		res = -ENOMEM;
+		goto out;
+	}
+	if ((size > 0) && (fread(data, (size_t)size, 1, f) != 1)) {
+		res = -EIO;
+		goto out;
+	}
+	archive->data = data;
+	archive->size = (size_t)size;
+	data = NULL;
+
+out:
+	if (res < 0)
+		ULOG_ERRNO("failed to read '%s'", -res, archive->path);
+	free(data);
+	fclose(f);
+	return res;
+}
+
+
+static int archive_load(struct vmeta_frame_archive *archive)
+{
+	int res;
+	const struct vmeta_frame_archive_column *cols;
+
+#ifndef _WIN32
+	int fd;
+	struct stat st;
+	void *map;
+
+	fd = open(archive->path, O_RDONLY);
+	if (fd < 0) {
+		res = -errno;
+		ULOG_ERRNO("open '%s'", -res, archive->path);
+		return res;
+	}
+	if (fstat(fd, &st) < 0) {
+		res = -errno;
+		ULOG_ERRNO("fstat", -res);
+		close(fd);
+		return res;
+	}
+	/* Files larger than the address space are left to archive_read(),
+	 * which rejects them */
+	map = ((st.st_size > 0) && ((uint64_t)st.st_size <= SIZE_MAX))
+		      ? mmap(NULL,
+			     (size_t)st.st_size,
+			     PROT_READ,
+			     MAP_SHARED,
+			     fd,
+			     0)
+		      : MAP_FAILED;
+	close(fd);
+	if (map != MAP_FAILED) {
+		archive->data = map;
+		archive->size = (size_t)st.st_size;
+		archive->mapped = 1;
+	} else {
+		res = archive_read(archive);
+		if (res < 0)
+			return res;
+	}
+#else /* _WIN32 */
+	res = archive_read(archive);
+	if (res < 0)
+		return res;
+#endif /* _WIN32 */
+
+	archive->hdr = (const void *)archive->data;
+	res = check_archive(archive->hdr,
+			    archive->data,
+			    archive->size,
+			    &archive->row_count);
+	if (res < 0) {
+		ULOGE("'%s': invalid archive file", archive->path);
+		archive_unload(archive);
+		return res;
+	}
+
+	/* Columns unknown to this version are ignored, and columns with an
+	 * unexpected type are considered as missing */
+	cols = (const void *)(archive->data + archive->hdr->schema_offset);
+	for (uint32_t i = 0; i < archive->hdr->column_count; i++) {
+		uint32_t column = cols[i].column;
+		if ((column >= VMETA_FRAME_TABLE_COLUMN_COUNT) ||
+		    (cols[i].type != vmeta_frame_table_columns[column].type) ||
+		    (cols[i].size != vmeta_frame_table_columns[column].size))
+			continue;
+		archive->columns[column] = &cols[i];
+	}
+
+	return 0;
+}
+
+
+int vmeta_frame_archive_open(const char *path,
+			     struct vmeta_frame_archive **ret_obj)
+{
+	int res;
+	struct vmeta_frame_archive *archive;
+
+	ULOG_ERRNO_RETURN_ERR_IF(path == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	archive = calloc(1, sizeof(*archive));
+	if (archive == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+	archive->path = strdup(path);
+	if (archive->path == NULL) {
+		ULOG_ERRNO("strdup", ENOMEM);
+		free(archive);
+		return -ENOMEM;
+	}
+
+	res = archive_load(archive);
+	if (res < 0) {
+		vmeta_frame_archive_close(archive);
+		return res;
+	}
+
+	*ret_obj = archive;
+	return 0;
+}
+
+
+int vmeta_frame_archive_close(struct vmeta_frame_archive *archive)
+{
+	if (archive == NULL)
+		return 0;
+
+	archive_unload(archive);
+	free(archive->path);
+	free(archive);
+
+	return 0;
+}
+
+
+int vmeta_frame_archive_refresh(struct vmeta_frame_archive *archive)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(archive == NULL, EINVAL);
+
+	archive_unload(archive);
+	return archive_load(archive);
+}
+
+
+int vmeta_frame_archive_get_session(struct vmeta_frame_archive *archive,
+				    struct vmeta_session *session)
+{
+	int res;
+	const char *str, *end, *key, *value;
+
+	ULOG_ERRNO_RETURN_ERR_IF(archive == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(archive->data == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+
+	memset(session, 0, sizeof(*session));
+	str = (const char *)archive->data + archive->hdr->session_offset;
+	end = str + archive->hdr->session_size;
+	while (str < end) {
+		key = str;
+		str = memchr(key, '\0', end - key);
+		if (str == NULL)
+			break;
+		value = ++str;
+		str = memchr(value, '\0', end - value);
+		if (str == NULL)
+			break;
+		str++;
+		res = vmeta_session_recording_read(key, value, session);
+		if (res < 0)
+			ULOG_ERRNO("vmeta_session_recording_read", -res);
+	}
+
+	return 0;
+}
+
+
+int vmeta_frame_archive_get_count(struct vmeta_frame_archive *archive,
+				  size_t *count,
+				  size_t *block_rows)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(archive == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(archive->data == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(count == NULL, EINVAL);
+
+	*count = archive->row_count;
+	if (block_rows != NULL)
+		*block_rows = archive->hdr->block_rows;
+
+	return 0;
+}
+
+
+int vmeta_frame_archive_get_column(struct vmeta_frame_archive *archive,
+				   size_t block,
+				   enum vmeta_frame_table_column column,
+				   const void **data,
+				   const uint8_t **presence,
+				   size_t *count)
+{
+	const struct vmeta_frame_archive_column *col;
+	const uint8_t *base;
+	uint64_t first;
+
+	ULOG_ERRNO_RETURN_ERR_IF(archive == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(archive->data == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(column >= VMETA_FRAME_TABLE_COLUMN_COUNT,
+				 EINVAL);
+
+	first = (uint64_t)block * archive->hdr->block_rows;
+	col = archive->columns[column];
+	if ((first >= archive->row_count) || (col == NULL))
+		return -ENOENT;
+
+	base = archive->data + archive->hdr->data_offset +
+	       block * archive->hdr->block_size;
+	if (data != NULL)
+		*data = base + col->values_offset;
+	if (presence != NULL)
+		*presence = base + col->presence_offset;
+	if (count != NULL) {
+		uint64_t rows = archive->row_count - first;
+		*count = (rows < archive->hdr->block_rows)
+				 ? rows
+				 : archive->hdr->block_rows;
+	}
+
+	return 0;
+}
@@ -0,0 +1,241 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+
+struct vmeta_frame_pool {
+	pthread_mutex_t lock;
+	unsigned int capacity;
+
+	/* Number of references: one for the owner (released by
+	 * vmeta_frame_pool_destroy()) plus one per frame allocated from the
+	 * pool and not yet returned to it */
+	unsigned int refcount;
+	int destroyed;
+
+	/* Idle frame structures */
+	struct vmeta_frame **frames;
+	unsigned int frame_count;
+
+	/* Idle protobuf-based metadata objects */
+	struct vmeta_frame_proto **protos;
+	unsigned int proto_count;
+};
+
+
+static void vmeta_frame_pool_free(struct vmeta_frame_pool *pool)
+{
+	unsigned int i;
+
+	for (i = 0; i < pool->frame_count; i++)
+		free(pool->frames[i]);
+	for (i = 0; i < pool->proto_count; i++)
+		vmeta_frame_proto_destroy(pool->protos[i]);
+	free(pool->frames);
+	free(pool->protos);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
+
+
+int vmeta_frame_pool_new(unsigned int capacity,
+			 struct vmeta_frame_pool **ret_obj)
+{
+	int res;
+	struct vmeta_frame_pool *pool;
+
+	ULOG_ERRNO_RETURN_ERR_IF(capacity == 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		res = -ENOMEM;
+		ULOG_ERRNO("calloc", -res);
+		return res;
+	}
+	pool->capacity = capacity;
+	pool->refcount = 1;
+
+	res = pthread_mutex_init(&pool->lock, NULL);
+	if (res != 0) {
+		ULOG_ERRNO("pthread_mutex_init", res);
+		free(pool);
+		return -res;
+	}
+
+	pool->frames = calloc(capacity, sizeof(*pool->frames));
+	pool->protos = calloc(capacity, sizeof(*pool->protos));
+	if (pool->frames == NULL || pool->protos == NULL) {
+		res = -ENOMEM;
+		ULOG_ERRNO("calloc", -res);
+		vmeta_frame_pool_free(pool);
+		return res;
+	}
+
+	*ret_obj = pool;
+	return 0;
+}
+
+
+int vmeta_frame_pool_destroy(struct vmeta_frame_pool *pool)
+{
+	unsigned int i, frame_count, proto_count;
+	struct vmeta_frame **frames;
+	struct vmeta_frame_proto **protos;
+	int last;
+
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->destroyed) {
+		pthread_mutex_unlock(&pool->lock);
+		ULOGE("%s: pool already destroyed", __func__);
+		return -EALREADY;
+	}
+	pool->destroyed = 1;
+	/* Detach the idle structures; the arrays are freed with the pool */
+	frames = pool->frames;
+	frame_count = pool->frame_count;
+	pool->frame_count = 0;
+	protos = pool->protos;
+	proto_count = pool->proto_count;
+	pool->proto_count = 0;
+	last = (--pool->refcount == 0);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < frame_count; i++)
+		free(frames[i]);
+	for (i = 0; i < proto_count; i++)
+		vmeta_frame_proto_destroy(protos[i]);
+
+	if (last)
+		vmeta_frame_pool_free(pool);
+
+	return 0;
+}
+
+
+int vmeta_frame_pool_get_frame(struct vmeta_frame_pool *pool,
+			       struct vmeta_frame **frame)
+{
+	int res;
+	struct vmeta_frame *l_frame = NULL;
+
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->destroyed) {
+		pthread_mutex_unlock(&pool->lock);
+		ULOGE("%s: pool is destroyed", __func__);
+		return -EPERM;
+	}
+	if (pool->frame_count > 0)
+		l_frame = pool->frames[--pool->frame_count];
+	pool->refcount++;
+	pthread_mutex_unlock(&pool->lock);
+
+	if (l_frame == NULL) {
+		l_frame = calloc(1, sizeof(*l_frame));
+		if (l_frame == NULL) {
+			res = -ENOMEM;
+			ULOG_ERRNO("calloc", -res);
+			pthread_mutex_lock(&pool->lock);
+			pool->refcount--;
+			pthread_mutex_unlock(&pool->lock);
+			return res;
+		}
+	}
+	l_frame->pool = pool;
+
+	*frame = l_frame;
+	return 0;
+}
+
+
+struct vmeta_frame_proto *
+vmeta_frame_pool_get_proto(struct vmeta_frame_pool *pool)
+{
+	struct vmeta_frame_proto *proto = NULL;
+
+	ULOG_ERRNO_RETURN_VAL_IF(pool == NULL, EINVAL, NULL);
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->proto_count > 0)
+		proto = pool->protos[--pool->proto_count];
+	pthread_mutex_unlock(&pool->lock);
+
+	return proto;
+}
+
+
+int vmeta_frame_pool_put_frame(struct vmeta_frame *frame)
+{
+	int res = 0;
+	struct vmeta_frame_pool *pool;
+	struct vmeta_frame_proto *proto = NULL;
+	int last;
+
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(frame->pool == NULL, EINVAL);
+
+	pool = frame->pool;
+	if (frame->type == VMETA_FRAME_TYPE_PROTO && frame->proto != NULL) {
+		proto = frame->proto;
+		/* Release the data outside of the pool lock, as it may call
+		 * the borrowed buffer release callback function */
+		res = vmeta_frame_proto_recycle(proto);
+		if (res < 0) {
+			ULOG_ERRNO("vmeta_frame_proto_recycle", -res);
+			res = vmeta_frame_proto_destroy(proto);
+			proto = NULL;
+		}
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	if (!pool->destroyed && proto != NULL &&
+	    pool->proto_count < pool->capacity) {
+		pool->protos[pool->proto_count++] = proto;
+		proto = NULL;
+	}
+	if (!pool->destroyed && pool->frame_count < pool->capacity) {
+		memset(frame, 0, sizeof(*frame));
+		pool->frames[pool->frame_count++] = frame;
+		frame = NULL;
+	}
+	last = (--pool->refcount == 0);
+	pthread_mutex_unlock(&pool->lock);
+
+	if (proto != NULL)
+		res = vmeta_frame_proto_destroy(proto);
+	free(frame);
+	if (last)
+		vmeta_frame_pool_free(pool);
+
+	return res;
+}
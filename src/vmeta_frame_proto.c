@@ -26,24 +26,258 @@
 
 #include "vmeta_priv.h"
 
-struct vmeta_frame_proto {
-	/* Encoded part */
-	int packed;
+/* Unpacking arena sizing: protobuf-c structures are larger than their
+ * wire-format encoding, so the arena is sized as a multiple of the packed
+ * length, with a minimum size */
+#define VMETA_FRAME_PROTO_ARENA_RATIO 4
+#define VMETA_FRAME_PROTO_ARENA_MIN_SIZE 512
+#define VMETA_FRAME_PROTO_ARENA_ALIGN 16
+#define VMETA_FRAME_PROTO_ARENA_ALIGN_SIZE(_s)                                 \
+	(((_s) + VMETA_FRAME_PROTO_ARENA_ALIGN - 1) &                          \
+	 ~((size_t)VMETA_FRAME_PROTO_ARENA_ALIGN - 1))
+
+
+/* State word layout: the packed/unpacked flags, the write lock flag and the
+ * packed-read and unpacked-read lock counters are kept in a single atomic
+ * word so that read locks can be taken and released without the mutex */
+#define VMETA_FRAME_PROTO_STATE_PACKED (1u << 0)
+#define VMETA_FRAME_PROTO_STATE_UNPACKED (1u << 1)
+#define VMETA_FRAME_PROTO_STATE_W_LOCK (1u << 2)
+#define VMETA_FRAME_PROTO_STATE_RU_SHIFT 3
+#define VMETA_FRAME_PROTO_STATE_RU_ONE (1u << VMETA_FRAME_PROTO_STATE_RU_SHIFT)
+#define VMETA_FRAME_PROTO_STATE_RU_MASK                                        \
+	(0x3fffu << VMETA_FRAME_PROTO_STATE_RU_SHIFT)
+#define VMETA_FRAME_PROTO_STATE_RP_SHIFT 17
+#define VMETA_FRAME_PROTO_STATE_RP_ONE (1u << VMETA_FRAME_PROTO_STATE_RP_SHIFT)
+#define VMETA_FRAME_PROTO_STATE_RP_MASK                                        \
+	(0x7fffu << VMETA_FRAME_PROTO_STATE_RP_SHIFT)
+
+#if !defined(__GNUC__)
+#	error no atomic functions found on this platform
+#endif
+
+
+/* Arena overflow chunk (allocated when the main block is exhausted) */
+struct vmeta_frame_proto_arena_chunk {
+	struct vmeta_frame_proto_arena_chunk *next;
+};
+
+
+#define VMETA_FRAME_PROTO_ARENA_CHUNK_HDR_SIZE                                 \
+	VMETA_FRAME_PROTO_ARENA_ALIGN_SIZE(                                    \
+		sizeof(struct vmeta_frame_proto_arena_chunk))
+
+
+/* Bump allocator used to unpack the protobuf structure */
+struct vmeta_frame_proto_arena {
+	/* Main block */
+	uint8_t *base;
+	size_t size;
+	size_t used;
+
+	/* Overflow chunks */
+	struct vmeta_frame_proto_arena_chunk *overflow;
+	size_t overflow_size;
+
+	/* Minimum size of the main block for the next unpacking (grown
+	 * when the previous unpacking overflowed) */
+	size_t size_hint;
+};
+
+
+/* Serialized top-level part of the decoded metadata */
+struct vmeta_frame_proto_packed_part {
 	uint8_t *buf;
+	size_t size;
+	size_t len;
+};
+
+
+struct vmeta_frame_proto {
+	/* Encoded part (valid when VMETA_FRAME_PROTO_STATE_PACKED is set) */
+	const uint8_t *buf;
 	size_t len;
 
-	/* Decoded part */
-	int unpacked;
+	/* Owned encoded buffer (kept allocated until the object is destroyed
+	 * so that it can be reused when packing or reading again) */
+	uint8_t *own_buf;
+	size_t own_size;
+
+	/* Borrowed encoded buffer (not owned, released through the callback
+	 * function instead of being freed); the borrowed flag is accessed
+	 * atomically so that it can be queried without the mutex */
+	int borrowed;
+	vmeta_frame_buffer_release_cb_t release;
+	const uint8_t *release_data;
+	void *release_userdata;
+
+	/* Decoded part (valid when VMETA_FRAME_PROTO_STATE_UNPACKED is set) */
 	Vmeta__TimedMetadata *meta;
 
-	/* lock */
+	/* Unpacking arena (the decoded part is allocated in the arena when
+	 * arena_backed is set, and with the system allocator otherwise) */
+	int arena_backed;
+	struct vmeta_frame_proto_arena arena;
+	ProtobufCAllocator allocator;
+
+	/* Serialized top-level parts of the decoded part, reused for packing
+	 * (valid when the part bit is set in parts_valid, see
+	 * enum vmeta_frame_proto_part); the buffers are kept allocated until
+	 * the object is destroyed */
+	struct vmeta_frame_proto_packed_part
+		parts[VMETA_FRAME_PROTO_PART_COUNT];
+	uint32_t parts_valid;
+
+	/* State word (see VMETA_FRAME_PROTO_STATE_*); the mutex serializes
+	 * the packing, unpacking and write lock transitions */
+	uint32_t state;
 	pthread_mutex_t lock;
-	uint32_t rp_lock;
-	uint32_t ru_lock;
-	uint32_t w_lock;
 };
 
 
+static inline uint32_t
+vmeta_frame_proto_state_get(struct vmeta_frame_proto *meta)
+{
+	return __atomic_load_n(&meta->state, __ATOMIC_ACQUIRE);
+}
+
+
+static inline void vmeta_frame_proto_state_set(struct vmeta_frame_proto *meta,
+					       uint32_t flags)
+{
+	__atomic_or_fetch(&meta->state, flags, __ATOMIC_RELEASE);
+}
+
+
+static inline void
+vmeta_frame_proto_state_clear(struct vmeta_frame_proto *meta, uint32_t flags)
+{
+	__atomic_and_fetch(&meta->state, ~flags, __ATOMIC_RELEASE);
+}
+
+
+/* Take a read lock (the counter is given by one and mask) if the flag is set
+ * and the metadata is not write-locked; returns 1 if the lock was taken, 0 if
+ * the flag is not set, or a negative errno value */
+static int vmeta_frame_proto_read_lock(struct vmeta_frame_proto *meta,
+				       uint32_t flag,
+				       uint32_t one,
+				       uint32_t mask)
+{
+	uint32_t state = vmeta_frame_proto_state_get(meta);
+
+	do {
+		if (state & VMETA_FRAME_PROTO_STATE_W_LOCK)
+			return -EBUSY;
+		if (!(state & flag))
+			return 0;
+		if ((state & mask) == mask)
+			return -EBUSY;
+	} while (!__atomic_compare_exchange_n(&meta->state,
+					      &state,
+					      state + one,
+					      1,
+					      __ATOMIC_ACQUIRE,
+					      __ATOMIC_ACQUIRE));
+
+	return 1;
+}
+
+
+static void vmeta_frame_proto_read_unlock(struct vmeta_frame_proto *meta,
+					  uint32_t one)
+{
+	__atomic_sub_fetch(&meta->state, one, __ATOMIC_RELEASE);
+}
+
+
+static void *vmeta_frame_proto_arena_alloc(void *allocator_data, size_t size)
+{
+	struct vmeta_frame_proto_arena *arena = allocator_data;
+	struct vmeta_frame_proto_arena_chunk *chunk;
+	uint8_t *ptr;
+
+	size = VMETA_FRAME_PROTO_ARENA_ALIGN_SIZE(size);
+
+	if (arena->base != NULL && arena->size - arena->used >= size) {
+		ptr = arena->base + arena->used;
+		arena->used += size;
+		return ptr;
+	}
+
+	/* Main block exhausted, allocate an overflow chunk */
+	chunk = malloc(VMETA_FRAME_PROTO_ARENA_CHUNK_HDR_SIZE + size);
+	if (chunk == NULL)
+		return NULL;
+	chunk->next = arena->overflow;
+	arena->overflow = chunk;
+	arena->overflow_size += size;
+
+	return (uint8_t *)chunk + VMETA_FRAME_PROTO_ARENA_CHUNK_HDR_SIZE;
+}
+
+
+static void vmeta_frame_proto_arena_free(void *allocator_data, void *pointer)
+{
+	/* Memory is released all at once by vmeta_frame_proto_arena_reset() */
+}
+
+
+static int
+vmeta_frame_proto_arena_prepare(struct vmeta_frame_proto_arena *arena,
+				size_t packed_len)
+{
+	size_t size;
+
+	size = packed_len * VMETA_FRAME_PROTO_ARENA_RATIO;
+	if (size < VMETA_FRAME_PROTO_ARENA_MIN_SIZE)
+		size = VMETA_FRAME_PROTO_ARENA_MIN_SIZE;
+	if (size < arena->size_hint)
+		size = arena->size_hint;
+	size = VMETA_FRAME_PROTO_ARENA_ALIGN_SIZE(size);
+
+	arena->used = 0;
+	if (arena->size >= size)
+		return 0;
+
+	free(arena->base);
+	arena->size = 0;
+	arena->base = malloc(size);
+	if (arena->base == NULL)
+		return -ENOMEM;
+	arena->size = size;
+
+	return 0;
+}
+
+
+static void vmeta_frame_proto_arena_reset(struct vmeta_frame_proto_arena *arena)
+{
+	struct vmeta_frame_proto_arena_chunk *chunk;
+
+	/* Remember the peak usage so that the next unpacking fits in the
+	 * main block */
+	if (arena->overflow_size > 0)
+		arena->size_hint = arena->used + arena->overflow_size;
+
+	while (arena->overflow != NULL) {
+		chunk = arena->overflow;
+		arena->overflow = chunk->next;
+		free(chunk);
+	}
+	arena->overflow_size = 0;
+	arena->used = 0;
+}
+
+
+static void vmeta_frame_proto_arena_clear(struct vmeta_frame_proto_arena *arena)
+{
+	vmeta_frame_proto_arena_reset(arena);
+	free(arena->base);
+	memset(arena, 0, sizeof(*arena));
+}
+
+
 static int vmeta_frame_proto_alloc(struct vmeta_frame_proto **meta)
 {
 	int res;
@@ -59,58 +293,246 @@ static int vmeta_frame_proto_alloc(struct vmeta_frame_proto **meta)
 		return -res;
 	}
 
+	(*meta)->allocator.alloc = &vmeta_frame_proto_arena_alloc;
+	(*meta)->allocator.free = &vmeta_frame_proto_arena_free;
+	(*meta)->allocator.allocator_data = &(*meta)->arena;
+
 	return 0;
 }
 
 
+static void vmeta_frame_proto_free_unpacked(struct vmeta_frame_proto *meta)
+{
+	if (!(vmeta_frame_proto_state_get(meta) &
+	      VMETA_FRAME_PROTO_STATE_UNPACKED))
+		return;
+
+	/* Arena-backed structures are released all at once */
+	if (meta->arena_backed)
+		vmeta_frame_proto_arena_reset(&meta->arena);
+	else
+		vmeta__timed_metadata__free_unpacked(meta->meta, NULL);
+	meta->meta = NULL;
+	meta->arena_backed = 0;
+	meta->parts_valid = 0;
+	vmeta_frame_proto_state_clear(meta, VMETA_FRAME_PROTO_STATE_UNPACKED);
+}
+
+
+static void vmeta_frame_proto_free_buf(struct vmeta_frame_proto *meta)
+{
+	if (meta->borrowed) {
+		if (meta->release)
+			meta->release(meta->release_data,
+				      meta->release_userdata);
+		__atomic_store_n(&meta->borrowed, 0, __ATOMIC_RELEASE);
+		meta->release = NULL;
+		meta->release_data = NULL;
+		meta->release_userdata = NULL;
+	}
+	meta->buf = NULL;
+	meta->len = 0;
+}
+
+
+static int vmeta_frame_proto_reserve_buf(struct vmeta_frame_proto *meta,
+					 size_t len)
+{
+	uint8_t *buf;
+
+	/* We want to allow a "zero-length" input, but malloc(0) return value
+	 * is implementation-defined, so we use malloc(1) in this case */
+	if (len == 0)
+		len = 1;
+	if (meta->own_size >= len)
+		return 0;
+
+	buf = realloc(meta->own_buf, len);
+	if (buf == NULL)
+		return -ENOMEM;
+	meta->own_buf = buf;
+	meta->own_size = len;
+
+	return 0;
+}
+
+
+/* Select a single top-level part of the metadata in out */
+static void vmeta_frame_proto_part_select(const Vmeta__TimedMetadata *meta,
+					  unsigned int index,
+					  Vmeta__TimedMetadata *out)
+{
+	vmeta__timed_metadata__init(out);
+
+	switch (index) {
+	case 0:
+		out->drone = meta->drone;
+		break;
+	case 1:
+		out->camera = meta->camera;
+		break;
+	case 2:
+		out->n_links = meta->n_links;
+		out->links = meta->links;
+		break;
+	case 3:
+		out->tracking = meta->tracking;
+		break;
+	case 4:
+		out->proposal = meta->proposal;
+		break;
+	case 5:
+		out->automation = meta->automation;
+		break;
+	case 6:
+		out->thermal = meta->thermal;
+		break;
+	case 7:
+		out->n_lfic = meta->n_lfic;
+		out->lfic = meta->lfic;
+		break;
+	case 8:
+		out->n_user = meta->n_user;
+		out->user = meta->user;
+		break;
+	default:
+		break;
+	}
+}
+
+
+/* Serialize again the modified top-level parts of the unpacked metadata and
+ * return the total packed size; as protobuf-c packs the fields in field
+ * number order, the packed metadata is the concatenation of the parts.
+ * Returns -ENOTSUP if the metadata cannot be packed by parts. */
+static int vmeta_frame_proto_update_parts(struct vmeta_frame_proto *meta,
+					  size_t *len)
+{
+	Vmeta__TimedMetadata field;
+	struct vmeta_frame_proto_packed_part *part;
+	size_t size, total = 0;
+	uint8_t *buf;
+
+	/* Unknown fields are packed after the known ones */
+	if (meta->meta->base.n_unknown_fields != 0)
+		return -ENOTSUP;
+
+	for (unsigned int i = 0; i < VMETA_FRAME_PROTO_PART_COUNT; i++) {
+		part = &meta->parts[i];
+		if (meta->parts_valid & (1u << i)) {
+			total += part->len;
+			continue;
+		}
+		vmeta_frame_proto_part_select(meta->meta, i, &field);
+		size = vmeta__timed_metadata__get_packed_size(&field);
+		if (size > part->size) {
+			buf = realloc(part->buf, size);
+			if (buf == NULL)
+				return -ENOMEM;
+			part->buf = buf;
+			part->size = size;
+		}
+		part->len = 0;
+		if (size > 0)
+			part->len = vmeta__timed_metadata__pack(&field,
+								part->buf);
+		meta->parts_valid |= 1u << i;
+		total += part->len;
+	}
+
+	*len = total;
+	return 0;
+}
+
+
+/* Copy the serialized parts (see vmeta_frame_proto_update_parts()) */
+static void vmeta_frame_proto_copy_parts(struct vmeta_frame_proto *meta,
+					 uint8_t *out)
+{
+	for (unsigned int i = 0; i < VMETA_FRAME_PROTO_PART_COUNT; i++) {
+		if (meta->parts[i].len == 0)
+			continue;
+		memcpy(out, meta->parts[i].buf, meta->parts[i].len);
+		out += meta->parts[i].len;
+	}
+}
+
+
 static int vmeta_frame_proto_pack(struct vmeta_frame *meta)
 {
+	int res, by_parts;
 	size_t len;
+	uint32_t state = vmeta_frame_proto_state_get(meta->proto);
 
 	/* If the metadata is already packed, this is a no-op */
-	if (meta->proto->packed)
+	if (state & VMETA_FRAME_PROTO_STATE_PACKED)
 		return 0;
 
-	/* Do not pack if the metadata is packed-read or write locked */
-	if (meta->proto->rp_lock || meta->proto->w_lock)
+	/* Do not pack if the metadata is write locked */
+	if (state & VMETA_FRAME_PROTO_STATE_W_LOCK)
 		return -EBUSY;
 
 	/* If the metadata is neither packed nor unpacked, we have a problem */
-	if (!meta->proto->unpacked)
+	if (!(state & VMETA_FRAME_PROTO_STATE_UNPACKED))
 		return -EINVAL;
 
-	len = vmeta__timed_metadata__get_packed_size(meta->proto->meta);
-	meta->proto->buf = malloc(len);
-	if (!meta->proto->buf)
-		return -ENOMEM;
+	/* Reuse the serialized parts that have not been modified */
+	res = vmeta_frame_proto_update_parts(meta->proto, &len);
+	by_parts = (res == 0);
+	if (res == -ENOTSUP)
+		len = vmeta__timed_metadata__get_packed_size(meta->proto->meta);
+	else if (res < 0)
+		return res;
+	res = vmeta_frame_proto_reserve_buf(meta->proto, len);
+	if (res < 0)
+		return res;
 
-	meta->proto->len = vmeta__timed_metadata__pack(meta->proto->meta,
-						       meta->proto->buf);
-	meta->proto->packed = 1;
+	if (by_parts)
+		vmeta_frame_proto_copy_parts(meta->proto, meta->proto->own_buf);
+	else
+		len = vmeta__timed_metadata__pack(meta->proto->meta,
+						  meta->proto->own_buf);
+	meta->proto->len = len;
+	meta->proto->buf = meta->proto->own_buf;
+	vmeta_frame_proto_state_set(meta->proto,
+				    VMETA_FRAME_PROTO_STATE_PACKED);
 
 	return 0;
 }
 
 
-static int vmeta_frame_proto_unpack(struct vmeta_frame *meta)
+static int vmeta_frame_proto_unpack(struct vmeta_frame *meta, int use_arena)
 {
+	int res;
+	ProtobufCAllocator *allocator = NULL;
+	uint32_t state = vmeta_frame_proto_state_get(meta->proto);
+
 	/* If the metadata is already unpacked, this is a no-op */
-	if (meta->proto->unpacked)
+	if (state & VMETA_FRAME_PROTO_STATE_UNPACKED)
 		return 0;
 
-	/* Do not unpack if the metadata is unpacked-read or write locked */
-	if (meta->proto->ru_lock || meta->proto->w_lock)
-		return -EBUSY;
-
 	/* If the metadata is neither packed nor unpacked, we have a problem */
-	if (!meta->proto->packed)
+	if (!(state & VMETA_FRAME_PROTO_STATE_PACKED))
 		return -EINVAL;
 
+	if (use_arena) {
+		res = vmeta_frame_proto_arena_prepare(&meta->proto->arena,
+						      meta->proto->len);
+		if (res < 0)
+			return res;
+		allocator = &meta->proto->allocator;
+	}
+
 	meta->proto->meta = vmeta__timed_metadata__unpack(
-		NULL, meta->proto->len, meta->proto->buf);
-	if (meta->proto->meta == NULL)
+		allocator, meta->proto->len, meta->proto->buf);
+	if (meta->proto->meta == NULL) {
+		if (use_arena)
+			vmeta_frame_proto_arena_reset(&meta->proto->arena);
 		return -EPROTO;
-	meta->proto->unpacked = 1;
+	}
+	meta->proto->arena_backed = use_arena;
+	vmeta_frame_proto_state_set(meta->proto,
+				    VMETA_FRAME_PROTO_STATE_UNPACKED);
 
 	return 0;
 }
@@ -123,16 +545,21 @@ int vmeta_frame_proto_init(struct vmeta_frame_proto **meta)
 
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
 
-	res = vmeta_frame_proto_alloc(&l_meta);
-	if (res != 0)
-		return res;
+	if (*meta != NULL) {
+		/* Reuse a recycled object */
+		l_meta = *meta;
+	} else {
+		res = vmeta_frame_proto_alloc(&l_meta);
+		if (res != 0)
+			return res;
+	}
 	l_meta->meta = calloc(1, sizeof(*l_meta->meta));
 	if (!l_meta->meta) {
 		res = -ENOMEM;
 		goto error;
 	}
 	vmeta__timed_metadata__init(l_meta->meta);
-	l_meta->unpacked = 1;
+	vmeta_frame_proto_state_set(l_meta, VMETA_FRAME_PROTO_STATE_UNPACKED);
 	*meta = l_meta;
 
 	return 0;
@@ -145,10 +572,12 @@ error:
 
 
 int vmeta_frame_proto_read(struct vmeta_buffer *buf,
+			   int borrow,
+			   vmeta_frame_buffer_release_cb_t release,
+			   void *userdata,
 			   struct vmeta_frame_proto **meta)
 {
 	int res;
-	size_t alloc_len;
 	struct vmeta_frame_proto *l_meta;
 	uint64_t empty_cookie = VMETA_FRAME_PROTO_EMPTY_COOKIE;
 
@@ -161,21 +590,36 @@ int vmeta_frame_proto_read(struct vmeta_buffer *buf,
 		return -ENODATA;
 	}
 
-	res = vmeta_frame_proto_alloc(&l_meta);
-	if (res != 0)
-		return res;
+	if (*meta != NULL) {
+		/* Reuse a recycled object */
+		l_meta = *meta;
+	} else {
+		res = vmeta_frame_proto_alloc(&l_meta);
+		if (res != 0)
+			return res;
+	}
 	l_meta->len = buf->len - buf->pos;
 
-	/* We want to allow a "zero-length" input, but malloc(0) return value
-	 * is implementation-defined, so we use malloc(1) in this case */
-	alloc_len = l_meta->len == 0 ? 1 : l_meta->len;
-	l_meta->buf = malloc(alloc_len);
-	if (!l_meta->buf) {
-		res = -ENOMEM;
-		goto error;
+	if (borrow) {
+		/* Reference the caller data directly; the ownership is only
+		 * transferred on success */
+		l_meta->buf = buf->cdata + buf->pos;
+		vmeta_frame_proto_state_set(l_meta,
+					    VMETA_FRAME_PROTO_STATE_PACKED);
+		__atomic_store_n(&l_meta->borrowed, 1, __ATOMIC_RELEASE);
+		l_meta->release = release;
+		l_meta->release_data = buf->cdata;
+		l_meta->release_userdata = userdata;
+		*meta = l_meta;
+		return 0;
 	}
-	memcpy(l_meta->buf, buf->data + buf->pos, l_meta->len);
-	l_meta->packed = 1;
+
+	res = vmeta_frame_proto_reserve_buf(l_meta, l_meta->len);
+	if (res < 0)
+		goto error;
+	memcpy(l_meta->own_buf, buf->cdata + buf->pos, l_meta->len);
+	l_meta->buf = l_meta->own_buf;
+	vmeta_frame_proto_state_set(l_meta, VMETA_FRAME_PROTO_STATE_PACKED);
 	*meta = l_meta;
 
 	return 0;
@@ -187,35 +631,120 @@ error:
 }
 
 
-int vmeta_frame_proto_write(struct vmeta_buffer *buf, struct vmeta_frame *meta)
+int vmeta_frame_proto_is_borrowed(struct vmeta_frame_proto *meta)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
+
+	return __atomic_load_n(&meta->borrowed, __ATOMIC_ACQUIRE);
+}
+
+
+/* ProtobufCBuffer appending directly to a vmeta_buffer; once the buffer is
+ * full, the overflow flag is set and the data is dropped */
+struct vmeta_frame_proto_out {
+	ProtobufCBuffer base;
+	struct vmeta_buffer *buf;
+	size_t pos;
+	int overflow;
+};
+
+
+static void vmeta_frame_proto_out_append(ProtobufCBuffer *buffer,
+					 size_t len,
+					 const uint8_t *data)
+{
+	struct vmeta_frame_proto_out *out =
+		(struct vmeta_frame_proto_out *)buffer;
+
+	if (out->overflow || len > out->buf->len - out->pos) {
+		out->overflow = 1;
+		return;
+	}
+	memcpy(out->buf->data + out->pos, data, len);
+	out->pos += len;
+}
+
+
+int vmeta_frame_proto_write(struct vmeta_buffer *buf,
+			    struct vmeta_frame *meta,
+			    int cache)
 {
 	int res = 0;
+	const uint8_t *data;
+	size_t len;
+	const Vmeta__TimedMetadata *timed_meta;
+	struct vmeta_frame_proto_out out;
 
 	ULOG_ERRNO_RETURN_ERR_IF(!buf, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf->pos > buf->len, ENOBUFS);
+	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
+	ULOG_ERRNO_RETURN_ERR_IF(!meta->proto, EINVAL);
 
-	pthread_mutex_lock(&meta->proto->lock);
+	/* Copy the packed data if it is already available or if it must be
+	 * kept in the frame */
+	res = vmeta_frame_proto_read_lock(meta->proto,
+					  VMETA_FRAME_PROTO_STATE_PACKED,
+					  VMETA_FRAME_PROTO_STATE_RP_ONE,
+					  VMETA_FRAME_PROTO_STATE_RP_MASK);
+	if (res < 0)
+		return res;
+	if (res > 0 || cache) {
+		if (res == 0) {
+			res = vmeta_frame_proto_get_buffer(meta, &data, &len);
+			if (res < 0)
+				return res;
+		} else {
+			data = meta->proto->buf;
+			len = meta->proto->len;
+		}
+		res = vmeta_buffer_write(buf, data, len);
+		vmeta_frame_proto_release_buffer(meta, data);
+		return res;
+	}
 
-	res = vmeta_frame_proto_pack(meta);
-	if (res != 0)
-		goto out;
+	/* Otherwise pack the unpacked metadata straight into the output
+	 * buffer, without an intermediate packed copy */
+	res = vmeta_frame_proto_get_unpacked(meta, &timed_meta);
+	if (res < 0)
+		return res;
 
-	if (meta->proto->w_lock) {
-		res = -EBUSY;
-		goto out;
+	/* Reuse the serialized parts that have not been modified */
+	pthread_mutex_lock(&meta->proto->lock);
+	res = vmeta_frame_proto_update_parts(meta->proto, &len);
+	if (res == 0 && len > buf->len - buf->pos) {
+		res = -ENOBUFS;
+		ULOG_ERRNO("vmeta_frame_proto_write", -res);
+	} else if (res == 0) {
+		vmeta_frame_proto_copy_parts(meta->proto, buf->data + buf->pos);
+		buf->pos += len;
 	}
+	pthread_mutex_unlock(&meta->proto->lock);
+	if (res != -ENOTSUP)
+		goto out;
 
-	res = vmeta_buffer_write(buf, meta->proto->buf, meta->proto->len);
+	res = 0;
+	out.base.append = &vmeta_frame_proto_out_append;
+	out.buf = buf;
+	out.pos = buf->pos;
+	out.overflow = 0;
+	vmeta__timed_metadata__pack_to_buffer(timed_meta, &out.base);
+	if (out.overflow) {
+		res = -ENOBUFS;
+		ULOG_ERRNO("vmeta__timed_metadata__pack_to_buffer", -res);
+	} else {
+		buf->pos = out.pos;
+	}
 
 out:
-	pthread_mutex_unlock(&meta->proto->lock);
+	vmeta_frame_proto_release_unpacked(meta, timed_meta);
 
 	return res;
 }
 
 
 int vmeta_frame_proto_to_json(struct vmeta_frame *meta,
-			      struct json_object *jobj)
+			      struct vmeta_json_writer *w)
 {
 	int ret = 0;
 	Vmeta__TimedMetadata *timed_meta = NULL;
@@ -226,7 +755,7 @@ int vmeta_frame_proto_to_json(struct vmeta_frame *meta,
 		ULOG_ERRNO("vmeta_frame_proto_get_unpacked", -ret);
 		goto error;
 	}
-	ret = vmeta_json_proto_add_timed_metadata(jobj, timed_meta);
+	ret = vmeta_json_proto_add_timed_metadata(w, timed_meta);
 	if (ret < 0) {
 		ULOG_ERRNO("vmeta_json_add_proto_timed_metadata", -ret);
 		goto error;
@@ -240,26 +769,101 @@ error:
 }
 
 
+int vmeta_frame_proto_to_csv(struct vmeta_frame *meta,
+			     struct vmeta_csv_writer *w)
+{
+	int ret;
+	struct vmeta_frame_flat flat;
+
+	/* The protobuf-based metadata has no fixed layout: the CSV values
+	 * are the flat telemetry fields, zero when not available */
+	ret = vmeta_frame_get_fields(meta, VMETA_FRAME_FIELD_ALL, &flat);
+	if (ret < 0) {
+		ULOG_ERRNO("vmeta_frame_get_fields", -ret);
+		return ret;
+	}
+
+	vmeta_csv_add_uint(w, flat.timestamp);
+	vmeta_csv_add_uint(w, flat.utc_timestamp);
+	vmeta_csv_add_location(w, &flat.location);
+	vmeta_csv_add_ned(w, &flat.speed);
+	vmeta_csv_add_double(w, flat.ground_distance, 2);
+	vmeta_csv_add_double(w, flat.altitude_ato, 2);
+	vmeta_csv_add_quaternion(w, &flat.drone_quat);
+	vmeta_csv_add_quaternion(w, &flat.frame_quat);
+	vmeta_csv_add_quaternion(w, &flat.frame_base_quat);
+	vmeta_csv_add_float(w, flat.exposure_time, 4);
+	vmeta_csv_add_int(w, flat.gain);
+	vmeta_csv_add_float(w, flat.awb_r_gain, 5);
+	vmeta_csv_add_float(w, flat.awb_b_gain, 5);
+	vmeta_csv_add_float(w, flat.picture_h_fov, 4);
+	vmeta_csv_add_float(w, flat.picture_v_fov, 4);
+	vmeta_csv_add_float(w, flat.zoom_level, 3);
+	vmeta_csv_add_int(w, flat.battery_percentage);
+	vmeta_csv_add_int(w, flat.flying_state);
+	vmeta_csv_add_int(w, flat.piloting_mode);
+	vmeta_csv_add_uint(w, flat.link_goodput);
+	vmeta_csv_add_int(w, flat.link_quality);
+	vmeta_csv_add_int(w, flat.wifi_rssi);
+
+	return 0;
+}
+
+
+size_t vmeta_frame_proto_csv_header(char *str, size_t maxlen)
+{
+	size_t len = 0;
+
+	VMETA_STR_PRINT(
+		str + len,
+		len,
+		maxlen - len,
+		"frame_timestamp frame_utc_timestamp "
+		"location_valid location_latitude location_longitude "
+		"location_altitude_wgs84ellipsoid location_altitude_egm96amsl "
+		"location_horizontal_accuracy location_vertical_accuracy "
+		"location_sv_count speed_north speed_east speed_down "
+		"ground_distance altitude_ato "
+		"drone_quat_w drone_quat_x drone_quat_y drone_quat_z "
+		"frame_quat_w frame_quat_x frame_quat_y frame_quat_z "
+		"frame_base_quat_w frame_base_quat_x frame_base_quat_y "
+		"frame_base_quat_z exposure_time gain "
+		"awb_r_gain awb_b_gain picture_hfov picture_vfov zoom_level "
+		"battery_percentage flying_state piloting_mode "
+		"link_goodput link_quality wifi_rssi");
+
+	return len;
+}
+
+
 int vmeta_frame_proto_destroy(struct vmeta_frame_proto *meta)
 {
+	uint32_t state;
+
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
 
-	if (meta->rp_lock)
+	state = vmeta_frame_proto_state_get(meta);
+	if (state & VMETA_FRAME_PROTO_STATE_RP_MASK)
 		ULOGW("metadata destroyed with %" PRIu32
 		      " packed-read-lock held",
-		      meta->rp_lock);
-	if (meta->ru_lock)
+		      (state & VMETA_FRAME_PROTO_STATE_RP_MASK) >>
+			      VMETA_FRAME_PROTO_STATE_RP_SHIFT);
+	if (state & VMETA_FRAME_PROTO_STATE_RU_MASK)
 		ULOGW("metadata destroyed with %" PRIu32
 		      " unpacked-read-lock held",
-		      meta->ru_lock);
-	if (meta->w_lock)
+		      (state & VMETA_FRAME_PROTO_STATE_RU_MASK) >>
+			      VMETA_FRAME_PROTO_STATE_RU_SHIFT);
+	if (state & VMETA_FRAME_PROTO_STATE_W_LOCK)
 		ULOGW("metadata destroyed with write-lock held");
 
-	if (meta->packed)
-		free(meta->buf);
+	if (state & VMETA_FRAME_PROTO_STATE_PACKED)
+		vmeta_frame_proto_free_buf(meta);
 
-	if (meta->unpacked)
-		vmeta__timed_metadata__free_unpacked(meta->meta, NULL);
+	vmeta_frame_proto_free_unpacked(meta);
+	vmeta_frame_proto_arena_clear(&meta->arena);
+	free(meta->own_buf);
+	for (unsigned int i = 0; i < VMETA_FRAME_PROTO_PART_COUNT; i++)
+		free(meta->parts[i].buf);
 
 	pthread_mutex_destroy(&meta->lock);
 	free(meta);
@@ -268,67 +872,105 @@ int vmeta_frame_proto_destroy(struct vmeta_frame_proto *meta)
 }
 
 
-int vmeta_frame_proto_get_unpacked(struct vmeta_frame *meta,
-				   const Vmeta__TimedMetadata **proto_meta)
+int vmeta_frame_proto_recycle(struct vmeta_frame_proto *meta)
 {
 	int ret = 0;
+	uint32_t state;
 
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(!proto_meta, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
-	ULOG_ERRNO_RETURN_ERR_IF(!meta->proto, EINVAL);
-
-	pthread_mutex_lock(&meta->proto->lock);
 
-	ret = vmeta_frame_proto_unpack(meta);
-	if (ret < 0)
-		goto out;
+	pthread_mutex_lock(&meta->lock);
 
-	if (meta->proto->w_lock) {
+	state = vmeta_frame_proto_state_get(meta);
+	if (state & (VMETA_FRAME_PROTO_STATE_RP_MASK |
+		     VMETA_FRAME_PROTO_STATE_RU_MASK |
+		     VMETA_FRAME_PROTO_STATE_W_LOCK)) {
 		ret = -EBUSY;
 		goto out;
 	}
 
-	*proto_meta = meta->proto->meta;
-	meta->proto->ru_lock++;
+	/* Release the data but keep the lock, the owned buffer and the
+	 * unpacking arena for the next use */
+	if (state & VMETA_FRAME_PROTO_STATE_PACKED)
+		vmeta_frame_proto_free_buf(meta);
+	vmeta_frame_proto_free_unpacked(meta);
+	vmeta_frame_proto_state_clear(meta, VMETA_FRAME_PROTO_STATE_PACKED);
 
 out:
-	pthread_mutex_unlock(&meta->proto->lock);
+	pthread_mutex_unlock(&meta->lock);
 
 	return ret;
 }
 
 
+int vmeta_frame_proto_get_unpacked(struct vmeta_frame *meta,
+				   const Vmeta__TimedMetadata **proto_meta)
+{
+	int ret = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!proto_meta, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
+	ULOG_ERRNO_RETURN_ERR_IF(!meta->proto, EINVAL);
+
+	/* Fast path: the metadata is already unpacked */
+	ret = vmeta_frame_proto_read_lock(meta->proto,
+					  VMETA_FRAME_PROTO_STATE_UNPACKED,
+					  VMETA_FRAME_PROTO_STATE_RU_ONE,
+					  VMETA_FRAME_PROTO_STATE_RU_MASK);
+	if (ret == 0) {
+		/* Slow path: unpack first; the write lock is only taken with
+		 * the mutex held, so it cannot be taken in the meantime */
+		pthread_mutex_lock(&meta->proto->lock);
+		if (vmeta_frame_proto_state_get(meta->proto) &
+		    VMETA_FRAME_PROTO_STATE_W_LOCK)
+			ret = -EBUSY;
+		else
+			ret = vmeta_frame_proto_unpack(meta, 1);
+		if (ret == 0)
+			ret = vmeta_frame_proto_read_lock(
+				meta->proto,
+				VMETA_FRAME_PROTO_STATE_UNPACKED,
+				VMETA_FRAME_PROTO_STATE_RU_ONE,
+				VMETA_FRAME_PROTO_STATE_RU_MASK);
+		pthread_mutex_unlock(&meta->proto->lock);
+	}
+	if (ret < 0)
+		return ret;
+
+	*proto_meta = meta->proto->meta;
+
+	return 0;
+}
+
+
 int vmeta_frame_proto_release_unpacked(struct vmeta_frame *meta,
 				       const Vmeta__TimedMetadata *proto_meta)
 {
-	int ret = 0;
+	uint32_t state;
 
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(!proto_meta, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
 	ULOG_ERRNO_RETURN_ERR_IF(!meta->proto, EINVAL);
 
-	pthread_mutex_lock(&meta->proto->lock);
+	state = vmeta_frame_proto_state_get(meta->proto);
 
-	if (!meta->proto->ru_lock) {
+	if (!(state & VMETA_FRAME_PROTO_STATE_RU_MASK)) {
 		ULOGE("%s called with no unpacked-read-lock held", __func__);
-		ret = -EPROTO;
-		goto out;
+		return -EPROTO;
 	}
 
-	if (!meta->proto->unpacked || proto_meta != meta->proto->meta) {
+	if (!(state & VMETA_FRAME_PROTO_STATE_UNPACKED) ||
+	    proto_meta != meta->proto->meta) {
 		ULOGE("%s called with a wrong proto_meta", __func__);
-		ret = -EPROTO;
-		goto out;
+		return -EPROTO;
 	}
 
-	meta->proto->ru_lock--;
+	vmeta_frame_proto_read_unlock(meta->proto,
+				      VMETA_FRAME_PROTO_STATE_RU_ONE);
 
-out:
-	pthread_mutex_unlock(&meta->proto->lock);
-
-	return ret;
+	return 0;
 }
 
 
@@ -336,6 +978,7 @@ int vmeta_frame_proto_get_unpacked_rw(struct vmeta_frame *meta,
 				      Vmeta__TimedMetadata **proto_meta)
 {
 	int ret = 0;
+	uint32_t state;
 
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(!proto_meta, EINVAL);
@@ -344,18 +987,38 @@ int vmeta_frame_proto_get_unpacked_rw(struct vmeta_frame *meta,
 
 	pthread_mutex_lock(&meta->proto->lock);
 
-	ret = vmeta_frame_proto_unpack(meta);
-	if (ret < 0)
-		goto out;
-
-	if (meta->proto->ru_lock || meta->proto->rp_lock ||
-	    meta->proto->w_lock) {
-		ret = -EBUSY;
+	/* Take the write lock only if no lock is held */
+	state = vmeta_frame_proto_state_get(meta->proto);
+	do {
+		if (state & (VMETA_FRAME_PROTO_STATE_RP_MASK |
+			     VMETA_FRAME_PROTO_STATE_RU_MASK |
+			     VMETA_FRAME_PROTO_STATE_W_LOCK)) {
+			ret = -EBUSY;
+			goto out;
+		}
+	} while (!__atomic_compare_exchange_n(
+		&meta->proto->state,
+		&state,
+		state | VMETA_FRAME_PROTO_STATE_W_LOCK,
+		1,
+		__ATOMIC_ACQUIRE,
+		__ATOMIC_ACQUIRE));
+
+	/* Writers may add or replace parts of the structure using the system
+	 * allocator, so an arena-backed structure is unpacked again from the
+	 * packed buffer using the system allocator */
+	if (meta->proto->arena_backed &&
+	    (state & VMETA_FRAME_PROTO_STATE_PACKED))
+		vmeta_frame_proto_free_unpacked(meta->proto);
+
+	ret = vmeta_frame_proto_unpack(meta, 0);
+	if (ret < 0) {
+		vmeta_frame_proto_state_clear(meta->proto,
+					      VMETA_FRAME_PROTO_STATE_W_LOCK);
 		goto out;
 	}
 
 	*proto_meta = meta->proto->meta;
-	meta->proto->w_lock = 1;
 
 out:
 	pthread_mutex_unlock(&meta->proto->lock);
@@ -366,8 +1029,18 @@ out:
 
 int vmeta_frame_proto_release_unpacked_rw(struct vmeta_frame *meta,
 					  Vmeta__TimedMetadata *proto_meta)
+{
+	return vmeta_frame_proto_release_unpacked_rw2(
+		meta, proto_meta, VMETA_FRAME_PROTO_PART_ALL);
+}
+
+
+int vmeta_frame_proto_release_unpacked_rw2(struct vmeta_frame *meta,
+					   Vmeta__TimedMetadata *proto_meta,
+					   uint32_t dirty)
 {
 	int ret = 0;
+	uint32_t state;
 
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(!proto_meta, EINVAL);
@@ -376,27 +1049,36 @@ int vmeta_frame_proto_release_unpacked_rw(struct vmeta_frame *meta,
 
 	pthread_mutex_lock(&meta->proto->lock);
 
-	if (!meta->proto->w_lock) {
+	state = vmeta_frame_proto_state_get(meta->proto);
+
+	if (!(state & VMETA_FRAME_PROTO_STATE_W_LOCK)) {
 		ULOGE("%s called with no write-lock held", __func__);
 		ret = -EPROTO;
 		goto out;
 	}
 
-	if (!meta->proto->unpacked || proto_meta != meta->proto->meta) {
+	if (!(state & VMETA_FRAME_PROTO_STATE_UNPACKED) ||
+	    proto_meta != meta->proto->meta) {
 		ULOGE("%s called with a wrong proto_meta", __func__);
 		ret = -EPROTO;
 		goto out;
 	}
 
-	meta->proto->w_lock = 0;
-
-	if (meta->proto->unpacked) {
-		free(meta->proto->buf);
-		meta->proto->buf = NULL;
-		meta->proto->len = 0;
-		meta->proto->packed = 0;
+	/* Unmodified metadata: the packed data is still valid */
+	if ((dirty & VMETA_FRAME_PROTO_PART_ALL) == 0) {
+		vmeta_frame_proto_state_clear(meta->proto,
+					      VMETA_FRAME_PROTO_STATE_W_LOCK);
+		goto out;
 	}
 
+	/* The packed data and the modified parts are outdated */
+	meta->proto->parts_valid &= ~dirty;
+	if (state & VMETA_FRAME_PROTO_STATE_PACKED)
+		vmeta_frame_proto_free_buf(meta->proto);
+	vmeta_frame_proto_state_clear(meta->proto,
+				      VMETA_FRAME_PROTO_STATE_PACKED |
+					      VMETA_FRAME_PROTO_STATE_W_LOCK);
+
 out:
 	pthread_mutex_unlock(&meta->proto->lock);
 
@@ -416,58 +1098,128 @@ int vmeta_frame_proto_get_buffer(struct vmeta_frame *meta,
 	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
 	ULOG_ERRNO_RETURN_ERR_IF(!meta->proto, EINVAL);
 
-	pthread_mutex_lock(&meta->proto->lock);
-
-	ret = vmeta_frame_proto_pack(meta);
-	if (ret < 0)
-		goto out;
-
-	if (meta->proto->w_lock) {
-		ret = -EBUSY;
-		goto out;
+	/* Fast path: the metadata is already packed */
+	ret = vmeta_frame_proto_read_lock(meta->proto,
+					  VMETA_FRAME_PROTO_STATE_PACKED,
+					  VMETA_FRAME_PROTO_STATE_RP_ONE,
+					  VMETA_FRAME_PROTO_STATE_RP_MASK);
+	if (ret == 0) {
+		/* Slow path: pack first */
+		pthread_mutex_lock(&meta->proto->lock);
+		ret = vmeta_frame_proto_pack(meta);
+		if (ret == 0)
+			ret = vmeta_frame_proto_read_lock(
+				meta->proto,
+				VMETA_FRAME_PROTO_STATE_PACKED,
+				VMETA_FRAME_PROTO_STATE_RP_ONE,
+				VMETA_FRAME_PROTO_STATE_RP_MASK);
+		pthread_mutex_unlock(&meta->proto->lock);
 	}
+	if (ret < 0)
+		return ret;
 
 	*buf = meta->proto->buf;
 	*len = meta->proto->len;
-	meta->proto->rp_lock++;
-
-out:
-	pthread_mutex_unlock(&meta->proto->lock);
 
-	return ret;
+	return 0;
 }
 
 
 int vmeta_frame_proto_release_buffer(struct vmeta_frame *meta,
 				     const uint8_t *buf)
 {
-	int ret = 0;
+	uint32_t state;
 
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(!buf, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
 	ULOG_ERRNO_RETURN_ERR_IF(!meta->proto, EINVAL);
 
-	pthread_mutex_lock(&meta->proto->lock);
+	state = vmeta_frame_proto_state_get(meta->proto);
 
-	if (!meta->proto->rp_lock) {
+	if (!(state & VMETA_FRAME_PROTO_STATE_RP_MASK)) {
 		ULOGE("%s called with no packed-read-lock held", __func__);
-		ret = -EPROTO;
-		goto out;
+		return -EPROTO;
 	}
 
-	if (!meta->proto->packed || buf != meta->proto->buf) {
+	if (!(state & VMETA_FRAME_PROTO_STATE_PACKED) ||
+	    buf != meta->proto->buf) {
 		ULOGE("%s called with a wrong buffer", __func__);
-		ret = -EPROTO;
-		goto out;
+		return -EPROTO;
 	}
 
-	meta->proto->rp_lock--;
+	vmeta_frame_proto_read_unlock(meta->proto,
+				      VMETA_FRAME_PROTO_STATE_RP_ONE);
 
-out:
-	pthread_mutex_unlock(&meta->proto->lock);
+	return 0;
+}
 
-	return ret;
+
+int vmeta_frame_proto_get_view(struct vmeta_frame *meta,
+			       unsigned int parts,
+			       struct vmeta_frame_proto_view *view,
+			       const Vmeta__TimedMetadata **proto_meta)
+{
+	int ret;
+
+	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!view, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!proto_meta, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
+	ULOG_ERRNO_RETURN_ERR_IF(!meta->proto, EINVAL);
+
+	if (view->held) {
+		*proto_meta = view->held;
+		return 0;
+	}
+
+	/* Parts that cannot be decoded directly need the unpacked metadata */
+	if (parts & ~(VMETA_FRAME_PROTO_VIEW_DRONE |
+		      VMETA_FRAME_PROTO_VIEW_CAMERA))
+		return vmeta_frame_proto_get_unpacked(meta, proto_meta);
+
+	/* Only decode from the packed buffer if the metadata is not already
+	 * unpacked */
+	ret = vmeta_frame_proto_read_lock(meta->proto,
+					  VMETA_FRAME_PROTO_STATE_PACKED,
+					  VMETA_FRAME_PROTO_STATE_RP_ONE,
+					  VMETA_FRAME_PROTO_STATE_RP_MASK);
+	if (ret < 0)
+		return ret;
+	if (ret > 0) {
+		ret = -EAGAIN;
+		if (!(vmeta_frame_proto_state_get(meta->proto) &
+		      VMETA_FRAME_PROTO_STATE_UNPACKED)) {
+			struct vmeta_frame_proto *proto = meta->proto;
+			ret = vmeta_frame_proto_scan_buffer(
+				proto->buf, proto->len, parts, view);
+		}
+		vmeta_frame_proto_read_unlock(meta->proto,
+					      VMETA_FRAME_PROTO_STATE_RP_ONE);
+		if (ret == 0) {
+			*proto_meta = &view->tm;
+			return 0;
+		}
+	}
+
+	/* Fall back to the unpacked metadata (a malformed buffer is reported
+	 * by the unpacking) */
+	return vmeta_frame_proto_get_unpacked(meta, proto_meta);
+}
+
+
+int vmeta_frame_proto_release_view(struct vmeta_frame *meta,
+				   struct vmeta_frame_proto_view *view,
+				   const Vmeta__TimedMetadata *proto_meta)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(!view, EINVAL);
+
+	/* Nothing to release for metadata held by the caller or decoded into
+	 * the view */
+	if (view->held || proto_meta == &view->tm)
+		return 0;
+
+	return vmeta_frame_proto_release_unpacked(meta, proto_meta);
 }
 
 
@@ -1183,6 +1935,8 @@ Vmeta__Location *vmeta_frame_proto_get_lfic_location(Vmeta__LFICMetadata *lfic)
 ssize_t vmeta_frame_proto_get_packed_size(struct vmeta_frame *meta)
 {
 	ssize_t ret;
+	size_t len;
+	uint32_t state;
 
 	ULOG_ERRNO_RETURN_ERR_IF(!meta, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
@@ -1190,12 +1944,20 @@ ssize_t vmeta_frame_proto_get_packed_size(struct vmeta_frame *meta)
 
 	pthread_mutex_lock(&meta->proto->lock);
 
-	if (meta->proto->packed)
+	state = vmeta_frame_proto_state_get(meta->proto);
+	if (state & VMETA_FRAME_PROTO_STATE_PACKED) {
 		ret = meta->proto->len;
-	else if (meta->proto->unpacked)
-		ret = vmeta__timed_metadata__get_packed_size(meta->proto->meta);
-	else
+	} else if (state & VMETA_FRAME_PROTO_STATE_UNPACKED) {
+		/* Reuse the serialized parts that have not been modified */
+		ret = vmeta_frame_proto_update_parts(meta->proto, &len);
+		if (ret == 0)
+			ret = len;
+		else if (ret == -ENOTSUP)
+			ret = vmeta__timed_metadata__get_packed_size(
+				meta->proto->meta);
+	} else {
 		ret = -EINVAL;
+	}
 
 	pthread_mutex_unlock(&meta->proto->lock);
 
@@ -0,0 +1,407 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+/* Packed buffer split in top-level parts */
+struct vmeta_frame_proto_delta_ref {
+	uint8_t *buf;
+	size_t size;
+	size_t len;
+	struct vmeta_frame_proto_span spans[VMETA_FRAME_PROTO_PART_COUNT];
+};
+
+
+struct vmeta_frame_proto_delta_enc {
+	unsigned int keyframe_interval;
+
+	/* Number of frames written since the last keyframe, including the
+	 * keyframe */
+	unsigned int count;
+	int keyframe_requested;
+
+	/* Last keyframe (valid if has_ref is set) */
+	int has_ref;
+	uint16_t keyframe_id;
+	struct vmeta_frame_proto_delta_ref ref;
+};
+
+
+struct vmeta_frame_proto_delta_dec {
+	/* Last keyframe (valid if has_ref is set) */
+	int has_ref;
+	uint16_t keyframe_id;
+	struct vmeta_frame_proto_delta_ref ref;
+
+	/* Reconstructed frame buffer */
+	uint8_t *out;
+	size_t out_size;
+};
+
+
+static int vmeta_frame_proto_delta_reserve(uint8_t **buf,
+					   size_t *size,
+					   size_t len)
+{
+	uint8_t *tmp;
+
+	if (*size >= len)
+		return 0;
+
+	tmp = realloc(*buf, len);
+	if (tmp == NULL)
+		return -ENOMEM;
+	*buf = tmp;
+	*size = len;
+
+	return 0;
+}
+
+
+/* Keep a copy of a keyframe split in parts */
+static int
+vmeta_frame_proto_delta_ref_set(struct vmeta_frame_proto_delta_ref *ref,
+				const uint8_t *buf,
+				size_t len,
+				const struct vmeta_frame_proto_span *spans)
+{
+	int res;
+
+	res = vmeta_frame_proto_delta_reserve(&ref->buf, &ref->size, len);
+	if (res < 0)
+		return res;
+	if (len > 0)
+		memcpy(ref->buf, buf, len);
+	ref->len = len;
+	memcpy(ref->spans, spans, sizeof(ref->spans));
+
+	return 0;
+}
+
+
+static void vmeta_frame_proto_delta_write_header(uint8_t *p,
+						 uint16_t flags,
+						 uint16_t keyframe_id,
+						 uint16_t kept)
+{
+	/* Big-endian, as the other metadata formats */
+	p[0] = (VMETA_FRAME_PROTO_DELTA_MAGIC >> 24) & 0xff;
+	p[1] = (VMETA_FRAME_PROTO_DELTA_MAGIC >> 16) & 0xff;
+	p[2] = (VMETA_FRAME_PROTO_DELTA_MAGIC >> 8) & 0xff;
+	p[3] = VMETA_FRAME_PROTO_DELTA_MAGIC & 0xff;
+	p[4] = flags >> 8;
+	p[5] = flags & 0xff;
+	p[6] = keyframe_id >> 8;
+	p[7] = keyframe_id & 0xff;
+	p[8] = kept >> 8;
+	p[9] = kept & 0xff;
+}
+
+
+int vmeta_frame_proto_delta_enc_new(
+	unsigned int keyframe_interval,
+	struct vmeta_frame_proto_delta_enc **ret_obj)
+{
+	struct vmeta_frame_proto_delta_enc *enc;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	enc = calloc(1, sizeof(*enc));
+	if (enc == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+	enc->keyframe_interval = keyframe_interval;
+
+	*ret_obj = enc;
+	return 0;
+}
+
+
+int vmeta_frame_proto_delta_enc_destroy(struct vmeta_frame_proto_delta_enc *enc)
+{
+	if (enc == NULL)
+		return 0;
+
+	free(enc->ref.buf);
+	free(enc);
+
+	return 0;
+}
+
+
+int vmeta_frame_proto_delta_enc_request_keyframe(
+	struct vmeta_frame_proto_delta_enc *enc)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(enc == NULL, EINVAL);
+
+	enc->keyframe_requested = 1;
+
+	return 0;
+}
+
+
+int vmeta_frame_proto_delta_enc_write(struct vmeta_frame_proto_delta_enc *enc,
+				      struct vmeta_buffer *buf,
+				      struct vmeta_frame *meta)
+{
+	int res, keyframe;
+	const uint8_t *data = NULL;
+	size_t len, total, i;
+	uint16_t kept = 0;
+	uint8_t *p;
+	struct vmeta_frame_proto_span spans[VMETA_FRAME_PROTO_PART_COUNT];
+	const struct vmeta_frame_proto_span *ref_spans;
+
+	ULOG_ERRNO_RETURN_ERR_IF(enc == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf->pos > buf->len, ENOBUFS);
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(meta->type != VMETA_FRAME_TYPE_PROTO, EPROTO);
+	ref_spans = enc->ref.spans;
+
+	res = vmeta_frame_proto_get_buffer(meta, &data, &len);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_frame_proto_get_buffer", -res);
+		return res;
+	}
+
+	/* Metadata that cannot be split in parts is sent as a keyframe that
+	 * cannot be used as a reference */
+	res = vmeta_frame_proto_scan_parts(data, len, spans);
+	keyframe = (res < 0) || !enc->has_ref || enc->keyframe_requested ||
+		   (enc->keyframe_interval > 0 &&
+		    enc->count >= enc->keyframe_interval);
+
+	if (keyframe) {
+		total = len;
+	} else {
+		/* Only the parts that differ from the keyframe are sent */
+		total = 0;
+		for (i = 0; i < VMETA_FRAME_PROTO_PART_COUNT; i++) {
+			if (spans[i].len == 0)
+				continue;
+			if (spans[i].len == ref_spans[i].len &&
+			    memcmp(data + spans[i].offset,
+				   enc->ref.buf + ref_spans[i].offset,
+				   spans[i].len) == 0)
+				kept |= 1u << i;
+			else
+				total += spans[i].len;
+		}
+	}
+
+	if (total + VMETA_FRAME_PROTO_DELTA_HEADER_SIZE >
+	    buf->len - buf->pos) {
+		res = -ENOBUFS;
+		ULOG_ERRNO("vmeta_frame_proto_delta_enc_write", -res);
+		goto out;
+	}
+
+	if (keyframe) {
+		/* Keep the new keyframe as the reference */
+		enc->has_ref = 0;
+		if (res == 0) {
+			res = vmeta_frame_proto_delta_ref_set(
+				&enc->ref, data, len, spans);
+			if (res < 0)
+				goto out;
+			enc->has_ref = 1;
+		}
+		res = 0;
+		enc->keyframe_id++;
+		enc->keyframe_requested = 0;
+		enc->count = 0;
+	}
+
+	p = buf->data + buf->pos;
+	vmeta_frame_proto_delta_write_header(
+		p,
+		keyframe ? VMETA_FRAME_PROTO_DELTA_FLAG_KEYFRAME : 0,
+		enc->keyframe_id,
+		kept);
+	p += VMETA_FRAME_PROTO_DELTA_HEADER_SIZE;
+	if (keyframe) {
+		if (len > 0)
+			memcpy(p, data, len);
+	} else {
+		for (i = 0; i < VMETA_FRAME_PROTO_PART_COUNT; i++) {
+			if (spans[i].len == 0 || (kept & (1u << i)))
+				continue;
+			memcpy(p, data + spans[i].offset, spans[i].len);
+			p += spans[i].len;
+		}
+	}
+	buf->pos += VMETA_FRAME_PROTO_DELTA_HEADER_SIZE + total;
+	enc->count++;
+
+out:
+	vmeta_frame_proto_release_buffer(meta, data);
+	return res;
+}
+
+
+int vmeta_frame_proto_delta_dec_new(
+	struct vmeta_frame_proto_delta_dec **ret_obj)
+{
+	struct vmeta_frame_proto_delta_dec *dec;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	dec = calloc(1, sizeof(*dec));
+	if (dec == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	*ret_obj = dec;
+	return 0;
+}
+
+
+int vmeta_frame_proto_delta_dec_destroy(struct vmeta_frame_proto_delta_dec *dec)
+{
+	if (dec == NULL)
+		return 0;
+
+	free(dec->ref.buf);
+	free(dec->out);
+	free(dec);
+
+	return 0;
+}
+
+
+/* Rebuild the full packed metadata from a delta frame and the keyframe */
+static int
+vmeta_frame_proto_delta_dec_rebuild(struct vmeta_frame_proto_delta_dec *dec,
+				    const uint8_t *data,
+				    size_t len,
+				    uint16_t kept,
+				    size_t *out_len)
+{
+	int res;
+	size_t i, total = 0;
+	uint8_t *p;
+	struct vmeta_frame_proto_span spans[VMETA_FRAME_PROTO_PART_COUNT];
+	const struct vmeta_frame_proto_span *ref_spans = dec->ref.spans;
+
+	res = vmeta_frame_proto_scan_parts(data, len, spans);
+	if (res < 0)
+		return -EPROTO;
+
+	for (i = 0; i < VMETA_FRAME_PROTO_PART_COUNT; i++) {
+		if (spans[i].len > 0) {
+			total += spans[i].len;
+		} else if (kept & (1u << i)) {
+			if (ref_spans[i].len == 0)
+				return -EPROTO;
+			total += ref_spans[i].len;
+		}
+	}
+
+	res = vmeta_frame_proto_delta_reserve(&dec->out, &dec->out_size, total);
+	if (res < 0)
+		return res;
+
+	/* The parts are written in field number order */
+	p = dec->out;
+	for (i = 0; i < VMETA_FRAME_PROTO_PART_COUNT; i++) {
+		if (spans[i].len > 0) {
+			memcpy(p, data + spans[i].offset, spans[i].len);
+			p += spans[i].len;
+		} else if (kept & (1u << i)) {
+			memcpy(p,
+			       dec->ref.buf + ref_spans[i].offset,
+			       ref_spans[i].len);
+			p += ref_spans[i].len;
+		}
+	}
+
+	*out_len = total;
+	return 0;
+}
+
+
+int vmeta_frame_proto_delta_dec_read(struct vmeta_frame_proto_delta_dec *dec,
+				     struct vmeta_buffer *buf,
+				     struct vmeta_frame **ret_obj)
+{
+	int res;
+	const uint8_t *p;
+	size_t len, out_len;
+	uint16_t flags, keyframe_id, kept;
+	struct vmeta_frame_proto_span spans[VMETA_FRAME_PROTO_PART_COUNT];
+	struct vmeta_buffer vb;
+
+	ULOG_ERRNO_RETURN_ERR_IF(dec == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf->pos > buf->len, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	p = buf->cdata + buf->pos;
+	len = buf->len - buf->pos;
+
+	/* Metadata without the delta header */
+	if (len < VMETA_FRAME_PROTO_DELTA_HEADER_SIZE ||
+	    vmeta_load_u32(p) != VMETA_FRAME_PROTO_DELTA_MAGIC)
+		return vmeta_frame_read(
+			buf, VMETA_FRAME_PROTO_MIME_TYPE, ret_obj);
+
+	flags = vmeta_load_u16(p + 4);
+	keyframe_id = vmeta_load_u16(p + 6);
+	kept = vmeta_load_u16(p + 8);
+	p += VMETA_FRAME_PROTO_DELTA_HEADER_SIZE;
+	len -= VMETA_FRAME_PROTO_DELTA_HEADER_SIZE;
+
+	if (flags & VMETA_FRAME_PROTO_DELTA_FLAG_KEYFRAME) {
+		/* Keep the keyframe as the reference, if it can be split in
+		 * parts */
+		dec->has_ref = 0;
+		if (vmeta_frame_proto_scan_parts(p, len, spans) == 0) {
+			res = vmeta_frame_proto_delta_ref_set(
+				&dec->ref, p, len, spans);
+			if (res < 0)
+				return res;
+			dec->has_ref = 1;
+			dec->keyframe_id = keyframe_id;
+		}
+		vmeta_buffer_set_cdata(&vb, p, len, 0);
+	} else {
+		if (!dec->has_ref || dec->keyframe_id != keyframe_id)
+			return -EAGAIN;
+		res = vmeta_frame_proto_delta_dec_rebuild(
+			dec, p, len, kept, &out_len);
+		if (res < 0) {
+			ULOG_ERRNO("vmeta_frame_proto_delta_dec_rebuild", -res);
+			return res;
+		}
+		vmeta_buffer_set_cdata(&vb, dec->out, out_len, 0);
+	}
+
+	return vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, ret_obj);
+}
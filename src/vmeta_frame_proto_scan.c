@@ -0,0 +1,715 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+/* Wire-level decoding of selected parts of a packed TimedMetadata message,
+ * without unpacking the whole message with protobuf-c. The decoded fields
+ * follow the protobuf merging rules (the last value of a scalar field wins,
+ * repeated occurrences of a message field are merged). */
+
+
+struct vmeta_proto_scan {
+	const uint8_t *buf;
+	size_t len;
+	size_t pos;
+};
+
+
+static int vmeta_proto_scan_varint(struct vmeta_proto_scan *s, uint64_t *val)
+{
+	uint64_t v = 0;
+	unsigned int shift = 0;
+	uint8_t b;
+
+	do {
+		if (s->pos >= s->len || shift >= 64)
+			return -EPROTO;
+		b = s->buf[s->pos++];
+		v |= (uint64_t)(b & 0x7f) << shift;
+		shift += 7;
+	} while (b & 0x80);
+
+	*val = v;
+	return 0;
+}
+
+
+static int vmeta_proto_scan_fixed32(struct vmeta_proto_scan *s,
+				    uint32_t wire_type,
+				    uint32_t *val)
+{
+	const uint8_t *p;
+
+	if (wire_type != VMETA_PROTO_WIRE_FIXED32 || s->len - s->pos < 4)
+		return -EPROTO;
+
+	/* Little-endian encoding */
+	p = s->buf + s->pos;
+	*val = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+	       ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	s->pos += 4;
+
+	return 0;
+}
+
+
+static int vmeta_proto_scan_fixed64(struct vmeta_proto_scan *s,
+				    uint32_t wire_type,
+				    uint64_t *val)
+{
+	const uint8_t *p;
+	uint64_t v = 0;
+
+	if (wire_type != VMETA_PROTO_WIRE_FIXED64 || s->len - s->pos < 8)
+		return -EPROTO;
+
+	/* Little-endian encoding */
+	p = s->buf + s->pos;
+	for (int i = 7; i >= 0; i--)
+		v = (v << 8) | p[i];
+	*val = v;
+	s->pos += 8;
+
+	return 0;
+}
+
+
+static int vmeta_proto_scan_tag(struct vmeta_proto_scan *s,
+				uint32_t *field,
+				uint32_t *wire_type)
+{
+	int res;
+	uint64_t tag;
+
+	res = vmeta_proto_scan_varint(s, &tag);
+	if (res < 0)
+		return res;
+	if ((tag >> 3) == 0 || (tag >> 3) > UINT32_MAX)
+		return -EPROTO;
+
+	*field = (uint32_t)(tag >> 3);
+	*wire_type = (uint32_t)(tag & 0x7);
+	return 0;
+}
+
+
+static int vmeta_proto_scan_message(struct vmeta_proto_scan *s,
+				    uint32_t wire_type,
+				    struct vmeta_proto_scan *sub)
+{
+	int res;
+	uint64_t len;
+
+	if (wire_type != VMETA_PROTO_WIRE_LEN)
+		return -EPROTO;
+	res = vmeta_proto_scan_varint(s, &len);
+	if (res < 0)
+		return res;
+	if (len > s->len - s->pos)
+		return -EPROTO;
+
+	sub->buf = s->buf + s->pos;
+	sub->len = (size_t)len;
+	sub->pos = 0;
+	s->pos += (size_t)len;
+
+	return 0;
+}
+
+
+static int vmeta_proto_scan_skip(struct vmeta_proto_scan *s,
+				 uint32_t wire_type)
+{
+	uint64_t v;
+	uint32_t v32;
+	struct vmeta_proto_scan sub;
+
+	switch (wire_type) {
+	case VMETA_PROTO_WIRE_VARINT:
+		return vmeta_proto_scan_varint(s, &v);
+	case VMETA_PROTO_WIRE_FIXED64:
+		return vmeta_proto_scan_fixed64(s, wire_type, &v);
+	case VMETA_PROTO_WIRE_LEN:
+		return vmeta_proto_scan_message(s, wire_type, &sub);
+	case VMETA_PROTO_WIRE_FIXED32:
+		return vmeta_proto_scan_fixed32(s, wire_type, &v32);
+	default:
+		/* Groups are not used in vmeta.proto */
+		return -EPROTO;
+	}
+}
+
+
+static int vmeta_proto_scan_float(struct vmeta_proto_scan *s,
+				  uint32_t wire_type,
+				  float *val)
+{
+	int res;
+	uint32_t v;
+
+	res = vmeta_proto_scan_fixed32(s, wire_type, &v);
+	if (res < 0)
+		return res;
+	memcpy(val, &v, sizeof(*val));
+	return 0;
+}
+
+
+static int vmeta_proto_scan_double(struct vmeta_proto_scan *s,
+				   uint32_t wire_type,
+				   double *val)
+{
+	int res;
+	uint64_t v;
+
+	res = vmeta_proto_scan_fixed64(s, wire_type, &v);
+	if (res < 0)
+		return res;
+	memcpy(val, &v, sizeof(*val));
+	return 0;
+}
+
+
+static int vmeta_proto_scan_uint64(struct vmeta_proto_scan *s,
+				   uint32_t wire_type,
+				   uint64_t *val)
+{
+	if (wire_type != VMETA_PROTO_WIRE_VARINT)
+		return -EPROTO;
+	return vmeta_proto_scan_varint(s, val);
+}
+
+
+static int vmeta_proto_scan_uint32(struct vmeta_proto_scan *s,
+				   uint32_t wire_type,
+				   uint32_t *val)
+{
+	int res;
+	uint64_t v;
+
+	res = vmeta_proto_scan_uint64(s, wire_type, &v);
+	if (res < 0)
+		return res;
+	*val = (uint32_t)v;
+	return 0;
+}
+
+
+/* Also used for enums and bools, which are stored as int-sized values */
+static int vmeta_proto_scan_int32(struct vmeta_proto_scan *s,
+				  uint32_t wire_type,
+				  int32_t *val)
+{
+	int res;
+	uint64_t v;
+
+	res = vmeta_proto_scan_uint64(s, wire_type, &v);
+	if (res < 0)
+		return res;
+	*val = (int32_t)(uint32_t)v;
+	return 0;
+}
+
+
+static int vmeta_proto_scan_sint32(struct vmeta_proto_scan *s,
+				   uint32_t wire_type,
+				   int32_t *val)
+{
+	int res;
+	uint64_t v;
+	uint32_t v32;
+
+	res = vmeta_proto_scan_uint64(s, wire_type, &v);
+	if (res < 0)
+		return res;
+	/* ZigZag decoding */
+	v32 = (uint32_t)v;
+	*val = (int32_t)((v32 >> 1) ^ (~(v32 & 1) + 1));
+	return 0;
+}
+
+
+static int vmeta_proto_scan_quaternion(struct vmeta_proto_scan *s,
+				       Vmeta__Quaternion *quat)
+{
+	int res;
+	uint32_t field, wire_type;
+
+	while (s->pos < s->len) {
+		res = vmeta_proto_scan_tag(s, &field, &wire_type);
+		if (res < 0)
+			return res;
+		switch (field) {
+		case 1: /* w */
+			res = vmeta_proto_scan_float(s, wire_type, &quat->w);
+			break;
+		case 2: /* x */
+			res = vmeta_proto_scan_float(s, wire_type, &quat->x);
+			break;
+		case 3: /* y */
+			res = vmeta_proto_scan_float(s, wire_type, &quat->y);
+			break;
+		case 4: /* z */
+			res = vmeta_proto_scan_float(s, wire_type, &quat->z);
+			break;
+		default:
+			res = vmeta_proto_scan_skip(s, wire_type);
+			break;
+		}
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+static int vmeta_proto_scan_location(struct vmeta_proto_scan *s,
+				     Vmeta__Location *loc)
+{
+	int res;
+	uint32_t field, wire_type;
+
+	while (s->pos < s->len) {
+		res = vmeta_proto_scan_tag(s, &field, &wire_type);
+		if (res < 0)
+			return res;
+		switch (field) {
+		case 1: /* latitude */
+			res = vmeta_proto_scan_double(
+				s, wire_type, &loc->latitude);
+			break;
+		case 2: /* longitude */
+			res = vmeta_proto_scan_double(
+				s, wire_type, &loc->longitude);
+			break;
+		case 3: /* altitude_wgs84ellipsoid */
+			res = vmeta_proto_scan_double(
+				s, wire_type, &loc->altitude_wgs84ellipsoid);
+			break;
+		case 4: /* sv_count */
+			res = vmeta_proto_scan_uint32(
+				s, wire_type, &loc->sv_count);
+			break;
+		case 5: /* horizontal_accuracy */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &loc->horizontal_accuracy);
+			break;
+		case 6: /* vertical_accuracy */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &loc->vertical_accuracy);
+			break;
+		case 7: /* altitude_egm96amsl */
+			res = vmeta_proto_scan_double(
+				s, wire_type, &loc->altitude_egm96amsl);
+			break;
+		default:
+			res = vmeta_proto_scan_skip(s, wire_type);
+			break;
+		}
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+/* Vmeta__NED, Vmeta__Vector2 and Vmeta__Vector3 share the same layout of up
+ * to three consecutive float fields numbered from 1 */
+static int vmeta_proto_scan_floats(struct vmeta_proto_scan *s,
+				   float *values,
+				   uint32_t count)
+{
+	int res;
+	uint32_t field, wire_type;
+
+	while (s->pos < s->len) {
+		res = vmeta_proto_scan_tag(s, &field, &wire_type);
+		if (res < 0)
+			return res;
+		if (field <= count)
+			res = vmeta_proto_scan_float(
+				s, wire_type, &values[field - 1]);
+		else
+			res = vmeta_proto_scan_skip(s, wire_type);
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+static int vmeta_proto_scan_ned(struct vmeta_proto_scan *s, Vmeta__NED *ned)
+{
+	float values[3] = {ned->north, ned->east, ned->down};
+	int res = vmeta_proto_scan_floats(s, values, 3);
+	ned->north = values[0];
+	ned->east = values[1];
+	ned->down = values[2];
+	return res;
+}
+
+
+static int vmeta_proto_scan_vector2(struct vmeta_proto_scan *s,
+				    Vmeta__Vector2 *vec)
+{
+	float values[2] = {vec->x, vec->y};
+	int res = vmeta_proto_scan_floats(s, values, 2);
+	vec->x = values[0];
+	vec->y = values[1];
+	return res;
+}
+
+
+static int vmeta_proto_scan_vector3(struct vmeta_proto_scan *s,
+				    Vmeta__Vector3 *vec)
+{
+	float values[3] = {vec->x, vec->y, vec->z};
+	int res = vmeta_proto_scan_floats(s, values, 3);
+	vec->x = values[0];
+	vec->y = values[1];
+	vec->z = values[2];
+	return res;
+}
+
+
+/* Message field helpers: the sub-message is initialized on its first
+ * occurrence, and further occurrences are merged into it */
+#define VMETA_PROTO_SCAN_SUBMESSAGE(_res, _s, _wt, _ptr, _storage, _type) \
+	do {                                                                   \
+		struct vmeta_proto_scan __sub;                                 \
+		_res = vmeta_proto_scan_message(_s, _wt, &__sub);              \
+		if (_res < 0)                                                  \
+			break;                                                 \
+		if ((_ptr) == NULL) {                                          \
+			vmeta__##_type##__init(_storage);                      \
+			(_ptr) = (_storage);                                   \
+		}                                                              \
+		_res = vmeta_proto_scan_##_type(&__sub, _ptr);                 \
+	} while (0)
+
+
+static int vmeta_proto_scan_drone(struct vmeta_proto_scan *s,
+				  struct vmeta_frame_proto_view *view)
+{
+	int res;
+	uint32_t field, wire_type;
+	Vmeta__DroneMetadata *drone = &view->drone;
+
+	while (s->pos < s->len) {
+		res = vmeta_proto_scan_tag(s, &field, &wire_type);
+		if (res < 0)
+			return res;
+		switch (field) {
+		case 1: /* quat */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    drone->quat,
+						    &view->drone_quat,
+						    quaternion);
+			break;
+		case 2: /* location */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    drone->location,
+						    &view->drone_location,
+						    location);
+			break;
+		case 3: /* ground_distance */
+			res = vmeta_proto_scan_double(
+				s, wire_type, &drone->ground_distance);
+			break;
+		case 4: /* speed */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    drone->speed,
+						    &view->drone_speed,
+						    ned);
+			break;
+		case 5: /* battery_percentage */
+			res = vmeta_proto_scan_sint32(
+				s, wire_type, &drone->battery_percentage);
+			break;
+		case 7: /* flying_state */
+			res = vmeta_proto_scan_int32(
+				s, wire_type, (int32_t *)&drone->flying_state);
+			break;
+		case 9: /* position */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    drone->position,
+						    &view->drone_position,
+						    ned);
+			break;
+		case 10: /* local_position */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    drone->local_position,
+						    &view->drone_local_position,
+						    vector3);
+			break;
+		case 11: /* animation_in_progress */
+			res = vmeta_proto_scan_int32(
+				s,
+				wire_type,
+				(int32_t *)&drone->animation_in_progress);
+			if (res == 0)
+				drone->animation_in_progress =
+					!!drone->animation_in_progress;
+			break;
+		case 12: /* piloting_mode */
+			res = vmeta_proto_scan_int32(
+				s, wire_type, (int32_t *)&drone->piloting_mode);
+			break;
+		case 13: /* altitude_ato */
+			res = vmeta_proto_scan_double(
+				s, wire_type, &drone->altitude_ato);
+			break;
+		default:
+			res = vmeta_proto_scan_skip(s, wire_type);
+			break;
+		}
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+static int vmeta_proto_scan_camera(struct vmeta_proto_scan *s,
+				   struct vmeta_frame_proto_view *view)
+{
+	int res;
+	uint32_t field, wire_type;
+	Vmeta__CameraMetadata *camera = &view->camera;
+
+	while (s->pos < s->len) {
+		res = vmeta_proto_scan_tag(s, &field, &wire_type);
+		if (res < 0)
+			return res;
+		switch (field) {
+		case 1: /* timestamp */
+			res = vmeta_proto_scan_uint64(
+				s, wire_type, &camera->timestamp);
+			break;
+		case 2: /* base_quat */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    camera->base_quat,
+						    &view->camera_base_quat,
+						    quaternion);
+			break;
+		case 3: /* quat */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    camera->quat,
+						    &view->camera_quat,
+						    quaternion);
+			break;
+		case 4: /* exposure_time */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &camera->exposure_time);
+			break;
+		case 5: /* iso_gain */
+			res = vmeta_proto_scan_uint32(
+				s, wire_type, &camera->iso_gain);
+			break;
+		case 6: /* awb_r_gain */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &camera->awb_r_gain);
+			break;
+		case 7: /* awb_b_gain */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &camera->awb_b_gain);
+			break;
+		case 8: /* hfov */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &camera->hfov);
+			break;
+		case 9: /* vfov */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &camera->vfov);
+			break;
+		case 10: /* utc_timestamp */
+			res = vmeta_proto_scan_uint64(
+				s, wire_type, &camera->utc_timestamp);
+			break;
+		case 11: /* utc_timestamp_accuracy */
+			res = vmeta_proto_scan_uint32(
+				s, wire_type, &camera->utc_timestamp_accuracy);
+			break;
+		case 12: /* local_position */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    camera->local_position,
+						    &view->camera_local_position,
+						    vector3);
+			break;
+		case 13: /* location */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    camera->location,
+						    &view->camera_location,
+						    location);
+			break;
+		case 14: /* principal_point */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    camera->principal_point,
+						    &view->camera_principal_point,
+						    vector2);
+			break;
+		case 15: /* local_quat */
+			VMETA_PROTO_SCAN_SUBMESSAGE(res,
+						    s,
+						    wire_type,
+						    camera->local_quat,
+						    &view->camera_local_quat,
+						    quaternion);
+			break;
+		case 16: /* zoom_level */
+			res = vmeta_proto_scan_float(
+				s, wire_type, &camera->zoom_level);
+			break;
+		case 17: /* spectrum */
+			res = vmeta_proto_scan_int32(
+				s, wire_type, (int32_t *)&camera->spectrum);
+			break;
+		case 18: /* subtype */
+			res = vmeta_proto_scan_int32(
+				s, wire_type, (int32_t *)&camera->subtype);
+			break;
+		default:
+			res = vmeta_proto_scan_skip(s, wire_type);
+			break;
+		}
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+int vmeta_frame_proto_scan_buffer(const uint8_t *buf,
+				  size_t len,
+				  unsigned int parts,
+				  struct vmeta_frame_proto_view *view)
+{
+	int res;
+	uint32_t field, wire_type;
+	struct vmeta_proto_scan s = {.buf = buf, .len = len, .pos = 0};
+	struct vmeta_proto_scan sub;
+
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL && len > 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(view == NULL, EINVAL);
+
+	vmeta__timed_metadata__init(&view->tm);
+
+	while (s.pos < s.len) {
+		res = vmeta_proto_scan_tag(&s, &field, &wire_type);
+		if (res < 0)
+			return res;
+		if (field == 1 && (parts & VMETA_FRAME_PROTO_VIEW_DRONE)) {
+			/* drone */
+			res = vmeta_proto_scan_message(&s, wire_type, &sub);
+			if (res < 0)
+				return res;
+			if (view->tm.drone == NULL) {
+				vmeta__drone_metadata__init(&view->drone);
+				view->tm.drone = &view->drone;
+			}
+			res = vmeta_proto_scan_drone(&sub, view);
+		} else if (field == 2 &&
+			   (parts & VMETA_FRAME_PROTO_VIEW_CAMERA)) {
+			/* camera */
+			res = vmeta_proto_scan_message(&s, wire_type, &sub);
+			if (res < 0)
+				return res;
+			if (view->tm.camera == NULL) {
+				vmeta__camera_metadata__init(&view->camera);
+				view->tm.camera = &view->camera;
+			}
+			res = vmeta_proto_scan_camera(&sub, view);
+		} else {
+			res = vmeta_proto_scan_skip(&s, wire_type);
+		}
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+int vmeta_frame_proto_scan_parts(
+	const uint8_t *buf,
+	size_t len,
+	struct vmeta_frame_proto_span spans[VMETA_FRAME_PROTO_PART_COUNT])
+{
+	int res;
+	uint32_t field, wire_type, last = 0;
+	size_t start;
+	struct vmeta_proto_scan s = {.buf = buf, .len = len, .pos = 0};
+
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL && len > 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(spans == NULL, EINVAL);
+
+	memset(spans, 0, VMETA_FRAME_PROTO_PART_COUNT * sizeof(*spans));
+
+	while (s.pos < s.len) {
+		start = s.pos;
+		res = vmeta_proto_scan_tag(&s, &field, &wire_type);
+		if (res < 0)
+			return res;
+		if (field > VMETA_FRAME_PROTO_PART_COUNT || field < last)
+			return -ENOTSUP;
+		res = vmeta_proto_scan_skip(&s, wire_type);
+		if (res < 0)
+			return res;
+		if (field != last)
+			spans[field - 1].offset = start;
+		spans[field - 1].len += s.pos - start;
+		last = field;
+	}
+
+	return 0;
+}
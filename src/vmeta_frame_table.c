@@ -0,0 +1,276 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+
+#define VMETA_FRAME_TABLE_DEFAULT_CAPACITY 1024
+
+
+#define VMETA_FRAME_TABLE_COLUMN_DESC(_col, _type, _ctype, _field, _member)   \
+	[VMETA_FRAME_TABLE_COLUMN_##_col] = {                                  \
+		.type = VMETA_FRAME_TABLE_TYPE_##_type,                        \
+		.size = sizeof(_ctype),                                        \
+		.field = VMETA_FRAME_FIELD_##_field,                           \
+		.offset = offsetof(struct vmeta_frame_flat, _member),          \
+	}
+
+
+/* clang-format off */
+const struct vmeta_frame_table_column_desc
+	vmeta_frame_table_columns[VMETA_FRAME_TABLE_COLUMN_COUNT] = {
+	VMETA_FRAME_TABLE_COLUMN_DESC(TIMESTAMP, U64, uint64_t,
+				      TIMESTAMP, timestamp),
+	VMETA_FRAME_TABLE_COLUMN_DESC(LATITUDE, DOUBLE, double,
+				      LOCATION, location.latitude),
+	VMETA_FRAME_TABLE_COLUMN_DESC(LONGITUDE, DOUBLE, double,
+				      LOCATION, location.longitude),
+	VMETA_FRAME_TABLE_COLUMN_DESC(ALTITUDE_WGS84ELLIPSOID, DOUBLE, double,
+				      LOCATION,
+				      location.altitude_wgs84ellipsoid),
+	VMETA_FRAME_TABLE_COLUMN_DESC(ALTITUDE_EGM96AMSL, DOUBLE, double,
+				      LOCATION, location.altitude_egm96amsl),
+	VMETA_FRAME_TABLE_COLUMN_DESC(SPEED_NORTH, FLOAT, float,
+				      SPEED_NED, speed.north),
+	VMETA_FRAME_TABLE_COLUMN_DESC(SPEED_EAST, FLOAT, float,
+				      SPEED_NED, speed.east),
+	VMETA_FRAME_TABLE_COLUMN_DESC(SPEED_DOWN, FLOAT, float,
+				      SPEED_NED, speed.down),
+	VMETA_FRAME_TABLE_COLUMN_DESC(DRONE_QUAT_W, FLOAT, float,
+				      DRONE_QUAT, drone_quat.w),
+	VMETA_FRAME_TABLE_COLUMN_DESC(DRONE_QUAT_X, FLOAT, float,
+				      DRONE_QUAT, drone_quat.x),
+	VMETA_FRAME_TABLE_COLUMN_DESC(DRONE_QUAT_Y, FLOAT, float,
+				      DRONE_QUAT, drone_quat.y),
+	VMETA_FRAME_TABLE_COLUMN_DESC(DRONE_QUAT_Z, FLOAT, float,
+				      DRONE_QUAT, drone_quat.z),
+	VMETA_FRAME_TABLE_COLUMN_DESC(FRAME_QUAT_W, FLOAT, float,
+				      FRAME_QUAT, frame_quat.w),
+	VMETA_FRAME_TABLE_COLUMN_DESC(FRAME_QUAT_X, FLOAT, float,
+				      FRAME_QUAT, frame_quat.x),
+	VMETA_FRAME_TABLE_COLUMN_DESC(FRAME_QUAT_Y, FLOAT, float,
+				      FRAME_QUAT, frame_quat.y),
+	VMETA_FRAME_TABLE_COLUMN_DESC(FRAME_QUAT_Z, FLOAT, float,
+				      FRAME_QUAT, frame_quat.z),
+	VMETA_FRAME_TABLE_COLUMN_DESC(EXPOSURE_TIME, FLOAT, float,
+				      EXPOSURE_TIME, exposure_time),
+	VMETA_FRAME_TABLE_COLUMN_DESC(GAIN, U16, uint16_t,
+				      GAIN, gain),
+	VMETA_FRAME_TABLE_COLUMN_DESC(LINK_QUALITY, U8, uint8_t,
+				      LINK_QUALITY, link_quality),
+};
+/* clang-format on */
+
+
+int vmeta_frame_table_column_set(
+	const struct vmeta_frame_table_column_desc *desc,
+	const struct vmeta_frame_flat *flat,
+	uint8_t *value)
+{
+	if (flat->present & desc->field) {
+		memcpy(value, (const uint8_t *)flat + desc->offset, desc->size);
+		return 1;
+	}
+
+	switch (desc->type) {
+	case VMETA_FRAME_TABLE_TYPE_DOUBLE:
+		*(double *)value = NAN;
+		break;
+	case VMETA_FRAME_TABLE_TYPE_FLOAT:
+		*(float *)value = NAN;
+		break;
+	default:
+		memset(value, 0, desc->size);
+		break;
+	}
+	return 0;
+}
+
+
+struct vmeta_frame_table {
+	size_t count;
+	size_t capacity;
+
+	/* Column values and presence bitmaps */
+	uint8_t *columns[VMETA_FRAME_TABLE_COLUMN_COUNT];
+	uint8_t *presence[VMETA_FRAME_TABLE_COLUMN_COUNT];
+};
+
+
+static int vmeta_frame_table_grow(struct vmeta_frame_table *table,
+				  size_t capacity)
+{
+	uint8_t *p;
+
+	/* The capacity is only updated once all columns are reallocated, so
+	 * that a failure leaves the table usable */
+	for (unsigned int i = 0; i < VMETA_FRAME_TABLE_COLUMN_COUNT; i++) {
+		if (capacity > SIZE_MAX / vmeta_frame_table_columns[i].size)
+			goto enomem;
+		p = realloc(table->columns[i],
+			    capacity * vmeta_frame_table_columns[i].size);
+		if (p == NULL)
+			goto enomem;
+		table->columns[i] = p;
+		p = realloc(table->presence[i], (capacity + 7) / 8);
+		if (p == NULL)
+			goto enomem;
+		table->presence[i] = p;
+	}
+	table->capacity = capacity;
+
+	return 0;
+
+enomem:
+	ULOG_ERRNO("realloc", ENOMEM);
+	return -ENOMEM;
+}
+
+
+int vmeta_frame_table_new(size_t capacity, struct vmeta_frame_table **ret)
+{
+	int res;
+	struct vmeta_frame_table *table;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret == NULL, EINVAL);
+
+	table = calloc(1, sizeof(*table));
+	if (table == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	res = vmeta_frame_table_grow(
+		table,
+		capacity > 0 ? capacity : VMETA_FRAME_TABLE_DEFAULT_CAPACITY);
+	if (res < 0) {
+		vmeta_frame_table_destroy(table);
+		return res;
+	}
+
+	*ret = table;
+	return 0;
+}
+
+
+int vmeta_frame_table_destroy(struct vmeta_frame_table *table)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(table == NULL, EINVAL);
+
+	for (unsigned int i = 0; i < VMETA_FRAME_TABLE_COLUMN_COUNT; i++) {
+		free(table->columns[i]);
+		free(table->presence[i]);
+	}
+	free(table);
+
+	return 0;
+}
+
+
+int vmeta_frame_table_append(struct vmeta_frame_table *table,
+			     struct vmeta_frame *meta)
+{
+	int res;
+	size_t row;
+	uint8_t bit;
+	struct vmeta_frame_flat flat;
+
+	ULOG_ERRNO_RETURN_ERR_IF(table == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+
+	res = vmeta_frame_get_fields(meta, VMETA_FRAME_TABLE_FIELDS, &flat);
+	if (res < 0)
+		return res;
+
+	if (table->count == table->capacity) {
+		if (table->capacity > SIZE_MAX / 2) {
+			ULOGE("frame table capacity overflow");
+			return -ENOMEM;
+		}
+		res = vmeta_frame_table_grow(table, 2 * table->capacity);
+		if (res < 0)
+			return res;
+	}
+
+	row = table->count;
+	bit = 1 << (row % 8);
+	for (unsigned int i = 0; i < VMETA_FRAME_TABLE_COLUMN_COUNT; i++) {
+		const struct vmeta_frame_table_column_desc *desc;
+		uint8_t *presence;
+
+		desc = &vmeta_frame_table_columns[i];
+		presence = &table->presence[i][row / 8];
+		if (vmeta_frame_table_column_set(
+			    desc, &flat, table->columns[i] + row * desc->size))
+			*presence |= bit;
+		else
+			*presence &= ~bit;
+	}
+	table->count++;
+
+	return 0;
+}
+
+
+int vmeta_frame_table_clear(struct vmeta_frame_table *table)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(table == NULL, EINVAL);
+
+	table->count = 0;
+
+	return 0;
+}
+
+
+int vmeta_frame_table_get_count(struct vmeta_frame_table *table,
+				size_t *count)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(table == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(count == NULL, EINVAL);
+
+	*count = table->count;
+
+	return 0;
+}
+
+
+int vmeta_frame_table_get_column(struct vmeta_frame_table *table,
+				 enum vmeta_frame_table_column column,
+				 const void **data,
+				 const uint8_t **presence)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(table == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(column >= VMETA_FRAME_TABLE_COLUMN_COUNT,
+				 EINVAL);
+
+	if (data != NULL)
+		*data = table->columns[column];
+	if (presence != NULL)
+		*presence = table->presence[column];
+
+	return 0;
+}
@@ -154,67 +154,76 @@ out:
 }
 
 
-int vmeta_frame_v1_streaming_basic_to_json(
+int vmeta_frame_v1_streaming_basic_to_json_writer(
 	const struct vmeta_frame_v1_streaming_basic *meta,
-	struct json_object *jobj)
+	struct vmeta_json_writer *w)
 {
-	vmeta_json_add_euler(jobj, "drone_attitude", &meta->drone_attitude);
+	vmeta_json_add_euler(w, "drone_attitude", &meta->drone_attitude);
 
-	vmeta_json_add_quaternion(jobj, "frame_quat", &meta->frame_quat);
-	vmeta_json_add_double(jobj, "camera_pan", meta->camera_pan);
-	vmeta_json_add_double(jobj, "camera_tilt", meta->camera_tilt);
-	vmeta_json_add_double(jobj, "exposure_time", meta->exposure_time);
-	vmeta_json_add_int(jobj, "gain", meta->gain);
+	vmeta_json_add_quaternion(w, "frame_quat", &meta->frame_quat);
+	vmeta_json_add_double(w, "camera_pan", meta->camera_pan);
+	vmeta_json_add_double(w, "camera_tilt", meta->camera_tilt);
+	vmeta_json_add_double(w, "exposure_time", meta->exposure_time);
+	vmeta_json_add_int(w, "gain", meta->gain);
 
-	vmeta_json_add_int(jobj, "wifi_rssi", meta->wifi_rssi);
-	vmeta_json_add_int(
-		jobj, "battery_percentage", meta->battery_percentage);
+	vmeta_json_add_int(w, "wifi_rssi", meta->wifi_rssi);
+	vmeta_json_add_int(w, "battery_percentage", meta->battery_percentage);
 
 	return 0;
 }
 
 
-size_t vmeta_frame_v1_streaming_basic_to_csv(
+int vmeta_frame_v1_streaming_basic_to_json(
 	const struct vmeta_frame_v1_streaming_basic *meta,
-	char *str,
-	size_t maxlen)
+	struct json_object *jobj)
 {
-	size_t len = 0;
+	struct vmeta_json_writer w;
 
-	len += vmeta_csv_add_euler(
-		str + len, maxlen - len, &meta->drone_attitude);
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
+	vmeta_json_writer_init_object(&w, jobj);
+	vmeta_frame_v1_streaming_basic_to_json_writer(meta, &w);
+	return vmeta_json_writer_finish(&w);
+}
+
+
+void vmeta_frame_v1_streaming_basic_to_csv_writer(
+	const struct vmeta_frame_v1_streaming_basic *meta,
+	struct vmeta_csv_writer *w)
+{
 	struct vmeta_location loc;
-	memset(&loc, 0, sizeof(loc));
-	len += vmeta_csv_add_location(str + len, maxlen - len, &loc);
-	VMETA_STR_PRINT(str + len, len, maxlen - len, " %.2f %.2f ", 0., 0.);
 	struct vmeta_xyz speed;
+
+	memset(&loc, 0, sizeof(loc));
 	memset(&speed, 0, sizeof(speed));
-	len += vmeta_csv_add_xyz(str + len, maxlen - len, &speed);
-
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->frame_quat);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.4f %.4f %.4f %d",
-			meta->camera_pan,
-			meta->camera_tilt,
-			meta->exposure_time,
-			meta->gain);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d",
-			meta->wifi_rssi,
-			meta->battery_percentage);
 
-	VMETA_STR_PRINT(
-		str + len, len, maxlen - len, " %d %d %d %d", 0, 0, 0, 0);
+	vmeta_csv_add_euler(w, &meta->drone_attitude);
+	vmeta_csv_add_location(w, &loc);
+	vmeta_csv_add_double(w, 0., 2);
+	vmeta_csv_add_double(w, 0., 2);
+	vmeta_csv_add_xyz(w, &speed);
+	vmeta_csv_add_quaternion(w, &meta->frame_quat);
+	vmeta_csv_add_float(w, meta->camera_pan, 4);
+	vmeta_csv_add_float(w, meta->camera_tilt, 4);
+	vmeta_csv_add_float(w, meta->exposure_time, 4);
+	vmeta_csv_add_int(w, meta->gain);
+	vmeta_csv_add_int(w, meta->wifi_rssi);
+	vmeta_csv_add_int(w, meta->battery_percentage);
+	vmeta_csv_add_int(w, 0);
+	vmeta_csv_add_int(w, 0);
+	vmeta_csv_add_int(w, 0);
+	vmeta_csv_add_int(w, 0);
+}
 
-	return len;
+
+size_t vmeta_frame_v1_streaming_basic_to_csv(
+	const struct vmeta_frame_v1_streaming_basic *meta,
+	char *str,
+	size_t maxlen)
+{
+	struct vmeta_csv_writer w;
+
+	vmeta_csv_writer_init_str(&w, str, maxlen);
+	vmeta_frame_v1_streaming_basic_to_csv_writer(meta, &w);
+	return (size_t)vmeta_csv_writer_finish(&w);
 }
 
 
@@ -399,84 +408,80 @@ out:
 }
 
 
-int vmeta_frame_v1_streaming_extended_to_json(
+int vmeta_frame_v1_streaming_extended_to_json_writer(
 	const struct vmeta_frame_v1_streaming_extended *meta,
-	struct json_object *jobj)
+	struct vmeta_json_writer *w)
 {
-	vmeta_json_add_euler(jobj, "drone_attitude", &meta->drone_attitude);
-	vmeta_json_add_location(jobj, "location", &meta->location);
-	vmeta_json_add_double(jobj, "altitude", meta->altitude);
+	vmeta_json_add_euler(w, "drone_attitude", &meta->drone_attitude);
+	vmeta_json_add_location(w, "location", &meta->location);
+	vmeta_json_add_double(w, "altitude", meta->altitude);
 	vmeta_json_add_double(
-		jobj, "distance_from_home", meta->distance_from_home);
-	vmeta_json_add_xyz(jobj, "speed", &meta->speed);
+		w, "distance_from_home", meta->distance_from_home);
+	vmeta_json_add_xyz(w, "speed", &meta->speed);
 
-	vmeta_json_add_quaternion(jobj, "frame_quat", &meta->frame_quat);
-	vmeta_json_add_double(jobj, "camera_pan", meta->camera_pan);
-	vmeta_json_add_double(jobj, "camera_tilt", meta->camera_tilt);
-	vmeta_json_add_double(jobj, "exposure_time", meta->exposure_time);
-	vmeta_json_add_int(jobj, "gain", meta->gain);
+	vmeta_json_add_quaternion(w, "frame_quat", &meta->frame_quat);
+	vmeta_json_add_double(w, "camera_pan", meta->camera_pan);
+	vmeta_json_add_double(w, "camera_tilt", meta->camera_tilt);
+	vmeta_json_add_double(w, "exposure_time", meta->exposure_time);
+	vmeta_json_add_int(w, "gain", meta->gain);
 
-	vmeta_json_add_int(jobj, "wifi_rssi", meta->wifi_rssi);
-	vmeta_json_add_int(
-		jobj, "battery_percentage", meta->battery_percentage);
+	vmeta_json_add_int(w, "wifi_rssi", meta->wifi_rssi);
+	vmeta_json_add_int(w, "battery_percentage", meta->battery_percentage);
 
-	vmeta_json_add_int(jobj, "binning", meta->binning);
-	vmeta_json_add_int(jobj, "animation", meta->animation);
-	vmeta_json_add_str(jobj, "state", vmeta_flying_state_str(meta->state));
-	vmeta_json_add_str(jobj, "mode", vmeta_piloting_mode_str(meta->mode));
+	vmeta_json_add_int(w, "binning", meta->binning);
+	vmeta_json_add_int(w, "animation", meta->animation);
+	vmeta_json_add_str(w, "state", vmeta_flying_state_str(meta->state));
+	vmeta_json_add_str(w, "mode", vmeta_piloting_mode_str(meta->mode));
 
 	return 0;
 }
 
 
+int vmeta_frame_v1_streaming_extended_to_json(
+	const struct vmeta_frame_v1_streaming_extended *meta,
+	struct json_object *jobj)
+{
+	struct vmeta_json_writer w;
+
+	vmeta_json_writer_init_object(&w, jobj);
+	vmeta_frame_v1_streaming_extended_to_json_writer(meta, &w);
+	return vmeta_json_writer_finish(&w);
+}
+
+
+void vmeta_frame_v1_streaming_extended_to_csv_writer(
+	const struct vmeta_frame_v1_streaming_extended *meta,
+	struct vmeta_csv_writer *w)
+{
+	vmeta_csv_add_euler(w, &meta->drone_attitude);
+	vmeta_csv_add_location(w, &meta->location);
+	vmeta_csv_add_double(w, meta->altitude, 2);
+	vmeta_csv_add_double(w, meta->distance_from_home, 2);
+	vmeta_csv_add_xyz(w, &meta->speed);
+	vmeta_csv_add_quaternion(w, &meta->frame_quat);
+	vmeta_csv_add_float(w, meta->camera_pan, 4);
+	vmeta_csv_add_float(w, meta->camera_tilt, 4);
+	vmeta_csv_add_float(w, meta->exposure_time, 4);
+	vmeta_csv_add_int(w, meta->gain);
+	vmeta_csv_add_int(w, meta->wifi_rssi);
+	vmeta_csv_add_int(w, meta->battery_percentage);
+	vmeta_csv_add_int(w, meta->binning);
+	vmeta_csv_add_int(w, meta->animation);
+	vmeta_csv_add_int(w, meta->state);
+	vmeta_csv_add_int(w, meta->mode);
+}
+
+
 size_t vmeta_frame_v1_streaming_extended_to_csv(
 	const struct vmeta_frame_v1_streaming_extended *meta,
 	char *str,
 	size_t maxlen)
 {
-	size_t len = 0;
-
-	len += vmeta_csv_add_euler(
-		str + len, maxlen - len, &meta->drone_attitude);
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
-	len += vmeta_csv_add_location(str + len, maxlen - len, &meta->location);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.2f %.2f ",
-			meta->altitude,
-			meta->distance_from_home);
-	len += vmeta_csv_add_xyz(str + len, maxlen - len, &meta->speed);
-
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->frame_quat);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.4f %.4f %.4f %d",
-			meta->camera_pan,
-			meta->camera_tilt,
-			meta->exposure_time,
-			meta->gain);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d",
-			meta->wifi_rssi,
-			meta->battery_percentage);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d %d %d",
-			meta->binning,
-			meta->animation,
-			meta->state,
-			meta->mode);
+	struct vmeta_csv_writer w;
 
-	return len;
+	vmeta_csv_writer_init_str(&w, str, maxlen);
+	vmeta_frame_v1_streaming_extended_to_csv_writer(meta, &w);
+	return (size_t)vmeta_csv_writer_finish(&w);
 }
 
 
@@ -612,89 +617,82 @@ out:
 }
 
 
-int vmeta_frame_v1_recording_to_json(
+int vmeta_frame_v1_recording_to_json_writer(
 	const struct vmeta_frame_v1_recording *meta,
-	struct json_object *jobj)
+	struct vmeta_json_writer *w)
 {
-	vmeta_json_add_euler(jobj, "drone_attitude", &meta->drone_attitude);
-	vmeta_json_add_location(jobj, "location", &meta->location);
-	vmeta_json_add_double(jobj, "altitude", meta->altitude);
+	vmeta_json_add_euler(w, "drone_attitude", &meta->drone_attitude);
+	vmeta_json_add_location(w, "location", &meta->location);
+	vmeta_json_add_double(w, "altitude", meta->altitude);
 	vmeta_json_add_double(
-		jobj, "distance_from_home", meta->distance_from_home);
-	vmeta_json_add_xyz(jobj, "speed", &meta->speed);
+		w, "distance_from_home", meta->distance_from_home);
+	vmeta_json_add_xyz(w, "speed", &meta->speed);
 
-	vmeta_json_add_int64(jobj, "frame_timestamp", meta->frame_timestamp);
-	vmeta_json_add_quaternion(jobj, "frame_quat", &meta->frame_quat);
-	vmeta_json_add_double(jobj, "camera_pan", meta->camera_pan);
-	vmeta_json_add_double(jobj, "camera_tilt", meta->camera_tilt);
-	vmeta_json_add_double(jobj, "exposure_time", meta->exposure_time);
-	vmeta_json_add_int(jobj, "gain", meta->gain);
+	vmeta_json_add_int64(w, "frame_timestamp", meta->frame_timestamp);
+	vmeta_json_add_quaternion(w, "frame_quat", &meta->frame_quat);
+	vmeta_json_add_double(w, "camera_pan", meta->camera_pan);
+	vmeta_json_add_double(w, "camera_tilt", meta->camera_tilt);
+	vmeta_json_add_double(w, "exposure_time", meta->exposure_time);
+	vmeta_json_add_int(w, "gain", meta->gain);
 
-	vmeta_json_add_int(jobj, "wifi_rssi", meta->wifi_rssi);
-	vmeta_json_add_int(
-		jobj, "battery_percentage", meta->battery_percentage);
+	vmeta_json_add_int(w, "wifi_rssi", meta->wifi_rssi);
+	vmeta_json_add_int(w, "battery_percentage", meta->battery_percentage);
 
-	vmeta_json_add_int(jobj, "binning", meta->binning);
-	vmeta_json_add_int(jobj, "animation", meta->animation);
-	vmeta_json_add_str(jobj, "state", vmeta_flying_state_str(meta->state));
-	vmeta_json_add_str(jobj, "mode", vmeta_piloting_mode_str(meta->mode));
+	vmeta_json_add_int(w, "binning", meta->binning);
+	vmeta_json_add_int(w, "animation", meta->animation);
+	vmeta_json_add_str(w, "state", vmeta_flying_state_str(meta->state));
+	vmeta_json_add_str(w, "mode", vmeta_piloting_mode_str(meta->mode));
 
 	return 0;
 }
 
 
+int vmeta_frame_v1_recording_to_json(
+	const struct vmeta_frame_v1_recording *meta,
+	struct json_object *jobj)
+{
+	struct vmeta_json_writer w;
+
+	vmeta_json_writer_init_object(&w, jobj);
+	vmeta_frame_v1_recording_to_json_writer(meta, &w);
+	return vmeta_json_writer_finish(&w);
+}
+
+
+void vmeta_frame_v1_recording_to_csv_writer(
+	const struct vmeta_frame_v1_recording *meta,
+	struct vmeta_csv_writer *w)
+{
+	vmeta_csv_add_euler(w, &meta->drone_attitude);
+	vmeta_csv_add_location(w, &meta->location);
+	vmeta_csv_add_double(w, meta->altitude, 2);
+	vmeta_csv_add_double(w, meta->distance_from_home, 2);
+	vmeta_csv_add_xyz(w, &meta->speed);
+	vmeta_csv_add_uint(w, meta->frame_timestamp);
+	vmeta_csv_add_quaternion(w, &meta->frame_quat);
+	vmeta_csv_add_float(w, meta->camera_pan, 4);
+	vmeta_csv_add_float(w, meta->camera_tilt, 4);
+	vmeta_csv_add_float(w, meta->exposure_time, 4);
+	vmeta_csv_add_int(w, meta->gain);
+	vmeta_csv_add_int(w, meta->wifi_rssi);
+	vmeta_csv_add_int(w, meta->battery_percentage);
+	vmeta_csv_add_int(w, meta->binning);
+	vmeta_csv_add_int(w, meta->animation);
+	vmeta_csv_add_int(w, meta->state);
+	vmeta_csv_add_int(w, meta->mode);
+}
+
+
 size_t
 vmeta_frame_v1_recording_to_csv(const struct vmeta_frame_v1_recording *meta,
 				char *str,
 				size_t maxlen)
 {
-	size_t len = 0;
-
-	len += vmeta_csv_add_euler(
-		str + len, maxlen - len, &meta->drone_attitude);
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
-	len += vmeta_csv_add_location(str + len, maxlen - len, &meta->location);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.2f %.2f ",
-			meta->altitude,
-			meta->distance_from_home);
-	len += vmeta_csv_add_xyz(str + len, maxlen - len, &meta->speed);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %" PRIu64 " ",
-			meta->frame_timestamp);
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->frame_quat);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.4f %.4f %.4f %d",
-			meta->camera_pan,
-			meta->camera_tilt,
-			meta->exposure_time,
-			meta->gain);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d",
-			meta->wifi_rssi,
-			meta->battery_percentage);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d %d %d",
-			meta->binning,
-			meta->animation,
-			meta->state,
-			meta->mode);
+	struct vmeta_csv_writer w;
 
-	return len;
+	vmeta_csv_writer_init_str(&w, str, maxlen);
+	vmeta_frame_v1_recording_to_csv_writer(meta, &w);
+	return (size_t)vmeta_csv_writer_finish(&w);
 }
 
 
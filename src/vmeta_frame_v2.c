@@ -31,6 +31,36 @@
 /* clang-format on */
 
 
+/* Size of the base fields, after the id and length */
+#define VMETA_FRAME_V2_BASE_FIELDS_SIZE 52
+
+#define VMETA_FRAME_V2_Q8 (1.f / (1 << 8))
+#define VMETA_FRAME_V2_Q12 (1.f / (1 << 12))
+#define VMETA_FRAME_V2_Q14 (1.f / (1 << 14))
+
+
+/* Signed 16-bit base fields: speed (north, east, down), air speed, the
+ * drone and frame quaternions (w, x, y, z), camera pan and tilt, and
+ * exposure time */
+static const float s_base_i16_scale[15] = {
+	VMETA_FRAME_V2_Q8,
+	VMETA_FRAME_V2_Q8,
+	VMETA_FRAME_V2_Q8,
+	VMETA_FRAME_V2_Q8,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q14,
+	VMETA_FRAME_V2_Q12,
+	VMETA_FRAME_V2_Q12,
+	VMETA_FRAME_V2_Q8,
+};
+
+
 int vmeta_frame_v2_write(struct vmeta_buffer *buf,
 			 const struct vmeta_frame_v2 *meta)
 {
@@ -131,6 +161,8 @@ int vmeta_frame_v2_read(struct vmeta_buffer *buf, struct vmeta_frame_v2 *meta)
 	int32_t gps_altitude = 0;
 	int32_t gps_altitude_and_sv_count = 0;
 	uint8_t state = 0, mode = 0;
+	const uint8_t *p;
+	float i16[15];
 	struct vmeta_frame_v2_base *base = NULL;
 	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
@@ -162,31 +194,41 @@ int vmeta_frame_v2_read(struct vmeta_buffer *buf, struct vmeta_frame_v2 *meta)
 		goto out;
 	}
 
-	/* Read base fields */
-	CHECK(vmeta_read_f64_i32(buf, &base->ground_distance, 16));
-	CHECK(vmeta_read_f64_i32(buf, &location.latitude, 22));
-	CHECK(vmeta_read_f64_i32(buf, &location.longitude, 22));
-	CHECK(vmeta_read_i32(buf, &gps_altitude_and_sv_count));
-	CHECK(vmeta_read_f32_i16(buf, &base->speed.north, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->speed.east, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->speed.down, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->air_speed, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.w, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.x, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.y, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.z, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.w, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.x, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.y, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.z, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->camera_pan, 12));
-	CHECK(vmeta_read_f32_i16(buf, &base->camera_tilt, 12));
-	CHECK(vmeta_read_f32_i16(buf, &base->exposure_time, 8));
-	CHECK(vmeta_read_u16(buf, &base->gain));
-	CHECK(vmeta_read_u8(buf, &state));
-	CHECK(vmeta_read_u8(buf, &mode));
-	CHECK(vmeta_read_i8(buf, &base->wifi_rssi));
-	CHECK(vmeta_read_u8(buf, &base->battery_percentage));
+	/* Read base fields: the fixed-size block is bounds-checked once, then
+	 * decoded directly from the buffer */
+	if (buf->len - buf->pos < VMETA_FRAME_V2_BASE_FIELDS_SIZE) {
+		res = -ENOBUFS;
+		ULOG_ERRNO("vmeta_frame_v2: base fields", -res);
+		goto out;
+	}
+	p = buf->cdata + buf->pos;
+	base->ground_distance = (double)(int32_t)vmeta_load_u32(p) / (1 << 16);
+	location.latitude = (double)(int32_t)vmeta_load_u32(p + 4) / (1 << 22);
+	location.longitude = (double)(int32_t)vmeta_load_u32(p + 8) / (1 << 22);
+	gps_altitude_and_sv_count = (int32_t)vmeta_load_u32(p + 12);
+	vmeta_decode_f32_i16(p + 16, s_base_i16_scale, i16, 15);
+	base->gain = vmeta_load_u16(p + 46);
+	state = p[48];
+	mode = p[49];
+	base->wifi_rssi = (int8_t)p[50];
+	base->battery_percentage = p[51];
+	buf->pos += VMETA_FRAME_V2_BASE_FIELDS_SIZE;
+
+	base->speed.north = i16[0];
+	base->speed.east = i16[1];
+	base->speed.down = i16[2];
+	base->air_speed = i16[3];
+	base->drone_quat.w = i16[4];
+	base->drone_quat.x = i16[5];
+	base->drone_quat.y = i16[6];
+	base->drone_quat.z = i16[7];
+	base->frame_quat.w = i16[8];
+	base->frame_quat.x = i16[9];
+	base->frame_quat.y = i16[10];
+	base->frame_quat.z = i16[11];
+	base->camera_pan = i16[12];
+	base->camera_tilt = i16[13];
+	base->exposure_time = i16[14];
 
 	/* Unpack some fields manually */
 	gps_altitude = (gps_altitude_and_sv_count & 0xffffff00) >> 8;
@@ -256,145 +298,117 @@ out:
 }
 
 
-int vmeta_frame_v2_to_json(const struct vmeta_frame_v2 *meta,
-			   struct json_object *jobj)
+int vmeta_frame_v2_to_json_writer(const struct vmeta_frame_v2 *meta,
+				  struct vmeta_json_writer *w)
 {
-	vmeta_json_add_quaternion(jobj, "drone_quat", &meta->base.drone_quat);
-	vmeta_json_add_location(jobj, "location", &meta->base.location);
-	vmeta_json_add_double(
-		jobj, "ground_distance", meta->base.ground_distance);
-	vmeta_json_add_ned(jobj, "speed", &meta->base.speed);
-	vmeta_json_add_double(jobj, "air_speed", meta->base.air_speed);
-
-	vmeta_json_add_quaternion(jobj, "frame_quat", &meta->base.frame_quat);
-	vmeta_json_add_double(jobj, "camera_pan", meta->base.camera_pan);
-	vmeta_json_add_double(jobj, "camera_tilt", meta->base.camera_tilt);
-	vmeta_json_add_double(jobj, "exposure_time", meta->base.exposure_time);
-	vmeta_json_add_int(jobj, "gain", meta->base.gain);
-
-	vmeta_json_add_int(jobj, "wifi_rssi", meta->base.wifi_rssi);
+	vmeta_json_add_quaternion(w, "drone_quat", &meta->base.drone_quat);
+	vmeta_json_add_location(w, "location", &meta->base.location);
+	vmeta_json_add_double(w, "ground_distance", meta->base.ground_distance);
+	vmeta_json_add_ned(w, "speed", &meta->base.speed);
+	vmeta_json_add_double(w, "air_speed", meta->base.air_speed);
+
+	vmeta_json_add_quaternion(w, "frame_quat", &meta->base.frame_quat);
+	vmeta_json_add_double(w, "camera_pan", meta->base.camera_pan);
+	vmeta_json_add_double(w, "camera_tilt", meta->base.camera_tilt);
+	vmeta_json_add_double(w, "exposure_time", meta->base.exposure_time);
+	vmeta_json_add_int(w, "gain", meta->base.gain);
+
+	vmeta_json_add_int(w, "wifi_rssi", meta->base.wifi_rssi);
 	vmeta_json_add_int(
-		jobj, "battery_percentage", meta->base.battery_percentage);
+		w, "battery_percentage", meta->base.battery_percentage);
 
-	vmeta_json_add_int(jobj, "binning", meta->base.binning);
-	vmeta_json_add_int(jobj, "animation", meta->base.animation);
-	vmeta_json_add_str(
-		jobj, "state", vmeta_flying_state_str(meta->base.state));
+	vmeta_json_add_int(w, "binning", meta->base.binning);
+	vmeta_json_add_int(w, "animation", meta->base.animation);
 	vmeta_json_add_str(
-		jobj, "mode", vmeta_piloting_mode_str(meta->base.mode));
+		w, "state", vmeta_flying_state_str(meta->base.state));
+	vmeta_json_add_str(w, "mode", vmeta_piloting_mode_str(meta->base.mode));
 
 	if (meta->has_timestamp) {
-		vmeta_json_add_int64(jobj,
-				     "frame_timestamp",
-				     meta->timestamp.frame_timestamp);
+		vmeta_json_add_int64(
+			w, "frame_timestamp", meta->timestamp.frame_timestamp);
 	}
 
 	if (meta->has_followme) {
-		struct json_object *jobj_followme = json_object_new_object();
-		vmeta_json_add_location(
-			jobj_followme, "target", &meta->followme.target);
+		vmeta_json_begin_object(w, "followme");
+		vmeta_json_add_location(w, "target", &meta->followme.target);
+		vmeta_json_add_int(w, "enabled", meta->followme.enabled);
+		vmeta_json_add_int(w, "mode", meta->followme.mode);
 		vmeta_json_add_int(
-			jobj_followme, "enabled", meta->followme.enabled);
-		vmeta_json_add_int(jobj_followme, "mode", meta->followme.mode);
-		vmeta_json_add_int(jobj_followme,
-				   "angle_locked",
-				   meta->followme.angle_locked);
+			w, "angle_locked", meta->followme.angle_locked);
 		vmeta_json_add_str(
-			jobj_followme,
+			w,
 			"animation",
 			vmeta_followme_anim_str(meta->followme.animation));
-		json_object_object_add(jobj, "followme", jobj_followme);
+		vmeta_json_end_object(w);
 	}
 
 	return 0;
 }
 
 
-size_t vmeta_frame_v2_to_csv(const struct vmeta_frame_v2 *meta,
-			     char *str,
-			     size_t maxlen)
+int vmeta_frame_v2_to_json(const struct vmeta_frame_v2 *meta,
+			   struct json_object *jobj)
 {
-	size_t len = 0;
+	struct vmeta_json_writer w;
 
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->base.drone_quat);
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
-	len += vmeta_csv_add_location(
-		str + len, maxlen - len, &meta->base.location);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.2f ",
-			meta->base.ground_distance);
-	len += vmeta_csv_add_ned(str + len, maxlen - len, &meta->base.speed);
-	VMETA_STR_PRINT(
-		str + len, len, maxlen - len, " %.3f ", meta->base.air_speed);
-
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->base.frame_quat);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.4f %.4f %.4f %d",
-			meta->base.camera_pan,
-			meta->base.camera_tilt,
-			meta->base.exposure_time,
-			meta->base.gain);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d",
-			meta->base.wifi_rssi,
-			meta->base.battery_percentage);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d %d %d",
-			meta->base.binning,
-			meta->base.animation,
-			meta->base.state,
-			meta->base.mode);
+	vmeta_json_writer_init_object(&w, jobj);
+	vmeta_frame_v2_to_json_writer(meta, &w);
+	return vmeta_json_writer_finish(&w);
+}
 
-	if (meta->has_timestamp) {
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %" PRIu64,
-				meta->timestamp.frame_timestamp);
-	} else {
-		VMETA_STR_PRINT(str + len, len, maxlen - len, " 0");
-	}
+
+void vmeta_frame_v2_to_csv_writer(const struct vmeta_frame_v2 *meta,
+				  struct vmeta_csv_writer *w)
+{
+	vmeta_csv_add_quaternion(w, &meta->base.drone_quat);
+	vmeta_csv_add_location(w, &meta->base.location);
+	vmeta_csv_add_double(w, meta->base.ground_distance, 2);
+	vmeta_csv_add_ned(w, &meta->base.speed);
+	vmeta_csv_add_float(w, meta->base.air_speed, 3);
+	vmeta_csv_add_quaternion(w, &meta->base.frame_quat);
+	vmeta_csv_add_float(w, meta->base.camera_pan, 4);
+	vmeta_csv_add_float(w, meta->base.camera_tilt, 4);
+	vmeta_csv_add_float(w, meta->base.exposure_time, 4);
+	vmeta_csv_add_int(w, meta->base.gain);
+	vmeta_csv_add_int(w, meta->base.wifi_rssi);
+	vmeta_csv_add_int(w, meta->base.battery_percentage);
+	vmeta_csv_add_int(w, meta->base.binning);
+	vmeta_csv_add_int(w, meta->base.animation);
+	vmeta_csv_add_int(w, meta->base.state);
+	vmeta_csv_add_int(w, meta->base.mode);
+
+	vmeta_csv_add_uint(w,
+			   meta->has_timestamp
+				   ? meta->timestamp.frame_timestamp
+				   : 0);
 
 	if (meta->has_followme) {
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_location(
-			str + len, maxlen - len, &meta->followme.target);
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %d %d %d %d",
-				meta->followme.enabled,
-				meta->followme.mode,
-				meta->followme.angle_locked,
-				meta->followme.animation);
+		vmeta_csv_add_location(w, &meta->followme.target);
+		vmeta_csv_add_int(w, meta->followme.enabled);
+		vmeta_csv_add_int(w, meta->followme.mode);
+		vmeta_csv_add_int(w, meta->followme.angle_locked);
+		vmeta_csv_add_int(w, meta->followme.animation);
 	} else {
 		struct vmeta_location loc;
 		memset(&loc, 0, sizeof(loc));
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_location(str + len, maxlen - len, &loc);
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %d %d %d %d",
-				0,
-				0,
-				0,
-				0);
+		vmeta_csv_add_location(w, &loc);
+		vmeta_csv_add_int(w, 0);
+		vmeta_csv_add_int(w, 0);
+		vmeta_csv_add_int(w, 0);
+		vmeta_csv_add_int(w, 0);
 	}
+}
 
-	return len;
+
+size_t vmeta_frame_v2_to_csv(const struct vmeta_frame_v2 *meta,
+			     char *str,
+			     size_t maxlen)
+{
+	struct vmeta_csv_writer w;
+
+	vmeta_csv_writer_init_str(&w, str, maxlen);
+	vmeta_frame_v2_to_csv_writer(meta, &w);
+	return (size_t)vmeta_csv_writer_finish(&w);
 }
 
 
@@ -420,6 +434,8 @@ size_t vmeta_frame_v2_csv_header(char *str, size_t maxlen)
 		"followme_target_longitude "
 		"followme_target_altitude_wgs84ellipsoid "
 		"followme_target_altitude_egm96amsl "
+		"followme_target_horizontal_accuracy "
+		"followme_target_vertical_accuracy "
 		"followme_target_sv_count "
 		"followme_enabled followme_mode "
 		"followme_angle_locked followme_animation");
@@ -31,6 +31,47 @@
 /* clang-format on */
 
 
+/* Size of the base fields, after the id and length */
+#define VMETA_FRAME_V3_BASE_FIELDS_SIZE 68
+
+#define VMETA_FRAME_V3_Q8 (1.f / (1 << 8))
+#define VMETA_FRAME_V3_Q14 (1.f / (1 << 14))
+
+
+/* Signed 16-bit base fields: speed (north, east, down), air speed, then the
+ * drone, frame base and frame quaternions (w, x, y, z) */
+static const float s_base_i16_scale[16] = {
+	VMETA_FRAME_V3_Q8,
+	VMETA_FRAME_V3_Q8,
+	VMETA_FRAME_V3_Q8,
+	VMETA_FRAME_V3_Q8,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+};
+
+
+/* Unsigned 16-bit base fields: exposure time, gain (integer), AWB red and
+ * blue gains, picture horizontal and vertical fields of view */
+static const float s_base_u16_scale[6] = {
+	VMETA_FRAME_V3_Q8,
+	1.f,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q14,
+	VMETA_FRAME_V3_Q8,
+	VMETA_FRAME_V3_Q8,
+};
+
+
 int vmeta_frame_v3_write(struct vmeta_buffer *buf,
 			 const struct vmeta_frame_v3 *meta)
 {
@@ -135,6 +176,227 @@ out:
 }
 
 
+/* Location with the proto altitude conventions applied (see
+ * vmeta_frame_convert()) */
+static void v3_proto_location_adjust(const struct vmeta_location *in,
+				     struct vmeta_location *out)
+{
+	*out = *in;
+	if (isnan(out->altitude_wgs84ellipsoid))
+		out->altitude_wgs84ellipsoid = 0.;
+	else if (out->altitude_wgs84ellipsoid == 0.)
+		out->altitude_wgs84ellipsoid = DBL_MIN;
+	if (isnan(out->altitude_egm96amsl))
+		out->altitude_egm96amsl = 0.;
+	else if (out->altitude_egm96amsl == 0.)
+		out->altitude_egm96amsl = DBL_MIN;
+}
+
+
+static void v3_proto_location(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_location *loc = msg;
+
+	vmeta_proto_wire_double(w, 1, loc->latitude);
+	vmeta_proto_wire_double(w, 2, loc->longitude);
+	vmeta_proto_wire_double(w, 3, loc->altitude_wgs84ellipsoid);
+	vmeta_proto_wire_uint32(w, 4, loc->sv_count);
+	vmeta_proto_wire_float(w, 5, loc->horizontal_accuracy);
+	vmeta_proto_wire_float(w, 6, loc->vertical_accuracy);
+	vmeta_proto_wire_double(w, 7, loc->altitude_egm96amsl);
+}
+
+
+static void v3_proto_quat(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_quaternion *quat = msg;
+
+	vmeta_proto_wire_float(w, 1, quat->w);
+	vmeta_proto_wire_float(w, 2, quat->x);
+	vmeta_proto_wire_float(w, 3, quat->y);
+	vmeta_proto_wire_float(w, 4, quat->z);
+}
+
+
+static void v3_proto_ned(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_ned *ned = msg;
+
+	vmeta_proto_wire_float(w, 1, ned->north);
+	vmeta_proto_wire_float(w, 2, ned->east);
+	vmeta_proto_wire_float(w, 3, ned->down);
+}
+
+
+static void v3_proto_thermal_spot(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_thermal_spot *spot = msg;
+
+	vmeta_proto_wire_float(w, 1, spot->x);
+	vmeta_proto_wire_float(w, 2, spot->y);
+	vmeta_proto_wire_float(w, 3, spot->temp);
+	vmeta_proto_wire_int32(w, 4, spot->value);
+}
+
+
+static void v3_proto_drone(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_frame_v3_base *base = msg;
+	struct vmeta_location loc;
+
+	vmeta_proto_wire_message(w, 1, &v3_proto_quat, &base->drone_quat);
+	if (base->location.valid) {
+		v3_proto_location_adjust(&base->location, &loc);
+		vmeta_proto_wire_message(w, 2, &v3_proto_location, &loc);
+	}
+	vmeta_proto_wire_double(w, 3, base->ground_distance);
+	vmeta_proto_wire_message(w, 4, &v3_proto_ned, &base->speed);
+	vmeta_proto_wire_sint32(w, 5, base->battery_percentage);
+	vmeta_proto_wire_int32(
+		w, 7, vmeta_frame_flying_state_vmeta_to_proto(base->state));
+	vmeta_proto_wire_bool(w, 11, base->animation);
+	vmeta_proto_wire_int32(
+		w, 12, vmeta_frame_piloting_mode_vmeta_to_proto(base->mode));
+	/* Altitude above takeoff is not available in v3 */
+	vmeta_proto_wire_double(w, 13, NAN);
+}
+
+
+static void v3_proto_camera(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_frame_v3 *meta = msg;
+	const struct vmeta_frame_v3_base *base = &meta->base;
+
+	if (meta->has_timestamp)
+		vmeta_proto_wire_uint64(w, 1, meta->timestamp.frame_timestamp);
+	vmeta_proto_wire_message(w, 2, &v3_proto_quat, &base->frame_base_quat);
+	vmeta_proto_wire_message(w, 3, &v3_proto_quat, &base->frame_quat);
+	vmeta_proto_wire_float(w, 4, base->exposure_time);
+	vmeta_proto_wire_uint32(w, 5, base->gain);
+	vmeta_proto_wire_float(w, 6, base->awb_r_gain);
+	vmeta_proto_wire_float(w, 7, base->awb_b_gain);
+	/* Fields of view, deg->rad */
+	vmeta_proto_wire_float(w, 8, base->picture_hfov * M_PI / 180.);
+	vmeta_proto_wire_float(w, 9, base->picture_vfov * M_PI / 180.);
+	/* Zoom level is not available in v3 */
+	vmeta_proto_wire_float(w, 16, NAN);
+}
+
+
+static void v3_proto_wifi(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_frame_v3_base *base = msg;
+
+	vmeta_proto_wire_uint32(w, 1, base->link_goodput);
+	vmeta_proto_wire_uint32(w, 2, (uint32_t)base->link_quality);
+	vmeta_proto_wire_sint32(w, 3, base->wifi_rssi);
+}
+
+
+static void v3_proto_link(struct vmeta_proto_wire *w, const void *msg)
+{
+	vmeta_proto_wire_message(w, 1, &v3_proto_wifi, msg);
+}
+
+
+static void v3_proto_automation(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_frame_ext_automation *automation = msg;
+	struct vmeta_location loc;
+
+	if (automation->flight_destination.valid) {
+		v3_proto_location_adjust(&automation->flight_destination,
+					 &loc);
+		vmeta_proto_wire_message(w, 1, &v3_proto_location, &loc);
+	}
+	if (automation->framing_target.valid) {
+		v3_proto_location_adjust(&automation->framing_target, &loc);
+		vmeta_proto_wire_message(w, 2, &v3_proto_location, &loc);
+	}
+	vmeta_proto_wire_bool(w, 3, automation->followme_enabled);
+	vmeta_proto_wire_bool(w, 4, automation->lookatme_enabled);
+	vmeta_proto_wire_bool(w, 5, automation->angle_locked);
+	vmeta_proto_wire_int32(w,
+			       6,
+			       vmeta_frame_automation_anim_vmeta_to_proto(
+				       automation->animation));
+}
+
+
+static void v3_proto_thermal(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_frame_ext_thermal *thermal = msg;
+
+	vmeta_proto_wire_int32(w,
+			       1,
+			       vmeta_frame_thermal_calib_state_vmeta_to_proto(
+				       thermal->calib_state));
+	if (thermal->min.valid)
+		vmeta_proto_wire_message(
+			w, 2, &v3_proto_thermal_spot, &thermal->min);
+	if (thermal->max.valid)
+		vmeta_proto_wire_message(
+			w, 3, &v3_proto_thermal_spot, &thermal->max);
+	if (thermal->probe.valid)
+		vmeta_proto_wire_message(
+			w, 4, &v3_proto_thermal_spot, &thermal->probe);
+}
+
+
+static void v3_proto_lfic(struct vmeta_proto_wire *w, const void *msg)
+{
+	const struct vmeta_frame_ext_lfic *lfic = msg;
+	struct vmeta_location loc;
+
+	vmeta_proto_wire_float(w, 1, lfic->target_x);
+	vmeta_proto_wire_float(w, 2, lfic->target_y);
+	if (lfic->target_location.valid) {
+		v3_proto_location_adjust(&lfic->target_location, &loc);
+		loc.horizontal_accuracy = lfic->estimated_precision;
+		loc.vertical_accuracy = lfic->estimated_precision;
+		vmeta_proto_wire_message(w, 3, &v3_proto_location, &loc);
+	}
+	vmeta_proto_wire_double(w, 4, lfic->grid_precision);
+	vmeta_proto_wire_int32(w, 5, VMETA__LFIC_TYPE__LFIC_TYPE_COT);
+}
+
+
+int vmeta_frame_v3_write_proto(struct vmeta_buffer *buf,
+			       const struct vmeta_frame_v3 *meta)
+{
+	struct vmeta_proto_wire w;
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf->data == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf->pos > buf->len, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+
+	/* The TimedMetadata fields are written in field number order, with
+	 * the same content as a vmeta_frame_convert() to proto */
+	vmeta_proto_wire_init(&w, buf->data + buf->pos, buf->len - buf->pos);
+	vmeta_proto_wire_message(&w, 1, &v3_proto_drone, &meta->base);
+	vmeta_proto_wire_message(&w, 2, &v3_proto_camera, meta);
+	vmeta_proto_wire_message(&w, 3, &v3_proto_link, &meta->base);
+	if (meta->has_automation)
+		vmeta_proto_wire_message(
+			&w, 6, &v3_proto_automation, &meta->automation);
+	if (meta->has_thermal)
+		vmeta_proto_wire_message(
+			&w, 7, &v3_proto_thermal, &meta->thermal);
+	if (meta->has_lfic)
+		vmeta_proto_wire_message(&w, 8, &v3_proto_lfic, &meta->lfic);
+
+	if (w.overflow) {
+		ULOGE("vmeta_frame_v3: proto: %zu bytes needed, %zu available",
+		      w.pos,
+		      buf->len - buf->pos);
+		return -ENOBUFS;
+	}
+
+	buf->pos += w.pos;
+	return 0;
+}
+
+
 int vmeta_frame_v3_read(struct vmeta_buffer *buf, struct vmeta_frame_v3 *meta)
 {
 	int res = 0;
@@ -145,6 +407,8 @@ int vmeta_frame_v3_read(struct vmeta_buffer *buf, struct vmeta_frame_v3 *meta)
 	int32_t gpsAltitudeAndSvCount = 0;
 	uint32_t link_quality = 0;
 	uint8_t state = 0, mode = 0;
+	const uint8_t *p;
+	float i16[16], u16[6];
 	struct vmeta_frame_v3_base *base = NULL;
 	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
@@ -176,38 +440,49 @@ int vmeta_frame_v3_read(struct vmeta_buffer *buf, struct vmeta_frame_v3 *meta)
 		goto out;
 	}
 
-	/* Read base fields */
-	CHECK(vmeta_read_f64_i32(buf, &base->ground_distance, 16));
-	CHECK(vmeta_read_f64_i32(buf, &location.latitude, 22));
-	CHECK(vmeta_read_f64_i32(buf, &location.longitude, 22));
-	CHECK(vmeta_read_i32(buf, &gpsAltitudeAndSvCount));
-	CHECK(vmeta_read_f32_i16(buf, &base->speed.north, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->speed.east, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->speed.down, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->air_speed, 8));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.w, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.x, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.y, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->drone_quat.z, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_base_quat.w, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_base_quat.x, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_base_quat.y, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_base_quat.z, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.w, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.x, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.y, 14));
-	CHECK(vmeta_read_f32_i16(buf, &base->frame_quat.z, 14));
-	CHECK(vmeta_read_f32_u16(buf, &base->exposure_time, 8));
-	CHECK(vmeta_read_u16(buf, &base->gain));
-	CHECK(vmeta_read_f32_u16(buf, &base->awb_r_gain, 14));
-	CHECK(vmeta_read_f32_u16(buf, &base->awb_b_gain, 14));
-	CHECK(vmeta_read_f32_u16(buf, &base->picture_hfov, 8));
-	CHECK(vmeta_read_f32_u16(buf, &base->picture_vfov, 8));
-	CHECK(vmeta_read_u32(buf, &link_quality));
-	CHECK(vmeta_read_i8(buf, &base->wifi_rssi));
-	CHECK(vmeta_read_u8(buf, &base->battery_percentage));
-	CHECK(vmeta_read_u8(buf, &state));
-	CHECK(vmeta_read_u8(buf, &mode));
+	/* Read base fields: the fixed-size block is bounds-checked once, then
+	 * decoded directly from the buffer */
+	if (buf->len - buf->pos < VMETA_FRAME_V3_BASE_FIELDS_SIZE) {
+		res = -ENOBUFS;
+		ULOG_ERRNO("vmeta_frame_v3: base fields", -res);
+		goto out;
+	}
+	p = buf->cdata + buf->pos;
+	base->ground_distance = (double)(int32_t)vmeta_load_u32(p) / (1 << 16);
+	location.latitude = (double)(int32_t)vmeta_load_u32(p + 4) / (1 << 22);
+	location.longitude = (double)(int32_t)vmeta_load_u32(p + 8) / (1 << 22);
+	gpsAltitudeAndSvCount = (int32_t)vmeta_load_u32(p + 12);
+	vmeta_decode_f32_i16(p + 16, s_base_i16_scale, i16, 16);
+	vmeta_decode_f32_u16(p + 48, s_base_u16_scale, u16, 6);
+	link_quality = vmeta_load_u32(p + 60);
+	base->wifi_rssi = (int8_t)p[64];
+	base->battery_percentage = p[65];
+	state = p[66];
+	mode = p[67];
+	buf->pos += VMETA_FRAME_V3_BASE_FIELDS_SIZE;
+
+	base->speed.north = i16[0];
+	base->speed.east = i16[1];
+	base->speed.down = i16[2];
+	base->air_speed = i16[3];
+	base->drone_quat.w = i16[4];
+	base->drone_quat.x = i16[5];
+	base->drone_quat.y = i16[6];
+	base->drone_quat.z = i16[7];
+	base->frame_base_quat.w = i16[8];
+	base->frame_base_quat.x = i16[9];
+	base->frame_base_quat.y = i16[10];
+	base->frame_base_quat.z = i16[11];
+	base->frame_quat.w = i16[12];
+	base->frame_quat.x = i16[13];
+	base->frame_quat.y = i16[14];
+	base->frame_quat.z = i16[15];
+	base->exposure_time = u16[0];
+	base->gain = (uint16_t)u16[1];
+	base->awb_r_gain = u16[2];
+	base->awb_b_gain = u16[3];
+	base->picture_hfov = u16[4];
+	base->picture_vfov = u16[5];
 
 	/* Unpack some fields manually */
 	gpsAltitude = (gpsAltitudeAndSvCount & 0xffffff00) >> 8;
@@ -290,251 +565,192 @@ out:
 }
 
 
-int vmeta_frame_v3_to_json(const struct vmeta_frame_v3 *meta,
-			   struct json_object *jobj)
+int vmeta_frame_v3_to_json_writer(const struct vmeta_frame_v3 *meta,
+				  struct vmeta_json_writer *w)
 {
-	vmeta_json_add_quaternion(jobj, "drone_quat", &meta->base.drone_quat);
-	vmeta_json_add_location(jobj, "location", &meta->base.location);
-	vmeta_json_add_double(
-		jobj, "ground_distance", meta->base.ground_distance);
-	vmeta_json_add_ned(jobj, "speed", &meta->base.speed);
-	vmeta_json_add_double(jobj, "air_speed", meta->base.air_speed);
+	vmeta_json_add_quaternion(w, "drone_quat", &meta->base.drone_quat);
+	vmeta_json_add_location(w, "location", &meta->base.location);
+	vmeta_json_add_double(w, "ground_distance", meta->base.ground_distance);
+	vmeta_json_add_ned(w, "speed", &meta->base.speed);
+	vmeta_json_add_double(w, "air_speed", meta->base.air_speed);
 
 	vmeta_json_add_quaternion(
-		jobj, "frame_base_quat", &meta->base.frame_base_quat);
-	vmeta_json_add_quaternion(jobj, "frame_quat", &meta->base.frame_quat);
-	vmeta_json_add_double(jobj, "exposure_time", meta->base.exposure_time);
-	vmeta_json_add_int(jobj, "gain", meta->base.gain);
-	vmeta_json_add_double(jobj, "awb_r_gain", meta->base.awb_r_gain);
-	vmeta_json_add_double(jobj, "awb_b_gain", meta->base.awb_b_gain);
-	vmeta_json_add_double(jobj, "picture_hfov", meta->base.picture_hfov);
-	vmeta_json_add_double(jobj, "picture_vfov", meta->base.picture_vfov);
-
-	vmeta_json_add_int(jobj, "link_goodput", meta->base.link_goodput);
-	vmeta_json_add_int(jobj, "link_quality", meta->base.link_quality);
-	vmeta_json_add_int(jobj, "wifi_rssi", meta->base.wifi_rssi);
+		w, "frame_base_quat", &meta->base.frame_base_quat);
+	vmeta_json_add_quaternion(w, "frame_quat", &meta->base.frame_quat);
+	vmeta_json_add_double(w, "exposure_time", meta->base.exposure_time);
+	vmeta_json_add_int(w, "gain", meta->base.gain);
+	vmeta_json_add_double(w, "awb_r_gain", meta->base.awb_r_gain);
+	vmeta_json_add_double(w, "awb_b_gain", meta->base.awb_b_gain);
+	vmeta_json_add_double(w, "picture_hfov", meta->base.picture_hfov);
+	vmeta_json_add_double(w, "picture_vfov", meta->base.picture_vfov);
+
+	vmeta_json_add_int(w, "link_goodput", meta->base.link_goodput);
+	vmeta_json_add_int(w, "link_quality", meta->base.link_quality);
+	vmeta_json_add_int(w, "wifi_rssi", meta->base.wifi_rssi);
 	vmeta_json_add_int(
-		jobj, "battery_percentage", meta->base.battery_percentage);
+		w, "battery_percentage", meta->base.battery_percentage);
 
-	vmeta_json_add_int(jobj, "animation", meta->base.animation);
+	vmeta_json_add_int(w, "animation", meta->base.animation);
 	vmeta_json_add_str(
-		jobj, "state", vmeta_flying_state_str(meta->base.state));
-	vmeta_json_add_str(
-		jobj, "mode", vmeta_piloting_mode_str(meta->base.mode));
+		w, "state", vmeta_flying_state_str(meta->base.state));
+	vmeta_json_add_str(w, "mode", vmeta_piloting_mode_str(meta->base.mode));
 
 	if (meta->has_timestamp) {
-		vmeta_json_add_int64(jobj,
-				     "frame_timestamp",
-				     meta->timestamp.frame_timestamp);
+		vmeta_json_add_int64(
+			w, "frame_timestamp", meta->timestamp.frame_timestamp);
 	}
 
 	if (meta->has_automation) {
-		struct json_object *jobj_automation = json_object_new_object();
-		vmeta_json_add_location(jobj_automation,
-					"framing_target",
-					&meta->automation.framing_target);
-		vmeta_json_add_location(jobj_automation,
+		vmeta_json_begin_object(w, "automation");
+		vmeta_json_add_location(
+			w, "framing_target", &meta->automation.framing_target);
+		vmeta_json_add_location(w,
 					"flight_destination",
 					&meta->automation.flight_destination);
-		vmeta_json_add_int(jobj_automation,
+		vmeta_json_add_int(w,
 				   "followme_enabled",
 				   meta->automation.followme_enabled);
-		vmeta_json_add_int(jobj_automation,
+		vmeta_json_add_int(w,
 				   "lookatme_enabled",
 				   meta->automation.lookatme_enabled);
-		vmeta_json_add_int(jobj_automation,
-				   "angle_locked",
-				   meta->automation.angle_locked);
+		vmeta_json_add_int(
+			w, "angle_locked", meta->automation.angle_locked);
 		vmeta_json_add_str(
-			jobj_automation,
+			w,
 			"animation",
 			vmeta_automation_anim_str(meta->automation.animation));
-		json_object_object_add(jobj, "automation", jobj_automation);
+		vmeta_json_end_object(w);
 	}
 
 	if (meta->has_thermal) {
-		struct json_object *jobj_thermal = json_object_new_object();
-		vmeta_json_add_str(jobj_thermal,
+		vmeta_json_begin_object(w, "thermal");
+		vmeta_json_add_str(w,
 				   "calib_state",
 				   vmeta_thermal_calib_state_str(
 					   meta->thermal.calib_state));
-		vmeta_json_add_thermal_spot(
-			jobj_thermal, "min", &meta->thermal.min);
-		vmeta_json_add_thermal_spot(
-			jobj_thermal, "max", &meta->thermal.max);
-		vmeta_json_add_thermal_spot(
-			jobj_thermal, "probe", &meta->thermal.probe);
-		json_object_object_add(jobj, "thermal", jobj_thermal);
+		vmeta_json_add_thermal_spot(w, "min", &meta->thermal.min);
+		vmeta_json_add_thermal_spot(w, "max", &meta->thermal.max);
+		vmeta_json_add_thermal_spot(w, "probe", &meta->thermal.probe);
+		vmeta_json_end_object(w);
 	}
 
 	if (meta->has_lfic) {
-		struct json_object *jobj_lfic = json_object_new_object();
-		vmeta_json_add_double(
-			jobj_lfic, "target_x", meta->lfic.target_x);
-		vmeta_json_add_double(
-			jobj_lfic, "target_y", meta->lfic.target_y);
-		vmeta_json_add_location(jobj_lfic,
-					"target_location",
-					&meta->lfic.target_location);
-		vmeta_json_add_double(jobj_lfic,
+		vmeta_json_begin_object(w, "lfic");
+		vmeta_json_add_double(w, "target_x", meta->lfic.target_x);
+		vmeta_json_add_double(w, "target_y", meta->lfic.target_y);
+		vmeta_json_add_location(
+			w, "target_location", &meta->lfic.target_location);
+		vmeta_json_add_double(w,
 				      "estimated_precision",
 				      meta->lfic.estimated_precision);
 		vmeta_json_add_double(
-			jobj_lfic, "grid_precision", meta->lfic.grid_precision);
-		json_object_object_add(jobj, "lfic", jobj_lfic);
+			w, "grid_precision", meta->lfic.grid_precision);
+		vmeta_json_end_object(w);
 	}
 
 	return 0;
 }
 
 
-size_t vmeta_frame_v3_to_csv(const struct vmeta_frame_v3 *meta,
-			     char *str,
-			     size_t maxlen)
+int vmeta_frame_v3_to_json(const struct vmeta_frame_v3 *meta,
+			   struct json_object *jobj)
 {
-	size_t len = 0;
+	struct vmeta_json_writer w;
 
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->base.drone_quat);
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
-	len += vmeta_csv_add_location(
-		str + len, maxlen - len, &meta->base.location);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.2f ",
-			meta->base.ground_distance);
-	len += vmeta_csv_add_ned(str + len, maxlen - len, &meta->base.speed);
-	VMETA_STR_PRINT(
-		str + len, len, maxlen - len, " %.3f ", meta->base.air_speed);
-
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->base.frame_base_quat);
-	VMETA_STR_SPACE(str + len, len, maxlen - len);
-	len += vmeta_csv_add_quaternion(
-		str + len, maxlen - len, &meta->base.frame_quat);
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.4f %d",
-			meta->base.exposure_time,
-			meta->base.gain);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %.5f %.5f %.4f %.4f",
-			meta->base.awb_r_gain,
-			meta->base.awb_b_gain,
-			meta->base.picture_hfov,
-			meta->base.picture_vfov);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d %d %d",
-			meta->base.link_goodput,
-			meta->base.link_quality,
-			meta->base.wifi_rssi,
-			meta->base.battery_percentage);
-
-	VMETA_STR_PRINT(str + len,
-			len,
-			maxlen - len,
-			" %d %d %d",
-			meta->base.animation,
-			meta->base.state,
-			meta->base.mode);
+	vmeta_json_writer_init_object(&w, jobj);
+	vmeta_frame_v3_to_json_writer(meta, &w);
+	return vmeta_json_writer_finish(&w);
+}
 
-	if (meta->has_timestamp) {
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %" PRIu64,
-				meta->timestamp.frame_timestamp);
-	} else {
-		VMETA_STR_PRINT(str + len, len, maxlen - len, " 0");
-	}
+
+void vmeta_frame_v3_to_csv_writer(const struct vmeta_frame_v3 *meta,
+				  struct vmeta_csv_writer *w)
+{
+	vmeta_csv_add_quaternion(w, &meta->base.drone_quat);
+	vmeta_csv_add_location(w, &meta->base.location);
+	vmeta_csv_add_double(w, meta->base.ground_distance, 2);
+	vmeta_csv_add_ned(w, &meta->base.speed);
+	vmeta_csv_add_float(w, meta->base.air_speed, 3);
+	vmeta_csv_add_quaternion(w, &meta->base.frame_base_quat);
+	vmeta_csv_add_quaternion(w, &meta->base.frame_quat);
+	vmeta_csv_add_float(w, meta->base.exposure_time, 4);
+	vmeta_csv_add_int(w, meta->base.gain);
+	vmeta_csv_add_float(w, meta->base.awb_r_gain, 5);
+	vmeta_csv_add_float(w, meta->base.awb_b_gain, 5);
+	vmeta_csv_add_float(w, meta->base.picture_hfov, 4);
+	vmeta_csv_add_float(w, meta->base.picture_vfov, 4);
+	vmeta_csv_add_int(w, meta->base.link_goodput);
+	vmeta_csv_add_int(w, meta->base.link_quality);
+	vmeta_csv_add_int(w, meta->base.wifi_rssi);
+	vmeta_csv_add_int(w, meta->base.battery_percentage);
+	vmeta_csv_add_int(w, meta->base.animation);
+	vmeta_csv_add_int(w, meta->base.state);
+	vmeta_csv_add_int(w, meta->base.mode);
+
+	vmeta_csv_add_uint(w,
+			   meta->has_timestamp
+				   ? meta->timestamp.frame_timestamp
+				   : 0);
 
 	if (meta->has_automation) {
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_location(str + len,
-					      maxlen - len,
-					      &meta->automation.framing_target);
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_location(
-			str + len,
-			maxlen - len,
-			&meta->automation.flight_destination);
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %d %d %d %d",
-				meta->automation.followme_enabled,
-				meta->automation.lookatme_enabled,
-				meta->automation.angle_locked,
-				meta->automation.animation);
+		vmeta_csv_add_location(w, &meta->automation.framing_target);
+		vmeta_csv_add_location(w,
+				       &meta->automation.flight_destination);
+		vmeta_csv_add_int(w, meta->automation.followme_enabled);
+		vmeta_csv_add_int(w, meta->automation.lookatme_enabled);
+		vmeta_csv_add_int(w, meta->automation.angle_locked);
+		vmeta_csv_add_int(w, meta->automation.animation);
 	} else {
 		struct vmeta_location loc;
 		memset(&loc, 0, sizeof(loc));
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_location(str + len, maxlen - len, &loc);
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_location(str + len, maxlen - len, &loc);
-		VMETA_STR_PRINT(str + len, len, maxlen - len, " 0 0 0 0");
+		vmeta_csv_add_location(w, &loc);
+		vmeta_csv_add_location(w, &loc);
+		vmeta_csv_add_int(w, 0);
+		vmeta_csv_add_int(w, 0);
+		vmeta_csv_add_int(w, 0);
+		vmeta_csv_add_int(w, 0);
 	}
 
 	if (meta->has_thermal) {
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %d ",
-				meta->thermal.calib_state);
-		len += vmeta_csv_add_thermal_spot(
-			str + len, maxlen - len, &meta->thermal.min);
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_thermal_spot(
-			str + len, maxlen - len, &meta->thermal.max);
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_thermal_spot(
-			str + len, maxlen - len, &meta->thermal.probe);
+		vmeta_csv_add_int(w, meta->thermal.calib_state);
+		vmeta_csv_add_thermal_spot(w, &meta->thermal.min);
+		vmeta_csv_add_thermal_spot(w, &meta->thermal.max);
+		vmeta_csv_add_thermal_spot(w, &meta->thermal.probe);
 	} else {
 		struct vmeta_thermal_spot spot = {0};
-		VMETA_STR_PRINT(str + len, len, maxlen - len, " 0 ");
-		len += vmeta_csv_add_thermal_spot(
-			str + len, maxlen - len, &spot);
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_thermal_spot(
-			str + len, maxlen - len, &spot);
-		VMETA_STR_SPACE(str + len, len, maxlen - len);
-		len += vmeta_csv_add_thermal_spot(
-			str + len, maxlen - len, &spot);
+		vmeta_csv_add_int(w, 0);
+		vmeta_csv_add_thermal_spot(w, &spot);
+		vmeta_csv_add_thermal_spot(w, &spot);
+		vmeta_csv_add_thermal_spot(w, &spot);
 	}
 
 	if (meta->has_lfic) {
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %.3f %.3f ",
-				meta->lfic.target_x,
-				meta->lfic.target_y);
-		len += vmeta_csv_add_location(
-			str + len, maxlen - len, &meta->lfic.target_location);
-		VMETA_STR_PRINT(str + len,
-				len,
-				maxlen - len,
-				" %.2lf %.2lf",
-				meta->lfic.estimated_precision,
-				meta->lfic.grid_precision);
+		vmeta_csv_add_float(w, meta->lfic.target_x, 3);
+		vmeta_csv_add_float(w, meta->lfic.target_y, 3);
+		vmeta_csv_add_location(w, &meta->lfic.target_location);
+		vmeta_csv_add_double(w, meta->lfic.estimated_precision, 2);
+		vmeta_csv_add_double(w, meta->lfic.grid_precision, 2);
 	} else {
 		struct vmeta_location loc;
 		memset(&loc, 0, sizeof(loc));
-		VMETA_STR_PRINT(str + len, len, maxlen - len, " 0.000 0.000");
-		len += vmeta_csv_add_location(str + len, maxlen - len, &loc);
-		VMETA_STR_PRINT(str + len, len, maxlen - len, " 0.00 0.00");
+		vmeta_csv_add_float(w, 0.f, 3);
+		vmeta_csv_add_float(w, 0.f, 3);
+		vmeta_csv_add_location(w, &loc);
+		vmeta_csv_add_double(w, 0., 2);
+		vmeta_csv_add_double(w, 0., 2);
 	}
+}
 
-	return len;
+
+size_t vmeta_frame_v3_to_csv(const struct vmeta_frame_v3 *meta,
+			     char *str,
+			     size_t maxlen)
+{
+	struct vmeta_csv_writer w;
+
+	vmeta_csv_writer_init_str(&w, str, maxlen);
+	vmeta_frame_v3_to_csv_writer(meta, &w);
+	return (size_t)vmeta_csv_writer_finish(&w);
 }
 
 
@@ -563,26 +779,35 @@ size_t vmeta_frame_v3_csv_header(char *str, size_t maxlen)
 		"automation_framing_target_longitude "
 		"automation_framing_target_altitude_wgs84ellipsoid "
 		"automation_framing_target_altitude_egm96amsl "
+		"automation_framing_target_horizontal_accuracy "
+		"automation_framing_target_vertical_accuracy "
 		"automation_framing_target_sv_count "
 		"automation_flight_destination_valid "
 		"automation_flight_destination_latitude "
 		"automation_flight_destination_longitude "
 		"automation_flight_destination_altitude_wgs84ellipsoid "
 		"automation_flight_destination_altitude_egm96amsl "
+		"automation_flight_destination_horizontal_accuracy "
+		"automation_flight_destination_vertical_accuracy "
 		"automation_flight_destination_sv_count "
 		"automation_followme_enabled automation_lookatme_enabled "
 		"automation_angle_locked automation_animation "
 		"thermal_cablib_state "
 		"thermal_min_valid "
 		"thermal_min_x thermal_min_y thermal_min_temp "
+		"thermal_min_value "
 		"thermal_max_valid "
 		"thermal_max_x thermal_max_y thermal_max_temp "
+		"thermal_max_value "
 		"thermal_probe_valid "
 		"thermal_probe_x thermal_probe_y thermal_probe_temp "
+		"thermal_probe_value "
 		"lfic_target_x lfic_target_y lfic_target_location_valid "
 		"lfic_target_location_latitude lfic_target_location_longitude "
 		"lfic_target_location_altitude_wgs84ellipsoid "
 		"lfic_target_location_altitude_egm96amsl "
+		"lfic_target_location_horizontal_accuracy "
+		"lfic_target_location_vertical_accuracy "
 		"lfic_target_location_sv_count "
 		"lfic_estimated_precision lfic_grid_precision");
 
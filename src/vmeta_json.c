@@ -27,177 +27,580 @@
 #include "vmeta_priv.h"
 
 
-int vmeta_json_add_location(struct json_object *jobj,
+static void json_flush(struct vmeta_json_writer *w)
+{
+	int ret;
+
+	if (w->err != 0 || w->pos == 0)
+		return;
+	ret = w->sink(w->str, w->pos, w->userdata);
+	if (ret < 0)
+		w->err = ret;
+	w->pos = 0;
+}
+
+
+static void json_put(struct vmeta_json_writer *w, const char *s, size_t n)
+{
+	size_t cpy;
+
+	w->len += n;
+	if (w->mode == VMETA_JSON_WRITER_MODE_BUFFER) {
+		/* Keep counting past the end of the buffer, so that the
+		 * required length is known */
+		if (w->pos < w->maxlen) {
+			cpy = w->maxlen - w->pos;
+			memcpy(w->str + w->pos, s, n < cpy ? n : cpy);
+		}
+		w->pos += n;
+		return;
+	}
+
+	while (n > 0 && w->err == 0) {
+		if (w->pos == w->maxlen)
+			json_flush(w);
+		cpy = w->maxlen - w->pos;
+		if (cpy > n)
+			cpy = n;
+		memcpy(w->str + w->pos, s, cpy);
+		w->pos += cpy;
+		s += cpy;
+		n -= cpy;
+	}
+}
+
+
+static void json_put_str(struct vmeta_json_writer *w, const char *s)
+{
+	json_put(w, s, strlen(s));
+}
+
+
+/* Write the separator and key preceding a value in text mode */
+static void json_put_member(struct vmeta_json_writer *w, const char *name)
+{
+	uint32_t bit;
+
+	if (w->depth == 0)
+		return;
+	bit = UINT32_C(1) << (w->depth - 1);
+	if (w->empty & bit) {
+		w->empty &= ~bit;
+		json_put(w, " ", 1);
+	} else {
+		json_put(w, ", ", 2);
+	}
+	if (!(w->array & bit)) {
+		json_put(w, "\"", 1);
+		json_put_str(w, name);
+		json_put(w, "\": ", 3);
+	}
+}
+
+
+/* Attach a new json-c value to the current container in object mode */
+static void json_attach(struct vmeta_json_writer *w,
+			const char *name,
+			struct json_object *jval)
+{
+	struct json_object *parent;
+
+	if (jval == NULL) {
+		w->err = -ENOMEM;
+		return;
+	}
+	if (w->depth == 0) {
+		json_object_put(jval);
+		w->err = -EPROTO;
+		return;
+	}
+	parent = w->stack[w->depth - 1];
+	if (w->array & (UINT32_C(1) << (w->depth - 1)))
+		json_object_array_add(parent, jval);
+	else
+		json_object_object_add(parent, name, jval);
+}
+
+
+static void json_put_int64(struct vmeta_json_writer *w, int64_t val)
+{
+	char str[24];
+	char *p = str + sizeof(str);
+	uint64_t u = val < 0 ? -(uint64_t)val : (uint64_t)val;
+
+	do {
+		*--p = '0' + (u % 10);
+		u /= 10;
+	} while (u != 0);
+	if (val < 0)
+		*--p = '-';
+	json_put(w, p, (size_t)(str + sizeof(str) - p));
+}
+
+
+static void json_put_escaped(struct vmeta_json_writer *w, const char *s)
+{
+	static const char hex[] = "0123456789abcdef";
+	const char *run = s;
+	char esc[6] = {'\\', 'u', '0', '0'};
+	unsigned char c;
+
+	/* Same escaping as json-c (including the '/' character) */
+	json_put(w, "\"", 1);
+	for (; (c = (unsigned char)*s) != '\0'; s++) {
+		if (c >= 0x20 && c != '"' && c != '\\' && c != '/')
+			continue;
+		json_put(w, run, (size_t)(s - run));
+		run = s + 1;
+		switch (c) {
+		case '\b':
+			json_put(w, "\\b", 2);
+			break;
+		case '\n':
+			json_put(w, "\\n", 2);
+			break;
+		case '\r':
+			json_put(w, "\\r", 2);
+			break;
+		case '\t':
+			json_put(w, "\\t", 2);
+			break;
+		case '\f':
+			json_put(w, "\\f", 2);
+			break;
+		case '"':
+		case '\\':
+		case '/':
+			esc[1] = c;
+			json_put(w, esc, 2);
+			break;
+		default:
+			esc[1] = 'u';
+			esc[4] = hex[c >> 4];
+			esc[5] = hex[c & 0xf];
+			json_put(w, esc, 6);
+			break;
+		}
+	}
+	json_put(w, run, (size_t)(s - run));
+	json_put(w, "\"", 1);
+}
+
+
+static void json_push(struct vmeta_json_writer *w, int array)
+{
+	uint32_t bit;
+
+	if (w->depth >= VMETA_JSON_WRITER_MAX_DEPTH) {
+		w->err = -E2BIG;
+		return;
+	}
+	bit = UINT32_C(1) << w->depth;
+	w->empty |= bit;
+	if (array)
+		w->array |= bit;
+	else
+		w->array &= ~bit;
+	w->depth++;
+}
+
+
+void vmeta_json_writer_init_object(struct vmeta_json_writer *w,
+				   struct json_object *jobj)
+{
+	memset(w, 0, offsetof(struct vmeta_json_writer, chunk));
+	w->mode = VMETA_JSON_WRITER_MODE_OBJECT;
+	w->stack[0] = jobj;
+	json_push(w, json_object_get_type(jobj) == json_type_array);
+}
+
+
+void vmeta_json_writer_init_buffer(struct vmeta_json_writer *w,
+				   char *str,
+				   size_t maxlen)
+{
+	memset(w, 0, offsetof(struct vmeta_json_writer, chunk));
+	w->mode = VMETA_JSON_WRITER_MODE_BUFFER;
+	w->str = str;
+	w->maxlen = maxlen;
+}
+
+
+void vmeta_json_writer_init_sink(struct vmeta_json_writer *w,
+				 vmeta_json_sink_t sink,
+				 void *userdata)
+{
+	memset(w, 0, offsetof(struct vmeta_json_writer, chunk));
+	w->mode = VMETA_JSON_WRITER_MODE_SINK;
+	w->str = w->chunk;
+	w->maxlen = sizeof(w->chunk);
+	w->sink = sink;
+	w->userdata = userdata;
+}
+
+
+ssize_t vmeta_json_writer_finish(struct vmeta_json_writer *w)
+{
+	switch (w->mode) {
+	case VMETA_JSON_WRITER_MODE_OBJECT:
+		return w->err;
+
+	case VMETA_JSON_WRITER_MODE_BUFFER:
+		if (w->err != 0)
+			return w->err;
+		if (w->len >= w->maxlen)
+			return -ENOBUFS;
+		w->str[w->len] = '\0';
+		return w->len;
+
+	case VMETA_JSON_WRITER_MODE_SINK:
+		json_flush(w);
+		return w->err != 0 ? w->err : (ssize_t)w->len;
+
+	default:
+		return -EINVAL;
+	}
+}
+
+
+void vmeta_json_begin_object(struct vmeta_json_writer *w, const char *name)
+{
+	struct json_object *jval;
+
+	if (w->err != 0)
+		return;
+	if (w->mode == VMETA_JSON_WRITER_MODE_OBJECT) {
+		jval = json_object_new_object();
+		json_attach(w, name, jval);
+		if (w->err != 0)
+			return;
+		json_push(w, 0);
+		if (w->err == 0)
+			w->stack[w->depth - 1] = jval;
+		return;
+	}
+	json_put_member(w, name);
+	json_put(w, "{", 1);
+	json_push(w, 0);
+}
+
+
+void vmeta_json_end_object(struct vmeta_json_writer *w)
+{
+	if (w->err != 0)
+		return;
+	if (w->depth == 0) {
+		w->err = -EPROTO;
+		return;
+	}
+	w->depth--;
+	if (w->mode != VMETA_JSON_WRITER_MODE_OBJECT)
+		json_put(w, " }", 2);
+}
+
+
+void vmeta_json_begin_array(struct vmeta_json_writer *w, const char *name)
+{
+	struct json_object *jval;
+
+	if (w->err != 0)
+		return;
+	if (w->mode == VMETA_JSON_WRITER_MODE_OBJECT) {
+		jval = json_object_new_array();
+		json_attach(w, name, jval);
+		if (w->err != 0)
+			return;
+		json_push(w, 1);
+		if (w->err == 0)
+			w->stack[w->depth - 1] = jval;
+		return;
+	}
+	json_put_member(w, name);
+	json_put(w, "[", 1);
+	json_push(w, 1);
+}
+
+
+void vmeta_json_end_array(struct vmeta_json_writer *w)
+{
+	if (w->err != 0)
+		return;
+	if (w->depth == 0) {
+		w->err = -EPROTO;
+		return;
+	}
+	w->depth--;
+	if (w->mode != VMETA_JSON_WRITER_MODE_OBJECT)
+		json_put(w, " ]", 2);
+}
+
+
+int vmeta_json_add_bool(struct vmeta_json_writer *w, const char *name, int val)
+{
+	if (w->err != 0)
+		return w->err;
+	if (w->mode == VMETA_JSON_WRITER_MODE_OBJECT) {
+		json_attach(w, name, json_object_new_boolean(val));
+		return w->err;
+	}
+	json_put_member(w, name);
+	if (val)
+		json_put(w, "true", 4);
+	else
+		json_put(w, "false", 5);
+	return w->err;
+}
+
+
+int vmeta_json_add_int(struct vmeta_json_writer *w, const char *name, int val)
+{
+	if (w->err != 0)
+		return w->err;
+	if (w->mode == VMETA_JSON_WRITER_MODE_OBJECT) {
+		json_attach(w, name, json_object_new_int(val));
+		return w->err;
+	}
+	json_put_member(w, name);
+	json_put_int64(w, val);
+	return w->err;
+}
+
+
+int vmeta_json_add_int64(struct vmeta_json_writer *w,
+			 const char *name,
+			 int64_t val)
+{
+	if (w->err != 0)
+		return w->err;
+	if (w->mode == VMETA_JSON_WRITER_MODE_OBJECT) {
+		json_attach(w, name, json_object_new_int64(val));
+		return w->err;
+	}
+	json_put_member(w, name);
+	json_put_int64(w, val);
+	return w->err;
+}
+
+
+int vmeta_json_add_double(struct vmeta_json_writer *w,
+			  const char *name,
+			  double val)
+{
+	char str[VMETA_DTOA_MAX_LEN + 2];
+	size_t len;
+
+	if (w->err != 0)
+		return w->err;
+	if (w->mode == VMETA_JSON_WRITER_MODE_OBJECT) {
+		json_attach(w, name, json_object_new_double(val));
+		return w->err;
+	}
+	json_put_member(w, name);
+
+	/* Same special values and integer suffix as json-c */
+	if (isnan(val)) {
+		json_put(w, "NaN", 3);
+	} else if (isinf(val)) {
+		if (val > 0)
+			json_put(w, "Infinity", 8);
+		else
+			json_put(w, "-Infinity", 9);
+	} else {
+		len = vmeta_dtoa(val, str);
+		if (strpbrk(str, ".e") == NULL) {
+			memcpy(str + len, ".0", 2);
+			len += 2;
+		}
+		json_put(w, str, len);
+	}
+	return w->err;
+}
+
+
+int vmeta_json_add_str(struct vmeta_json_writer *w,
+		       const char *name,
+		       const char *val)
+{
+	if (w->err != 0)
+		return w->err;
+	if (w->mode == VMETA_JSON_WRITER_MODE_OBJECT) {
+		json_attach(w, name, json_object_new_string(val));
+		return w->err;
+	}
+	json_put_member(w, name);
+	json_put_escaped(w, val);
+	return w->err;
+}
+
+int vmeta_json_add_location(struct vmeta_json_writer *w,
 			    const char *name,
 			    const struct vmeta_location *val)
 {
 	if (!val->valid)
 		return 0;
 
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "latitude", val->latitude);
-	vmeta_json_add_double(jobj_val, "longitude", val->longitude);
+	vmeta_json_add_double(w, "latitude", val->latitude);
+	vmeta_json_add_double(w, "longitude", val->longitude);
 	if (!isnan(val->altitude_wgs84ellipsoid)) {
-		vmeta_json_add_double(jobj_val,
+		vmeta_json_add_double(w,
 				      "altitude_wgs84ellipsoid",
 				      val->altitude_wgs84ellipsoid);
 	}
 	if (!isnan(val->altitude_egm96amsl)) {
-		vmeta_json_add_double(jobj_val,
-				      "altitude_egm96amsl",
-				      val->altitude_egm96amsl);
+		vmeta_json_add_double(
+			w, "altitude_egm96amsl", val->altitude_egm96amsl);
 	}
 	if (val->horizontal_accuracy != 0.) {
-		vmeta_json_add_double(jobj_val,
-				      "horizontal_accuracy",
-				      val->horizontal_accuracy);
+		vmeta_json_add_double(
+			w, "horizontal_accuracy", val->horizontal_accuracy);
 	}
 	if (val->vertical_accuracy != 0.) {
 		vmeta_json_add_double(
-			jobj_val, "vertical_accuracy", val->vertical_accuracy);
+			w, "vertical_accuracy", val->vertical_accuracy);
 	}
 	if (val->sv_count != VMETA_LOCATION_INVALID_SV_COUNT)
-		vmeta_json_add_int(jobj_val, "sv_count", val->sv_count);
+		vmeta_json_add_int(w, "sv_count", val->sv_count);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
-int vmeta_json_add_quaternion(struct json_object *jobj,
+int vmeta_json_add_quaternion(struct vmeta_json_writer *w,
 			      const char *name,
 			      const struct vmeta_quaternion *val)
 {
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "w", val->w);
-	vmeta_json_add_double(jobj_val, "x", val->x);
-	vmeta_json_add_double(jobj_val, "y", val->y);
-	vmeta_json_add_double(jobj_val, "z", val->z);
+	vmeta_json_add_double(w, "w", val->w);
+	vmeta_json_add_double(w, "x", val->x);
+	vmeta_json_add_double(w, "y", val->y);
+	vmeta_json_add_double(w, "z", val->z);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
-int vmeta_json_add_euler(struct json_object *jobj,
+int vmeta_json_add_euler(struct vmeta_json_writer *w,
 			 const char *name,
 			 const struct vmeta_euler *val)
 {
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "yaw", val->yaw);
-	vmeta_json_add_double(jobj_val, "pitch", val->pitch);
-	vmeta_json_add_double(jobj_val, "roll", val->roll);
+	vmeta_json_add_double(w, "yaw", val->yaw);
+	vmeta_json_add_double(w, "pitch", val->pitch);
+	vmeta_json_add_double(w, "roll", val->roll);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
-int vmeta_json_add_xyz(struct json_object *jobj,
+int vmeta_json_add_xyz(struct vmeta_json_writer *w,
 		       const char *name,
 		       const struct vmeta_xyz *val)
 {
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "x", val->x);
-	vmeta_json_add_double(jobj_val, "y", val->y);
-	vmeta_json_add_double(jobj_val, "z", val->z);
+	vmeta_json_add_double(w, "x", val->x);
+	vmeta_json_add_double(w, "y", val->y);
+	vmeta_json_add_double(w, "z", val->z);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
-int vmeta_json_add_xy(struct json_object *jobj,
+int vmeta_json_add_xy(struct vmeta_json_writer *w,
 		      const char *name,
 		      const struct vmeta_xy *val)
 {
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "x", val->x);
-	vmeta_json_add_double(jobj_val, "y", val->y);
+	vmeta_json_add_double(w, "x", val->x);
+	vmeta_json_add_double(w, "y", val->y);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
-int vmeta_json_add_ned(struct json_object *jobj,
+int vmeta_json_add_ned(struct vmeta_json_writer *w,
 		       const char *name,
 		       const struct vmeta_ned *val)
 {
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "north", val->north);
-	vmeta_json_add_double(jobj_val, "east", val->east);
-	vmeta_json_add_double(jobj_val, "down", val->down);
+	vmeta_json_add_double(w, "north", val->north);
+	vmeta_json_add_double(w, "east", val->east);
+	vmeta_json_add_double(w, "down", val->down);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
-int vmeta_json_add_fov(struct json_object *jobj,
+int vmeta_json_add_fov(struct vmeta_json_writer *w,
 		       const char *name,
 		       const struct vmeta_fov *val)
 {
 	if ((!val->has_horz) && (!val->has_vert))
 		return 0;
 
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
 	if (val->has_horz)
-		vmeta_json_add_double(jobj_val, "horz", val->horz);
+		vmeta_json_add_double(w, "horz", val->horz);
 
 	if (val->has_vert)
-		vmeta_json_add_double(jobj_val, "vert", val->vert);
+		vmeta_json_add_double(w, "vert", val->vert);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
 int vmeta_json_add_thermal_conversion(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const struct vmeta_thermal_conversion *val)
 {
 	if (!val->valid)
 		return 0;
 
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "r", val->r);
-	vmeta_json_add_double(jobj_val, "b", val->b);
-	vmeta_json_add_double(jobj_val, "f", val->f);
-	vmeta_json_add_double(jobj_val, "o", val->o);
-	vmeta_json_add_double(jobj_val, "tau_win", val->tau_win);
-	vmeta_json_add_double(jobj_val, "t_win", val->t_win);
-	vmeta_json_add_double(jobj_val, "t_bg", val->t_bg);
-	vmeta_json_add_double(jobj_val, "emissivity", val->emissivity);
+	vmeta_json_add_double(w, "r", val->r);
+	vmeta_json_add_double(w, "b", val->b);
+	vmeta_json_add_double(w, "f", val->f);
+	vmeta_json_add_double(w, "o", val->o);
+	vmeta_json_add_double(w, "tau_win", val->tau_win);
+	vmeta_json_add_double(w, "t_win", val->t_win);
+	vmeta_json_add_double(w, "t_bg", val->t_bg);
+	vmeta_json_add_double(w, "emissivity", val->emissivity);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
 
 
-int vmeta_json_add_thermal_spot(struct json_object *jobj,
+int vmeta_json_add_thermal_spot(struct vmeta_json_writer *w,
 				const char *name,
 				const struct vmeta_thermal_spot *val)
 {
 	if (!val->valid)
 		return 0;
 
-	struct json_object *jobj_val = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
-	vmeta_json_add_double(jobj_val, "x", val->x);
-	vmeta_json_add_double(jobj_val, "y", val->y);
-	vmeta_json_add_double(jobj_val, "temp", val->temp);
-	vmeta_json_add_int(jobj_val, "value", val->value);
+	vmeta_json_add_double(w, "x", val->x);
+	vmeta_json_add_double(w, "y", val->y);
+	vmeta_json_add_double(w, "temp", val->temp);
+	vmeta_json_add_int(w, "value", val->value);
 
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_end_object(w);
 	return 0;
 }
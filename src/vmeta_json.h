@@ -28,88 +28,161 @@
 #define _VMETA_JSON_H_
 
 
-static inline int
-vmeta_json_add_bool(struct json_object *jobj, const char *name, int val)
-{
-	json_object_object_add(jobj, name, json_object_new_boolean(val));
-	return 0;
-}
+/* Maximum nesting depth of a JSON writer (root object included) */
+#define VMETA_JSON_WRITER_MAX_DEPTH 16
 
+/* Size of the text chunks forwarded to a JSON sink callback */
+#define VMETA_JSON_WRITER_CHUNK_SIZE 512
 
-static inline int
-vmeta_json_add_int(struct json_object *jobj, const char *name, int val)
-{
-	json_object_object_add(jobj, name, json_object_new_int(val));
-	return 0;
-}
 
+enum vmeta_json_writer_mode {
+	/* Build a json-c object tree */
+	VMETA_JSON_WRITER_MODE_OBJECT = 0,
 
-static inline int
-vmeta_json_add_int64(struct json_object *jobj, const char *name, int64_t val)
-{
-	json_object_object_add(jobj, name, json_object_new_int64(val));
-	return 0;
-}
+	/* Write JSON text to a caller-provided buffer */
+	VMETA_JSON_WRITER_MODE_BUFFER,
 
+	/* Write JSON text to a sink callback function */
+	VMETA_JSON_WRITER_MODE_SINK,
+};
 
-static inline int
-vmeta_json_add_double(struct json_object *jobj, const char *name, double val)
-{
-	json_object_object_add(jobj, name, json_object_new_double(val));
-	return 0;
-}
 
+/* JSON writer: the same emitter code either builds a json-c object tree or
+ * directly writes JSON text (with the json-c JSON_C_TO_STRING_SPACED layout,
+ * i.e. the json_object_to_json_string() output) without any allocation.
+ * In text modes, doubles are written with their shortest round-trip
+ * representation (see vmeta_dtoa()). */
+struct vmeta_json_writer {
+	enum vmeta_json_writer_mode mode;
+	int err;
 
-static inline int
-vmeta_json_add_str(struct json_object *jobj, const char *name, const char *val)
-{
-	json_object_object_add(jobj, name, json_object_new_string(val));
-	return 0;
-}
+	/* Nesting state: bit n of empty is set if level n has no member yet,
+	 * bit n of array is set if level n is an array */
+	unsigned int depth;
+	uint32_t empty;
+	uint32_t array;
 
+	/* MODE_OBJECT: current json-c containers */
+	struct json_object *stack[VMETA_JSON_WRITER_MAX_DEPTH];
 
-int vmeta_json_add_location(struct json_object *jobj,
+	/* MODE_BUFFER and MODE_SINK: output buffer (the chunk buffer in
+	 * MODE_SINK) and total length of the output text */
+	char *str;
+	size_t maxlen;
+	size_t pos;
+	size_t len;
+
+	/* MODE_SINK */
+	vmeta_json_sink_t sink;
+	void *userdata;
+	char chunk[VMETA_JSON_WRITER_CHUNK_SIZE];
+};
+
+
+void vmeta_json_writer_init_object(struct vmeta_json_writer *w,
+				   struct json_object *jobj);
+
+
+void vmeta_json_writer_init_buffer(struct vmeta_json_writer *w,
+				   char *str,
+				   size_t maxlen);
+
+
+void vmeta_json_writer_init_sink(struct vmeta_json_writer *w,
+				 vmeta_json_sink_t sink,
+				 void *userdata);
+
+
+/**
+ * Complete a JSON writer output: flush the remaining text to the sink, or
+ * null-terminate the buffer.
+ * @param w: JSON writer
+ * @return the length of the JSON text (0 in object mode) on success,
+ *         negative errno value in case of error (-ENOBUFS if the text does
+ *         not fit in the buffer)
+ */
+ssize_t vmeta_json_writer_finish(struct vmeta_json_writer *w);
+
+
+/* The name argument of the functions below is ignored for members of an
+ * array; it is written as-is, without escaping */
+
+
+void vmeta_json_begin_object(struct vmeta_json_writer *w, const char *name);
+
+
+void vmeta_json_end_object(struct vmeta_json_writer *w);
+
+
+void vmeta_json_begin_array(struct vmeta_json_writer *w, const char *name);
+
+
+void vmeta_json_end_array(struct vmeta_json_writer *w);
+
+
+int vmeta_json_add_bool(struct vmeta_json_writer *w, const char *name, int val);
+
+
+int vmeta_json_add_int(struct vmeta_json_writer *w, const char *name, int val);
+
+
+int vmeta_json_add_int64(struct vmeta_json_writer *w,
+			 const char *name,
+			 int64_t val);
+
+
+int vmeta_json_add_double(struct vmeta_json_writer *w,
+			  const char *name,
+			  double val);
+
+
+int vmeta_json_add_str(struct vmeta_json_writer *w,
+		       const char *name,
+		       const char *val);
+
+
+int vmeta_json_add_location(struct vmeta_json_writer *w,
 			    const char *name,
 			    const struct vmeta_location *val);
 
 
-int vmeta_json_add_quaternion(struct json_object *jobj,
+int vmeta_json_add_quaternion(struct vmeta_json_writer *w,
 			      const char *name,
 			      const struct vmeta_quaternion *val);
 
 
-int vmeta_json_add_euler(struct json_object *jobj,
+int vmeta_json_add_euler(struct vmeta_json_writer *w,
 			 const char *name,
 			 const struct vmeta_euler *val);
 
 
-int vmeta_json_add_xyz(struct json_object *jobj,
+int vmeta_json_add_xyz(struct vmeta_json_writer *w,
 		       const char *name,
 		       const struct vmeta_xyz *val);
 
 
-int vmeta_json_add_xy(struct json_object *jobj,
+int vmeta_json_add_xy(struct vmeta_json_writer *w,
 		      const char *name,
 		      const struct vmeta_xy *val);
 
 
-int vmeta_json_add_ned(struct json_object *jobj,
+int vmeta_json_add_ned(struct vmeta_json_writer *w,
 		       const char *name,
 		       const struct vmeta_ned *val);
 
 
-int vmeta_json_add_fov(struct json_object *jobj,
+int vmeta_json_add_fov(struct vmeta_json_writer *w,
 		       const char *name,
 		       const struct vmeta_fov *val);
 
 
 int vmeta_json_add_thermal_conversion(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const struct vmeta_thermal_conversion *val);
 
 
-int vmeta_json_add_thermal_spot(struct json_object *jobj,
+int vmeta_json_add_thermal_spot(struct vmeta_json_writer *w,
 				const char *name,
 				const struct vmeta_thermal_spot *val);
 
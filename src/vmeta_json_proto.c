@@ -27,7 +27,7 @@
 #include "vmeta_priv.h"
 
 
-int vmeta_json_proto_add_timed_metadata(struct json_object *jobj,
+int vmeta_json_proto_add_timed_metadata(struct vmeta_json_writer *w,
 					Vmeta__TimedMetadata *timed)
 {
 	int res = 0;
@@ -37,26 +37,25 @@ int vmeta_json_proto_add_timed_metadata(struct json_object *jobj,
 		ULOGD("No timed metadata info");
 		goto out;
 	}
-	vmeta_json_proto_add_drone_metadata(jobj, "drone", timed->drone);
-	vmeta_json_proto_add_camera_metadata(jobj, "camera", timed->camera);
-	vmeta_json_add_array(jobj,
+	vmeta_json_proto_add_drone_metadata(w, "drone", timed->drone);
+	vmeta_json_proto_add_camera_metadata(w, "camera", timed->camera);
+	vmeta_json_add_array(w,
 			     "links",
 			     (union array_element_type *)timed->links,
 			     timed->n_links,
 			     vmeta_json_proto_add_link_metadata);
-	vmeta_json_proto_add_tracking_metadata(
-		jobj, "tracking", timed->tracking);
+	vmeta_json_proto_add_tracking_metadata(w, "tracking", timed->tracking);
 	vmeta_json_proto_add_tracking_proposal_metadata(
-		jobj, "proposal", timed->proposal);
+		w, "proposal", timed->proposal);
 	vmeta_json_proto_add_automation_metadata(
-		jobj, "automation", timed->automation);
-	vmeta_json_proto_add_thermal_metadata(jobj, "thermal", timed->thermal);
-	vmeta_json_add_array(jobj,
+		w, "automation", timed->automation);
+	vmeta_json_proto_add_thermal_metadata(w, "thermal", timed->thermal);
+	vmeta_json_add_array(w,
 			     "lfic",
 			     (union array_element_type *)timed->lfic,
 			     timed->n_lfic,
 			     vmeta_json_proto_add_lfic_metadata);
-	vmeta_json_add_array(jobj,
+	vmeta_json_add_array(w,
 			     "user",
 			     (union array_element_type *)timed->user,
 			     timed->n_user,
@@ -66,128 +65,114 @@ out:
 }
 
 
-void vmeta_json_proto_add_quaternion(struct json_object *jobj,
+void vmeta_json_proto_add_quaternion(struct vmeta_json_writer *w,
 				     const char *name,
 				     const Vmeta__Quaternion *quaternion)
 {
-	struct json_object *jobj_quaternion;
-
 	if (!quaternion) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_quaternion = json_object_new_object();
-	vmeta_json_add_double(jobj_quaternion, "w", quaternion->w);
-	vmeta_json_add_double(jobj_quaternion, "x", quaternion->x);
-	vmeta_json_add_double(jobj_quaternion, "y", quaternion->y);
-	vmeta_json_add_double(jobj_quaternion, "z", quaternion->z);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "w", quaternion->w);
+	vmeta_json_add_double(w, "x", quaternion->x);
+	vmeta_json_add_double(w, "y", quaternion->y);
+	vmeta_json_add_double(w, "z", quaternion->z);
 
-	json_object_object_add(jobj, name, jobj_quaternion);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_location(struct json_object *jobj,
+void vmeta_json_proto_add_location(struct vmeta_json_writer *w,
 				   const char *name,
 				   const Vmeta__Location *location)
 {
-	struct json_object *jobj_location;
-
 	if (!location) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_location = json_object_new_object();
-	vmeta_json_add_double(jobj_location, "latitude", location->latitude);
-	vmeta_json_add_double(jobj_location, "longitude", location->longitude);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "latitude", location->latitude);
+	vmeta_json_add_double(w, "longitude", location->longitude);
 	if (location->altitude_wgs84ellipsoid != 0.) {
-		vmeta_json_add_double(jobj_location,
+		vmeta_json_add_double(w,
 				      "altitude_wgs84ellipsoid",
 				      location->altitude_wgs84ellipsoid);
 	}
 	if (location->altitude_egm96amsl != 0.) {
-		vmeta_json_add_double(jobj_location,
-				      "altitude_egm96amsl",
-				      location->altitude_egm96amsl);
+		vmeta_json_add_double(
+			w, "altitude_egm96amsl", location->altitude_egm96amsl);
 	}
 	if (location->horizontal_accuracy != 0.) {
-		vmeta_json_add_double(jobj_location,
+		vmeta_json_add_double(w,
 				      "horizontal_accuracy",
 				      location->horizontal_accuracy);
 	}
 	if (location->vertical_accuracy != 0.) {
-		vmeta_json_add_double(jobj_location,
-				      "vertical_accuracy",
-				      location->vertical_accuracy);
+		vmeta_json_add_double(
+			w, "vertical_accuracy", location->vertical_accuracy);
 	}
 	if (location->sv_count != VMETA_LOCATION_INVALID_SV_COUNT)
-		vmeta_json_add_int(
-			jobj_location, "sv_count", location->sv_count);
+		vmeta_json_add_int(w, "sv_count", location->sv_count);
 
-	json_object_object_add(jobj, name, jobj_location);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_ned(struct json_object *jobj,
+void vmeta_json_proto_add_ned(struct vmeta_json_writer *w,
 			      const char *name,
 			      const Vmeta__NED *ned)
 {
-	struct json_object *jobj_ned;
-
 	if (!ned) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_ned = json_object_new_object();
-	vmeta_json_add_double(jobj_ned, "north", ned->north);
-	vmeta_json_add_double(jobj_ned, "east", ned->east);
-	vmeta_json_add_double(jobj_ned, "down", ned->down);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "north", ned->north);
+	vmeta_json_add_double(w, "east", ned->east);
+	vmeta_json_add_double(w, "down", ned->down);
 
-	json_object_object_add(jobj, name, jobj_ned);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_vec2(struct json_object *jobj,
+void vmeta_json_proto_add_vec2(struct vmeta_json_writer *w,
 			       const char *name,
 			       const Vmeta__Vector2 *vec2)
 {
-	struct json_object *jobj_vec2;
-
 	if (!vec2) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_vec2 = json_object_new_object();
-	vmeta_json_add_double(jobj_vec2, "x", vec2->x);
-	vmeta_json_add_double(jobj_vec2, "y", vec2->y);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "x", vec2->x);
+	vmeta_json_add_double(w, "y", vec2->y);
 
-	json_object_object_add(jobj, name, jobj_vec2);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_vec3(struct json_object *jobj,
+void vmeta_json_proto_add_vec3(struct vmeta_json_writer *w,
 			       const char *name,
 			       const Vmeta__Vector3 *vec3)
 {
-	struct json_object *jobj_vec3;
-
 	if (!vec3) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_vec3 = json_object_new_object();
-	vmeta_json_add_double(jobj_vec3, "x", vec3->x);
-	vmeta_json_add_double(jobj_vec3, "y", vec3->y);
-	vmeta_json_add_double(jobj_vec3, "z", vec3->z);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "x", vec3->x);
+	vmeta_json_add_double(w, "y", vec3->y);
+	vmeta_json_add_double(w, "z", vec3->z);
 
-	json_object_object_add(jobj, name, jobj_vec3);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_drone_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_drone_metadata(struct vmeta_json_writer *w,
 					 const char *name,
 					 const Vmeta__DroneMetadata *drone)
 {
-	struct json_object *jobj_drone;
 	const ProtobufCEnumValue *flying_state;
 	const ProtobufCEnumValue *piloting_mode;
 
@@ -201,206 +186,169 @@ void vmeta_json_proto_add_drone_metadata(struct json_object *jobj,
 	piloting_mode = protobuf_c_enum_descriptor_get_value(
 		&vmeta__piloting_mode__descriptor, drone->piloting_mode);
 
-	jobj_drone = json_object_new_object();
-
-	vmeta_json_proto_add_quaternion(jobj_drone, "quat", drone->quat);
-	vmeta_json_proto_add_location(jobj_drone, "location", drone->location);
-	vmeta_json_add_double(
-		jobj_drone, "ground_distance", drone->ground_distance);
-	vmeta_json_add_double(jobj_drone, "altitude_ato", drone->altitude_ato);
-	vmeta_json_proto_add_ned(jobj_drone, "position", drone->position);
-	vmeta_json_proto_add_vec3(
-		jobj_drone, "local_position", drone->local_position);
-	vmeta_json_proto_add_ned(jobj_drone, "speed", drone->speed);
-	vmeta_json_add_int(
-		jobj_drone, "battery_percentage", drone->battery_percentage);
-	vmeta_json_add_bool(jobj_drone,
-			    "animation_in_progress",
-			    drone->animation_in_progress);
+	vmeta_json_begin_object(w, name);
+
+	vmeta_json_proto_add_quaternion(w, "quat", drone->quat);
+	vmeta_json_proto_add_location(w, "location", drone->location);
+	vmeta_json_add_double(w, "ground_distance", drone->ground_distance);
+	vmeta_json_add_double(w, "altitude_ato", drone->altitude_ato);
+	vmeta_json_proto_add_ned(w, "position", drone->position);
+	vmeta_json_proto_add_vec3(w, "local_position", drone->local_position);
+	vmeta_json_proto_add_ned(w, "speed", drone->speed);
+	vmeta_json_add_int(w, "battery_percentage", drone->battery_percentage);
+	vmeta_json_add_bool(
+		w, "animation_in_progress", drone->animation_in_progress);
 	if (flying_state != NULL) {
-		vmeta_json_add_str(
-			jobj_drone, "flying_state", flying_state->name);
+		vmeta_json_add_str(w, "flying_state", flying_state->name);
 	}
 	if (piloting_mode != NULL) {
-		vmeta_json_add_str(
-			jobj_drone, "piloting_mode", piloting_mode->name);
+		vmeta_json_add_str(w, "piloting_mode", piloting_mode->name);
 	}
-	json_object_object_add(jobj, name, jobj_drone);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_camera_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_camera_metadata(struct vmeta_json_writer *w,
 					  const char *name,
 					  const Vmeta__CameraMetadata *camera)
 {
 	const ProtobufCEnumValue *spectrum;
 	const ProtobufCEnumValue *subtype;
-	struct json_object *jobj_camera;
 
 	if (!camera) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_camera = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
 	spectrum = protobuf_c_enum_descriptor_get_value(
 		&vmeta__camera_spectrum__descriptor, camera->spectrum);
 	subtype = protobuf_c_enum_descriptor_get_value(
 		&vmeta__camera_subtype__descriptor, camera->subtype);
 
-	vmeta_json_add_int64(jobj_camera, "timestamp", camera->timestamp);
+	vmeta_json_add_int64(w, "timestamp", camera->timestamp);
 	if ((camera->utc_timestamp != 0) &&
 	    (camera->utc_timestamp_accuracy != 0)) {
-		vmeta_json_add_int64(
-			jobj_camera, "utc_timestamp", camera->utc_timestamp);
-		vmeta_json_add_int(jobj_camera,
+		vmeta_json_add_int64(w, "utc_timestamp", camera->utc_timestamp);
+		vmeta_json_add_int(w,
 				   "utc_timestamp_accuracy",
 				   camera->utc_timestamp_accuracy);
 	}
-	vmeta_json_proto_add_quaternion(
-		jobj_camera, "base_quat", camera->base_quat);
-	vmeta_json_proto_add_quaternion(jobj_camera, "quat", camera->quat);
-	vmeta_json_proto_add_quaternion(
-		jobj_camera, "local_quat", camera->local_quat);
-	vmeta_json_proto_add_vec3(
-		jobj_camera, "local_position", camera->local_position);
-	vmeta_json_proto_add_location(
-		jobj_camera, "location", camera->location);
+	vmeta_json_proto_add_quaternion(w, "base_quat", camera->base_quat);
+	vmeta_json_proto_add_quaternion(w, "quat", camera->quat);
+	vmeta_json_proto_add_quaternion(w, "local_quat", camera->local_quat);
+	vmeta_json_proto_add_vec3(w, "local_position", camera->local_position);
+	vmeta_json_proto_add_location(w, "location", camera->location);
 	vmeta_json_proto_add_vec2(
-		jobj_camera, "principal_point", camera->principal_point);
-	vmeta_json_add_double(
-		jobj_camera, "exposure_time", camera->exposure_time);
-	vmeta_json_add_int(jobj_camera, "iso_gain", camera->iso_gain);
-	vmeta_json_add_double(jobj_camera, "awb_r_gain", camera->awb_r_gain);
-	vmeta_json_add_double(jobj_camera, "awb_b_gain", camera->awb_b_gain);
-	vmeta_json_add_double(jobj_camera, "hfov", camera->hfov);
-	vmeta_json_add_double(jobj_camera, "vfov", camera->vfov);
-	vmeta_json_add_double(jobj_camera, "zoom_level", camera->zoom_level);
+		w, "principal_point", camera->principal_point);
+	vmeta_json_add_double(w, "exposure_time", camera->exposure_time);
+	vmeta_json_add_int(w, "iso_gain", camera->iso_gain);
+	vmeta_json_add_double(w, "awb_r_gain", camera->awb_r_gain);
+	vmeta_json_add_double(w, "awb_b_gain", camera->awb_b_gain);
+	vmeta_json_add_double(w, "hfov", camera->hfov);
+	vmeta_json_add_double(w, "vfov", camera->vfov);
+	vmeta_json_add_double(w, "zoom_level", camera->zoom_level);
 	if (spectrum)
-		vmeta_json_add_str(jobj_camera, "spectrum", spectrum->name);
+		vmeta_json_add_str(w, "spectrum", spectrum->name);
 	if (subtype)
-		vmeta_json_add_str(jobj_camera, "subtype", subtype->name);
+		vmeta_json_add_str(w, "subtype", subtype->name);
 
-	json_object_object_add(jobj, name, jobj_camera);
+	vmeta_json_end_object(w);
 }
 
 
 void vmeta_json_proto_add_wifi_link_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__WifiLinkMetadata *wifi)
 {
-	struct json_object *jobj_wifi;
-
 	if (!wifi) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_wifi = json_object_new_object();
-	vmeta_json_add_int(jobj_wifi, "goodput", wifi->goodput);
-	vmeta_json_add_int(jobj_wifi, "quality", wifi->quality);
-	vmeta_json_add_int(jobj_wifi, "rssi", wifi->rssi);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_int(w, "goodput", wifi->goodput);
+	vmeta_json_add_int(w, "quality", wifi->quality);
+	vmeta_json_add_int(w, "rssi", wifi->rssi);
 
-	json_object_object_add(jobj, name, jobj_wifi);
+	vmeta_json_end_object(w);
 }
 
 
 void vmeta_json_proto_add_starfish_link_info(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__StarfishLinkInfo *starfish_info)
 {
-	struct json_object *jobj_starfish_info;
-
 	if (!starfish_info) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_starfish_info = json_object_new_object();
-	vmeta_json_add_str(jobj_starfish_info,
-			   "type",
-			   vmeta_link_type_to_str(starfish_info->type));
-	vmeta_json_add_str(jobj_starfish_info,
-			   "status",
-			   vmeta_link_status_to_str(starfish_info->status));
-	vmeta_json_add_int(
-		jobj_starfish_info, "quality", starfish_info->quality);
-	vmeta_json_add_bool(
-		jobj_starfish_info, "active", starfish_info->active);
-
-	if (json_object_get_type(jobj) == json_type_object)
-		json_object_object_add(jobj, name, jobj_starfish_info);
-	else if (json_object_get_type(jobj) == json_type_array)
-		json_object_array_add(jobj, jobj_starfish_info);
-	else
-		free(jobj_starfish_info);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_str(
+		w, "type", vmeta_link_type_to_str(starfish_info->type));
+	vmeta_json_add_str(
+		w, "status", vmeta_link_status_to_str(starfish_info->status));
+	vmeta_json_add_int(w, "quality", starfish_info->quality);
+	vmeta_json_add_bool(w, "active", starfish_info->active);
+
+	vmeta_json_end_object(w);
 }
 
 
 void vmeta_json_proto_add_starfish_link_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__StarfishLinkMetadata *starfish)
 {
-	struct json_object *jobj_starfish;
-
 	if (!starfish) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_starfish = json_object_new_object();
-	vmeta_json_add_array(jobj_starfish,
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_array(w,
 			     "links",
 			     (union array_element_type *)starfish->links,
 			     starfish->n_links,
 			     vmeta_json_proto_add_starfish_link_info);
-	vmeta_json_add_int(jobj_starfish, "quality", starfish->quality);
+	vmeta_json_add_int(w, "quality", starfish->quality);
 
-	json_object_object_add(jobj, name, jobj_starfish);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_link_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_link_metadata(struct vmeta_json_writer *w,
 					const char *name,
 					const Vmeta__LinkMetadata *link)
 {
-	struct json_object *jobj_link;
-
 	if (!link) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_link = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 
 	switch (link->protocol_case) {
 	case VMETA__LINK_METADATA__PROTOCOL__NOT_SET:
 		break;
 	case VMETA__LINK_METADATA__PROTOCOL_WIFI:
-		vmeta_json_proto_add_wifi_link_metadata(
-			jobj_link, "wifi", link->wifi);
+		vmeta_json_proto_add_wifi_link_metadata(w, "wifi", link->wifi);
 		break;
 	case VMETA__LINK_METADATA__PROTOCOL_STARFISH:
 		vmeta_json_proto_add_starfish_link_metadata(
-			jobj_link, "starfish", link->starfish);
+			w, "starfish", link->starfish);
 		break;
 	default:
 		break;
 	}
 
-	if (json_object_get_type(jobj) == json_type_object)
-		json_object_object_add(jobj, name, jobj_link);
-	else if (json_object_get_type(jobj) == json_type_array)
-		json_object_array_add(jobj, jobj_link);
-	else
-		free(jobj_link);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_bounding_box(struct json_object *jobj,
+void vmeta_json_proto_add_bounding_box(struct vmeta_json_writer *w,
 				       const char *name,
 				       const Vmeta__BoundingBox *bbox)
 {
-	struct json_object *jobj_bbox;
 	const ProtobufCEnumValue *object_class;
 
 	if (!bbox) {
@@ -411,33 +359,26 @@ void vmeta_json_proto_add_bounding_box(struct json_object *jobj,
 	object_class = protobuf_c_enum_descriptor_get_value(
 		&vmeta__tracking_class__descriptor, bbox->object_class);
 
-	jobj_bbox = json_object_new_object();
-	vmeta_json_add_double(jobj_bbox, "x", bbox->x);
-	vmeta_json_add_double(jobj_bbox, "y", bbox->y);
-	vmeta_json_add_double(jobj_bbox, "width", bbox->width);
-	vmeta_json_add_double(jobj_bbox, "height", bbox->height);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "x", bbox->x);
+	vmeta_json_add_double(w, "y", bbox->y);
+	vmeta_json_add_double(w, "width", bbox->width);
+	vmeta_json_add_double(w, "height", bbox->height);
 	if (object_class != NULL) {
-		vmeta_json_add_str(
-			jobj_bbox, "object_class", object_class->name);
+		vmeta_json_add_str(w, "object_class", object_class->name);
 	}
-	vmeta_json_add_double(jobj_bbox, "confidence", bbox->confidence);
-	vmeta_json_add_int(jobj_bbox, "uid", bbox->uid);
+	vmeta_json_add_double(w, "confidence", bbox->confidence);
+	vmeta_json_add_int(w, "uid", bbox->uid);
 
-	if (json_object_get_type(jobj) == json_type_object)
-		json_object_object_add(jobj, name, jobj_bbox);
-	else if (json_object_get_type(jobj) == json_type_array)
-		json_object_array_add(jobj, jobj_bbox);
-	else
-		free(jobj_bbox);
+	vmeta_json_end_object(w);
 }
 
 
 void vmeta_json_proto_add_tracking_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__TrackingMetadata *tracking)
 {
-	struct json_object *jobj_tracking;
 	const ProtobufCEnumValue *state;
 
 	if (!tracking) {
@@ -448,48 +389,44 @@ void vmeta_json_proto_add_tracking_metadata(
 	state = protobuf_c_enum_descriptor_get_value(
 		&vmeta__tracking_state__descriptor, tracking->state);
 
-	jobj_tracking = json_object_new_object();
-	vmeta_json_proto_add_bounding_box(
-		jobj_tracking, "target", tracking->target);
-	vmeta_json_add_int64(jobj_tracking, "timestamp", tracking->timestamp);
-	vmeta_json_add_int(jobj_tracking, "quality", tracking->quality);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_proto_add_bounding_box(w, "target", tracking->target);
+	vmeta_json_add_int64(w, "timestamp", tracking->timestamp);
+	vmeta_json_add_int(w, "quality", tracking->quality);
 	if (state != NULL)
-		vmeta_json_add_str(jobj_tracking, "state", state->name);
-	vmeta_json_add_int(jobj_tracking, "cookie", tracking->cookie);
+		vmeta_json_add_str(w, "state", state->name);
+	vmeta_json_add_int(w, "cookie", tracking->cookie);
 
-	json_object_object_add(jobj, name, jobj_tracking);
+	vmeta_json_end_object(w);
 }
 
 
 void vmeta_json_proto_add_tracking_proposal_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__TrackingProposalMetadata *proposal)
 {
-	struct json_object *jobj_proposal;
-
 	if (!proposal) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_proposal = json_object_new_object();
-	vmeta_json_add_array(jobj_proposal,
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_array(w,
 			     "proposals",
 			     (union array_element_type *)proposal->proposals,
 			     proposal->n_proposals,
 			     vmeta_json_proto_add_bounding_box);
-	vmeta_json_add_int64(jobj_proposal, "timestamp", proposal->timestamp);
+	vmeta_json_add_int64(w, "timestamp", proposal->timestamp);
 
-	json_object_object_add(jobj, name, jobj_proposal);
+	vmeta_json_end_object(w);
 }
 
 
 void vmeta_json_proto_add_automation_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__AutomationMetadata *automation)
 {
-	struct json_object *jobj_automation;
 	const ProtobufCEnumValue *animation;
 
 	if (!automation) {
@@ -499,33 +436,27 @@ void vmeta_json_proto_add_automation_metadata(
 	animation = protobuf_c_enum_descriptor_get_value(
 		&vmeta__animation__descriptor, automation->animation);
 
-	jobj_automation = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 	vmeta_json_proto_add_location(
-		jobj_automation, "destination", automation->destination);
-	vmeta_json_proto_add_location(jobj_automation,
-				      "target_location",
-				      automation->target_location);
-	vmeta_json_add_bool(
-		jobj_automation, "follow_me", automation->follow_me);
-	vmeta_json_add_bool(
-		jobj_automation, "lookat_me", automation->lookat_me);
-	vmeta_json_add_bool(
-		jobj_automation, "angle_locked", automation->angle_locked);
+		w, "destination", automation->destination);
+	vmeta_json_proto_add_location(
+		w, "target_location", automation->target_location);
+	vmeta_json_add_bool(w, "follow_me", automation->follow_me);
+	vmeta_json_add_bool(w, "lookat_me", automation->lookat_me);
+	vmeta_json_add_bool(w, "angle_locked", automation->angle_locked);
 	if (animation) {
-		vmeta_json_add_str(
-			jobj_automation, "animation", animation->name);
+		vmeta_json_add_str(w, "animation", animation->name);
 	}
-	json_object_object_add(jobj, name, jobj_automation);
+	vmeta_json_end_object(w);
 }
 
 
 void vmeta_json_proto_add_thermal_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__ThermalMetadata *thermal)
 {
 	const ProtobufCEnumValue *calibration_state;
-	struct json_object *jobj_thermal;
 
 	if (!thermal) {
 		ULOGD("No %s info", name);
@@ -535,72 +466,61 @@ void vmeta_json_proto_add_thermal_metadata(
 		&vmeta__thermal_calibration_state__descriptor,
 		thermal->calibration_state);
 
-	jobj_thermal = json_object_new_object();
+	vmeta_json_begin_object(w, name);
 	if (calibration_state) {
-		vmeta_json_add_str(jobj_thermal,
-				   "calibration_state",
-				   calibration_state->name);
+		vmeta_json_add_str(
+			w, "calibration_state", calibration_state->name);
 	}
 
-	vmeta_json_proto_add_thermal_spot(jobj_thermal, "min", thermal->min);
-	vmeta_json_proto_add_thermal_spot(jobj_thermal, "max", thermal->max);
-	vmeta_json_proto_add_thermal_spot(
-		jobj_thermal, "probe", thermal->probe);
-	vmeta_json_proto_add_thermal_mask(jobj_thermal, "mask", thermal->mask);
-	json_object_object_add(jobj, name, jobj_thermal);
+	vmeta_json_proto_add_thermal_spot(w, "min", thermal->min);
+	vmeta_json_proto_add_thermal_spot(w, "max", thermal->max);
+	vmeta_json_proto_add_thermal_spot(w, "probe", thermal->probe);
+	vmeta_json_proto_add_thermal_mask(w, "mask", thermal->mask);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_lfic_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_lfic_metadata(struct vmeta_json_writer *w,
 					const char *name,
 					const Vmeta__LFICMetadata *lfic)
 {
-	struct json_object *jobj_lfic;
-
 	if (!lfic) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_lfic = json_object_new_object();
-	vmeta_json_add_double(jobj_lfic, "x", lfic->x);
-	vmeta_json_add_double(jobj_lfic, "y", lfic->y);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "x", lfic->x);
+	vmeta_json_add_double(w, "y", lfic->y);
 	if (lfic->location != NULL) {
-		vmeta_json_proto_add_location(
-			jobj_lfic, "location", lfic->location);
+		vmeta_json_proto_add_location(w, "location", lfic->location);
 	}
 	if (lfic->grid_precision != 0.) {
 		vmeta_json_add_double(
-			jobj_lfic, "grid_precision", lfic->grid_precision);
+			w, "grid_precision", lfic->grid_precision);
 	}
 	vmeta_json_add_str(
-		jobj_lfic,
+		w,
 		"type",
 		vmeta_lfic_type_str(
 			vmeta_frame_lfic_type_proto_to_vmeta(lfic->type)));
 	if (lfic->horizontal_tangential_accuracy != 0.) {
-		vmeta_json_add_double(jobj_lfic,
+		vmeta_json_add_double(w,
 				      "horizontal_tangential_accuracy",
 				      lfic->horizontal_tangential_accuracy);
 	}
 	if (lfic->horizontal_radial_accuracy != 0.) {
-		vmeta_json_add_double(jobj_lfic,
+		vmeta_json_add_double(w,
 				      "horizontal_radial_accuracy",
 				      lfic->horizontal_radial_accuracy);
 	}
-	if (json_object_get_type(jobj) == json_type_object)
-		json_object_object_add(jobj, name, jobj_lfic);
-	else if (json_object_get_type(jobj) == json_type_array)
-		json_object_array_add(jobj, jobj_lfic);
-	else
-		free(jobj_lfic);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_user_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_user_metadata(struct vmeta_json_writer *w,
 					const char *name,
 					const Vmeta__UserMetadata *user)
 {
-	struct json_object *jobj_user;
 	char *base64_data = NULL;
 	int err;
 
@@ -608,65 +528,55 @@ void vmeta_json_proto_add_user_metadata(struct json_object *jobj,
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_user = json_object_new_object();
-	vmeta_json_add_int64(jobj_user, "timestamp", user->timestamp);
-	vmeta_json_add_int(jobj_user, "uid_hash", user->uid_hash);
-	vmeta_json_add_int(jobj_user, "len", user->data.len);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_int64(w, "timestamp", user->timestamp);
+	vmeta_json_add_int(w, "uid_hash", user->uid_hash);
+	vmeta_json_add_int(w, "len", user->data.len);
 	if (user->data.data != NULL && user->data.len > 0) {
 		err = vmeta_base64_encode(
 			user->data.data, user->data.len, &base64_data);
 		if (err < 0) {
 			ULOG_ERRNO("vmeta_base64_encode", -err);
 		} else {
-			vmeta_json_add_str(
-				jobj_user, "base64_data", base64_data);
+			vmeta_json_add_str(w, "base64_data", base64_data);
 		}
 		free(base64_data);
 	} else {
-		vmeta_json_add_str(jobj_user, "base64_data", "");
-	}
-	if (json_object_get_type(jobj) == json_type_object)
-		json_object_object_add(jobj, name, jobj_user);
-	else if (json_object_get_type(jobj) == json_type_array)
-		json_object_array_add(jobj, jobj_user);
-	else
-		free(jobj_user);
+		vmeta_json_add_str(w, "base64_data", "");
+	}
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_thermal_spot(struct json_object *jobj,
+void vmeta_json_proto_add_thermal_spot(struct vmeta_json_writer *w,
 				       const char *name,
 				       const Vmeta__ThermalSpot *thermal)
 {
-	struct json_object *jobj_val;
-
 	if (!thermal) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_val = json_object_new_object();
-	vmeta_json_add_double(jobj_val, "x", thermal->x);
-	vmeta_json_add_double(jobj_val, "y", thermal->y);
-	vmeta_json_add_double(jobj_val, "temp", thermal->temp);
-	vmeta_json_add_int(jobj_val, "value", thermal->value);
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "x", thermal->x);
+	vmeta_json_add_double(w, "y", thermal->y);
+	vmeta_json_add_double(w, "temp", thermal->temp);
+	vmeta_json_add_int(w, "value", thermal->value);
+	vmeta_json_end_object(w);
 }
 
 
-void vmeta_json_proto_add_thermal_mask(struct json_object *jobj,
+void vmeta_json_proto_add_thermal_mask(struct vmeta_json_writer *w,
 				       const char *name,
 				       const Vmeta__Rectf *thermal)
 {
-	struct json_object *jobj_val;
-
 	if (!thermal) {
 		ULOGD("No %s info", name);
 		return;
 	}
-	jobj_val = json_object_new_object();
-	vmeta_json_add_double(jobj_val, "x", thermal->x);
-	vmeta_json_add_double(jobj_val, "y", thermal->y);
-	vmeta_json_add_double(jobj_val, "width", thermal->width);
-	vmeta_json_add_double(jobj_val, "height", thermal->height);
-	json_object_object_add(jobj, name, jobj_val);
+	vmeta_json_begin_object(w, name);
+	vmeta_json_add_double(w, "x", thermal->x);
+	vmeta_json_add_double(w, "y", thermal->y);
+	vmeta_json_add_double(w, "width", thermal->width);
+	vmeta_json_add_double(w, "height", thermal->height);
+	vmeta_json_end_object(w);
 }
@@ -41,134 +41,129 @@ union array_element_type {
 
 
 static inline int
-vmeta_json_add_array(struct json_object *jobj,
+vmeta_json_add_array(struct vmeta_json_writer *w,
 		     const char *name,
 		     union array_element_type *val,
 		     size_t size,
-		     void (*object_nester)(struct json_object *,
+		     void (*object_nester)(struct vmeta_json_writer *,
 					   const char *,
 					   union array_element_type))
 {
-	struct json_object *jobj_array = json_object_new_array();
-	char name_index[64];
-
-	for (size_t i = 0; i < size; ++i) {
-		snprintf(name_index, sizeof(name_index), "%s[%zu]", name, i);
-		object_nester(jobj_array, name_index, val[i]);
-	}
-
-	json_object_object_add(jobj, name, jobj_array);
+	vmeta_json_begin_array(w, name);
+	for (size_t i = 0; i < size; ++i)
+		object_nester(w, name, val[i]);
+	vmeta_json_end_array(w);
 	return 0;
 }
 
 
-int vmeta_json_proto_add_timed_metadata(struct json_object *jobj,
+int vmeta_json_proto_add_timed_metadata(struct vmeta_json_writer *w,
 					Vmeta__TimedMetadata *timed);
 
 
-void vmeta_json_proto_add_quaternion(struct json_object *jobj,
+void vmeta_json_proto_add_quaternion(struct vmeta_json_writer *w,
 				     const char *name,
 				     const Vmeta__Quaternion *quaternion);
 
 
-void vmeta_json_proto_add_location(struct json_object *jobj,
+void vmeta_json_proto_add_location(struct vmeta_json_writer *w,
 				   const char *name,
 				   const Vmeta__Location *location);
 
 
-void vmeta_json_proto_add_ned(struct json_object *jobj,
+void vmeta_json_proto_add_ned(struct vmeta_json_writer *w,
 			      const char *name,
 			      const Vmeta__NED *ned);
 
 
-void vmeta_json_proto_add_vec2(struct json_object *jobj,
+void vmeta_json_proto_add_vec2(struct vmeta_json_writer *w,
 			       const char *name,
 			       const Vmeta__Vector2 *vec2);
 
 
-void vmeta_json_proto_add_vec3(struct json_object *jobj,
+void vmeta_json_proto_add_vec3(struct vmeta_json_writer *w,
 			       const char *name,
 			       const Vmeta__Vector3 *vec3);
 
 
-void vmeta_json_proto_add_drone_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_drone_metadata(struct vmeta_json_writer *w,
 					 const char *name,
 					 const Vmeta__DroneMetadata *drone);
 
 
-void vmeta_json_proto_add_camera_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_camera_metadata(struct vmeta_json_writer *w,
 					  const char *name,
 					  const Vmeta__CameraMetadata *camera);
 
 
 void vmeta_json_proto_add_wifi_link_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__WifiLinkMetadata *wifi);
 
 
 void vmeta_json_proto_add_starfish_link_info(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__StarfishLinkInfo *starfish_info);
 
 
 void vmeta_json_proto_add_starfish_link_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__StarfishLinkMetadata *starfish);
 
 
-void vmeta_json_proto_add_link_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_link_metadata(struct vmeta_json_writer *w,
 					const char *name,
 					const Vmeta__LinkMetadata *link);
 
 
-void vmeta_json_proto_add_bounding_box(struct json_object *jobj,
+void vmeta_json_proto_add_bounding_box(struct vmeta_json_writer *w,
 				       const char *name,
 				       const Vmeta__BoundingBox *bbox);
 
 
 void vmeta_json_proto_add_tracking_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__TrackingMetadata *tracking);
 
 
 void vmeta_json_proto_add_tracking_proposal_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__TrackingProposalMetadata *proposal);
 
 
 void vmeta_json_proto_add_thermal_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__ThermalMetadata *thermal);
 
 
 void vmeta_json_proto_add_automation_metadata(
-	struct json_object *jobj,
+	struct vmeta_json_writer *w,
 	const char *name,
 	const Vmeta__AutomationMetadata *automation);
 
 
-void vmeta_json_proto_add_lfic_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_lfic_metadata(struct vmeta_json_writer *w,
 					const char *name,
 					const Vmeta__LFICMetadata *lfic);
 
 
-void vmeta_json_proto_add_user_metadata(struct json_object *jobj,
+void vmeta_json_proto_add_user_metadata(struct vmeta_json_writer *w,
 					const char *name,
 					const Vmeta__UserMetadata *user);
 
 
-void vmeta_json_proto_add_thermal_spot(struct json_object *jobj,
+void vmeta_json_proto_add_thermal_spot(struct vmeta_json_writer *w,
 				       const char *name,
 				       const Vmeta__ThermalSpot *thermal);
 
 
-void vmeta_json_proto_add_thermal_mask(struct json_object *jobj,
+void vmeta_json_proto_add_thermal_mask(struct vmeta_json_writer *w,
 				       const char *name,
 				       const Vmeta__Rectf *thermal);
 
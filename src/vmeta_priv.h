@@ -31,8 +31,10 @@
 #include <float.h>
 #include <inttypes.h>
 #include <json-c/json.h>
+#include <limits.h>
 #include <math.h>
 #include <pthread.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -64,6 +66,53 @@
 
 #define VMETA_STR_LF(_str, _len, _max) (_len += snprintf(_str, _max, "\n"))
 
+/* Maximum length of a vmeta_dtoa() or vmeta_ftoa() output, including the
+ * null terminator */
+#define VMETA_DTOA_MAX_LEN 32
+
+
+/**
+ * Format a double with the shortest digits that read back as the same value,
+ * in the same layout as printf's "%.17g" format.
+ * @param val: value to format
+ * @param str: output string, at least VMETA_DTOA_MAX_LEN bytes long
+ * @return the length of the null-terminated output string
+ */
+size_t vmeta_dtoa(double val, char *str);
+
+
+/**
+ * Format a float with the shortest digits that read back as the same float
+ * value, in the same layout as vmeta_dtoa().
+ * @param val: value to format
+ * @param str: output string, at least VMETA_DTOA_MAX_LEN bytes long
+ * @return the length of the null-terminated output string
+ */
+size_t vmeta_ftoa(float val, char *str);
+
+
+/**
+ * Compute a 64-bit hash-value of a buffer (not a cryptographic hash).
+ * The data is processed by 64-bit words; the hash of several buffers can be
+ * computed by passing the previous hash-value as the seed parameter.
+ * @param data: pointer to the data to hash
+ * @param len: length of the data in bytes
+ * @param seed: previous hash-value, or any initial value
+ * @return the hash-value
+ */
+uint64_t vmeta_hash64(const void *data, size_t len, uint64_t seed);
+
+
+/**
+ * Compute a 128-bit hash-value of a buffer (not a cryptographic hash).
+ * The hash-value is updated in place: the hash of several buffers can be
+ * computed by calling the function for each buffer with the same hash.
+ * @param data: pointer to the data to hash
+ * @param len: length of the data in bytes
+ * @param hash: previous hash-value, or any initial value (input and output)
+ */
+void vmeta_hash128(const void *data, size_t len, uint64_t hash[2]);
+
 
 static inline void vmeta_location_adjust_read(const struct vmeta_location *in,
 					      struct vmeta_location *out)
@@ -341,6 +390,51 @@ vmeta_read_f64_u32(struct vmeta_buffer *buf, double *v, uint32_t shift)
 }
 
 
+/* Unchecked big-endian loads, for data already bounds-checked */
+static inline uint16_t vmeta_load_u16(const uint8_t *p)
+{
+	return ((uint16_t)p[0] << 8) | p[1];
+}
+
+
+static inline uint32_t vmeta_load_u32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | p[3];
+}
+
+
+/**
+ * Convert consecutive big-endian fixed-point signed 16-bit values to floats.
+ * Each value is multiplied by its own scale (1 / (1 << shift) for a
+ * fixed-point value), so that fields with different shifts can be decoded
+ * at once; the result is identical to vmeta_read_f32_i16(). The data must
+ * have been bounds-checked by the caller.
+ * @param src: pointer to the first value
+ * @param scale: array of count scales
+ * @param dst: array of count floats (output)
+ * @param count: number of values
+ */
+void vmeta_decode_f32_i16(const uint8_t *src,
+			  const float *scale,
+			  float *dst,
+			  size_t count);
+
+
+/**
+ * Convert consecutive big-endian fixed-point unsigned 16-bit values to
+ * floats; see vmeta_decode_f32_i16().
+ * @param src: pointer to the first value
+ * @param scale: array of count scales
+ * @param dst: array of count floats (output)
+ * @param count: number of values
+ */
+void vmeta_decode_f32_u16(const uint8_t *src,
+			  const float *scale,
+			  float *dst,
+			  size_t count);
+
+
 int vmeta_base64_encode(const void *data, size_t size, char **out);
 
 
@@ -395,25 +489,458 @@ int vmeta_frame_proto_init(struct vmeta_frame_proto **meta);
 
 
 int vmeta_frame_proto_read(struct vmeta_buffer *buf,
+			   int borrow,
+			   vmeta_frame_buffer_release_cb_t release,
+			   void *userdata,
 			   struct vmeta_frame_proto **meta);
 
 
-int vmeta_frame_proto_write(struct vmeta_buffer *buf, struct vmeta_frame *meta);
+int vmeta_frame_proto_is_borrowed(struct vmeta_frame_proto *meta);
+
+
+int vmeta_frame_proto_write(struct vmeta_buffer *buf,
+			    struct vmeta_frame *meta,
+			    int cache);
 
 
 int vmeta_frame_proto_to_json(struct vmeta_frame *meta,
-			      struct json_object *jobj);
+			      struct vmeta_json_writer *w);
+
+
+int vmeta_frame_proto_to_csv(struct vmeta_frame *meta,
+			     struct vmeta_csv_writer *w);
+
+
+size_t vmeta_frame_proto_csv_header(char *str, size_t maxlen);
 
 
 int vmeta_frame_proto_destroy(struct vmeta_frame_proto *meta);
 
 
+int vmeta_frame_proto_recycle(struct vmeta_frame_proto *meta);
+
+
+/* Parts of the protobuf-based metadata that can be decoded directly from the
+ * packed buffer (see vmeta_frame_proto_get_view()) */
+#define VMETA_FRAME_PROTO_VIEW_DRONE (1u << 0)
+#define VMETA_FRAME_PROTO_VIEW_CAMERA (1u << 1)
+/* Parts that always require the unpacked metadata */
+#define VMETA_FRAME_PROTO_VIEW_LINKS (1u << 2)
+
+
+/* Partial protobuf-based metadata decoded from the packed buffer; only the
+ * requested parts are set in the tm structure */
+struct vmeta_frame_proto_view {
+	Vmeta__TimedMetadata tm;
+
+	Vmeta__DroneMetadata drone;
+	Vmeta__Quaternion drone_quat;
+	Vmeta__Location drone_location;
+	Vmeta__NED drone_speed;
+	Vmeta__NED drone_position;
+	Vmeta__Vector3 drone_local_position;
+
+	Vmeta__CameraMetadata camera;
+	Vmeta__Quaternion camera_base_quat;
+	Vmeta__Quaternion camera_quat;
+	Vmeta__Quaternion camera_local_quat;
+	Vmeta__Vector3 camera_local_position;
+	Vmeta__Location camera_location;
+	Vmeta__Vector2 camera_principal_point;
+
+	/* Metadata already acquired by the caller for several getters (see
+	 * vmeta_frame_get_fields()); when set, getting and releasing the view
+	 * only return this pointer */
+	const Vmeta__TimedMetadata *held;
+};
+
+
+/**
+ * Get a read-only view of parts of the protobuf-based metadata.
+ * If the metadata is only available packed, the requested parts are decoded
+ * directly from the packed buffer into the view structure, without unpacking
+ * the whole message; otherwise this is equivalent to
+ * vmeta_frame_proto_get_unpacked().
+ * The view must be released using vmeta_frame_proto_release_view().
+ * @param meta: pointer to the frame metadata structure
+ * @param parts: requested parts (VMETA_FRAME_PROTO_VIEW_* flags)
+ * @param view: pointer to a view structure, used as storage when decoding
+ *              from the packed buffer
+ * @param proto_meta: pointer filled with the metadata (only the requested
+ *                    parts are valid)
+ * @return 0 on success, negative errno value in case of error
+ */
+int vmeta_frame_proto_get_view(struct vmeta_frame *meta,
+			       unsigned int parts,
+			       struct vmeta_frame_proto_view *view,
+			       const Vmeta__TimedMetadata **proto_meta);
+
+
+int vmeta_frame_proto_release_view(struct vmeta_frame *meta,
+				   struct vmeta_frame_proto_view *view,
+				   const Vmeta__TimedMetadata *proto_meta);
+
+
+int vmeta_frame_proto_scan_buffer(const uint8_t *buf,
+				  size_t len,
+				  unsigned int parts,
+				  struct vmeta_frame_proto_view *view);
+
+
+/* Number of top-level parts (see enum vmeta_frame_proto_part) */
+#define VMETA_FRAME_PROTO_PART_COUNT 9
+
+
+/* Location of a part in a packed buffer */
+struct vmeta_frame_proto_span {
+	size_t offset;
+	size_t len;
+};
+
+
+/* Split a packed TimedMetadata message into the spans of its top-level parts
+ * (field number i + 1 in spans[i], empty spans for absent parts); returns
+ * -ENOTSUP if the message has unknown fields or if the occurrences of a field
+ * are not contiguous and in field number order (as packed by protobuf-c) */
+int vmeta_frame_proto_scan_parts(
+	const uint8_t *buf,
+	size_t len,
+	struct vmeta_frame_proto_span spans[VMETA_FRAME_PROTO_PART_COUNT]);
+
+
+/**
+ * Internal API for protobuf wire format encoding
+ */
+
+
+/* Wire types */
+#define VMETA_PROTO_WIRE_VARINT 0
+#define VMETA_PROTO_WIRE_FIXED64 1
+#define VMETA_PROTO_WIRE_LEN 2
+#define VMETA_PROTO_WIRE_FIXED32 5
+
+
+/* Protobuf wire format writer; once the data is full, the writer only keeps
+ * counting the bytes and the overflow flag is set */
+struct vmeta_proto_wire {
+	uint8_t *data;
+	size_t len;
+	size_t pos;
+	int overflow;
+};
+
+
+/* Message content writer (see vmeta_proto_wire_message()) */
+typedef void (*vmeta_proto_wire_message_cb_t)(struct vmeta_proto_wire *w,
+					      const void *msg);
+
+
+void vmeta_proto_wire_init(struct vmeta_proto_wire *w,
+			   uint8_t *data,
+			   size_t len);
+
+
+/* Scalar field writers: following the proto3 rules (and the protobuf-c
+ * packing), zero values are not written */
+void vmeta_proto_wire_uint32(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     uint32_t val);
+
+
+void vmeta_proto_wire_uint64(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     uint64_t val);
+
+
+/* Also used for enum fields */
+void vmeta_proto_wire_int32(struct vmeta_proto_wire *w,
+			    uint32_t field,
+			    int32_t val);
+
+
+void vmeta_proto_wire_sint32(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     int32_t val);
+
+
+void vmeta_proto_wire_bool(struct vmeta_proto_wire *w, uint32_t field, int val);
+
+
+void vmeta_proto_wire_float(struct vmeta_proto_wire *w,
+			    uint32_t field,
+			    float val);
+
+
+void vmeta_proto_wire_double(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     double val);
+
+
+/* Write a message field (always written, even if empty) whose content is
+ * written by the cb function */
+void vmeta_proto_wire_message(struct vmeta_proto_wire *w,
+			      uint32_t field,
+			      vmeta_proto_wire_message_cb_t cb,
+			      const void *msg);
+
+
+/**
+ * Internal API for vmeta_frame_pool
+ */
+
+
+int vmeta_frame_pool_get_frame(struct vmeta_frame_pool *pool,
+			       struct vmeta_frame **frame);
+
+
+struct vmeta_frame_proto *
+vmeta_frame_pool_get_proto(struct vmeta_frame_pool *pool);
+
+
+int vmeta_frame_pool_put_frame(struct vmeta_frame *frame);
+
+
 const char *vmeta_link_type_to_str(Vmeta__LinkType val);
 
 
 const char *vmeta_link_status_to_str(Vmeta__LinkStatus val);
 
 
+/**
+ * Internal JSON API: the *_to_json_writer() functions add the metadata fields
+ * as members of the current object of a JSON writer (see vmeta_json.h)
+ */
+
+
+int vmeta_frame_v1_streaming_basic_to_json_writer(
+	const struct vmeta_frame_v1_streaming_basic *meta,
+	struct vmeta_json_writer *w);
+
+
+int vmeta_frame_v1_streaming_extended_to_json_writer(
+	const struct vmeta_frame_v1_streaming_extended *meta,
+	struct vmeta_json_writer *w);
+
+
+int vmeta_frame_v1_recording_to_json_writer(
+	const struct vmeta_frame_v1_recording *meta,
+	struct vmeta_json_writer *w);
+
+
+int vmeta_frame_v2_to_json_writer(const struct vmeta_frame_v2 *meta,
+				  struct vmeta_json_writer *w);
+
+
+int vmeta_frame_v3_to_json_writer(const struct vmeta_frame_v3 *meta,
+				  struct vmeta_json_writer *w);
+
+
+int vmeta_frame_to_json_writer(struct vmeta_frame *meta,
+			       struct vmeta_json_writer *w);
+
+
+int vmeta_session_to_json_writer(const struct vmeta_session *meta,
+				 struct vmeta_json_writer *w);
+
+
+/**
+ * Internal CSV API: the *_to_csv_writer() functions add the metadata fields
+ * as values of a CSV writer (see vmeta_csv.h)
+ */
+
+
+void vmeta_frame_v1_streaming_basic_to_csv_writer(
+	const struct vmeta_frame_v1_streaming_basic *meta,
+	struct vmeta_csv_writer *w);
+
+
+void vmeta_frame_v1_streaming_extended_to_csv_writer(
+	const struct vmeta_frame_v1_streaming_extended *meta,
+	struct vmeta_csv_writer *w);
+
+
+void vmeta_frame_v1_recording_to_csv_writer(
+	const struct vmeta_frame_v1_recording *meta,
+	struct vmeta_csv_writer *w);
+
+
+void vmeta_frame_v2_to_csv_writer(const struct vmeta_frame_v2 *meta,
+				  struct vmeta_csv_writer *w);
+
+
+void vmeta_frame_v3_to_csv_writer(const struct vmeta_frame_v3 *meta,
+				  struct vmeta_csv_writer *w);
+
+
+/**
+ * Internal frame metadata table API: column descriptors shared by the
+ * frame metadata table and the frame metadata archive
+ */
+
+
+/* Frame metadata fields extracted for the table columns */
+#define VMETA_FRAME_TABLE_FIELDS                                               \
+	(VMETA_FRAME_FIELD_TIMESTAMP | VMETA_FRAME_FIELD_LOCATION |            \
+	 VMETA_FRAME_FIELD_SPEED_NED | VMETA_FRAME_FIELD_DRONE_QUAT |          \
+	 VMETA_FRAME_FIELD_FRAME_QUAT | VMETA_FRAME_FIELD_EXPOSURE_TIME |      \
+	 VMETA_FRAME_FIELD_GAIN | VMETA_FRAME_FIELD_LINK_QUALITY)
+
+
+enum vmeta_frame_table_type {
+	VMETA_FRAME_TABLE_TYPE_U64 = 0,
+	VMETA_FRAME_TABLE_TYPE_DOUBLE,
+	VMETA_FRAME_TABLE_TYPE_FLOAT,
+	VMETA_FRAME_TABLE_TYPE_U16,
+	VMETA_FRAME_TABLE_TYPE_U8,
+};
+
+
+struct vmeta_frame_table_column_desc {
+	enum vmeta_frame_table_type type;
+	size_t size;
+
+	/* Field the column is filled from (enum vmeta_frame_field bit), and
+	 * offset of the value in the vmeta_frame_flat structure */
+	uint32_t field;
+	size_t offset;
+};
+
+
+extern const struct vmeta_frame_table_column_desc
+	vmeta_frame_table_columns[VMETA_FRAME_TABLE_COLUMN_COUNT];
+
+
+/* Set a column value from the fields of a frame (see
+ * vmeta_frame_get_fields()); absent values are set to NaN for floating-point
+ * columns and 0 otherwise. Returns 1 if the value is present, 0 otherwise. */
+int vmeta_frame_table_column_set(
+	const struct vmeta_frame_table_column_desc *desc,
+	const struct vmeta_frame_flat *flat,
+	uint8_t *value);
+
+
+/**
+ * Internal session metadata field API: field descriptors shared by the
+ * session metadata fingerprints, the session metadata merging and the
+ * serialized session metadata
+ */
+
+
+/* Fields of the session metadata structure; there must be at most 64 fields
+ * as the users keep sets of fields in 64-bit masks */
+enum vmeta_session_field_id {
+	VMETA_SESSION_FIELD_FRIENDLY_NAME = 0,
+	VMETA_SESSION_FIELD_MAKER,
+	VMETA_SESSION_FIELD_MODEL,
+	VMETA_SESSION_FIELD_MODEL_ID,
+	VMETA_SESSION_FIELD_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_SOFTWARE_VERSION,
+	VMETA_SESSION_FIELD_BUILD_ID,
+	VMETA_SESSION_FIELD_TITLE,
+	VMETA_SESSION_FIELD_COMMENT,
+	VMETA_SESSION_FIELD_COPYRIGHT,
+	VMETA_SESSION_FIELD_MEDIA_DATE,
+	VMETA_SESSION_FIELD_MEDIA_DATE_GMTOFF,
+	VMETA_SESSION_FIELD_RUN_DATE,
+	VMETA_SESSION_FIELD_RUN_DATE_GMTOFF,
+	VMETA_SESSION_FIELD_RUN_ID,
+	VMETA_SESSION_FIELD_BOOT_DATE,
+	VMETA_SESSION_FIELD_BOOT_DATE_GMTOFF,
+	VMETA_SESSION_FIELD_BOOT_ID,
+	VMETA_SESSION_FIELD_FLIGHT_DATE,
+	VMETA_SESSION_FIELD_FLIGHT_DATE_GMTOFF,
+	VMETA_SESSION_FIELD_FLIGHT_ID,
+	VMETA_SESSION_FIELD_CUSTOM_ID,
+	VMETA_SESSION_FIELD_TAKEOFF_LOC,
+	VMETA_SESSION_FIELD_LOCATION,
+	VMETA_SESSION_FIELD_PICTURE_FOV,
+	VMETA_SESSION_FIELD_THERMAL,
+	VMETA_SESSION_FIELD_HAS_THERMAL,
+	VMETA_SESSION_FIELD_DEFAULT_MEDIA,
+	VMETA_SESSION_FIELD_PROTO_DELTA,
+	VMETA_SESSION_FIELD_CAMERA_TYPE,
+	VMETA_SESSION_FIELD_CAMERA_SUBTYPE,
+	VMETA_SESSION_FIELD_CAMERA_SPECTRUM,
+	VMETA_SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_CAMERA_MODEL,
+	VMETA_SESSION_FIELD_OVERLAY,
+	VMETA_SESSION_FIELD_PRINCIPAL_POINT,
+	VMETA_SESSION_FIELD_VIDEO_MODE,
+	VMETA_SESSION_FIELD_VIDEO_STOP_REASON,
+	VMETA_SESSION_FIELD_DYNAMIC_RANGE,
+	VMETA_SESSION_FIELD_TONE_MAPPING,
+	VMETA_SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	VMETA_SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX,
+	VMETA_SESSION_FIELD_MEDIA_ID,
+	VMETA_SESSION_FIELD_RESOURCE_INDEX,
+
+	VMETA_SESSION_FIELD_COUNT,
+};
+
+
+/* Session metadata field value types */
+enum vmeta_session_value_type {
+	/* Null-terminated string */
+	VMETA_SESSION_VALUE_STR = 0,
+
+	/* Scalar value (0 when unset) */
+	VMETA_SESSION_VALUE_SCALAR,
+
+	/* Structure compared as raw bytes */
+	VMETA_SESSION_VALUE_STRUCT,
+
+	/* struct vmeta_location (erased through the valid flag) */
+	VMETA_SESSION_VALUE_LOCATION,
+
+	/* struct vmeta_fov (erased through the has_horz/has_vert flags) */
+	VMETA_SESSION_VALUE_FOV,
+
+	/* struct vmeta_thermal (never erased, see has_thermal) */
+	VMETA_SESSION_VALUE_THERMAL,
+
+	/* struct vmeta_principal_point (only the valid flag is cleared) */
+	VMETA_SESSION_VALUE_PRINCIPAL_POINT,
+
+	/* Bit fields */
+	VMETA_SESSION_VALUE_HAS_THERMAL,
+	VMETA_SESSION_VALUE_DEFAULT_MEDIA,
+	VMETA_SESSION_VALUE_PROTO_DELTA,
+};
+
+
+struct vmeta_session_field_desc {
+	enum vmeta_session_group group;
+	enum vmeta_session_value_type type;
+
+	/* Offset and size of the member in the vmeta_session structure
+	 * (0 for the bit fields) */
+	size_t offset;
+	size_t size;
+
+	/* The field only qualifies the previous field (GMT offset of a date,
+	 * thermal flag) and is always written along with it */
+	int joined;
+};
+
+
+extern const struct vmeta_session_field_desc
+	vmeta_session_fields[VMETA_SESSION_FIELD_COUNT];
+
+
+/* Check whether a field has the same value in two session metadata; strings
+ * are compared up to their terminator, other values as raw bytes. Returns 1
+ * if the values are equal, 0 otherwise. */
+int vmeta_session_field_equal(const struct vmeta_session_field_desc *desc,
+			      const struct vmeta_session *meta1,
+			      const struct vmeta_session *meta2);
+
+
+/* Copy a field from a session metadata to another */
+void vmeta_session_field_copy(const struct vmeta_session_field_desc *desc,
+			      struct vmeta_session *dst,
+			      const struct vmeta_session *src);
+
+
 /**
  * Internal conversion API
  */
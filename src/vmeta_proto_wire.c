@@ -0,0 +1,207 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+/* Wire-level encoding of protobuf messages, without building a protobuf-c
+ * message tree. Fields must be written in increasing field number order to
+ * produce the same bytes as protobuf-c packing. */
+
+
+static void
+vmeta_proto_wire_put(struct vmeta_proto_wire *w, const uint8_t *p, size_t n)
+{
+	if (!w->overflow && n > w->len - w->pos)
+		w->overflow = 1;
+	if (!w->overflow)
+		memcpy(w->data + w->pos, p, n);
+	w->pos += n;
+}
+
+
+static size_t vmeta_proto_wire_varint_encode(uint8_t *p, uint64_t val)
+{
+	size_t n = 0;
+
+	while (val >= 0x80) {
+		p[n++] = (uint8_t)(val | 0x80);
+		val >>= 7;
+	}
+	p[n++] = (uint8_t)val;
+
+	return n;
+}
+
+
+static void vmeta_proto_wire_varint(struct vmeta_proto_wire *w, uint64_t val)
+{
+	uint8_t p[10];
+
+	vmeta_proto_wire_put(w, p, vmeta_proto_wire_varint_encode(p, val));
+}
+
+
+static void vmeta_proto_wire_tag(struct vmeta_proto_wire *w,
+				 uint32_t field,
+				 uint32_t wire_type)
+{
+	vmeta_proto_wire_varint(w, ((uint64_t)field << 3) | wire_type);
+}
+
+
+void vmeta_proto_wire_init(struct vmeta_proto_wire *w,
+			   uint8_t *data,
+			   size_t len)
+{
+	w->data = data;
+	w->len = len;
+	w->pos = 0;
+	w->overflow = 0;
+}
+
+
+void vmeta_proto_wire_uint32(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     uint32_t val)
+{
+	if (val == 0)
+		return;
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_VARINT);
+	vmeta_proto_wire_varint(w, val);
+}
+
+
+void vmeta_proto_wire_uint64(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     uint64_t val)
+{
+	if (val == 0)
+		return;
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_VARINT);
+	vmeta_proto_wire_varint(w, val);
+}
+
+
+void vmeta_proto_wire_int32(struct vmeta_proto_wire *w,
+			    uint32_t field,
+			    int32_t val)
+{
+	if (val == 0)
+		return;
+	/* Negative values are sign-extended to 64 bits */
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_VARINT);
+	vmeta_proto_wire_varint(w, (uint64_t)(int64_t)val);
+}
+
+
+void vmeta_proto_wire_sint32(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     int32_t val)
+{
+	if (val == 0)
+		return;
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_VARINT);
+	vmeta_proto_wire_varint(
+		w, ((uint32_t)val << 1) ^ (uint32_t)(val >> 31));
+}
+
+
+void vmeta_proto_wire_bool(struct vmeta_proto_wire *w, uint32_t field, int val)
+{
+	if (!val)
+		return;
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_VARINT);
+	vmeta_proto_wire_varint(w, 1);
+}
+
+
+void vmeta_proto_wire_float(struct vmeta_proto_wire *w,
+			    uint32_t field,
+			    float val)
+{
+	uint32_t v;
+	uint8_t p[4];
+
+	/* NaN values are written, -0 is not (same as protobuf-c) */
+	if (val == 0)
+		return;
+	memcpy(&v, &val, sizeof(v));
+	for (size_t i = 0; i < sizeof(p); i++)
+		p[i] = (uint8_t)(v >> (8 * i));
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_FIXED32);
+	vmeta_proto_wire_put(w, p, sizeof(p));
+}
+
+
+void vmeta_proto_wire_double(struct vmeta_proto_wire *w,
+			     uint32_t field,
+			     double val)
+{
+	uint64_t v;
+	uint8_t p[8];
+
+	if (val == 0)
+		return;
+	memcpy(&v, &val, sizeof(v));
+	for (size_t i = 0; i < sizeof(p); i++)
+		p[i] = (uint8_t)(v >> (8 * i));
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_FIXED64);
+	vmeta_proto_wire_put(w, p, sizeof(p));
+}
+
+
+void vmeta_proto_wire_message(struct vmeta_proto_wire *w,
+			      uint32_t field,
+			      vmeta_proto_wire_message_cb_t cb,
+			      const void *msg)
+{
+	uint8_t p[10];
+	size_t start, size, n;
+
+	vmeta_proto_wire_tag(w, field, VMETA_PROTO_WIRE_LEN);
+
+	/* Reserve one byte for the length, which is enough for messages of
+	 * up to 127 bytes; the content is moved afterwards if more bytes are
+	 * needed, so that the message is only written once */
+	vmeta_proto_wire_varint(w, 0);
+	start = w->pos;
+	cb(w, msg);
+	size = w->pos - start;
+	n = vmeta_proto_wire_varint_encode(p, size);
+	if (n > 1 && !w->overflow) {
+		if (n - 1 > w->len - w->pos) {
+			w->overflow = 1;
+		} else {
+			memmove(w->data + start + n - 1,
+				w->data + start,
+				size);
+		}
+	}
+	if (!w->overflow)
+		memcpy(w->data + start - 1, p, n);
+	w->pos += n - 1;
+}
@@ -34,59 +34,6 @@
 	}
 
 
-#define MERGE_META_STR(_dst, _src, _field)                                     \
-	{                                                                      \
-		if (strlen(_dst->_field) != strlen(_src->_field)) {            \
-			_dst->_field[0] = '\0';                                \
-		}                                                              \
-		if (strncmp(_dst->_field,                                      \
-			    _src->_field,                                      \
-			    strlen(_src->_field)) != 0) {                      \
-			_dst->_field[0] = '\0';                                \
-		}                                                              \
-	}
-
-
-#define REMOVE_DUPLICATE_META_STR(_dst, _src, _field)                          \
-	{                                                                      \
-		if (_src->_field[0] != '\0') {                                 \
-			_dst->_field[0] = '\0';                                \
-		}                                                              \
-	}
-
-
-#define MERGE_META_VAL(_dst, _src, _field, _v)                                 \
-	{                                                                      \
-		if (_dst->_field != _src->_field) {                            \
-			_dst->_field = _v;                                     \
-		}                                                              \
-	}
-
-
-#define REMOVE_DUPLICATE_META_VAL(_dst, _src, _field, _v)                      \
-	{                                                                      \
-		if (_src->_field != _v) {                                      \
-			_dst->_field = _v;                                     \
-		}                                                              \
-	}
-
-
-#define MERGE_META_PTR(_dst, _src, _field, _size)                              \
-	{                                                                      \
-		if (memcmp(_dst->_field, _src->_field, _size) != 0) {          \
-			memset(_dst->_field, 0, _size);                        \
-		}                                                              \
-	}
-
-
-#define REMOVE_DUPLICATE_META_PTR(_dst, _src, _field, _size)                   \
-	{                                                                      \
-		if (memcmp(_dst->_field, _src->_field, _size) == 0) {          \
-			memset(_dst->_field, 0, _size);                        \
-		}                                                              \
-	}
-
-
 #define CMP_FIELD_VAL(_dst, _src, _field)                                      \
 	{                                                                      \
 		if (_dst->_field != _src->_field)                              \
@@ -632,6 +579,661 @@ int vmeta_session_principal_point_read(
 }
 
 
+/* Session metadata fields, as identified by the keys of the readers */
+enum session_field {
+	SESSION_FIELD_UNKNOWN = 0,
+	SESSION_FIELD_FRIENDLY_NAME,
+	SESSION_FIELD_TITLE,
+	SESSION_FIELD_COMMENT,
+	SESSION_FIELD_COPYRIGHT,
+	SESSION_FIELD_MEDIA_DATE,
+	SESSION_FIELD_TAKEOFF_LOC,
+	SESSION_FIELD_LOCATION,
+	SESSION_FIELD_MAKER,
+	SESSION_FIELD_MODEL,
+	SESSION_FIELD_SOFTWARE_VERSION,
+	SESSION_FIELD_SERIAL_NUMBER,
+	SESSION_FIELD_MODEL_ID,
+	SESSION_FIELD_BUILD_ID,
+	SESSION_FIELD_RUN_DATE,
+	SESSION_FIELD_RUN_ID,
+	SESSION_FIELD_BOOT_DATE,
+	SESSION_FIELD_BOOT_ID,
+	SESSION_FIELD_FLIGHT_DATE,
+	SESSION_FIELD_FLIGHT_ID,
+	SESSION_FIELD_CUSTOM_ID,
+	SESSION_FIELD_PICTURE_HORZ_FOV,
+	SESSION_FIELD_PICTURE_VERT_FOV,
+	SESSION_FIELD_PICTURE_FOV,
+	SESSION_FIELD_THERMAL_METAVERSION,
+	SESSION_FIELD_THERMAL_CAMSERIAL,
+	SESSION_FIELD_THERMAL_ALIGNMENT,
+	SESSION_FIELD_THERMAL_CONV_LOW,
+	SESSION_FIELD_THERMAL_CONV_HIGH,
+	SESSION_FIELD_THERMAL_SCALE_FACTOR,
+	SESSION_FIELD_CAMERA_TYPE,
+	SESSION_FIELD_CAMERA_SUBTYPE,
+	SESSION_FIELD_CAMERA_SPECTRUM,
+	SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	SESSION_FIELD_CAMERA_MODEL_TYPE,
+	SESSION_FIELD_PERSPECTIVE_DISTORTION,
+	SESSION_FIELD_FISHEYE_AFFINE_MATRIX,
+	SESSION_FIELD_FISHEYE_POLYNOMIAL,
+	SESSION_FIELD_HEADER_FOOTER,
+	SESSION_FIELD_VIDEO_MODE,
+	SESSION_FIELD_VIDEO_STOP_REASON,
+	SESSION_FIELD_DYNAMIC_RANGE,
+	SESSION_FIELD_TONE_MAPPING,
+	SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX,
+	SESSION_FIELD_MEDIA_ID,
+	SESSION_FIELD_RESOURCE_INDEX,
+	SESSION_FIELD_PRINCIPAL_POINT,
+	SESSION_FIELD_DEFAULT_MEDIA,
+	SESSION_FIELD_PROTO_DELTA,
+
+	/* MP4 udta keys (see vmeta_session_recording_read()) */
+	SESSION_FIELD_UDTA_FRIENDLY_NAME,
+	SESSION_FIELD_UDTA_TITLE,
+	SESSION_FIELD_UDTA_COMMENT,
+	SESSION_FIELD_UDTA_COPYRIGHT,
+	SESSION_FIELD_UDTA_MEDIA_DATE,
+	SESSION_FIELD_UDTA_LOCATION,
+	SESSION_FIELD_UDTA_MAKER,
+	SESSION_FIELD_UDTA_MODEL,
+	SESSION_FIELD_UDTA_SOFTWARE_VERSION,
+	SESSION_FIELD_UDTA_SERIAL_NUMBER,
+};
+
+
+/* Key flag: SDP session-level attribute only */
+#define SESSION_KEY_FLAG_SDP_SESSION (1 << 0)
+
+
+struct session_key {
+	const char *key;
+	enum session_field field;
+	uint32_t flags;
+};
+
+
+/* Keys of the RTCP SDES PRIV items */
+static const struct session_key s_sdes_keys[] = {
+	{VMETA_STRM_SDES_KEY_MEDIA_DATE, SESSION_FIELD_MEDIA_DATE, 0},
+	{VMETA_STRM_SDES_KEY_RUN_DATE, SESSION_FIELD_RUN_DATE, 0},
+	{VMETA_STRM_SDES_KEY_TAKEOFF_LOC, SESSION_FIELD_TAKEOFF_LOC, 0},
+	{VMETA_STRM_SDES_KEY_RUN_ID, SESSION_FIELD_RUN_ID, 0},
+	{VMETA_STRM_SDES_KEY_BOOT_DATE, SESSION_FIELD_BOOT_DATE, 0},
+	{VMETA_STRM_SDES_KEY_BOOT_ID, SESSION_FIELD_BOOT_ID, 0},
+	{VMETA_STRM_SDES_KEY_FLIGHT_DATE, SESSION_FIELD_FLIGHT_DATE, 0},
+	{VMETA_STRM_SDES_KEY_FLIGHT_ID, SESSION_FIELD_FLIGHT_ID, 0},
+	{VMETA_STRM_SDES_KEY_CUSTOM_ID, SESSION_FIELD_CUSTOM_ID, 0},
+	{VMETA_STRM_SDES_KEY_MAKER, SESSION_FIELD_MAKER, 0},
+	{VMETA_STRM_SDES_KEY_MODEL, SESSION_FIELD_MODEL, 0},
+	{VMETA_STRM_SDES_KEY_MODEL_ID, SESSION_FIELD_MODEL_ID, 0},
+	{VMETA_STRM_SDES_KEY_BUILD_ID, SESSION_FIELD_BUILD_ID, 0},
+	{VMETA_STRM_SDES_KEY_TITLE, SESSION_FIELD_TITLE, 0},
+	{VMETA_STRM_SDES_KEY_COMMENT, SESSION_FIELD_COMMENT, 0},
+	{VMETA_STRM_SDES_KEY_COPYRIGHT, SESSION_FIELD_COPYRIGHT, 0},
+	{VMETA_STRM_SDES_KEY_PICTURE_HORZ_FOV,
+	 SESSION_FIELD_PICTURE_HORZ_FOV,
+	 0},
+	{VMETA_STRM_SDES_KEY_PICTURE_VERT_FOV,
+	 SESSION_FIELD_PICTURE_VERT_FOV,
+	 0},
+	{VMETA_STRM_SDES_KEY_PICTURE_FOV, SESSION_FIELD_PICTURE_FOV, 0},
+	{VMETA_STRM_SDES_KEY_THERMAL_METAVERSION,
+	 SESSION_FIELD_THERMAL_METAVERSION,
+	 0},
+	{VMETA_STRM_SDES_KEY_THERMAL_CAMSERIAL,
+	 SESSION_FIELD_THERMAL_CAMSERIAL,
+	 0},
+	{VMETA_STRM_SDES_KEY_THERMAL_ALIGNMENT,
+	 SESSION_FIELD_THERMAL_ALIGNMENT,
+	 0},
+	{VMETA_STRM_SDES_KEY_THERMAL_CONV_LOW,
+	 SESSION_FIELD_THERMAL_CONV_LOW,
+	 0},
+	{VMETA_STRM_SDES_KEY_THERMAL_CONV_HIGH,
+	 SESSION_FIELD_THERMAL_CONV_HIGH,
+	 0},
+	{VMETA_STRM_SDES_KEY_THERMAL_SCALE_FACTOR,
+	 SESSION_FIELD_THERMAL_SCALE_FACTOR,
+	 0},
+	{VMETA_STRM_SDES_KEY_CAMERA_TYPE, SESSION_FIELD_CAMERA_TYPE, 0},
+	{VMETA_STRM_SDES_KEY_CAMERA_SUBTYPE, SESSION_FIELD_CAMERA_SUBTYPE, 0},
+	{VMETA_STRM_SDES_KEY_CAMERA_SPECTRUM, SESSION_FIELD_CAMERA_SPECTRUM, 0},
+	{VMETA_STRM_SDES_KEY_CAMERA_SERIAL_NUMBER,
+	 SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	 0},
+	{VMETA_STRM_SDES_KEY_CAMERA_MODEL_TYPE,
+	 SESSION_FIELD_CAMERA_MODEL_TYPE,
+	 0},
+	{VMETA_STRM_SDES_KEY_PERSPECTIVE_DISTORTION,
+	 SESSION_FIELD_PERSPECTIVE_DISTORTION,
+	 0},
+	{VMETA_STRM_SDES_KEY_FISHEYE_AFFINE_MATRIX,
+	 SESSION_FIELD_FISHEYE_AFFINE_MATRIX,
+	 0},
+	{VMETA_STRM_SDES_KEY_FISHEYE_POLYNOMIAL,
+	 SESSION_FIELD_FISHEYE_POLYNOMIAL,
+	 0},
+	{VMETA_STRM_SDES_KEY_VIDEO_MODE, SESSION_FIELD_VIDEO_MODE, 0},
+	{VMETA_STRM_SDES_KEY_VIDEO_STOP_REASON,
+	 SESSION_FIELD_VIDEO_STOP_REASON,
+	 0},
+	{VMETA_STRM_SDES_KEY_DYNAMIC_RANGE, SESSION_FIELD_DYNAMIC_RANGE, 0},
+	{VMETA_STRM_SDES_KEY_TONE_MAPPING, SESSION_FIELD_TONE_MAPPING, 0},
+	{VMETA_STRM_SDES_KEY_FIRST_FRAME_CAPTURE_TS,
+	 SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	 0},
+	{VMETA_STRM_SDES_KEY_MEDIA_ID, SESSION_FIELD_MEDIA_ID, 0},
+	{VMETA_STRM_SDES_KEY_RESOURCE_INDEX, SESSION_FIELD_RESOURCE_INDEX, 0},
+	{VMETA_STRM_SDES_KEY_PRINCIPAL_POINT, SESSION_FIELD_PRINCIPAL_POINT, 0},
+};
+
+
+/* Keys of the SDP session-level and media-level attributes */
+static const struct session_key s_sdp_keys[] = {
+	{VMETA_STRM_SDP_KEY_MEDIA_DATE,
+	 SESSION_FIELD_MEDIA_DATE,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_RUN_DATE,
+	 SESSION_FIELD_RUN_DATE,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_RUN_ID,
+	 SESSION_FIELD_RUN_ID,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_BOOT_DATE,
+	 SESSION_FIELD_BOOT_DATE,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_BOOT_ID,
+	 SESSION_FIELD_BOOT_ID,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_FLIGHT_DATE,
+	 SESSION_FIELD_FLIGHT_DATE,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_FLIGHT_ID,
+	 SESSION_FIELD_FLIGHT_ID,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_CUSTOM_ID,
+	 SESSION_FIELD_CUSTOM_ID,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_MAKER,
+	 SESSION_FIELD_MAKER,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_MODEL,
+	 SESSION_FIELD_MODEL,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_MODEL_ID,
+	 SESSION_FIELD_MODEL_ID,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_SERIAL_NUMBER,
+	 SESSION_FIELD_SERIAL_NUMBER,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_BUILD_ID,
+	 SESSION_FIELD_BUILD_ID,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_COMMENT,
+	 SESSION_FIELD_COMMENT,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_COPYRIGHT,
+	 SESSION_FIELD_COPYRIGHT,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_TAKEOFF_LOC,
+	 SESSION_FIELD_TAKEOFF_LOC,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_LOCATION,
+	 SESSION_FIELD_LOCATION,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_VIDEO_MODE,
+	 SESSION_FIELD_VIDEO_MODE,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_VIDEO_STOP_REASON,
+	 SESSION_FIELD_VIDEO_STOP_REASON,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_DYNAMIC_RANGE,
+	 SESSION_FIELD_DYNAMIC_RANGE,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_TONE_MAPPING,
+	 SESSION_FIELD_TONE_MAPPING,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_FIRST_FRAME_CAPTURE_TS,
+	 SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_FIRST_FRAME_SAMPLE_INDEX,
+	 SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_MEDIA_ID,
+	 SESSION_FIELD_MEDIA_ID,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_RESOURCE_INDEX,
+	 SESSION_FIELD_RESOURCE_INDEX,
+	 SESSION_KEY_FLAG_SDP_SESSION},
+	{VMETA_STRM_SDP_KEY_PICTURE_FOV, SESSION_FIELD_PICTURE_FOV, 0},
+	{VMETA_STRM_SDP_KEY_CAMERA_TYPE, SESSION_FIELD_CAMERA_TYPE, 0},
+	{VMETA_STRM_SDP_KEY_CAMERA_SUBTYPE, SESSION_FIELD_CAMERA_SUBTYPE, 0},
+	{VMETA_STRM_SDP_KEY_CAMERA_SPECTRUM, SESSION_FIELD_CAMERA_SPECTRUM, 0},
+	{VMETA_STRM_SDP_KEY_CAMERA_MODEL_TYPE,
+	 SESSION_FIELD_CAMERA_MODEL_TYPE,
+	 0},
+	{VMETA_STRM_SDP_KEY_PERSPECTIVE_DISTORTION,
+	 SESSION_FIELD_PERSPECTIVE_DISTORTION,
+	 0},
+	{VMETA_STRM_SDP_KEY_FISHEYE_AFFINE_MATRIX,
+	 SESSION_FIELD_FISHEYE_AFFINE_MATRIX,
+	 0},
+	{VMETA_STRM_SDP_KEY_FISHEYE_POLYNOMIAL,
+	 SESSION_FIELD_FISHEYE_POLYNOMIAL,
+	 0},
+	{VMETA_STRM_SDP_KEY_CAMERA_SERIAL_NUMBER,
+	 SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	 0},
+	{VMETA_STRM_SDP_KEY_THERMAL_METAVERSION,
+	 SESSION_FIELD_THERMAL_METAVERSION,
+	 0},
+	{VMETA_STRM_SDP_KEY_THERMAL_CAMSERIAL,
+	 SESSION_FIELD_THERMAL_CAMSERIAL,
+	 0},
+	{VMETA_STRM_SDP_KEY_THERMAL_ALIGNMENT,
+	 SESSION_FIELD_THERMAL_ALIGNMENT,
+	 0},
+	{VMETA_STRM_SDP_KEY_THERMAL_CONV_LOW,
+	 SESSION_FIELD_THERMAL_CONV_LOW,
+	 0},
+	{VMETA_STRM_SDP_KEY_THERMAL_CONV_HIGH,
+	 SESSION_FIELD_THERMAL_CONV_HIGH,
+	 0},
+	{VMETA_STRM_SDP_KEY_THERMAL_SCALE_FACTOR,
+	 SESSION_FIELD_THERMAL_SCALE_FACTOR,
+	 0},
+	{VMETA_STRM_SDP_KEY_DEFAULT_MEDIA, SESSION_FIELD_DEFAULT_MEDIA, 0},
+	{VMETA_STRM_SDP_KEY_PROTO_DELTA, SESSION_FIELD_PROTO_DELTA, 0},
+	{VMETA_STRM_SDP_KEY_PRINCIPAL_POINT, SESSION_FIELD_PRINCIPAL_POINT, 0},
+};
+
+
+/* Keys of the MP4 meta and udta items */
+static const struct session_key s_rec_keys[] = {
+	{VMETA_REC_META_KEY_FRIENDLY_NAME, SESSION_FIELD_FRIENDLY_NAME, 0},
+	{VMETA_REC_META_KEY_TITLE, SESSION_FIELD_TITLE, 0},
+	{VMETA_REC_META_KEY_COMMENT, SESSION_FIELD_COMMENT, 0},
+	{VMETA_REC_META_KEY_COPYRIGHT, SESSION_FIELD_COPYRIGHT, 0},
+	{VMETA_REC_META_KEY_MEDIA_DATE, SESSION_FIELD_MEDIA_DATE, 0},
+	{VMETA_REC_META_KEY_TAKEOFF_LOC, SESSION_FIELD_TAKEOFF_LOC, 0},
+	{VMETA_REC_META_KEY_LOCATION, SESSION_FIELD_LOCATION, 0},
+	{VMETA_REC_META_KEY_MAKER, SESSION_FIELD_MAKER, 0},
+	{VMETA_REC_META_KEY_MODEL, SESSION_FIELD_MODEL, 0},
+	{VMETA_REC_META_KEY_SOFTWARE_VERSION,
+	 SESSION_FIELD_SOFTWARE_VERSION,
+	 0},
+	{VMETA_REC_META_KEY_SERIAL_NUMBER, SESSION_FIELD_SERIAL_NUMBER, 0},
+	{VMETA_REC_META_KEY_MODEL_ID, SESSION_FIELD_MODEL_ID, 0},
+	{VMETA_REC_META_KEY_BUILD_ID, SESSION_FIELD_BUILD_ID, 0},
+	{VMETA_REC_META_KEY_RUN_DATE, SESSION_FIELD_RUN_DATE, 0},
+	{VMETA_REC_META_KEY_RUN_ID, SESSION_FIELD_RUN_ID, 0},
+	{VMETA_REC_META_KEY_BOOT_DATE, SESSION_FIELD_BOOT_DATE, 0},
+	{VMETA_REC_META_KEY_BOOT_ID, SESSION_FIELD_BOOT_ID, 0},
+	{VMETA_REC_META_KEY_FLIGHT_DATE, SESSION_FIELD_FLIGHT_DATE, 0},
+	{VMETA_REC_META_KEY_FLIGHT_ID, SESSION_FIELD_FLIGHT_ID, 0},
+	{VMETA_REC_META_KEY_CUSTOM_ID, SESSION_FIELD_CUSTOM_ID, 0},
+	{VMETA_REC_META_KEY_PICTURE_HORZ_FOV,
+	 SESSION_FIELD_PICTURE_HORZ_FOV,
+	 0},
+	{VMETA_REC_META_KEY_PICTURE_VERT_FOV,
+	 SESSION_FIELD_PICTURE_VERT_FOV,
+	 0},
+	{VMETA_REC_META_KEY_PICTURE_FOV, SESSION_FIELD_PICTURE_FOV, 0},
+	{VMETA_REC_UDTA_KEY_FRIENDLY_NAME, SESSION_FIELD_UDTA_FRIENDLY_NAME, 0},
+	{VMETA_REC_UDTA_KEY_TITLE, SESSION_FIELD_UDTA_TITLE, 0},
+	{VMETA_REC_UDTA_KEY_COMMENT, SESSION_FIELD_UDTA_COMMENT, 0},
+	{VMETA_REC_UDTA_KEY_COPYRIGHT, SESSION_FIELD_UDTA_COPYRIGHT, 0},
+	{VMETA_REC_UDTA_KEY_MEDIA_DATE, SESSION_FIELD_UDTA_MEDIA_DATE, 0},
+	{VMETA_REC_UDTA_KEY_LOCATION, SESSION_FIELD_UDTA_LOCATION, 0},
+	{VMETA_REC_UDTA_KEY_MAKER, SESSION_FIELD_UDTA_MAKER, 0},
+	{VMETA_REC_UDTA_KEY_MODEL, SESSION_FIELD_UDTA_MODEL, 0},
+	{VMETA_REC_UDTA_KEY_SOFTWARE_VERSION,
+	 SESSION_FIELD_UDTA_SOFTWARE_VERSION,
+	 0},
+	{VMETA_REC_UDTA_KEY_SERIAL_NUMBER,
+	 SESSION_FIELD_UDTA_SERIAL_NUMBER,
+	 0},
+	{VMETA_REC_META_KEY_THERMAL_METAVERSION,
+	 SESSION_FIELD_THERMAL_METAVERSION,
+	 0},
+	{VMETA_REC_META_KEY_THERMAL_CAMSERIAL,
+	 SESSION_FIELD_THERMAL_CAMSERIAL,
+	 0},
+	{VMETA_REC_META_KEY_THERMAL_ALIGNMENT,
+	 SESSION_FIELD_THERMAL_ALIGNMENT,
+	 0},
+	{VMETA_REC_META_KEY_THERMAL_CONV_LOW,
+	 SESSION_FIELD_THERMAL_CONV_LOW,
+	 0},
+	{VMETA_REC_META_KEY_THERMAL_CONV_HIGH,
+	 SESSION_FIELD_THERMAL_CONV_HIGH,
+	 0},
+	{VMETA_REC_META_KEY_THERMAL_SCALE_FACTOR,
+	 SESSION_FIELD_THERMAL_SCALE_FACTOR,
+	 0},
+	{VMETA_REC_META_KEY_CAMERA_TYPE, SESSION_FIELD_CAMERA_TYPE, 0},
+	{VMETA_REC_META_KEY_CAMERA_SUBTYPE, SESSION_FIELD_CAMERA_SUBTYPE, 0},
+	{VMETA_REC_META_KEY_CAMERA_SPECTRUM, SESSION_FIELD_CAMERA_SPECTRUM, 0},
+	{VMETA_REC_META_KEY_CAMERA_SERIAL_NUMBER,
+	 SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	 0},
+	{VMETA_REC_META_KEY_CAMERA_MODEL_TYPE,
+	 SESSION_FIELD_CAMERA_MODEL_TYPE,
+	 0},
+	{VMETA_REC_META_KEY_PERSPECTIVE_DISTORTION,
+	 SESSION_FIELD_PERSPECTIVE_DISTORTION,
+	 0},
+	{VMETA_REC_META_KEY_FISHEYE_AFFINE_MATRIX,
+	 SESSION_FIELD_FISHEYE_AFFINE_MATRIX,
+	 0},
+	{VMETA_REC_META_KEY_FISHEYE_POLYNOMIAL,
+	 SESSION_FIELD_FISHEYE_POLYNOMIAL,
+	 0},
+	{VMETA_REC_META_KEY_HEADER_FOOTER, SESSION_FIELD_HEADER_FOOTER, 0},
+	{VMETA_REC_META_KEY_VIDEO_MODE, SESSION_FIELD_VIDEO_MODE, 0},
+	{VMETA_REC_META_KEY_VIDEO_STOP_REASON,
+	 SESSION_FIELD_VIDEO_STOP_REASON,
+	 0},
+	{VMETA_REC_META_KEY_DYNAMIC_RANGE, SESSION_FIELD_DYNAMIC_RANGE, 0},
+	{VMETA_REC_META_KEY_TONE_MAPPING, SESSION_FIELD_TONE_MAPPING, 0},
+	{VMETA_REC_META_KEY_FIRST_FRAME_CAPTURE_TS,
+	 SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	 0},
+	{VMETA_REC_META_KEY_FIRST_FRAME_SAMPLE_INDEX,
+	 SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX,
+	 0},
+	{VMETA_REC_META_KEY_MEDIA_ID, SESSION_FIELD_MEDIA_ID, 0},
+	{VMETA_REC_META_KEY_RESOURCE_INDEX, SESSION_FIELD_RESOURCE_INDEX, 0},
+	{VMETA_REC_META_KEY_PRINCIPAL_POINT, SESSION_FIELD_PRINCIPAL_POINT, 0},
+};
+
+
+/* Size of the key hash tables (power of 2, at least 4 times the number of
+ * keys of the largest table to keep the probe sequences short) */
+#define SESSION_KEY_TABLE_SIZE 256
+
+
+/* Open-addressing hash table of the keys of a reader, indexed by the key
+ * hashes (see vmeta_hash_joaat_str()); a key lookup costs one hash of the
+ * key and, on a hit, usually a single string compare */
+struct session_key_table {
+	const struct session_key *keys;
+	size_t count;
+	struct {
+		uint32_t hash;
+		/* Index in the keys array + 1, 0 for an empty slot */
+		uint8_t idx;
+	} slots[SESSION_KEY_TABLE_SIZE];
+};
+
+
+static struct session_key_table s_sdes_key_table = {
+	.keys = s_sdes_keys,
+	.count = SIZEOF_ARRAY(s_sdes_keys),
+};
+static struct session_key_table s_sdp_key_table = {
+	.keys = s_sdp_keys,
+	.count = SIZEOF_ARRAY(s_sdp_keys),
+};
+static struct session_key_table s_rec_key_table = {
+	.keys = s_rec_keys,
+	.count = SIZEOF_ARRAY(s_rec_keys),
+};
+static pthread_once_t s_key_tables_once = PTHREAD_ONCE_INIT;
+
+
+static void session_key_table_build(struct session_key_table *table)
+{
+	size_t i, slot;
+	uint32_t hash;
+
+	for (i = 0; i < table->count; i++) {
+		(void)vmeta_hash_joaat_str(table->keys[i].key, &hash);
+		slot = hash & (SESSION_KEY_TABLE_SIZE - 1);
+		while (table->slots[slot].idx != 0)
+			slot = (slot + 1) & (SESSION_KEY_TABLE_SIZE - 1);
+		table->slots[slot].hash = hash;
+		table->slots[slot].idx = i + 1;
+	}
+}
+
+
+static void session_key_tables_build(void)
+{
+	session_key_table_build(&s_sdes_key_table);
+	session_key_table_build(&s_sdp_key_table);
+	session_key_table_build(&s_rec_key_table);
+}
+
+
+static const struct session_key *
+session_key_lookup(struct session_key_table *table, const char *key)
+{
+	size_t slot;
+	uint32_t hash;
+	const struct session_key *k;
+
+	(void)pthread_once(&s_key_tables_once, session_key_tables_build);
+
+	(void)vmeta_hash_joaat_str(key, &hash);
+	slot = hash & (SESSION_KEY_TABLE_SIZE - 1);
+	while (table->slots[slot].idx != 0) {
+		if (table->slots[slot].hash == hash) {
+			k = &table->keys[table->slots[slot].idx - 1];
+			if (strcmp(k->key, key) == 0)
+				return k;
+		}
+		slot = (slot + 1) & (SESSION_KEY_TABLE_SIZE - 1);
+	}
+
+	return NULL;
+}
+
+
+/* Read the value of a field common to the session metadata readers; the
+ * reader-specific fields are ignored */
+static int session_field_read(enum session_field field,
+			      const char *value,
+			      struct vmeta_session *meta)
+{
+	int ret = 0;
+
+	switch (field) {
+	case SESSION_FIELD_FRIENDLY_NAME:
+		COPY_VALUE(meta->friendly_name, value);
+		break;
+	case SESSION_FIELD_TITLE:
+		COPY_VALUE(meta->title, value);
+		break;
+	case SESSION_FIELD_COMMENT:
+		COPY_VALUE(meta->comment, value);
+		break;
+	case SESSION_FIELD_COPYRIGHT:
+		COPY_VALUE(meta->copyright, value);
+		break;
+	case SESSION_FIELD_MEDIA_DATE:
+		ret = vmeta_session_date_read(
+			value, &meta->media_date, &meta->media_date_gmtoff);
+		break;
+	case SESSION_FIELD_TAKEOFF_LOC:
+		ret = vmeta_session_location_read(value, &meta->takeoff_loc);
+		break;
+	case SESSION_FIELD_LOCATION:
+		ret = vmeta_session_location_read(value, &meta->location);
+		break;
+	case SESSION_FIELD_MAKER:
+		COPY_VALUE(meta->maker, value);
+		break;
+	case SESSION_FIELD_MODEL:
+		COPY_VALUE(meta->model, value);
+		break;
+	case SESSION_FIELD_SOFTWARE_VERSION:
+		COPY_VALUE(meta->software_version, value);
+		break;
+	case SESSION_FIELD_SERIAL_NUMBER:
+		COPY_VALUE(meta->serial_number, value);
+		break;
+	case SESSION_FIELD_MODEL_ID:
+		COPY_VALUE(meta->model_id, value);
+		break;
+	case SESSION_FIELD_BUILD_ID:
+		COPY_VALUE(meta->build_id, value);
+		break;
+	case SESSION_FIELD_RUN_DATE:
+		ret = vmeta_session_date_read(
+			value, &meta->run_date, &meta->run_date_gmtoff);
+		break;
+	case SESSION_FIELD_RUN_ID:
+		COPY_VALUE(meta->run_id, value);
+		break;
+	case SESSION_FIELD_BOOT_DATE:
+		ret = vmeta_session_date_read(
+			value, &meta->boot_date, &meta->boot_date_gmtoff);
+		break;
+	case SESSION_FIELD_BOOT_ID:
+		COPY_VALUE(meta->boot_id, value);
+		break;
+	case SESSION_FIELD_FLIGHT_DATE:
+		ret = vmeta_session_date_read(
+			value, &meta->flight_date, &meta->flight_date_gmtoff);
+		break;
+	case SESSION_FIELD_FLIGHT_ID:
+		COPY_VALUE(meta->flight_id, value);
+		break;
+	case SESSION_FIELD_CUSTOM_ID:
+		COPY_VALUE(meta->custom_id, value);
+		break;
+	case SESSION_FIELD_PICTURE_HORZ_FOV:
+		meta->picture_fov.horz = atof(value);
+		meta->picture_fov.has_horz = 1;
+		break;
+	case SESSION_FIELD_PICTURE_VERT_FOV:
+		meta->picture_fov.vert = atof(value);
+		meta->picture_fov.has_vert = 1;
+		break;
+	case SESSION_FIELD_PICTURE_FOV:
+		ret = vmeta_session_fov_read(value, &meta->picture_fov);
+		break;
+	case SESSION_FIELD_THERMAL_METAVERSION: {
+		char metaversion[10];
+		COPY_VALUE(metaversion, value);
+		meta->thermal.metaversion = atoi(metaversion);
+		break;
+	}
+	case SESSION_FIELD_THERMAL_CAMSERIAL:
+		COPY_VALUE(meta->thermal.camserial, value);
+		break;
+	case SESSION_FIELD_THERMAL_ALIGNMENT:
+		ret = vmeta_session_thermal_alignment_read(
+			value, &meta->thermal.alignment);
+		break;
+	case SESSION_FIELD_THERMAL_CONV_LOW:
+		ret = vmeta_session_thermal_conversion_read(
+			value, &meta->thermal.conv_low);
+		break;
+	case SESSION_FIELD_THERMAL_CONV_HIGH:
+		ret = vmeta_session_thermal_conversion_read(
+			value, &meta->thermal.conv_high);
+		break;
+	case SESSION_FIELD_THERMAL_SCALE_FACTOR:
+		ret = vmeta_session_thermal_scale_factor_read(
+			value, &meta->thermal.scale_factor);
+		break;
+	case SESSION_FIELD_CAMERA_TYPE:
+		meta->camera_type = vmeta_camera_type_from_str(value);
+		break;
+	case SESSION_FIELD_CAMERA_SUBTYPE:
+		meta->camera_subtype = vmeta_camera_subtype_from_str(value);
+		break;
+	case SESSION_FIELD_CAMERA_SPECTRUM:
+		meta->camera_spectrum = vmeta_camera_spectrum_from_str(value);
+		break;
+	case SESSION_FIELD_CAMERA_SERIAL_NUMBER:
+		COPY_VALUE(meta->camera_serial_number, value);
+		break;
+	case SESSION_FIELD_CAMERA_MODEL_TYPE:
+		meta->camera_model.type =
+			vmeta_camera_model_type_from_str(value);
+		break;
+	case SESSION_FIELD_PERSPECTIVE_DISTORTION:
+		ret = vmeta_session_perspective_distortion_read(
+			value,
+			&meta->camera_model.perspective.distortion.r1,
+			&meta->camera_model.perspective.distortion.r2,
+			&meta->camera_model.perspective.distortion.r3,
+			&meta->camera_model.perspective.distortion.t1,
+			&meta->camera_model.perspective.distortion.t2);
+		break;
+	case SESSION_FIELD_FISHEYE_AFFINE_MATRIX:
+		ret = vmeta_session_fisheye_affine_matrix_read(
+			value,
+			&meta->camera_model.fisheye.affine_matrix.c,
+			&meta->camera_model.fisheye.affine_matrix.d,
+			&meta->camera_model.fisheye.affine_matrix.e,
+			&meta->camera_model.fisheye.affine_matrix.f);
+		break;
+	case SESSION_FIELD_FISHEYE_POLYNOMIAL:
+		ret = vmeta_session_fisheye_polynomial_read(
+			value,
+			&meta->camera_model.fisheye.polynomial.p2,
+			&meta->camera_model.fisheye.polynomial.p3,
+			&meta->camera_model.fisheye.polynomial.p4);
+		break;
+	case SESSION_FIELD_HEADER_FOOTER:
+		meta->overlay.type = VMETA_OVERLAY_TYPE_HEADER_FOOTER;
+		ret = vmeta_session_overlay_header_footer_read(
+			value,
+			&meta->overlay.header_footer.header_height,
+			&meta->overlay.header_footer.footer_height);
+		break;
+	case SESSION_FIELD_VIDEO_MODE:
+		meta->video_mode = vmeta_video_mode_from_str(value);
+		break;
+	case SESSION_FIELD_VIDEO_STOP_REASON:
+		meta->video_stop_reason =
+			vmeta_video_stop_reason_from_str(value);
+		break;
+	case SESSION_FIELD_DYNAMIC_RANGE:
+		meta->dynamic_range = vmeta_dynamic_range_from_str(value);
+		break;
+	case SESSION_FIELD_TONE_MAPPING:
+		meta->tone_mapping = vmeta_tone_mapping_from_str(value);
+		break;
+	case SESSION_FIELD_FIRST_FRAME_CAPTURE_TS:
+		meta->first_frame_capture_ts = strtoull(value, NULL, 0);
+		break;
+	case SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX:
+		meta->first_frame_sample_index = strtoul(value, NULL, 0);
+		break;
+	case SESSION_FIELD_MEDIA_ID:
+		meta->media_id = strtoul(value, NULL, 0);
+		break;
+	case SESSION_FIELD_RESOURCE_INDEX:
+		meta->resource_index = strtoul(value, NULL, 0);
+		break;
+	case SESSION_FIELD_PRINCIPAL_POINT:
+		ret = vmeta_session_principal_point_read(
+			value, &meta->principal_point);
+		break;
+	case SESSION_FIELD_DEFAULT_MEDIA:
+		meta->default_media = 1;
+		break;
+	case SESSION_FIELD_PROTO_DELTA:
+		meta->proto_delta = 1;
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
+
+
 int vmeta_session_streaming_sdes_write(
 	const struct vmeta_session *meta,
 	vmeta_session_streaming_sdes_write_cb_t cb,
@@ -1064,6 +1666,7 @@ int vmeta_session_streaming_sdes_read(enum vmeta_stream_sdes_type type,
 				      struct vmeta_session *meta)
 {
 	int ret = 0;
+	const struct session_key *k;
 
 	ULOG_ERRNO_RETURN_ERR_IF(value == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF((type == VMETA_STRM_SDES_TYPE_PRIV) &&
@@ -1089,197 +1692,9 @@ int vmeta_session_streaming_sdes_read(enum vmeta_stream_sdes_type type,
 		break;
 
 	case VMETA_STRM_SDES_TYPE_PRIV:
-		if (strcmp(prefix, VMETA_STRM_SDES_KEY_MEDIA_DATE) == 0) {
-			ret = vmeta_session_date_read(value,
-						      &meta->media_date,
-						      &meta->media_date_gmtoff);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_RUN_DATE) == 0) {
-			ret = vmeta_session_date_read(
-				value, &meta->run_date, &meta->run_date_gmtoff);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_TAKEOFF_LOC) ==
-			   0) {
-			ret = vmeta_session_location_read(value,
-							  &meta->takeoff_loc);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_RUN_ID) == 0) {
-			COPY_VALUE(meta->run_id, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_BOOT_DATE) == 0) {
-			ret = vmeta_session_date_read(value,
-						      &meta->boot_date,
-						      &meta->boot_date_gmtoff);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_BOOT_ID) == 0) {
-			COPY_VALUE(meta->boot_id, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_FLIGHT_DATE) ==
-			   0) {
-			ret = vmeta_session_date_read(
-				value,
-				&meta->flight_date,
-				&meta->flight_date_gmtoff);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_FLIGHT_ID) == 0) {
-			COPY_VALUE(meta->flight_id, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_CUSTOM_ID) == 0) {
-			COPY_VALUE(meta->custom_id, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_MAKER) == 0) {
-			COPY_VALUE(meta->maker, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_MODEL) == 0) {
-			COPY_VALUE(meta->model, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_MODEL_ID) == 0) {
-			COPY_VALUE(meta->model_id, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_BUILD_ID) == 0) {
-			COPY_VALUE(meta->build_id, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_TITLE) == 0) {
-			COPY_VALUE(meta->title, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_COMMENT) == 0) {
-			COPY_VALUE(meta->comment, value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_COPYRIGHT) == 0) {
-			COPY_VALUE(meta->copyright, value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_PICTURE_HORZ_FOV) == 0) {
-			meta->picture_fov.horz = atof(value);
-			meta->picture_fov.has_horz = 1;
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_PICTURE_VERT_FOV) == 0) {
-			meta->picture_fov.vert = atof(value);
-			meta->picture_fov.has_vert = 1;
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_PICTURE_FOV) ==
-			   0) {
-			ret = vmeta_session_fov_read(value, &meta->picture_fov);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_THERMAL_METAVERSION) ==
-			   0) {
-			char metaversion[10];
-			COPY_VALUE(metaversion, value);
-			meta->thermal.metaversion = atoi(metaversion);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_THERMAL_CAMSERIAL) == 0) {
-			COPY_VALUE(meta->thermal.camserial, value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_THERMAL_ALIGNMENT) == 0) {
-			ret = vmeta_session_thermal_alignment_read(
-				value, &meta->thermal.alignment);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_THERMAL_CONV_LOW) == 0) {
-			ret = vmeta_session_thermal_conversion_read(
-				value, &meta->thermal.conv_low);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_THERMAL_CONV_HIGH) == 0) {
-			ret = vmeta_session_thermal_conversion_read(
-				value, &meta->thermal.conv_high);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_THERMAL_SCALE_FACTOR) ==
-			   0) {
-			ret = vmeta_session_thermal_scale_factor_read(
-				value, &meta->thermal.scale_factor);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_CAMERA_TYPE) ==
-			   0) {
-			meta->camera_type = vmeta_camera_type_from_str(value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_CAMERA_SUBTYPE) ==
-			   0) {
-			meta->camera_subtype =
-				vmeta_camera_subtype_from_str(value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_CAMERA_SPECTRUM) == 0) {
-			meta->camera_spectrum =
-				vmeta_camera_spectrum_from_str(value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_CAMERA_SERIAL_NUMBER) ==
-			   0) {
-			COPY_VALUE(meta->camera_serial_number, value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_CAMERA_MODEL_TYPE) == 0) {
-			meta->camera_model.type =
-				vmeta_camera_model_type_from_str(value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_PERSPECTIVE_DISTORTION) ==
-			   0) {
-			ret = vmeta_session_perspective_distortion_read(
-				value,
-				&meta->camera_model.perspective.distortion.r1,
-				&meta->camera_model.perspective.distortion.r2,
-				&meta->camera_model.perspective.distortion.r3,
-				&meta->camera_model.perspective.distortion.t1,
-				&meta->camera_model.perspective.distortion.t2);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_FISHEYE_AFFINE_MATRIX) ==
-			   0) {
-			ret = vmeta_session_fisheye_affine_matrix_read(
-				value,
-				&meta->camera_model.fisheye.affine_matrix.c,
-				&meta->camera_model.fisheye.affine_matrix.d,
-				&meta->camera_model.fisheye.affine_matrix.e,
-				&meta->camera_model.fisheye.affine_matrix.f);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_FISHEYE_POLYNOMIAL) ==
-			   0) {
-			ret = vmeta_session_fisheye_polynomial_read(
-				value,
-				&meta->camera_model.fisheye.polynomial.p2,
-				&meta->camera_model.fisheye.polynomial.p3,
-				&meta->camera_model.fisheye.polynomial.p4);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_VIDEO_MODE) ==
-			   0) {
-			meta->video_mode = vmeta_video_mode_from_str(value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_VIDEO_STOP_REASON) == 0) {
-			meta->video_stop_reason =
-				vmeta_video_stop_reason_from_str(value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_DYNAMIC_RANGE) ==
-			   0) {
-			meta->dynamic_range =
-				vmeta_dynamic_range_from_str(value);
-
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_TONE_MAPPING) ==
-			   0) {
-			meta->tone_mapping = vmeta_tone_mapping_from_str(value);
-
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_FIRST_FRAME_CAPTURE_TS) ==
-			   0) {
-			meta->first_frame_capture_ts = strtoull(value, NULL, 0);
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_MEDIA_ID) == 0) {
-			meta->media_id = strtoul(value, NULL, 0);
-		} else if (strcmp(prefix, VMETA_STRM_SDES_KEY_RESOURCE_INDEX) ==
-			   0) {
-			meta->resource_index = strtoul(value, NULL, 0);
-		} else if (strcmp(prefix,
-				  VMETA_STRM_SDES_KEY_PRINCIPAL_POINT) == 0) {
-			ret = vmeta_session_principal_point_read(
-				value, &meta->principal_point);
-		}
+		k = session_key_lookup(&s_sdes_key_table, prefix);
+		if (k != NULL)
+			ret = session_field_read(k->field, value, meta);
 		meta->has_thermal = (meta->thermal.metaversion > 0) ||
 				    (meta->thermal.alignment.valid) ||
 				    (meta->thermal.camserial[0] != '\0');
@@ -1698,6 +2113,11 @@ int vmeta_session_streaming_sdp_write(const struct vmeta_session *meta,
 		(*cb)(type, "1", key, userdata);
 	}
 
+	if (meta->proto_delta) {
+		const char *key = VMETA_STRM_SDP_KEY_PROTO_DELTA;
+		(*cb)(type, "1", key, userdata);
+	}
+
 	if (meta->first_frame_capture_ts != 0) {
 		char conv[21];
 		snprintf(conv,
@@ -1753,6 +2173,7 @@ int vmeta_session_streaming_sdp_read(enum vmeta_stream_sdp_type type,
 				     struct vmeta_session *meta)
 {
 	int ret = 0;
+	const struct session_key *k;
 
 	ULOG_ERRNO_RETURN_ERR_IF(value == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(((type == VMETA_STRM_SDP_TYPE_SESSION_ATTR) ||
@@ -1776,213 +2197,32 @@ int vmeta_session_streaming_sdp_read(enum vmeta_stream_sdp_type type,
 		break;
 
 	case VMETA_STRM_SDP_TYPE_SESSION_ATTR:
-		if (strcmp(key, VMETA_STRM_SDP_KEY_MEDIA_DATE) == 0) {
-			ret = vmeta_session_date_read(value,
-						      &meta->media_date,
-						      &meta->media_date_gmtoff);
+	case VMETA_STRM_SDP_TYPE_MEDIA_ATTR:
+		/* Session-level keys are ignored in media-level attributes */
+		k = session_key_lookup(&s_sdp_key_table, key);
+		if ((k != NULL) &&
+		    ((type == VMETA_STRM_SDP_TYPE_SESSION_ATTR) ||
+		     (!(k->flags & SESSION_KEY_FLAG_SDP_SESSION))))
+			ret = session_field_read(k->field, value, meta);
+		meta->has_thermal = (meta->thermal.metaversion > 0) ||
+				    (meta->thermal.alignment.valid) ||
+				    (meta->thermal.camserial[0] != '\0');
+		break;
 
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_RUN_DATE) == 0) {
-			ret = vmeta_session_date_read(
-				value, &meta->run_date, &meta->run_date_gmtoff);
+	default:
+		break;
+	}
 
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_RUN_ID) == 0) {
-			COPY_VALUE(meta->run_id, value);
+	return ret;
+}
 
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_BOOT_DATE) == 0) {
-			ret = vmeta_session_date_read(value,
-						      &meta->boot_date,
-						      &meta->boot_date_gmtoff);
 
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_BOOT_ID) == 0) {
-			COPY_VALUE(meta->boot_id, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_FLIGHT_DATE) == 0) {
-			ret = vmeta_session_date_read(
-				value,
-				&meta->flight_date,
-				&meta->flight_date_gmtoff);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_FLIGHT_ID) == 0) {
-			COPY_VALUE(meta->flight_id, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_CUSTOM_ID) == 0) {
-			COPY_VALUE(meta->custom_id, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_MAKER) == 0) {
-			COPY_VALUE(meta->maker, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_MODEL) == 0) {
-			COPY_VALUE(meta->model, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_MODEL_ID) == 0) {
-			COPY_VALUE(meta->model_id, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_SERIAL_NUMBER) == 0) {
-			COPY_VALUE(meta->serial_number, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_BUILD_ID) == 0) {
-			COPY_VALUE(meta->build_id, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_COMMENT) == 0) {
-			COPY_VALUE(meta->comment, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_COPYRIGHT) == 0) {
-			COPY_VALUE(meta->copyright, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_TAKEOFF_LOC) == 0) {
-			ret = vmeta_session_location_read(value,
-							  &meta->takeoff_loc);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_LOCATION) == 0) {
-			ret = vmeta_session_location_read(value,
-							  &meta->location);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_VIDEO_MODE) == 0) {
-			meta->video_mode = vmeta_video_mode_from_str(value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_VIDEO_STOP_REASON) ==
-			   0) {
-			meta->video_stop_reason =
-				vmeta_video_stop_reason_from_str(value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_DYNAMIC_RANGE) == 0) {
-			meta->dynamic_range =
-				vmeta_dynamic_range_from_str(value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_TONE_MAPPING) == 0) {
-			meta->tone_mapping = vmeta_tone_mapping_from_str(value);
-
-		} else if (strcmp(key,
-				  VMETA_STRM_SDP_KEY_FIRST_FRAME_CAPTURE_TS) ==
-			   0) {
-			meta->first_frame_capture_ts = strtoull(value, NULL, 0);
-		} else if (
-			strcmp(key,
-			       VMETA_STRM_SDP_KEY_FIRST_FRAME_SAMPLE_INDEX) ==
-			0) {
-			meta->first_frame_sample_index =
-				strtoul(value, NULL, 0);
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_MEDIA_ID) == 0) {
-			meta->media_id = strtoul(value, NULL, 0);
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_RESOURCE_INDEX) ==
-			   0) {
-			meta->resource_index = strtoul(value, NULL, 0);
-		}
-		/* fall through */
-	case VMETA_STRM_SDP_TYPE_MEDIA_ATTR:
-		if (strcmp(key, VMETA_STRM_SDP_KEY_PICTURE_FOV) == 0) {
-			ret = vmeta_session_fov_read(value, &meta->picture_fov);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_CAMERA_TYPE) == 0) {
-			meta->camera_type = vmeta_camera_type_from_str(value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_CAMERA_SUBTYPE) ==
-			   0) {
-			meta->camera_subtype =
-				vmeta_camera_subtype_from_str(value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_CAMERA_SPECTRUM) ==
-			   0) {
-			meta->camera_spectrum =
-				vmeta_camera_spectrum_from_str(value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_CAMERA_MODEL_TYPE) ==
-			   0) {
-			meta->camera_model.type =
-				vmeta_camera_model_type_from_str(value);
-
-		} else if (strcmp(key,
-				  VMETA_STRM_SDP_KEY_PERSPECTIVE_DISTORTION) ==
-			   0) {
-			ret = vmeta_session_perspective_distortion_read(
-				value,
-				&meta->camera_model.perspective.distortion.r1,
-				&meta->camera_model.perspective.distortion.r2,
-				&meta->camera_model.perspective.distortion.r3,
-				&meta->camera_model.perspective.distortion.t1,
-				&meta->camera_model.perspective.distortion.t2);
-
-		} else if (strcmp(key,
-				  VMETA_STRM_SDP_KEY_FISHEYE_AFFINE_MATRIX) ==
-			   0) {
-			ret = vmeta_session_fisheye_affine_matrix_read(
-				value,
-				&meta->camera_model.fisheye.affine_matrix.c,
-				&meta->camera_model.fisheye.affine_matrix.d,
-				&meta->camera_model.fisheye.affine_matrix.e,
-				&meta->camera_model.fisheye.affine_matrix.f);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_FISHEYE_POLYNOMIAL) ==
-			   0) {
-			ret = vmeta_session_fisheye_polynomial_read(
-				value,
-				&meta->camera_model.fisheye.polynomial.p2,
-				&meta->camera_model.fisheye.polynomial.p3,
-				&meta->camera_model.fisheye.polynomial.p4);
-
-		} else if (strcmp(key,
-				  VMETA_STRM_SDP_KEY_CAMERA_SERIAL_NUMBER) ==
-			   0) {
-			COPY_VALUE(meta->camera_serial_number, value);
-
-		} else if (strcmp(key,
-				  VMETA_STRM_SDP_KEY_THERMAL_METAVERSION) ==
-			   0) {
-			char metaversion[10];
-			COPY_VALUE(metaversion, value);
-			meta->thermal.metaversion = atoi(metaversion);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_THERMAL_CAMSERIAL) ==
-			   0) {
-			COPY_VALUE(meta->thermal.camserial, value);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_THERMAL_ALIGNMENT) ==
-			   0) {
-			ret = vmeta_session_thermal_alignment_read(
-				value, &meta->thermal.alignment);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_THERMAL_CONV_LOW) ==
-			   0) {
-			ret = vmeta_session_thermal_conversion_read(
-				value, &meta->thermal.conv_low);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_THERMAL_CONV_HIGH) ==
-			   0) {
-			ret = vmeta_session_thermal_conversion_read(
-				value, &meta->thermal.conv_high);
-
-		} else if (strcmp(key,
-				  VMETA_STRM_SDP_KEY_THERMAL_SCALE_FACTOR) ==
-			   0) {
-			ret = vmeta_session_thermal_scale_factor_read(
-				value, &meta->thermal.scale_factor);
-
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_DEFAULT_MEDIA) == 0) {
-			meta->default_media = 1;
-		} else if (strcmp(key, VMETA_STRM_SDP_KEY_PRINCIPAL_POINT) ==
-			   0) {
-			ret = vmeta_session_principal_point_read(
-				value, &meta->principal_point);
-		}
-		meta->has_thermal = (meta->thermal.metaversion > 0) ||
-				    (meta->thermal.alignment.valid) ||
-				    (meta->thermal.camserial[0] != '\0');
-		break;
-
-	default:
-		break;
-	}
-
-	return ret;
-}
-
-
-int vmeta_session_recording_write(const struct vmeta_session *meta,
-				  vmeta_session_recording_write_cb_t cb,
-				  void *userdata)
-{
-	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(cb == NULL, EINVAL);
+int vmeta_session_recording_write(const struct vmeta_session *meta,
+				  vmeta_session_recording_write_cb_t cb,
+				  void *userdata)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(cb == NULL, EINVAL);
 
 	if (meta->friendly_name[0] != '\0') {
 		(*cb)(VMETA_REC_UDTA,
@@ -2561,87 +2801,20 @@ int vmeta_session_recording_read(const char *key,
 				 struct vmeta_session *meta)
 {
 	int ret = 0;
+	const struct session_key *k;
 
 	ULOG_ERRNO_RETURN_ERR_IF(key == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(value == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 
-	if (strcmp(key, VMETA_REC_META_KEY_FRIENDLY_NAME) == 0) {
-		COPY_VALUE(meta->friendly_name, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_TITLE) == 0) {
-		COPY_VALUE(meta->title, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_COMMENT) == 0) {
-		COPY_VALUE(meta->comment, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_COPYRIGHT) == 0) {
-		COPY_VALUE(meta->copyright, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_MEDIA_DATE) == 0) {
-		ret = vmeta_session_date_read(
-			value, &meta->media_date, &meta->media_date_gmtoff);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_TAKEOFF_LOC) == 0) {
-		ret = vmeta_session_location_read(value, &meta->takeoff_loc);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_LOCATION) == 0) {
-		ret = vmeta_session_location_read(value, &meta->location);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_MAKER) == 0) {
-		COPY_VALUE(meta->maker, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_MODEL) == 0) {
-		COPY_VALUE(meta->model, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_SOFTWARE_VERSION) == 0) {
-		COPY_VALUE(meta->software_version, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_SERIAL_NUMBER) == 0) {
-		COPY_VALUE(meta->serial_number, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_MODEL_ID) == 0) {
-		COPY_VALUE(meta->model_id, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_BUILD_ID) == 0) {
-		COPY_VALUE(meta->build_id, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_RUN_DATE) == 0) {
-		ret = vmeta_session_date_read(
-			value, &meta->run_date, &meta->run_date_gmtoff);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_RUN_ID) == 0) {
-		COPY_VALUE(meta->run_id, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_BOOT_DATE) == 0) {
-		ret = vmeta_session_date_read(
-			value, &meta->boot_date, &meta->boot_date_gmtoff);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_BOOT_ID) == 0) {
-		COPY_VALUE(meta->boot_id, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_FLIGHT_DATE) == 0) {
-		ret = vmeta_session_date_read(
-			value, &meta->flight_date, &meta->flight_date_gmtoff);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_FLIGHT_ID) == 0) {
-		COPY_VALUE(meta->flight_id, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_CUSTOM_ID) == 0) {
-		COPY_VALUE(meta->custom_id, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_PICTURE_HORZ_FOV) == 0) {
-		meta->picture_fov.horz = atof(value);
-		meta->picture_fov.has_horz = 1;
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_PICTURE_VERT_FOV) == 0) {
-		meta->picture_fov.vert = atof(value);
-		meta->picture_fov.has_vert = 1;
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_PICTURE_FOV) == 0) {
-		ret = vmeta_session_fov_read(value, &meta->picture_fov);
+	k = session_key_lookup(&s_rec_key_table, key);
+	if (k == NULL)
+		goto out;
 
-	} else if (strcmp(key, VMETA_REC_UDTA_KEY_FRIENDLY_NAME) == 0) {
+	/* The udta keys are only used for the fields that are not already
+	 * set from the meta keys */
+	switch (k->field) {
+	case SESSION_FIELD_UDTA_FRIENDLY_NAME:
 		if (meta->friendly_name[0] == '\0')
 			COPY_VALUE(meta->friendly_name, value);
 		if ((strncmp(value, "Parrot", 6) == 0) && (strlen(value) > 7)) {
@@ -2657,8 +2830,9 @@ int vmeta_session_recording_read(const char *key,
 			if (meta->model[0] == '\0')
 				COPY_VALUE(meta->model, value + 7);
 		}
+		break;
 
-	} else if (strcmp(key, VMETA_REC_UDTA_KEY_TITLE) == 0) {
+	case SESSION_FIELD_UDTA_TITLE:
 		if (meta->title[0] == '\0')
 			COPY_VALUE(meta->title, value);
 		if (meta->run_date == 0) {
@@ -2667,9 +2841,11 @@ int vmeta_session_recording_read(const char *key,
 			vmeta_session_date_read(
 				value, &meta->run_date, &meta->run_date_gmtoff);
 		}
+		break;
 
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_COMMENT) == 0) &&
-		   (meta->comment[0] == '\0')) {
+	case SESSION_FIELD_UDTA_COMMENT:
+		if (meta->comment[0] != '\0')
+			break;
 		if ((value[0] == '{') && (value[strlen(value) - 1] == '}')) {
 			/* The comment is a JSON string */
 			ret = vmeta_session_recording_json_comment_read(value,
@@ -2678,135 +2854,54 @@ int vmeta_session_recording_read(const char *key,
 			/* This is a real comment */
 			COPY_VALUE(meta->comment, value);
 		}
+		break;
 
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_COPYRIGHT) == 0) &&
-		   (meta->copyright[0] == '\0')) {
-		COPY_VALUE(meta->copyright, value);
-
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_MEDIA_DATE) == 0) &&
-		   (meta->media_date == 0)) {
-		ret = vmeta_session_date_read(
-			value, &meta->media_date, &meta->media_date_gmtoff);
-
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_LOCATION) == 0) &&
-		   (meta->location.valid == 0)) {
-		ret = vmeta_session_location_read(value, &meta->takeoff_loc);
-
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_MAKER) == 0) &&
-		   (meta->maker[0] == '\0')) {
-		COPY_VALUE(meta->maker, value);
-
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_MODEL) == 0) &&
-		   (meta->model[0] == '\0')) {
-		COPY_VALUE(meta->model, value);
-
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_SOFTWARE_VERSION) == 0) &&
-		   (meta->software_version[0] == '\0')) {
-		COPY_VALUE(meta->software_version, value);
-
-	} else if ((strcmp(key, VMETA_REC_UDTA_KEY_SERIAL_NUMBER) == 0) &&
-		   (meta->serial_number[0] == '\0')) {
-		COPY_VALUE(meta->serial_number, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_THERMAL_METAVERSION) == 0) {
-		char metaversion[10];
-		COPY_VALUE(metaversion, value);
-		meta->thermal.metaversion = atoi(metaversion);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_THERMAL_CAMSERIAL) == 0) {
-		COPY_VALUE(meta->thermal.camserial, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_THERMAL_ALIGNMENT) == 0) {
-		ret = vmeta_session_thermal_alignment_read(
-			value, &meta->thermal.alignment);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_THERMAL_CONV_LOW) == 0) {
-		ret = vmeta_session_thermal_conversion_read(
-			value, &meta->thermal.conv_low);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_THERMAL_CONV_HIGH) == 0) {
-		ret = vmeta_session_thermal_conversion_read(
-			value, &meta->thermal.conv_high);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_THERMAL_SCALE_FACTOR) == 0) {
-		ret = vmeta_session_thermal_scale_factor_read(
-			value, &meta->thermal.scale_factor);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_CAMERA_TYPE) == 0) {
-		meta->camera_type = vmeta_camera_type_from_str(value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_CAMERA_SUBTYPE) == 0) {
-		meta->camera_subtype = vmeta_camera_subtype_from_str(value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_CAMERA_SPECTRUM) == 0) {
-		meta->camera_spectrum = vmeta_camera_spectrum_from_str(value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_CAMERA_SERIAL_NUMBER) == 0) {
-		COPY_VALUE(meta->camera_serial_number, value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_CAMERA_MODEL_TYPE) == 0) {
-		meta->camera_model.type =
-			vmeta_camera_model_type_from_str(value);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_PERSPECTIVE_DISTORTION) ==
-		   0) {
-		ret = vmeta_session_perspective_distortion_read(
-			value,
-			&meta->camera_model.perspective.distortion.r1,
-			&meta->camera_model.perspective.distortion.r2,
-			&meta->camera_model.perspective.distortion.r3,
-			&meta->camera_model.perspective.distortion.t1,
-			&meta->camera_model.perspective.distortion.t2);
-
-	} else if (strcmp(key, VMETA_REC_META_KEY_FISHEYE_AFFINE_MATRIX) == 0) {
-		ret = vmeta_session_fisheye_affine_matrix_read(
-			value,
-			&meta->camera_model.fisheye.affine_matrix.c,
-			&meta->camera_model.fisheye.affine_matrix.d,
-			&meta->camera_model.fisheye.affine_matrix.e,
-			&meta->camera_model.fisheye.affine_matrix.f);
+	case SESSION_FIELD_UDTA_COPYRIGHT:
+		if (meta->copyright[0] == '\0')
+			COPY_VALUE(meta->copyright, value);
+		break;
 
-	} else if (strcmp(key, VMETA_REC_META_KEY_FISHEYE_POLYNOMIAL) == 0) {
-		ret = vmeta_session_fisheye_polynomial_read(
-			value,
-			&meta->camera_model.fisheye.polynomial.p2,
-			&meta->camera_model.fisheye.polynomial.p3,
-			&meta->camera_model.fisheye.polynomial.p4);
+	case SESSION_FIELD_UDTA_MEDIA_DATE:
+		if (meta->media_date == 0) {
+			ret = vmeta_session_date_read(value,
+						      &meta->media_date,
+						      &meta->media_date_gmtoff);
+		}
+		break;
 
-	} else if (strcmp(key, VMETA_REC_META_KEY_HEADER_FOOTER) == 0) {
-		meta->overlay.type = VMETA_OVERLAY_TYPE_HEADER_FOOTER;
-		ret = vmeta_session_overlay_header_footer_read(
-			value,
-			&meta->overlay.header_footer.header_height,
-			&meta->overlay.header_footer.footer_height);
+	case SESSION_FIELD_UDTA_LOCATION:
+		if (meta->location.valid == 0) {
+			ret = vmeta_session_location_read(value,
+							  &meta->takeoff_loc);
+		}
+		break;
 
-	} else if (strcmp(key, VMETA_REC_META_KEY_VIDEO_MODE) == 0) {
-		meta->video_mode = vmeta_video_mode_from_str(value);
+	case SESSION_FIELD_UDTA_MAKER:
+		if (meta->maker[0] == '\0')
+			COPY_VALUE(meta->maker, value);
+		break;
 
-	} else if (strcmp(key, VMETA_REC_META_KEY_VIDEO_STOP_REASON) == 0) {
-		meta->video_stop_reason =
-			vmeta_video_stop_reason_from_str(value);
+	case SESSION_FIELD_UDTA_MODEL:
+		if (meta->model[0] == '\0')
+			COPY_VALUE(meta->model, value);
+		break;
 
-	} else if (strcmp(key, VMETA_REC_META_KEY_DYNAMIC_RANGE) == 0) {
-		meta->dynamic_range = vmeta_dynamic_range_from_str(value);
+	case SESSION_FIELD_UDTA_SOFTWARE_VERSION:
+		if (meta->software_version[0] == '\0')
+			COPY_VALUE(meta->software_version, value);
+		break;
 
-	} else if (strcmp(key, VMETA_REC_META_KEY_TONE_MAPPING) == 0) {
-		meta->tone_mapping = vmeta_tone_mapping_from_str(value);
+	case SESSION_FIELD_UDTA_SERIAL_NUMBER:
+		if (meta->serial_number[0] == '\0')
+			COPY_VALUE(meta->serial_number, value);
+		break;
 
-	} else if (strcmp(key, VMETA_REC_META_KEY_FIRST_FRAME_CAPTURE_TS) ==
-		   0) {
-		meta->first_frame_capture_ts = strtoull(value, NULL, 0);
-	} else if (strcmp(key, VMETA_REC_META_KEY_FIRST_FRAME_SAMPLE_INDEX) ==
-		   0) {
-		meta->first_frame_sample_index = strtoul(value, NULL, 0);
-	} else if (strcmp(key, VMETA_REC_META_KEY_MEDIA_ID) == 0) {
-		meta->media_id = strtoul(value, NULL, 0);
-	} else if (strcmp(key, VMETA_REC_META_KEY_RESOURCE_INDEX) == 0) {
-		meta->resource_index = strtoul(value, NULL, 0);
-	} else if (strcmp(key, VMETA_REC_META_KEY_PRINCIPAL_POINT) == 0) {
-		ret = vmeta_session_principal_point_read(
-			value, &meta->principal_point);
+	default:
+		ret = session_field_read(k->field, value, meta);
+		break;
 	}
+
+out:
 	meta->has_thermal = (meta->thermal.metaversion > 0) ||
 			    (meta->thermal.alignment.valid) ||
 			    (meta->thermal.camserial[0] != '\0');
@@ -2815,43 +2910,40 @@ int vmeta_session_recording_read(const char *key,
 }
 
 
-int vmeta_session_to_json(const struct vmeta_session *meta,
-			  struct json_object *jobj)
+int vmeta_session_to_json_writer(const struct vmeta_session *meta,
+				 struct vmeta_json_writer *w)
 {
-	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(jobj == NULL, EINVAL);
-
 	if (meta->friendly_name[0] != '\0')
-		vmeta_json_add_str(jobj, "friendly_name", meta->friendly_name);
+		vmeta_json_add_str(w, "friendly_name", meta->friendly_name);
 
 	if (meta->maker[0] != '\0')
-		vmeta_json_add_str(jobj, "maker", meta->maker);
+		vmeta_json_add_str(w, "maker", meta->maker);
 
 	if (meta->model[0] != '\0')
-		vmeta_json_add_str(jobj, "model", meta->model);
+		vmeta_json_add_str(w, "model", meta->model);
 
 	if (meta->model_id[0] != '\0')
-		vmeta_json_add_str(jobj, "model_id", meta->model_id);
+		vmeta_json_add_str(w, "model_id", meta->model_id);
 
 	if (meta->serial_number[0] != '\0')
-		vmeta_json_add_str(jobj, "serial_number", meta->serial_number);
+		vmeta_json_add_str(w, "serial_number", meta->serial_number);
 
 	if (meta->software_version[0] != '\0') {
 		vmeta_json_add_str(
-			jobj, "software_version", meta->software_version);
+			w, "software_version", meta->software_version);
 	}
 
 	if (meta->build_id[0] != '\0')
-		vmeta_json_add_str(jobj, "build_id", meta->build_id);
+		vmeta_json_add_str(w, "build_id", meta->build_id);
 
 	if (meta->title[0] != '\0')
-		vmeta_json_add_str(jobj, "title", meta->title);
+		vmeta_json_add_str(w, "title", meta->title);
 
 	if (meta->comment[0] != '\0')
-		vmeta_json_add_str(jobj, "comment", meta->comment);
+		vmeta_json_add_str(w, "comment", meta->comment);
 
 	if (meta->copyright[0] != '\0')
-		vmeta_json_add_str(jobj, "copyright", meta->copyright);
+		vmeta_json_add_str(w, "copyright", meta->copyright);
 
 	if (meta->media_date != 0) {
 		char date[VMETA_SESSION_DATE_MAX_LEN];
@@ -2860,7 +2952,7 @@ int vmeta_session_to_json(const struct vmeta_session *meta,
 						       meta->media_date,
 						       meta->media_date_gmtoff);
 		if (ret > 0)
-			vmeta_json_add_str(jobj, "media_date", date);
+			vmeta_json_add_str(w, "media_date", date);
 	}
 
 	if (meta->run_date != 0) {
@@ -2870,11 +2962,11 @@ int vmeta_session_to_json(const struct vmeta_session *meta,
 						       meta->run_date,
 						       meta->run_date_gmtoff);
 		if (ret > 0)
-			vmeta_json_add_str(jobj, "run_date", date);
+			vmeta_json_add_str(w, "run_date", date);
 	}
 
 	if (meta->run_id[0] != '\0')
-		vmeta_json_add_str(jobj, "run_id", meta->run_id);
+		vmeta_json_add_str(w, "run_id", meta->run_id);
 
 	if (meta->boot_date != 0) {
 		char date[VMETA_SESSION_DATE_MAX_LEN];
@@ -2883,11 +2975,11 @@ int vmeta_session_to_json(const struct vmeta_session *meta,
 						       meta->boot_date,
 						       meta->boot_date_gmtoff);
 		if (ret > 0)
-			vmeta_json_add_str(jobj, "boot_date", date);
+			vmeta_json_add_str(w, "boot_date", date);
 	}
 
 	if (meta->boot_id[0] != '\0')
-		vmeta_json_add_str(jobj, "boot_id", meta->boot_id);
+		vmeta_json_add_str(w, "boot_id", meta->boot_id);
 
 	if (meta->flight_date != 0) {
 		char date[VMETA_SESSION_DATE_MAX_LEN];
@@ -2897,115 +2989,102 @@ int vmeta_session_to_json(const struct vmeta_session *meta,
 						 meta->flight_date,
 						 meta->flight_date_gmtoff);
 		if (ret > 0)
-			vmeta_json_add_str(jobj, "flight_date", date);
+			vmeta_json_add_str(w, "flight_date", date);
 	}
 
 	if (meta->flight_id[0] != '\0')
-		vmeta_json_add_str(jobj, "flight_id", meta->flight_id);
+		vmeta_json_add_str(w, "flight_id", meta->flight_id);
 
 	if (meta->custom_id[0] != '\0')
-		vmeta_json_add_str(jobj, "custom_id", meta->custom_id);
+		vmeta_json_add_str(w, "custom_id", meta->custom_id);
 
 	if (meta->takeoff_loc.valid) {
-		vmeta_json_add_location(
-			jobj, "takeoff_loc", &meta->takeoff_loc);
+		vmeta_json_add_location(w, "takeoff_loc", &meta->takeoff_loc);
 	}
 
 	if (meta->location.valid)
-		vmeta_json_add_location(jobj, "location", &meta->location);
+		vmeta_json_add_location(w, "location", &meta->location);
 
 	if ((meta->picture_fov.has_horz) || (meta->picture_fov.has_vert))
-		vmeta_json_add_fov(jobj, "picture_fov", &meta->picture_fov);
+		vmeta_json_add_fov(w, "picture_fov", &meta->picture_fov);
 
-	/* Note: the default_media field is deliberately ommited here */
+	/* Note: the default_media and proto_delta fields are deliberately
+	 * ommited here */
 
 	if (meta->camera_type != VMETA_CAMERA_TYPE_UNKNOWN) {
-		vmeta_json_add_str(jobj,
+		vmeta_json_add_str(w,
 				   "camera_type",
 				   vmeta_camera_type_to_str(meta->camera_type));
 	}
 
 	if (meta->camera_subtype != VMETA_CAMERA_SUBTYPE_UNKNOWN) {
 		vmeta_json_add_str(
-			jobj,
+			w,
 			"camera_subtype",
 			vmeta_camera_subtype_to_str(meta->camera_subtype));
 	}
 
 	if (meta->camera_spectrum != VMETA_CAMERA_SPECTRUM_UNKNOWN) {
 		vmeta_json_add_str(
-			jobj,
+			w,
 			"camera_spectrum",
 			vmeta_camera_spectrum_to_str(meta->camera_spectrum));
 	}
 
 	if (meta->camera_serial_number[0] != '\0') {
-		vmeta_json_add_str(jobj,
-				   "camera_serial_number",
-				   meta->camera_serial_number);
+		vmeta_json_add_str(
+			w, "camera_serial_number", meta->camera_serial_number);
 	}
 
 	switch (meta->camera_model.type) {
 	case VMETA_CAMERA_MODEL_TYPE_PERSPECTIVE: {
-		struct json_object *jobj_model = json_object_new_object();
-		struct json_object *jpd = json_object_new_object();
-		vmeta_json_add_str(jobj_model,
+		vmeta_json_begin_object(w, "camera_model");
+		vmeta_json_add_str(w,
 				   "type",
 				   vmeta_camera_model_type_to_str(
 					   meta->camera_model.type));
+		vmeta_json_begin_object(w, "perspective_distortion");
 		vmeta_json_add_double(
-			jpd,
-			"r1",
-			meta->camera_model.perspective.distortion.r1);
+			w, "r1", meta->camera_model.perspective.distortion.r1);
 		vmeta_json_add_double(
-			jpd,
-			"r2",
-			meta->camera_model.perspective.distortion.r2);
+			w, "r2", meta->camera_model.perspective.distortion.r2);
 		vmeta_json_add_double(
-			jpd,
-			"r3",
-			meta->camera_model.perspective.distortion.r3);
+			w, "r3", meta->camera_model.perspective.distortion.r3);
 		vmeta_json_add_double(
-			jpd,
-			"t1",
-			meta->camera_model.perspective.distortion.t1);
+			w, "t1", meta->camera_model.perspective.distortion.t1);
 		vmeta_json_add_double(
-			jpd,
-			"t2",
-			meta->camera_model.perspective.distortion.t2);
-		json_object_object_add(
-			jobj_model, "perspective_distortion", jpd);
-		json_object_object_add(jobj, "camera_model", jobj_model);
+			w, "t2", meta->camera_model.perspective.distortion.t2);
+		vmeta_json_end_object(w);
+		vmeta_json_end_object(w);
 		break;
 	}
 	case VMETA_CAMERA_MODEL_TYPE_FISHEYE: {
-		struct json_object *jobj_model = json_object_new_object();
-		struct json_object *jfam = json_object_new_object();
-		struct json_object *jfp = json_object_new_object();
-		vmeta_json_add_str(jobj_model,
+		vmeta_json_begin_object(w, "camera_model");
+		vmeta_json_add_str(w,
 				   "type",
 				   vmeta_camera_model_type_to_str(
 					   meta->camera_model.type));
+		vmeta_json_begin_object(w, "fisheye_affine_matrix");
 		vmeta_json_add_double(
-			jfam, "c", meta->camera_model.fisheye.affine_matrix.c);
+			w, "c", meta->camera_model.fisheye.affine_matrix.c);
 		vmeta_json_add_double(
-			jfam, "d", meta->camera_model.fisheye.affine_matrix.d);
+			w, "d", meta->camera_model.fisheye.affine_matrix.d);
 		vmeta_json_add_double(
-			jfam, "e", meta->camera_model.fisheye.affine_matrix.e);
+			w, "e", meta->camera_model.fisheye.affine_matrix.e);
 		vmeta_json_add_double(
-			jfam, "f", meta->camera_model.fisheye.affine_matrix.f);
-		json_object_object_add(
-			jobj_model, "fisheye_affine_matrix", jfam);
-		vmeta_json_add_double(jfp, "p0", 0.);
-		vmeta_json_add_double(jfp, "p1", 1.);
+			w, "f", meta->camera_model.fisheye.affine_matrix.f);
+		vmeta_json_end_object(w);
+		vmeta_json_begin_object(w, "fisheye_polynomial");
+		vmeta_json_add_double(w, "p0", 0.);
+		vmeta_json_add_double(w, "p1", 1.);
 		vmeta_json_add_double(
-			jfp, "p2", meta->camera_model.fisheye.polynomial.p2);
+			w, "p2", meta->camera_model.fisheye.polynomial.p2);
 		vmeta_json_add_double(
-			jfp, "p3", meta->camera_model.fisheye.polynomial.p3);
+			w, "p3", meta->camera_model.fisheye.polynomial.p3);
 		vmeta_json_add_double(
-			jfp, "p4", meta->camera_model.fisheye.polynomial.p4);
-		json_object_object_add(jobj_model, "fisheye_polynomial", jfp);
-		json_object_object_add(jobj, "camera_model", jobj_model);
+			w, "p4", meta->camera_model.fisheye.polynomial.p4);
+		vmeta_json_end_object(w);
+		vmeta_json_end_object(w);
 		break;
 	}
 	default:
@@ -3014,24 +3093,20 @@ int vmeta_session_to_json(const struct vmeta_session *meta,
 
 	switch (meta->overlay.type) {
 	case VMETA_OVERLAY_TYPE_HEADER_FOOTER: {
-		struct json_object *jobj_overlay = json_object_new_object();
-		struct json_object *jobj_header_footer =
-			json_object_new_object();
+		vmeta_json_begin_object(w, "overlay");
 		vmeta_json_add_str(
-			jobj_overlay,
-			"type",
-			vmeta_overlay_type_to_str(meta->overlay.type));
+			w, "type", vmeta_overlay_type_to_str(meta->overlay.type));
+		vmeta_json_begin_object(w, "header_footer");
 		vmeta_json_add_double(
-			jobj_header_footer,
+			w,
 			"header_height",
 			meta->overlay.header_footer.header_height);
 		vmeta_json_add_double(
-			jobj_header_footer,
+			w,
 			"footer_height",
 			meta->overlay.header_footer.footer_height);
-		json_object_object_add(
-			jobj_overlay, "header_footer", jobj_header_footer);
-		json_object_object_add(jobj, "overlay", jobj_overlay);
+		vmeta_json_end_object(w);
+		vmeta_json_end_object(w);
 		break;
 	}
 	default:
@@ -3039,96 +3114,98 @@ int vmeta_session_to_json(const struct vmeta_session *meta,
 	}
 
 	if (meta->principal_point.valid) {
-		vmeta_json_add_xy(jobj,
-				  "principal_point",
-				  &meta->principal_point.position);
+		vmeta_json_add_xy(
+			w, "principal_point", &meta->principal_point.position);
 	}
 
 	if (meta->video_mode != VMETA_VIDEO_MODE_UNKNOWN)
-		vmeta_json_add_str(jobj,
+		vmeta_json_add_str(w,
 				   "video_mode",
 				   vmeta_video_mode_to_str(meta->video_mode));
 
 	if (meta->video_stop_reason != VMETA_VIDEO_STOP_REASON_UNKNOWN)
-		vmeta_json_add_str(jobj,
+		vmeta_json_add_str(w,
 				   "video_stop_reason",
 				   vmeta_video_stop_reason_to_str(
 					   meta->video_stop_reason));
 
 	if (meta->dynamic_range != VMETA_DYNAMIC_RANGE_UNKNOWN)
 		vmeta_json_add_str(
-			jobj,
+			w,
 			"dynamic_range",
 			vmeta_dynamic_range_to_str(meta->dynamic_range));
 
 	if (meta->tone_mapping != VMETA_TONE_MAPPING_UNKNOWN)
 		vmeta_json_add_str(
-			jobj,
+			w,
 			"tone_mapping",
 			vmeta_tone_mapping_to_str(meta->tone_mapping));
 
 	if (meta->has_thermal) {
-		struct json_object *jobj_thermal = json_object_new_object();
-		vmeta_json_add_int(
-			jobj_thermal, "metaversion", meta->thermal.metaversion);
+		vmeta_json_begin_object(w, "thermal");
+		vmeta_json_add_int(w, "metaversion", meta->thermal.metaversion);
 		if (meta->thermal.camserial[0] != '\0') {
-			vmeta_json_add_str(jobj_thermal,
-					   "camserial",
-					   meta->thermal.camserial);
+			vmeta_json_add_str(
+				w, "camserial", meta->thermal.camserial);
 		}
 		if (meta->thermal.alignment.valid) {
-			struct json_object *jobj_align =
-				json_object_new_object();
-			vmeta_json_add_euler(jobj_align,
+			vmeta_json_begin_object(w, "alignment");
+			vmeta_json_add_euler(w,
 					     "rotation",
 					     &meta->thermal.alignment.rotation);
-			json_object_object_add(
-				jobj_thermal, "alignment", jobj_align);
+			vmeta_json_end_object(w);
 		}
 		if (meta->thermal.conv_low.valid) {
 			vmeta_json_add_thermal_conversion(
-				jobj_thermal,
-				"conv_low",
-				&meta->thermal.conv_low);
+				w, "conv_low", &meta->thermal.conv_low);
 		}
 		if (meta->thermal.conv_high.valid) {
 			vmeta_json_add_thermal_conversion(
-				jobj_thermal,
-				"conv_high",
-				&meta->thermal.conv_high);
+				w, "conv_high", &meta->thermal.conv_high);
 		}
 		if (meta->thermal.scale_factor != 0.) {
-			vmeta_json_add_double(jobj_thermal,
-					      "scale_factor",
-					      meta->thermal.scale_factor);
+			vmeta_json_add_double(
+				w, "scale_factor", meta->thermal.scale_factor);
 		}
-		json_object_object_add(jobj, "thermal", jobj_thermal);
+		vmeta_json_end_object(w);
 	}
 
 	if (meta->first_frame_capture_ts != 0) {
-		vmeta_json_add_int64(jobj,
+		vmeta_json_add_int64(w,
 				     "first_frame_capture_ts",
 				     meta->first_frame_capture_ts);
 	}
 
 	if (meta->first_frame_sample_index != 0) {
-		vmeta_json_add_int(jobj,
+		vmeta_json_add_int(w,
 				   "first_frame_sample_index",
 				   meta->first_frame_sample_index);
 	}
 
 	if (meta->media_id != 0)
-		vmeta_json_add_int(jobj, "media_id", meta->media_id);
+		vmeta_json_add_int(w, "media_id", meta->media_id);
 
 	if (meta->resource_index != 0) {
-		vmeta_json_add_int(
-			jobj, "resource_index", meta->resource_index);
+		vmeta_json_add_int(w, "resource_index", meta->resource_index);
 	}
 
 	return 0;
 }
 
 
+int vmeta_session_to_json(const struct vmeta_session *meta,
+			  struct json_object *jobj)
+{
+	struct vmeta_json_writer w;
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(jobj == NULL, EINVAL);
+
+	vmeta_json_writer_init_object(&w, jobj);
+	vmeta_session_to_json_writer(meta, &w);
+	return vmeta_json_writer_finish(&w);
+}
+
+
 int vmeta_session_to_str(const struct vmeta_session *meta,
 			 char *str,
 			 size_t maxlen)
@@ -3356,7 +3433,8 @@ int vmeta_session_to_str(const struct vmeta_session *meta,
 		}
 	}
 
-	/* Note: the default_media field is deliberately ommited here */
+	/* Note: the default_media and proto_delta fields are deliberately
+	 * ommited here */
 
 	if (meta->camera_type != VMETA_CAMERA_TYPE_UNKNOWN) {
 		VMETA_STR_PRINT(str + len,
@@ -3635,154 +3713,302 @@ int vmeta_session_to_str(const struct vmeta_session *meta,
 }
 
 
+#define SESSION_FIELD_DESC(_id, _group, _type, _name)                          \
+	[VMETA_SESSION_FIELD_##_id] = {                                        \
+		.group = VMETA_SESSION_GROUP_##_group,                         \
+		.type = VMETA_SESSION_VALUE_##_type,                           \
+		.offset = offsetof(struct vmeta_session, _name),               \
+		.size = sizeof(((struct vmeta_session *)0)->_name),            \
+	}
+
+#define SESSION_FIELD_DESC_GMTOFF(_id, _name)                                  \
+	[VMETA_SESSION_FIELD_##_id] = {                                        \
+		.group = VMETA_SESSION_GROUP_DATES,                            \
+		.type = VMETA_SESSION_VALUE_SCALAR,                            \
+		.offset = offsetof(struct vmeta_session, _name),               \
+		.size = sizeof(((struct vmeta_session *)0)->_name),            \
+		.joined = 1,                                                   \
+	}
+
+#define SESSION_FIELD_DESC_BIT(_id, _group, _joined)                           \
+	[VMETA_SESSION_FIELD_##_id] = {                                        \
+		.group = VMETA_SESSION_GROUP_##_group,                         \
+		.type = VMETA_SESSION_VALUE_##_id,                             \
+		.joined = _joined,                                             \
+	}
+
+
+/* Fields of the session metadata structure (see enum
+ * vmeta_session_field_id) */
+/* clang-format off */
+const struct vmeta_session_field_desc
+	vmeta_session_fields[VMETA_SESSION_FIELD_COUNT] = {
+	SESSION_FIELD_DESC(FRIENDLY_NAME, IDENTITY, STR, friendly_name),
+	SESSION_FIELD_DESC(MAKER, IDENTITY, STR, maker),
+	SESSION_FIELD_DESC(MODEL, IDENTITY, STR, model),
+	SESSION_FIELD_DESC(MODEL_ID, IDENTITY, STR, model_id),
+	SESSION_FIELD_DESC(SERIAL_NUMBER, IDENTITY, STR, serial_number),
+	SESSION_FIELD_DESC(SOFTWARE_VERSION, IDENTITY, STR, software_version),
+	SESSION_FIELD_DESC(BUILD_ID, IDENTITY, STR, build_id),
+	SESSION_FIELD_DESC(TITLE, IDENTITY, STR, title),
+	SESSION_FIELD_DESC(COMMENT, IDENTITY, STR, comment),
+	SESSION_FIELD_DESC(COPYRIGHT, IDENTITY, STR, copyright),
+	SESSION_FIELD_DESC(MEDIA_DATE, DATES, SCALAR, media_date),
+	SESSION_FIELD_DESC_GMTOFF(MEDIA_DATE_GMTOFF, media_date_gmtoff),
+	SESSION_FIELD_DESC(RUN_DATE, DATES, SCALAR, run_date),
+	SESSION_FIELD_DESC_GMTOFF(RUN_DATE_GMTOFF, run_date_gmtoff),
+	SESSION_FIELD_DESC(RUN_ID, IDENTITY, STR, run_id),
+	SESSION_FIELD_DESC(BOOT_DATE, DATES, SCALAR, boot_date),
+	SESSION_FIELD_DESC_GMTOFF(BOOT_DATE_GMTOFF, boot_date_gmtoff),
+	SESSION_FIELD_DESC(BOOT_ID, IDENTITY, STR, boot_id),
+	SESSION_FIELD_DESC(FLIGHT_DATE, DATES, SCALAR, flight_date),
+	SESSION_FIELD_DESC_GMTOFF(FLIGHT_DATE_GMTOFF, flight_date_gmtoff),
+	SESSION_FIELD_DESC(FLIGHT_ID, IDENTITY, STR, flight_id),
+	SESSION_FIELD_DESC(CUSTOM_ID, IDENTITY, STR, custom_id),
+	SESSION_FIELD_DESC(TAKEOFF_LOC, LOCATION, LOCATION, takeoff_loc),
+	SESSION_FIELD_DESC(LOCATION, LOCATION, LOCATION, location),
+	SESSION_FIELD_DESC(PICTURE_FOV, CAMERA_MODEL, FOV, picture_fov),
+	SESSION_FIELD_DESC(THERMAL, THERMAL, THERMAL, thermal),
+	SESSION_FIELD_DESC_BIT(HAS_THERMAL, THERMAL, 1),
+	SESSION_FIELD_DESC_BIT(DEFAULT_MEDIA, MEDIA, 0),
+	SESSION_FIELD_DESC_BIT(PROTO_DELTA, MEDIA, 0),
+	SESSION_FIELD_DESC(CAMERA_TYPE, CAMERA_MODEL, SCALAR, camera_type),
+	SESSION_FIELD_DESC(CAMERA_SUBTYPE, CAMERA_MODEL, SCALAR,
+			   camera_subtype),
+	SESSION_FIELD_DESC(CAMERA_SPECTRUM, CAMERA_MODEL, SCALAR,
+			   camera_spectrum),
+	SESSION_FIELD_DESC(CAMERA_SERIAL_NUMBER, CAMERA_MODEL, STR,
+			   camera_serial_number),
+	SESSION_FIELD_DESC(CAMERA_MODEL, CAMERA_MODEL, STRUCT, camera_model),
+	SESSION_FIELD_DESC(OVERLAY, OVERLAY, STRUCT, overlay),
+	SESSION_FIELD_DESC(PRINCIPAL_POINT, CAMERA_MODEL, PRINCIPAL_POINT,
+			   principal_point),
+	SESSION_FIELD_DESC(VIDEO_MODE, MEDIA, SCALAR, video_mode),
+	SESSION_FIELD_DESC(VIDEO_STOP_REASON, MEDIA, SCALAR, video_stop_reason),
+	SESSION_FIELD_DESC(DYNAMIC_RANGE, MEDIA, SCALAR, dynamic_range),
+	SESSION_FIELD_DESC(TONE_MAPPING, MEDIA, SCALAR, tone_mapping),
+	SESSION_FIELD_DESC(FIRST_FRAME_CAPTURE_TS, MEDIA, SCALAR,
+			   first_frame_capture_ts),
+	SESSION_FIELD_DESC(FIRST_FRAME_SAMPLE_INDEX, MEDIA, SCALAR,
+			   first_frame_sample_index),
+	SESSION_FIELD_DESC(MEDIA_ID, MEDIA, SCALAR, media_id),
+	SESSION_FIELD_DESC(RESOURCE_INDEX, MEDIA, SCALAR, resource_index),
+};
+/* clang-format on */
+
+
+/* The fields are masked in a uint64_t in vmeta_session_merge_metadata() */
+typedef char
+	session_field_count_check[(VMETA_SESSION_FIELD_COUNT <= 64) ? 1 : -1];
+
+
+/* Field value fingerprint; two values are considered identical if their
+ * fingerprints are equal */
+struct session_field_fp {
+	uint64_t hash;
+	size_t len;
+};
+
+
 static void
-fill_session_meta_with_identical_values(const struct vmeta_session *ref,
-					struct vmeta_session *ret)
+session_field_fingerprint(const struct vmeta_session_field_desc *desc,
+			  const struct vmeta_session *meta,
+			  struct session_field_fp *fp)
 {
-	MERGE_META_STR(ret, ref, friendly_name);
-	MERGE_META_STR(ret, ref, maker);
-	MERGE_META_STR(ret, ref, model);
-	MERGE_META_STR(ret, ref, model_id);
-	MERGE_META_STR(ret, ref, serial_number);
-	MERGE_META_STR(ret, ref, software_version);
-	MERGE_META_STR(ret, ref, build_id);
-	MERGE_META_STR(ret, ref, title);
-	MERGE_META_STR(ret, ref, comment);
-	MERGE_META_STR(ret, ref, copyright);
-
-	MERGE_META_VAL(ret, ref, media_date, 0);
-	MERGE_META_VAL(ret, ref, media_date_gmtoff, 0);
-	MERGE_META_VAL(ret, ref, run_date, 0);
-	MERGE_META_VAL(ret, ref, run_date_gmtoff, 0);
-
-	MERGE_META_STR(ret, ref, run_id);
-
-	MERGE_META_VAL(ret, ref, boot_date, 0);
-	MERGE_META_VAL(ret, ref, boot_date_gmtoff, 0);
-
-	MERGE_META_STR(ret, ref, boot_id);
-
-	MERGE_META_VAL(ret, ref, flight_date, 0);
-	MERGE_META_VAL(ret, ref, flight_date_gmtoff, 0);
-
-	MERGE_META_STR(ret, ref, flight_id);
-	MERGE_META_STR(ret, ref, custom_id);
-
-	MERGE_META_PTR(&ret, &ref, takeoff_loc, sizeof(struct vmeta_location));
-	MERGE_META_PTR(&ret, &ref, location, sizeof(struct vmeta_location));
-	MERGE_META_PTR(&ret, &ref, picture_fov, sizeof(struct vmeta_fov));
-	MERGE_META_PTR(&ret, &ref, thermal, sizeof(struct vmeta_thermal));
-
-	if ((ret->has_thermal != ref->has_thermal) ||
-	    (memcmp(&ret->thermal,
-		    &ref->thermal,
-		    sizeof(struct vmeta_thermal)) != 0))
-		ret->has_thermal = 0;
-
-	MERGE_META_VAL(ret, ref, default_media, 0);
-
-	MERGE_META_VAL(ret, ref, camera_type, VMETA_CAMERA_TYPE_UNKNOWN);
-	MERGE_META_VAL(ret, ref, camera_subtype, VMETA_CAMERA_SUBTYPE_UNKNOWN);
-	MERGE_META_VAL(
-		ret, ref, camera_spectrum, VMETA_CAMERA_SPECTRUM_UNKNOWN);
-
-	MERGE_META_STR(ret, ref, camera_serial_number);
-	MERGE_META_PTR(
-		&ret, &ref, camera_model, sizeof(struct vmeta_camera_model));
-	MERGE_META_PTR(&ret, &ref, overlay, sizeof(struct vmeta_overlay));
-	MERGE_META_VAL(ret, ref, video_mode, VMETA_VIDEO_MODE_UNKNOWN);
-	MERGE_META_VAL(
-		ret, ref, video_stop_reason, VMETA_VIDEO_STOP_REASON_UNKNOWN);
-	MERGE_META_VAL(ret, ref, dynamic_range, VMETA_DYNAMIC_RANGE_UNKNOWN);
-	MERGE_META_VAL(ret, ref, tone_mapping, VMETA_TONE_MAPPING_UNKNOWN);
-	MERGE_META_VAL(ret, ref, first_frame_capture_ts, 0);
-	MERGE_META_VAL(ret, ref, first_frame_sample_index, 0);
-	MERGE_META_VAL(ret, ref, media_id, 0);
-	MERGE_META_VAL(ret, ref, resource_index, 0);
-
-	if ((ret->principal_point.valid != ref->principal_point.valid) ||
-	    (memcmp(&ret->principal_point.position,
-		    &ref->principal_point.position,
-		    sizeof(struct vmeta_xy)) != 0))
-		ret->principal_point.valid = 0;
+	const uint8_t *field = (const uint8_t *)meta + desc->offset;
+	const struct vmeta_principal_point *pp;
+
+	switch (desc->type) {
+	case VMETA_SESSION_VALUE_STR:
+		fp->len = strnlen((const char *)field, desc->size);
+		fp->hash = vmeta_hash64(field, fp->len, 0);
+		break;
+	case VMETA_SESSION_VALUE_SCALAR:
+		/* Scalar values are their own fingerprint */
+		fp->len = desc->size;
+		fp->hash = 0;
+		memcpy(&fp->hash, field, desc->size);
+		break;
+	case VMETA_SESSION_VALUE_PRINCIPAL_POINT:
+		pp = (const struct vmeta_principal_point *)field;
+		fp->len = sizeof(pp->position);
+		fp->hash = vmeta_hash64(&pp->position, fp->len, 0) ^ pp->valid;
+		break;
+	case VMETA_SESSION_VALUE_HAS_THERMAL:
+		/* The thermal flag is only common along with the thermal
+		 * metadata */
+		fp->len = sizeof(meta->thermal);
+		fp->hash = vmeta_hash64(&meta->thermal, fp->len, 0) ^
+			   meta->has_thermal;
+		break;
+	case VMETA_SESSION_VALUE_DEFAULT_MEDIA:
+		fp->len = 0;
+		fp->hash = meta->default_media;
+		break;
+	case VMETA_SESSION_VALUE_PROTO_DELTA:
+		fp->len = 0;
+		fp->hash = meta->proto_delta;
+		break;
+	default:
+		fp->len = desc->size;
+		fp->hash = vmeta_hash64(field, desc->size, 0);
+		break;
+	}
 }
 
 
-static void
-erase_session_meta_with_identical_values(const struct vmeta_session *ref,
-					 struct vmeta_session *ret)
+/* Clear a field of the merged session metadata whose value is not common
+ * to all the session metadata */
+static void session_field_clear(const struct vmeta_session_field_desc *desc,
+				struct vmeta_session *meta)
+{
+	uint8_t *field = (uint8_t *)meta + desc->offset;
+
+	switch (desc->type) {
+	case VMETA_SESSION_VALUE_STR:
+		field[0] = '\0';
+		break;
+	case VMETA_SESSION_VALUE_PRINCIPAL_POINT:
+		meta->principal_point.valid = 0;
+		break;
+	case VMETA_SESSION_VALUE_HAS_THERMAL:
+		meta->has_thermal = 0;
+		break;
+	case VMETA_SESSION_VALUE_DEFAULT_MEDIA:
+		meta->default_media = 0;
+		break;
+	case VMETA_SESSION_VALUE_PROTO_DELTA:
+		meta->proto_delta = 0;
+		break;
+	default:
+		memset(field, 0, desc->size);
+		break;
+	}
+}
+
+
+/* Check whether a field is set (i.e. would be written) in a session
+ * metadata */
+static int session_field_is_set(const struct vmeta_session_field_desc *desc,
+				const struct vmeta_session *meta)
+{
+	const uint8_t *field = (const uint8_t *)meta + desc->offset;
+
+	switch (desc->type) {
+	case VMETA_SESSION_VALUE_STR:
+		return field[0] != '\0';
+	case VMETA_SESSION_VALUE_SCALAR:
+	case VMETA_SESSION_VALUE_STRUCT:
+		for (size_t i = 0; i < desc->size; i++) {
+			if (field[i] != 0)
+				return 1;
+		}
+		return 0;
+	case VMETA_SESSION_VALUE_LOCATION:
+		return ((const struct vmeta_location *)field)->valid;
+	case VMETA_SESSION_VALUE_FOV:
+		return meta->picture_fov.has_horz || meta->picture_fov.has_vert;
+	case VMETA_SESSION_VALUE_PRINCIPAL_POINT:
+		return meta->principal_point.valid;
+	case VMETA_SESSION_VALUE_HAS_THERMAL:
+		return meta->has_thermal;
+	case VMETA_SESSION_VALUE_DEFAULT_MEDIA:
+		return meta->default_media;
+	case VMETA_SESSION_VALUE_PROTO_DELTA:
+		return meta->proto_delta;
+	default:
+		/* The thermal metadata is never erased (see has_thermal) */
+		return 0;
+	}
+}
+
+
+/* Erase a field of a session metadata whose value is set and common to all
+ * the session metadata (i.e. is in the merged session metadata) */
+static void session_field_erase(const struct vmeta_session_field_desc *desc,
+				struct vmeta_session *meta)
+{
+	uint8_t *field = (uint8_t *)meta + desc->offset;
+
+	switch (desc->type) {
+	case VMETA_SESSION_VALUE_STR:
+		field[0] = '\0';
+		break;
+	case VMETA_SESSION_VALUE_SCALAR:
+	case VMETA_SESSION_VALUE_STRUCT:
+		memset(field, 0, desc->size);
+		break;
+	case VMETA_SESSION_VALUE_LOCATION:
+		((struct vmeta_location *)field)->valid = 0;
+		break;
+	case VMETA_SESSION_VALUE_FOV:
+		meta->picture_fov.has_horz = 0;
+		meta->picture_fov.has_vert = 0;
+		break;
+	case VMETA_SESSION_VALUE_PRINCIPAL_POINT:
+		meta->principal_point.valid = 0;
+		break;
+	case VMETA_SESSION_VALUE_HAS_THERMAL:
+		meta->has_thermal = 0;
+		break;
+	case VMETA_SESSION_VALUE_DEFAULT_MEDIA:
+		meta->default_media = 0;
+		break;
+	case VMETA_SESSION_VALUE_PROTO_DELTA:
+		meta->proto_delta = 0;
+		break;
+	default:
+		break;
+	}
+}
+
+
+int vmeta_session_field_equal(const struct vmeta_session_field_desc *desc,
+			      const struct vmeta_session *meta1,
+			      const struct vmeta_session *meta2)
+{
+	const char *field1 = (const char *)meta1 + desc->offset;
+	const char *field2 = (const char *)meta2 + desc->offset;
+	size_t len;
+
+	switch (desc->type) {
+	case VMETA_SESSION_VALUE_STR:
+		/* Bytes after the terminator are not part of the value */
+		len = strnlen(field1, desc->size);
+		return (len == strnlen(field2, desc->size)) &&
+		       (memcmp(field1, field2, len) == 0);
+	case VMETA_SESSION_VALUE_HAS_THERMAL:
+		return meta1->has_thermal == meta2->has_thermal;
+	case VMETA_SESSION_VALUE_DEFAULT_MEDIA:
+		return meta1->default_media == meta2->default_media;
+	case VMETA_SESSION_VALUE_PROTO_DELTA:
+		return meta1->proto_delta == meta2->proto_delta;
+	default:
+		return memcmp(field1, field2, desc->size) == 0;
+	}
+}
+
+
+void vmeta_session_field_copy(const struct vmeta_session_field_desc *desc,
+			      struct vmeta_session *dst,
+			      const struct vmeta_session *src)
 {
-	REMOVE_DUPLICATE_META_STR(ret, ref, friendly_name);
-	REMOVE_DUPLICATE_META_STR(ret, ref, maker);
-	REMOVE_DUPLICATE_META_STR(ret, ref, model);
-	REMOVE_DUPLICATE_META_STR(ret, ref, model_id);
-	REMOVE_DUPLICATE_META_STR(ret, ref, serial_number);
-	REMOVE_DUPLICATE_META_STR(ret, ref, software_version);
-	REMOVE_DUPLICATE_META_STR(ret, ref, build_id);
-	REMOVE_DUPLICATE_META_STR(ret, ref, title);
-	REMOVE_DUPLICATE_META_STR(ret, ref, comment);
-	REMOVE_DUPLICATE_META_STR(ret, ref, copyright);
-
-	REMOVE_DUPLICATE_META_VAL(ret, ref, media_date, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, media_date_gmtoff, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, run_date, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, run_date_gmtoff, 0);
-
-	REMOVE_DUPLICATE_META_STR(ret, ref, run_id);
-
-	REMOVE_DUPLICATE_META_VAL(ret, ref, boot_date, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, boot_date_gmtoff, 0);
-
-	REMOVE_DUPLICATE_META_STR(ret, ref, boot_id);
-
-	REMOVE_DUPLICATE_META_VAL(ret, ref, flight_date, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, flight_date_gmtoff, 0);
-
-	REMOVE_DUPLICATE_META_STR(ret, ref, flight_id);
-	REMOVE_DUPLICATE_META_STR(ret, ref, custom_id);
-
-	REMOVE_DUPLICATE_META_VAL(ret, ref, takeoff_loc.valid, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, location.valid, 0);
-
-	if (ref->picture_fov.has_horz || ref->picture_fov.has_vert) {
-		ret->picture_fov.has_horz = 0;
-		ret->picture_fov.has_vert = 0;
-	}
-
-	if (ref->has_thermal)
-		ret->has_thermal = 0;
-
-	REMOVE_DUPLICATE_META_VAL(ret, ref, default_media, 0);
-
-	REMOVE_DUPLICATE_META_VAL(
-		ret, ref, camera_type, VMETA_CAMERA_TYPE_UNKNOWN);
-	REMOVE_DUPLICATE_META_VAL(
-		ret, ref, camera_subtype, VMETA_CAMERA_SUBTYPE_UNKNOWN);
-	REMOVE_DUPLICATE_META_VAL(
-		ret, ref, camera_spectrum, VMETA_CAMERA_SPECTRUM_UNKNOWN);
-
-	REMOVE_DUPLICATE_META_STR(ret, ref, camera_serial_number);
-	REMOVE_DUPLICATE_META_PTR(
-		&ret, &ref, camera_model, sizeof(struct vmeta_camera_model));
-	REMOVE_DUPLICATE_META_PTR(
-		&ret, &ref, overlay, sizeof(struct vmeta_overlay));
-	REMOVE_DUPLICATE_META_VAL(
-		ret, ref, video_stop_reason, VMETA_VIDEO_STOP_REASON_UNKNOWN);
-	REMOVE_DUPLICATE_META_VAL(
-		ret, ref, dynamic_range, VMETA_DYNAMIC_RANGE_UNKNOWN);
-	REMOVE_DUPLICATE_META_VAL(
-		ret, ref, tone_mapping, VMETA_TONE_MAPPING_UNKNOWN);
-
-	REMOVE_DUPLICATE_META_VAL(
-		ret, ref, video_mode, VMETA_VIDEO_MODE_UNKNOWN);
-
-	REMOVE_DUPLICATE_META_VAL(ret, ref, first_frame_capture_ts, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, first_frame_sample_index, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, media_id, 0);
-	REMOVE_DUPLICATE_META_VAL(ret, ref, resource_index, 0);
-
-	if (ref->principal_point.valid)
-		ret->principal_point.valid = 0;
+	switch (desc->type) {
+	case VMETA_SESSION_VALUE_HAS_THERMAL:
+		dst->has_thermal = src->has_thermal;
+		break;
+	case VMETA_SESSION_VALUE_DEFAULT_MEDIA:
+		dst->default_media = src->default_media;
+		break;
+	case VMETA_SESSION_VALUE_PROTO_DELTA:
+		dst->proto_delta = src->proto_delta;
+		break;
+	default:
+		memcpy((uint8_t *)dst + desc->offset,
+		       (const uint8_t *)src + desc->offset,
+		       desc->size);
+		break;
+	}
 }
 
 
@@ -3790,29 +4016,65 @@ int vmeta_session_merge_metadata(struct vmeta_session **meta_list,
 				 size_t meta_list_count,
 				 struct vmeta_session *merged_meta)
 {
+	struct session_field_fp ref[VMETA_SESSION_FIELD_COUNT];
+	struct session_field_fp fp;
+	uint64_t common = 0;
+	size_t first;
+
 	ULOG_ERRNO_RETURN_ERR_IF(merged_meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(meta_list == NULL, EINVAL);
 
-	if (meta_list_count == 0)
+	for (first = 0; first < meta_list_count; first++) {
+		if (meta_list[first] != NULL)
+			break;
+	}
+	if (first == meta_list_count)
 		return 0;
 
-	/* Copy first vmeta into merged_meta */
-	memcpy(merged_meta, meta_list[0], sizeof(*merged_meta));
+	/* Fingerprint the fields of the first session metadata */
+	for (size_t j = 0; j < VMETA_SESSION_FIELD_COUNT; j++) {
+		session_field_fingerprint(
+			&vmeta_session_fields[j], meta_list[first], &ref[j]);
+		common |= UINT64_C(1) << j;
+	}
 
-	/* First pass: remove different values from merged_meta */
-	for (size_t i = 1; i < meta_list_count; i++) {
+	/* Single pass: a field is common if its fingerprint is the same in
+	 * all session metadata; a field that is not common is not
+	 * fingerprinted anymore in the following session metadata */
+	for (size_t i = first + 1; (i < meta_list_count) && (common != 0);
+	     i++) {
 		if (meta_list[i] == NULL)
 			continue;
-		fill_session_meta_with_identical_values(meta_list[i],
-							merged_meta);
+		for (size_t j = 0; j < VMETA_SESSION_FIELD_COUNT; j++) {
+			if (!(common & (UINT64_C(1) << j)))
+				continue;
+			session_field_fingerprint(
+				&vmeta_session_fields[j], meta_list[i], &fp);
+			if ((fp.hash != ref[j].hash) || (fp.len != ref[j].len))
+				common &= ~(UINT64_C(1) << j);
+		}
+	}
+
+	/* Merged session metadata: common fields only */
+	memcpy(merged_meta, meta_list[first], sizeof(*merged_meta));
+	for (size_t j = 0; j < VMETA_SESSION_FIELD_COUNT; j++) {
+		const struct vmeta_session_field_desc *desc =
+			&vmeta_session_fields[j];
+		if (!(common & (UINT64_C(1) << j)))
+			session_field_clear(desc, merged_meta);
+		else if (!session_field_is_set(desc, merged_meta))
+			common &= ~(UINT64_C(1) << j);
 	}
 
-	/* Second pass: remove identical values from meta_list */
-	for (size_t i = 0; i < meta_list_count; i++) {
+	/* Remove the common fields that are set from the session metadata */
+	for (size_t i = 0; (i < meta_list_count) && (common != 0); i++) {
 		if (meta_list[i] == NULL)
 			continue;
-		erase_session_meta_with_identical_values(merged_meta,
-							 meta_list[i]);
+		for (size_t j = 0; j < VMETA_SESSION_FIELD_COUNT; j++) {
+			if (common & (UINT64_C(1) << j))
+				session_field_erase(&vmeta_session_fields[j],
+						    meta_list[i]);
+		}
 	}
 
 	return 0;
@@ -3901,6 +4163,8 @@ int vmeta_session_cmp(const struct vmeta_session *meta1,
 
 	if (meta1->default_media != meta2->default_media)
 		return 0;
+	if (meta1->proto_delta != meta2->proto_delta)
+		return 0;
 	CMP_FIELD_VAL(meta1, meta2, camera_type);
 	CMP_FIELD_VAL(meta1, meta2, camera_subtype);
 	CMP_FIELD_VAL(meta1, meta2, camera_spectrum);
@@ -3925,6 +4189,196 @@ int vmeta_session_cmp(const struct vmeta_session *meta1,
 }
 
 
+/* Canonical value of a floating-point number for the fingerprints: values
+ * that are equal according to vmeta_session_cmp() (0.0 and -0.0, NaN
+ * altitudes) have the same representation */
+static uint64_t session_fp_double(double val)
+{
+	uint64_t ret;
+
+	if (isnan(val))
+		val = NAN;
+	else if (val == 0.)
+		val = 0.;
+	memcpy(&ret, &val, sizeof(ret));
+	return ret;
+}
+
+
+static uint64_t session_fp_scalar(const uint8_t *field, size_t size)
+{
+	uint8_t u8;
+	uint16_t u16;
+	uint32_t u32;
+	uint64_t u64 = 0;
+
+	switch (size) {
+	case sizeof(u8):
+		u8 = *field;
+		return u8;
+	case sizeof(u16):
+		memcpy(&u16, field, size);
+		return u16;
+	case sizeof(u32):
+		memcpy(&u32, field, size);
+		return u32;
+	default:
+		memcpy(&u64, field, (size < sizeof(u64)) ? size : sizeof(u64));
+		return u64;
+	}
+}
+
+
+/* Add a field to the fingerprint of its group; only the values compared by
+ * vmeta_session_cmp() are taken into account */
+static void session_field_fp_add(const struct vmeta_session_field_desc *desc,
+				 const struct vmeta_session *meta,
+				 uint64_t hash[2])
+{
+	const uint8_t *field = (const uint8_t *)meta + desc->offset;
+	const struct vmeta_location *loc;
+	uint64_t val[8];
+	size_t n = 0;
+
+	switch (desc->type) {
+	case VMETA_SESSION_VALUE_STR:
+		n = strnlen((const char *)field, desc->size);
+		vmeta_hash128(field, n, hash);
+		return;
+	case VMETA_SESSION_VALUE_SCALAR:
+		val[n++] = session_fp_scalar(field, desc->size);
+		break;
+	case VMETA_SESSION_VALUE_STRUCT:
+		vmeta_hash128(field, desc->size, hash);
+		return;
+	case VMETA_SESSION_VALUE_LOCATION:
+		loc = (const struct vmeta_location *)field;
+		val[n++] = loc->valid;
+		if (!loc->valid)
+			break;
+		val[n++] = session_fp_double(loc->latitude);
+		val[n++] = session_fp_double(loc->longitude);
+		val[n++] = session_fp_double(loc->altitude_wgs84ellipsoid);
+		val[n++] = session_fp_double(loc->altitude_egm96amsl);
+		val[n++] = session_fp_double(loc->horizontal_accuracy);
+		val[n++] = session_fp_double(loc->vertical_accuracy);
+		val[n++] = loc->sv_count;
+		break;
+	case VMETA_SESSION_VALUE_FOV:
+		val[n++] = meta->picture_fov.has_horz |
+			   (meta->picture_fov.has_vert << 1);
+		if (meta->picture_fov.has_horz)
+			val[n++] = session_fp_double(meta->picture_fov.horz);
+		if (meta->picture_fov.has_vert)
+			val[n++] = session_fp_double(meta->picture_fov.vert);
+		break;
+	case VMETA_SESSION_VALUE_THERMAL:
+		/* The thermal metadata is only compared along with the thermal
+		 * flag (see VMETA_SESSION_VALUE_HAS_THERMAL) */
+		return;
+	case VMETA_SESSION_VALUE_PRINCIPAL_POINT:
+		val[n++] = meta->principal_point.valid;
+		vmeta_hash128(val, n * sizeof(val[0]), hash);
+		if (meta->principal_point.valid)
+			vmeta_hash128(&meta->principal_point.position,
+				      sizeof(meta->principal_point.position),
+				      hash);
+		return;
+	case VMETA_SESSION_VALUE_HAS_THERMAL:
+		val[n++] = meta->has_thermal;
+		vmeta_hash128(val, n * sizeof(val[0]), hash);
+		if (meta->has_thermal)
+			vmeta_hash128(
+				&meta->thermal, sizeof(meta->thermal), hash);
+		return;
+	case VMETA_SESSION_VALUE_DEFAULT_MEDIA:
+		val[n++] = meta->default_media;
+		break;
+	case VMETA_SESSION_VALUE_PROTO_DELTA:
+		val[n++] = meta->proto_delta;
+		break;
+	default:
+		return;
+	}
+
+	vmeta_hash128(val, n * sizeof(val[0]), hash);
+}
+
+
+int vmeta_session_fingerprint(const struct vmeta_session *meta,
+			      struct vmeta_session_fingerprint *fp)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(fp == NULL, EINVAL);
+
+	return vmeta_session_fingerprint_update(
+		meta, (UINT32_C(1) << VMETA_SESSION_GROUP_COUNT) - 1, fp);
+}
+
+
+int vmeta_session_fingerprint_update(const struct vmeta_session *meta,
+				     uint32_t groups,
+				     struct vmeta_session_fingerprint *fp)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(fp == NULL, EINVAL);
+
+	groups &= (UINT32_C(1) << VMETA_SESSION_GROUP_COUNT) - 1;
+
+	for (unsigned int i = 0; i < VMETA_SESSION_GROUP_COUNT; i++) {
+		if (!(groups & (UINT32_C(1) << i)))
+			continue;
+		fp->group[i][0] = i;
+		fp->group[i][1] = 0;
+	}
+
+	/* Fields of the groups to update */
+	for (size_t j = 0; j < VMETA_SESSION_FIELD_COUNT; j++) {
+		const struct vmeta_session_field_desc *desc =
+			&vmeta_session_fields[j];
+		if (!(groups & (UINT32_C(1) << desc->group)))
+			continue;
+		session_field_fp_add(desc, meta, fp->group[desc->group]);
+	}
+
+	/* Fingerprint of all the fields: fingerprint of the groups */
+	fp->hash[0] = 0;
+	fp->hash[1] = 0;
+	vmeta_hash128(fp->group, sizeof(fp->group), fp->hash);
+
+	return 0;
+}
+
+
+int vmeta_session_fingerprint_cmp(const struct vmeta_session_fingerprint *fp1,
+				  const struct vmeta_session_fingerprint *fp2)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(fp1 == NULL && fp2 == NULL, EINVAL, 1);
+	ULOG_ERRNO_RETURN_VAL_IF(fp1 == NULL || fp2 == NULL, EINVAL, 0);
+
+	return (fp1->hash[0] == fp2->hash[0]) && (fp1->hash[1] == fp2->hash[1]);
+}
+
+
+uint32_t
+vmeta_session_fingerprint_diff(const struct vmeta_session_fingerprint *fp1,
+			       const struct vmeta_session_fingerprint *fp2)
+{
+	uint32_t all = (UINT32_C(1) << VMETA_SESSION_GROUP_COUNT) - 1;
+	uint32_t diff = 0;
+
+	ULOG_ERRNO_RETURN_VAL_IF(fp1 == NULL || fp2 == NULL, EINVAL, all);
+
+	for (unsigned int i = 0; i < VMETA_SESSION_GROUP_COUNT; i++) {
+		if ((fp1->group[i][0] != fp2->group[i][0]) ||
+		    (fp1->group[i][1] != fp2->group[i][1]))
+			diff |= UINT32_C(1) << i;
+	}
+
+	return diff;
+}
+
+
 int vmeta_session_is_valid(const struct vmeta_session *meta)
 {
 	ULOG_ERRNO_RETURN_VAL_IF(meta == NULL, EINVAL, 0);
@@ -0,0 +1,528 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vmeta_priv.h"
+
+
+/* Serialized items */
+enum session_output {
+	SESSION_OUTPUT_SDES = 0,
+	SESSION_OUTPUT_SDP_SESSION,
+	SESSION_OUTPUT_SDP_MEDIA,
+	SESSION_OUTPUT_RECORDING,
+
+	SESSION_OUTPUT_COUNT,
+};
+
+
+/* Order of the fields in vmeta_session_streaming_sdes_write() */
+static const enum vmeta_session_field_id s_sdes_order[] = {
+	VMETA_SESSION_FIELD_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_FRIENDLY_NAME,
+	VMETA_SESSION_FIELD_SOFTWARE_VERSION,
+	VMETA_SESSION_FIELD_TAKEOFF_LOC,
+	VMETA_SESSION_FIELD_LOCATION,
+	VMETA_SESSION_FIELD_MAKER,
+	VMETA_SESSION_FIELD_MODEL,
+	VMETA_SESSION_FIELD_MODEL_ID,
+	VMETA_SESSION_FIELD_BUILD_ID,
+	VMETA_SESSION_FIELD_TITLE,
+	VMETA_SESSION_FIELD_COMMENT,
+	VMETA_SESSION_FIELD_COPYRIGHT,
+	VMETA_SESSION_FIELD_MEDIA_DATE,
+	VMETA_SESSION_FIELD_RUN_DATE,
+	VMETA_SESSION_FIELD_RUN_ID,
+	VMETA_SESSION_FIELD_BOOT_DATE,
+	VMETA_SESSION_FIELD_BOOT_ID,
+	VMETA_SESSION_FIELD_FLIGHT_DATE,
+	VMETA_SESSION_FIELD_FLIGHT_ID,
+	VMETA_SESSION_FIELD_CUSTOM_ID,
+	VMETA_SESSION_FIELD_PICTURE_FOV,
+	VMETA_SESSION_FIELD_CAMERA_TYPE,
+	VMETA_SESSION_FIELD_CAMERA_SUBTYPE,
+	VMETA_SESSION_FIELD_CAMERA_SPECTRUM,
+	VMETA_SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_CAMERA_MODEL,
+	VMETA_SESSION_FIELD_VIDEO_MODE,
+	VMETA_SESSION_FIELD_VIDEO_STOP_REASON,
+	VMETA_SESSION_FIELD_DYNAMIC_RANGE,
+	VMETA_SESSION_FIELD_TONE_MAPPING,
+	VMETA_SESSION_FIELD_THERMAL,
+	VMETA_SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	VMETA_SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX,
+	VMETA_SESSION_FIELD_MEDIA_ID,
+	VMETA_SESSION_FIELD_RESOURCE_INDEX,
+	VMETA_SESSION_FIELD_PRINCIPAL_POINT,
+};
+
+
+/* Order of the fields in vmeta_session_streaming_sdp_write(); the
+ * session-level only fields come first */
+static const enum vmeta_session_field_id s_sdp_order[] = {
+	VMETA_SESSION_FIELD_FRIENDLY_NAME,
+	VMETA_SESSION_FIELD_TITLE,
+	VMETA_SESSION_FIELD_SOFTWARE_VERSION,
+	VMETA_SESSION_FIELD_MAKER,
+	VMETA_SESSION_FIELD_MODEL,
+	VMETA_SESSION_FIELD_MODEL_ID,
+	VMETA_SESSION_FIELD_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_BUILD_ID,
+	VMETA_SESSION_FIELD_COMMENT,
+	VMETA_SESSION_FIELD_COPYRIGHT,
+	VMETA_SESSION_FIELD_MEDIA_DATE,
+	VMETA_SESSION_FIELD_RUN_DATE,
+	VMETA_SESSION_FIELD_RUN_ID,
+	VMETA_SESSION_FIELD_BOOT_DATE,
+	VMETA_SESSION_FIELD_BOOT_ID,
+	VMETA_SESSION_FIELD_FLIGHT_DATE,
+	VMETA_SESSION_FIELD_FLIGHT_ID,
+	VMETA_SESSION_FIELD_CUSTOM_ID,
+	VMETA_SESSION_FIELD_TAKEOFF_LOC,
+	VMETA_SESSION_FIELD_LOCATION,
+	VMETA_SESSION_FIELD_VIDEO_MODE,
+	VMETA_SESSION_FIELD_VIDEO_STOP_REASON,
+	VMETA_SESSION_FIELD_PICTURE_FOV,
+	VMETA_SESSION_FIELD_CAMERA_TYPE,
+	VMETA_SESSION_FIELD_CAMERA_SUBTYPE,
+	VMETA_SESSION_FIELD_CAMERA_SPECTRUM,
+	VMETA_SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_CAMERA_MODEL,
+	VMETA_SESSION_FIELD_DYNAMIC_RANGE,
+	VMETA_SESSION_FIELD_TONE_MAPPING,
+	VMETA_SESSION_FIELD_THERMAL,
+	VMETA_SESSION_FIELD_DEFAULT_MEDIA,
+	VMETA_SESSION_FIELD_PROTO_DELTA,
+	VMETA_SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	VMETA_SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX,
+	VMETA_SESSION_FIELD_MEDIA_ID,
+	VMETA_SESSION_FIELD_RESOURCE_INDEX,
+	VMETA_SESSION_FIELD_PRINCIPAL_POINT,
+};
+
+
+/* Order of the fields in vmeta_session_recording_write() */
+static const enum vmeta_session_field_id s_recording_order[] = {
+	VMETA_SESSION_FIELD_FRIENDLY_NAME,
+	VMETA_SESSION_FIELD_TITLE,
+	VMETA_SESSION_FIELD_COMMENT,
+	VMETA_SESSION_FIELD_COPYRIGHT,
+	VMETA_SESSION_FIELD_MEDIA_DATE,
+	VMETA_SESSION_FIELD_TAKEOFF_LOC,
+	VMETA_SESSION_FIELD_LOCATION,
+	VMETA_SESSION_FIELD_MAKER,
+	VMETA_SESSION_FIELD_MODEL,
+	VMETA_SESSION_FIELD_SOFTWARE_VERSION,
+	VMETA_SESSION_FIELD_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_MODEL_ID,
+	VMETA_SESSION_FIELD_BUILD_ID,
+	VMETA_SESSION_FIELD_RUN_DATE,
+	VMETA_SESSION_FIELD_RUN_ID,
+	VMETA_SESSION_FIELD_BOOT_DATE,
+	VMETA_SESSION_FIELD_BOOT_ID,
+	VMETA_SESSION_FIELD_FLIGHT_DATE,
+	VMETA_SESSION_FIELD_FLIGHT_ID,
+	VMETA_SESSION_FIELD_CUSTOM_ID,
+	VMETA_SESSION_FIELD_PICTURE_FOV,
+	VMETA_SESSION_FIELD_CAMERA_TYPE,
+	VMETA_SESSION_FIELD_CAMERA_SUBTYPE,
+	VMETA_SESSION_FIELD_CAMERA_SPECTRUM,
+	VMETA_SESSION_FIELD_CAMERA_SERIAL_NUMBER,
+	VMETA_SESSION_FIELD_CAMERA_MODEL,
+	VMETA_SESSION_FIELD_OVERLAY,
+	VMETA_SESSION_FIELD_VIDEO_MODE,
+	VMETA_SESSION_FIELD_VIDEO_STOP_REASON,
+	VMETA_SESSION_FIELD_DYNAMIC_RANGE,
+	VMETA_SESSION_FIELD_TONE_MAPPING,
+	VMETA_SESSION_FIELD_THERMAL,
+	VMETA_SESSION_FIELD_FIRST_FRAME_CAPTURE_TS,
+	VMETA_SESSION_FIELD_FIRST_FRAME_SAMPLE_INDEX,
+	VMETA_SESSION_FIELD_MEDIA_ID,
+	VMETA_SESSION_FIELD_RESOURCE_INDEX,
+	VMETA_SESSION_FIELD_PRINCIPAL_POINT,
+};
+
+
+/* Rendered item; the key (if any) and the value are stored in the slot
+ * string buffer */
+struct session_item {
+	int type;
+	int has_key;
+	size_t key_offset;
+	size_t value_offset;
+};
+
+
+/* Rendered items of a field for an output */
+struct session_slot {
+	struct session_item *items;
+	unsigned int count;
+	unsigned int size;
+	char *str;
+	size_t len;
+	size_t str_size;
+	int err;
+};
+
+
+struct vmeta_session_serialized {
+	/* Session metadata of the last update */
+	struct vmeta_session meta;
+
+	/* Rendering session metadata: only the field being rendered is set,
+	 * all other fields are zero */
+	struct vmeta_session render_meta;
+
+	/* Fields to render (bit index is enum vmeta_session_field_id) */
+	uint64_t dirty;
+
+	/* Slots of the joined fields are unused */
+	struct session_slot slots[SESSION_OUTPUT_COUNT]
+				 [VMETA_SESSION_FIELD_COUNT];
+};
+
+
+static const struct vmeta_session s_empty_meta;
+
+
+/* A field and the following joined fields (see struct
+ * vmeta_session_field_desc) are rendered together */
+static int session_unit_equal(enum vmeta_session_field_id id,
+			      const struct vmeta_session *meta1,
+			      const struct vmeta_session *meta2)
+{
+	do {
+		if (!vmeta_session_field_equal(
+			    &vmeta_session_fields[id], meta1, meta2))
+			return 0;
+		id++;
+	} while ((id < VMETA_SESSION_FIELD_COUNT) &&
+		 (vmeta_session_fields[id].joined));
+
+	return 1;
+}
+
+
+static void session_unit_copy(enum vmeta_session_field_id id,
+			      struct vmeta_session *dst,
+			      const struct vmeta_session *src)
+{
+	do {
+		vmeta_session_field_copy(&vmeta_session_fields[id], dst, src);
+		id++;
+	} while ((id < VMETA_SESSION_FIELD_COUNT) &&
+		 (vmeta_session_fields[id].joined));
+}
+
+
+static int slot_append_str(struct session_slot *slot, const char *str)
+{
+	size_t len = strlen(str) + 1;
+
+	if (slot->len + len > slot->str_size) {
+		size_t size = 2 * (slot->len + len);
+		char *tmp = realloc(slot->str, size);
+		if (tmp == NULL)
+			return -ENOMEM;
+		slot->str = tmp;
+		slot->str_size = size;
+	}
+	memcpy(slot->str + slot->len, str, len);
+	slot->len += len;
+
+	return 0;
+}
+
+
+static void slot_add(struct session_slot *slot,
+		     int type,
+		     const char *key,
+		     const char *value)
+{
+	int res;
+	struct session_item *item;
+
+	if (slot->err != 0)
+		return;
+
+	if (slot->count == slot->size) {
+		unsigned int size = (slot->size == 0) ? 2 : 2 * slot->size;
+		item = realloc(slot->items, size * sizeof(*item));
+		if (item == NULL) {
+			slot->err = -ENOMEM;
+			return;
+		}
+		slot->items = item;
+		slot->size = size;
+	}
+
+	item = &slot->items[slot->count];
+	item->type = type;
+	item->has_key = (key != NULL);
+	item->key_offset = slot->len;
+	if (key != NULL) {
+		res = slot_append_str(slot, key);
+		if (res < 0) {
+			slot->err = res;
+			return;
+		}
+	}
+	item->value_offset = slot->len;
+	res = slot_append_str(slot, value);
+	if (res < 0) {
+		slot->err = res;
+		return;
+	}
+	slot->count++;
+}
+
+
+static void slot_sdes_cb(enum vmeta_stream_sdes_type type,
+			 const char *value,
+			 const char *prefix,
+			 void *userdata)
+{
+	slot_add(userdata, type, prefix, value);
+}
+
+
+static void slot_sdp_cb(enum vmeta_stream_sdp_type type,
+			const char *value,
+			const char *key,
+			void *userdata)
+{
+	slot_add(userdata, type, key, value);
+}
+
+
+static void slot_recording_cb(enum vmeta_record_type type,
+			      const char *key,
+			      const char *value,
+			      void *userdata)
+{
+	slot_add(userdata, type, key, value);
+}
+
+
+/* Render the items of a field using the regular writing functions on a
+ * session metadata structure where only this field is set */
+static int session_unit_render(struct vmeta_session_serialized *ser,
+			       enum vmeta_session_field_id id)
+{
+	int res = 0;
+	struct session_slot *slot;
+
+	session_unit_copy(id, &ser->render_meta, &ser->meta);
+
+	for (unsigned int i = 0; i < SESSION_OUTPUT_COUNT; i++) {
+		slot = &ser->slots[i][id];
+		slot->count = 0;
+		slot->len = 0;
+		slot->err = 0;
+		switch (i) {
+		case SESSION_OUTPUT_SDES:
+			vmeta_session_streaming_sdes_write(
+				&ser->render_meta, &slot_sdes_cb, slot);
+			break;
+		case SESSION_OUTPUT_SDP_SESSION:
+			vmeta_session_streaming_sdp_write(
+				&ser->render_meta, 0, &slot_sdp_cb, slot);
+			break;
+		case SESSION_OUTPUT_SDP_MEDIA:
+			vmeta_session_streaming_sdp_write(
+				&ser->render_meta, 1, &slot_sdp_cb, slot);
+			break;
+		case SESSION_OUTPUT_RECORDING:
+			vmeta_session_recording_write(
+				&ser->render_meta, &slot_recording_cb, slot);
+			break;
+		default:
+			break;
+		}
+		if (slot->err != 0) {
+			/* Leave the slot empty until the next update */
+			res = slot->err;
+			slot->count = 0;
+		}
+	}
+
+	session_unit_copy(id, &ser->render_meta, &s_empty_meta);
+
+	return res;
+}
+
+
+int vmeta_session_serialized_new(struct vmeta_session_serialized **ret_obj)
+{
+	struct vmeta_session_serialized *ser;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	ser = calloc(1, sizeof(*ser));
+	if (ser == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	*ret_obj = ser;
+	return 0;
+}
+
+
+int vmeta_session_serialized_destroy(struct vmeta_session_serialized *ser)
+{
+	if (ser == NULL)
+		return 0;
+
+	for (unsigned int i = 0; i < SESSION_OUTPUT_COUNT; i++) {
+		for (unsigned int j = 0; j < VMETA_SESSION_FIELD_COUNT; j++) {
+			free(ser->slots[i][j].items);
+			free(ser->slots[i][j].str);
+		}
+	}
+	free(ser);
+
+	return 0;
+}
+
+
+int vmeta_session_serialized_update(struct vmeta_session_serialized *ser,
+				    const struct vmeta_session *meta)
+{
+	int res, err = 0, count = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ser == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+
+	for (unsigned int i = 0; i < VMETA_SESSION_FIELD_COUNT; i++) {
+		if (vmeta_session_fields[i].joined)
+			continue;
+		if (session_unit_equal(i, &ser->meta, meta))
+			continue;
+		session_unit_copy(i, &ser->meta, meta);
+		ser->dirty |= UINT64_C(1) << i;
+	}
+
+	for (unsigned int i = 0; i < VMETA_SESSION_FIELD_COUNT; i++) {
+		if (!(ser->dirty & (UINT64_C(1) << i)))
+			continue;
+		res = session_unit_render(ser, i);
+		if (res < 0) {
+			/* Keep the field dirty to render it again on the
+			 * next update */
+			err = res;
+			continue;
+		}
+		ser->dirty &= ~(UINT64_C(1) << i);
+		count++;
+	}
+
+	if (err < 0) {
+		ULOG_ERRNO("session_unit_render", -err);
+		return err;
+	}
+
+	return count;
+}
+
+
+int vmeta_session_serialized_sdes_write(
+	const struct vmeta_session_serialized *ser,
+	vmeta_session_streaming_sdes_write_cb_t cb,
+	void *userdata)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(ser == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(cb == NULL, EINVAL);
+
+	for (unsigned int i = 0; i < SIZEOF_ARRAY(s_sdes_order); i++) {
+		const struct session_slot *slot =
+			&ser->slots[SESSION_OUTPUT_SDES][s_sdes_order[i]];
+		for (unsigned int j = 0; j < slot->count; j++) {
+			const struct session_item *item = &slot->items[j];
+			(*cb)(item->type,
+			      slot->str + item->value_offset,
+			      item->has_key ? slot->str + item->key_offset
+					    : NULL,
+			      userdata);
+		}
+	}
+
+	return 0;
+}
+
+
+int vmeta_session_serialized_sdp_write(
+	const struct vmeta_session_serialized *ser,
+	int media_level,
+	vmeta_session_streaming_sdp_write_cb_t cb,
+	void *userdata)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(ser == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(cb == NULL, EINVAL);
+
+	enum session_output output = media_level ? SESSION_OUTPUT_SDP_MEDIA
+						 : SESSION_OUTPUT_SDP_SESSION;
+
+	for (unsigned int i = 0; i < SIZEOF_ARRAY(s_sdp_order); i++) {
+		const struct session_slot *slot =
+			&ser->slots[output][s_sdp_order[i]];
+		for (unsigned int j = 0; j < slot->count; j++) {
+			const struct session_item *item = &slot->items[j];
+			(*cb)(item->type,
+			      slot->str + item->value_offset,
+			      item->has_key ? slot->str + item->key_offset
+					    : NULL,
+			      userdata);
+		}
+	}
+
+	return 0;
+}
+
+
+int vmeta_session_serialized_recording_write(
+	const struct vmeta_session_serialized *ser,
+	vmeta_session_recording_write_cb_t cb,
+	void *userdata)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(ser == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(cb == NULL, EINVAL);
+
+	for (unsigned int i = 0; i < SIZEOF_ARRAY(s_recording_order); i++) {
+		const struct session_slot *slot =
+			&ser->slots[SESSION_OUTPUT_RECORDING]
+				   [s_recording_order[i]];
+		for (unsigned int j = 0; j < slot->count; j++) {
+			const struct session_item *item = &slot->items[j];
+			(*cb)(item->type,
+			      slot->str + item->key_offset,
+			      slot->str + item->value_offset,
+			      userdata);
+		}
+	}
+
+	return 0;
+}
@@ -202,8 +202,79 @@ int vmeta_hash_joaat_str(const char *str, uint32_t *hash)
 }
 
 
-int vmeta_frame_get_location(struct vmeta_frame *meta,
-			     struct vmeta_location *loc)
+/* Final mix of the hashes (MurmurHash3 fmix64) */
+static inline uint64_t hash_fmix64(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xff51afd7ed558ccd);
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+	hash ^= hash >> 33;
+	return hash;
+}
+
+
+uint64_t vmeta_hash64(const void *data, size_t len, uint64_t seed)
+{
+	const uint8_t *p = data;
+	uint64_t hash = (seed ^ len) * UINT64_C(0x9e3779b97f4a7c15);
+	uint64_t word;
+
+	hash ^= hash >> 32;
+
+	while (len >= sizeof(word)) {
+		memcpy(&word, p, sizeof(word));
+		hash = (hash ^ word) * UINT64_C(0xff51afd7ed558ccd);
+		hash ^= hash >> 32;
+		p += sizeof(word);
+		len -= sizeof(word);
+	}
+	if (len > 0) {
+		word = 0;
+		memcpy(&word, p, len);
+		hash = (hash ^ word) * UINT64_C(0xff51afd7ed558ccd);
+		hash ^= hash >> 32;
+	}
+
+	return hash_fmix64(hash);
+}
+
+
+void vmeta_hash128(const void *data, size_t len, uint64_t hash[2])
+{
+	const uint8_t *p = data;
+	uint64_t h1 = (hash[0] ^ len) * UINT64_C(0x9e3779b97f4a7c15);
+	uint64_t h2 = (hash[1] ^ len) * UINT64_C(0xc2b2ae3d27d4eb4f);
+	uint64_t word;
+
+	h1 ^= h1 >> 32;
+	h2 ^= h2 >> 29;
+
+	/* Two independent lanes, with different multipliers and a rotated
+	 * input in the second one */
+	while (len > 0) {
+		size_t n = (len < sizeof(word)) ? len : sizeof(word);
+		word = 0;
+		memcpy(&word, p, n);
+		h1 = (h1 ^ word) * UINT64_C(0xff51afd7ed558ccd);
+		h1 ^= h1 >> 32;
+		h2 = (h2 ^ ((word << 31) | (word >> 33))) *
+		     UINT64_C(0x87c37b91114253d5);
+		h2 ^= h2 >> 29;
+		p += n;
+		len -= n;
+	}
+
+	h1 = hash_fmix64(h1);
+	h2 = hash_fmix64(h2);
+	hash[0] = h1 + h2;
+	hash[1] = h2 + hash[0];
+}
+
+
+static int vmeta_frame_get_location_view(struct vmeta_frame *meta,
+					 struct vmeta_frame_proto_view *view,
+					 struct vmeta_location *loc)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -234,12 +305,13 @@ int vmeta_frame_get_location(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone || !tm->drone->location) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		loc->altitude_wgs84ellipsoid =
@@ -257,7 +329,7 @@ int vmeta_frame_get_location(struct vmeta_frame *meta,
 		loc->vertical_accuracy = tm->drone->location->vertical_accuracy;
 		loc->sv_count = tm->drone->location->sv_count;
 		loc->valid = 1;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -272,7 +344,19 @@ int vmeta_frame_get_location(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_speed_ned(struct vmeta_frame *meta, struct vmeta_ned *speed)
+int vmeta_frame_get_location(struct vmeta_frame *meta,
+			     struct vmeta_location *loc)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_location_view(meta, &view, loc);
+}
+
+
+static int vmeta_frame_get_speed_ned_view(struct vmeta_frame *meta,
+					  struct vmeta_frame_proto_view *view,
+					  struct vmeta_ned *speed)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -309,18 +393,19 @@ int vmeta_frame_get_speed_ned(struct vmeta_frame *meta, struct vmeta_ned *speed)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone || !tm->drone->speed) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		speed->north = tm->drone->speed->north;
 		speed->east = tm->drone->speed->east;
 		speed->down = tm->drone->speed->down;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -333,6 +418,15 @@ int vmeta_frame_get_speed_ned(struct vmeta_frame *meta, struct vmeta_ned *speed)
 }
 
 
+int vmeta_frame_get_speed_ned(struct vmeta_frame *meta, struct vmeta_ned *speed)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_speed_ned_view(meta, &view, speed);
+}
+
+
 int vmeta_frame_get_air_speed(struct vmeta_frame *meta, float *speed)
 {
 	int res = 0;
@@ -370,7 +464,10 @@ int vmeta_frame_get_air_speed(struct vmeta_frame *meta, float *speed)
 }
 
 
-int vmeta_frame_get_ground_distance(struct vmeta_frame *meta, double *dist)
+static int
+vmeta_frame_get_ground_distance_view(struct vmeta_frame *meta,
+				     struct vmeta_frame_proto_view *view,
+				     double *dist)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -401,16 +498,17 @@ int vmeta_frame_get_ground_distance(struct vmeta_frame *meta, double *dist)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*dist = tm->drone->ground_distance;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -423,8 +521,19 @@ int vmeta_frame_get_ground_distance(struct vmeta_frame *meta, double *dist)
 }
 
 
-int vmeta_frame_get_altitude_above_takeoff(struct vmeta_frame *meta,
-					   double *alt)
+int vmeta_frame_get_ground_distance(struct vmeta_frame *meta, double *dist)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_ground_distance_view(meta, &view, dist);
+}
+
+
+static int
+vmeta_frame_get_altitude_above_takeoff_view(struct vmeta_frame *meta,
+					    struct vmeta_frame_proto_view *view,
+					    double *alt)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -443,16 +552,17 @@ int vmeta_frame_get_altitude_above_takeoff(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone || isnan(tm->drone->altitude_ato)) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*alt = tm->drone->altitude_ato;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -465,11 +575,22 @@ int vmeta_frame_get_altitude_above_takeoff(struct vmeta_frame *meta,
 }
 
 
+int vmeta_frame_get_altitude_above_takeoff(struct vmeta_frame *meta,
+					   double *alt)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_altitude_above_takeoff_view(meta, &view, alt);
+}
+
+
 int vmeta_frame_get_drone_euler(struct vmeta_frame *meta,
 				struct vmeta_euler *euler)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	struct vmeta_quaternion tmp;
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(euler == NULL, EINVAL);
@@ -501,12 +622,13 @@ int vmeta_frame_get_drone_euler(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone || !tm->drone->quat) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		tmp.w = tm->drone->quat->w;
@@ -514,7 +636,7 @@ int vmeta_frame_get_drone_euler(struct vmeta_frame *meta,
 		tmp.y = tm->drone->quat->y;
 		tmp.z = tm->drone->quat->z;
 		vmeta_quat_to_euler(&tmp, euler);
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
@@ -527,8 +649,9 @@ int vmeta_frame_get_drone_euler(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_drone_quat(struct vmeta_frame *meta,
-			       struct vmeta_quaternion *quat)
+static int vmeta_frame_get_drone_quat_view(struct vmeta_frame *meta,
+					   struct vmeta_frame_proto_view *view,
+					   struct vmeta_quaternion *quat)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -562,19 +685,20 @@ int vmeta_frame_get_drone_quat(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone || !tm->drone->quat) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		quat->w = tm->drone->quat->w;
 		quat->x = tm->drone->quat->x;
 		quat->y = tm->drone->quat->y;
 		quat->z = tm->drone->quat->z;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -587,11 +711,22 @@ int vmeta_frame_get_drone_quat(struct vmeta_frame *meta,
 }
 
 
+int vmeta_frame_get_drone_quat(struct vmeta_frame *meta,
+			       struct vmeta_quaternion *quat)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_drone_quat_view(meta, &view, quat);
+}
+
+
 int vmeta_frame_get_frame_euler(struct vmeta_frame *meta,
 				struct vmeta_euler *euler)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	struct vmeta_quaternion tmp;
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(euler == NULL, EINVAL);
@@ -623,12 +758,13 @@ int vmeta_frame_get_frame_euler(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || !tm->camera->quat) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		tmp.w = tm->camera->quat->w;
@@ -636,7 +772,7 @@ int vmeta_frame_get_frame_euler(struct vmeta_frame *meta,
 		tmp.y = tm->camera->quat->y;
 		tmp.z = tm->camera->quat->z;
 		vmeta_quat_to_euler(&tmp, euler);
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
@@ -649,8 +785,9 @@ int vmeta_frame_get_frame_euler(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_frame_quat(struct vmeta_frame *meta,
-			       struct vmeta_quaternion *quat)
+static int vmeta_frame_get_frame_quat_view(struct vmeta_frame *meta,
+					   struct vmeta_frame_proto_view *view,
+					   struct vmeta_quaternion *quat)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -684,19 +821,20 @@ int vmeta_frame_get_frame_quat(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || !tm->camera->quat) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		quat->w = tm->camera->quat->w;
 		quat->x = tm->camera->quat->x;
 		quat->y = tm->camera->quat->y;
 		quat->z = tm->camera->quat->z;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -709,11 +847,22 @@ int vmeta_frame_get_frame_quat(struct vmeta_frame *meta,
 }
 
 
+int vmeta_frame_get_frame_quat(struct vmeta_frame *meta,
+			       struct vmeta_quaternion *quat)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_frame_quat_view(meta, &view, quat);
+}
+
+
 int vmeta_frame_get_frame_local_quat(struct vmeta_frame *meta,
 				     struct vmeta_quaternion *local_quat)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(local_quat == NULL, EINVAL);
 	memset(local_quat, 0, sizeof(*local_quat));
@@ -729,19 +878,20 @@ int vmeta_frame_get_frame_local_quat(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || !tm->camera->local_quat) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		local_quat->w = tm->camera->local_quat->w;
 		local_quat->x = tm->camera->local_quat->x;
 		local_quat->y = tm->camera->local_quat->y;
 		local_quat->z = tm->camera->local_quat->z;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
@@ -759,6 +909,7 @@ int vmeta_frame_get_frame_base_euler(struct vmeta_frame *meta,
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	struct vmeta_quaternion tmp;
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(euler == NULL, EINVAL);
@@ -778,12 +929,13 @@ int vmeta_frame_get_frame_base_euler(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || !tm->camera->base_quat) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		tmp.w = tm->camera->base_quat->w;
@@ -791,7 +943,7 @@ int vmeta_frame_get_frame_base_euler(struct vmeta_frame *meta,
 		tmp.y = tm->camera->base_quat->y;
 		tmp.z = tm->camera->base_quat->z;
 		vmeta_quat_to_euler(&tmp, euler);
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
@@ -804,8 +956,10 @@ int vmeta_frame_get_frame_base_euler(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_frame_base_quat(struct vmeta_frame *meta,
-				    struct vmeta_quaternion *quat)
+static int
+vmeta_frame_get_frame_base_quat_view(struct vmeta_frame *meta,
+				     struct vmeta_frame_proto_view *view,
+				     struct vmeta_quaternion *quat)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -827,19 +981,20 @@ int vmeta_frame_get_frame_base_quat(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || !tm->camera->base_quat) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		quat->w = tm->camera->base_quat->w;
 		quat->x = tm->camera->base_quat->x;
 		quat->y = tm->camera->base_quat->y;
 		quat->z = tm->camera->base_quat->z;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -852,8 +1007,20 @@ int vmeta_frame_get_frame_base_quat(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_frame_utc_timestamp(struct vmeta_frame *meta,
-					uint64_t *timestamp)
+int vmeta_frame_get_frame_base_quat(struct vmeta_frame *meta,
+				    struct vmeta_quaternion *quat)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_frame_base_quat_view(meta, &view, quat);
+}
+
+
+static int
+vmeta_frame_get_frame_utc_timestamp_view(struct vmeta_frame *meta,
+					 struct vmeta_frame_proto_view *view,
+					 uint64_t *timestamp)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -871,16 +1038,17 @@ int vmeta_frame_get_frame_utc_timestamp(struct vmeta_frame *meta,
 		res = -ENOENT;
 		break;
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*timestamp = tm->camera->utc_timestamp;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -895,8 +1063,20 @@ int vmeta_frame_get_frame_utc_timestamp(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_frame_timestamp(struct vmeta_frame *meta,
-				    uint64_t *timestamp)
+int vmeta_frame_get_frame_utc_timestamp(struct vmeta_frame *meta,
+					uint64_t *timestamp)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_frame_utc_timestamp_view(meta, &view, timestamp);
+}
+
+
+static int
+vmeta_frame_get_frame_timestamp_view(struct vmeta_frame *meta,
+				     struct vmeta_frame_proto_view *view,
+				     uint64_t *timestamp)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -930,16 +1110,17 @@ int vmeta_frame_get_frame_timestamp(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*timestamp = tm->camera->timestamp;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -954,11 +1135,22 @@ int vmeta_frame_get_frame_timestamp(struct vmeta_frame *meta,
 }
 
 
+int vmeta_frame_get_frame_timestamp(struct vmeta_frame *meta,
+				    uint64_t *timestamp)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_frame_timestamp_view(meta, &view, timestamp);
+}
+
+
 int vmeta_frame_get_camera_location(struct vmeta_frame *meta,
 				    struct vmeta_location *loc)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(loc == NULL, EINVAL);
 	memset(loc, 0, sizeof(*loc));
@@ -974,12 +1166,13 @@ int vmeta_frame_get_camera_location(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || !tm->camera->location) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		loc->altitude_wgs84ellipsoid =
@@ -998,7 +1191,7 @@ int vmeta_frame_get_camera_location(struct vmeta_frame *meta,
 			tm->camera->location->vertical_accuracy;
 		loc->sv_count = tm->camera->location->sv_count;
 		loc->valid = 1;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
@@ -1018,6 +1211,7 @@ int vmeta_frame_get_camera_principal_point(struct vmeta_frame *meta,
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(vec == NULL, EINVAL);
 	memset(vec, 0, sizeof(*vec));
@@ -1033,17 +1227,18 @@ int vmeta_frame_get_camera_principal_point(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || !tm->camera->principal_point) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		vec->x = tm->camera->principal_point->x;
 		vec->y = tm->camera->principal_point->y;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
@@ -1136,7 +1331,10 @@ int vmeta_frame_get_camera_tilt(struct vmeta_frame *meta, float *tilt)
 }
 
 
-int vmeta_frame_get_exposure_time(struct vmeta_frame *meta, float *exp)
+static int
+vmeta_frame_get_exposure_time_view(struct vmeta_frame *meta,
+				   struct vmeta_frame_proto_view *view,
+				   float *exp)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1170,16 +1368,17 @@ int vmeta_frame_get_exposure_time(struct vmeta_frame *meta, float *exp)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*exp = tm->camera->exposure_time;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1192,7 +1391,18 @@ int vmeta_frame_get_exposure_time(struct vmeta_frame *meta, float *exp)
 }
 
 
-int vmeta_frame_get_gain(struct vmeta_frame *meta, uint16_t *gain)
+int vmeta_frame_get_exposure_time(struct vmeta_frame *meta, float *exp)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_exposure_time_view(meta, &view, exp);
+}
+
+
+static int vmeta_frame_get_gain_view(struct vmeta_frame *meta,
+				     struct vmeta_frame_proto_view *view,
+				     uint16_t *gain)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1226,16 +1436,17 @@ int vmeta_frame_get_gain(struct vmeta_frame *meta, uint16_t *gain)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*gain = tm->camera->iso_gain;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1248,7 +1459,18 @@ int vmeta_frame_get_gain(struct vmeta_frame *meta, uint16_t *gain)
 }
 
 
-int vmeta_frame_get_awb_r_gain(struct vmeta_frame *meta, float *gain)
+int vmeta_frame_get_gain(struct vmeta_frame *meta, uint16_t *gain)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_gain_view(meta, &view, gain);
+}
+
+
+static int vmeta_frame_get_awb_r_gain_view(struct vmeta_frame *meta,
+					   struct vmeta_frame_proto_view *view,
+					   float *gain)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1270,16 +1492,17 @@ int vmeta_frame_get_awb_r_gain(struct vmeta_frame *meta, float *gain)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*gain = tm->camera->awb_r_gain;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1292,7 +1515,18 @@ int vmeta_frame_get_awb_r_gain(struct vmeta_frame *meta, float *gain)
 }
 
 
-int vmeta_frame_get_awb_b_gain(struct vmeta_frame *meta, float *gain)
+int vmeta_frame_get_awb_r_gain(struct vmeta_frame *meta, float *gain)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_awb_r_gain_view(meta, &view, gain);
+}
+
+
+static int vmeta_frame_get_awb_b_gain_view(struct vmeta_frame *meta,
+					   struct vmeta_frame_proto_view *view,
+					   float *gain)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1314,16 +1548,17 @@ int vmeta_frame_get_awb_b_gain(struct vmeta_frame *meta, float *gain)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*gain = tm->camera->awb_b_gain;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1336,7 +1571,19 @@ int vmeta_frame_get_awb_b_gain(struct vmeta_frame *meta, float *gain)
 }
 
 
-int vmeta_frame_get_picture_h_fov(struct vmeta_frame *meta, float *fov)
+int vmeta_frame_get_awb_b_gain(struct vmeta_frame *meta, float *gain)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_awb_b_gain_view(meta, &view, gain);
+}
+
+
+static int
+vmeta_frame_get_picture_h_fov_view(struct vmeta_frame *meta,
+				   struct vmeta_frame_proto_view *view,
+				   float *fov)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1358,16 +1605,17 @@ int vmeta_frame_get_picture_h_fov(struct vmeta_frame *meta, float *fov)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*fov = tm->camera->hfov * 180. / M_PI;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1380,7 +1628,19 @@ int vmeta_frame_get_picture_h_fov(struct vmeta_frame *meta, float *fov)
 }
 
 
-int vmeta_frame_get_picture_v_fov(struct vmeta_frame *meta, float *fov)
+int vmeta_frame_get_picture_h_fov(struct vmeta_frame *meta, float *fov)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_picture_h_fov_view(meta, &view, fov);
+}
+
+
+static int
+vmeta_frame_get_picture_v_fov_view(struct vmeta_frame *meta,
+				   struct vmeta_frame_proto_view *view,
+				   float *fov)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1402,16 +1662,17 @@ int vmeta_frame_get_picture_v_fov(struct vmeta_frame *meta, float *fov)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*fov = tm->camera->vfov * 180. / M_PI;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1424,8 +1685,19 @@ int vmeta_frame_get_picture_v_fov(struct vmeta_frame *meta, float *fov)
 }
 
 
-int vmeta_frame_get_camera_zoom_level(struct vmeta_frame *meta,
-				      float *zoom_level)
+int vmeta_frame_get_picture_v_fov(struct vmeta_frame *meta, float *fov)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_picture_v_fov_view(meta, &view, fov);
+}
+
+
+static int
+vmeta_frame_get_camera_zoom_level_view(struct vmeta_frame *meta,
+				       struct vmeta_frame_proto_view *view,
+				       float *zoom_level)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1444,16 +1716,17 @@ int vmeta_frame_get_camera_zoom_level(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera || isnan(tm->camera->zoom_level)) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*zoom_level = tm->camera->zoom_level;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1466,7 +1739,20 @@ int vmeta_frame_get_camera_zoom_level(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_link_goodput(struct vmeta_frame *meta, uint32_t *goodput)
+int vmeta_frame_get_camera_zoom_level(struct vmeta_frame *meta,
+				      float *zoom_level)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_camera_zoom_level_view(meta, &view, zoom_level);
+}
+
+
+static int
+vmeta_frame_get_link_goodput_view(struct vmeta_frame *meta,
+				  struct vmeta_frame_proto_view *view,
+				  uint32_t *goodput)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1489,30 +1775,31 @@ int vmeta_frame_get_link_goodput(struct vmeta_frame *meta, uint32_t *goodput)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_LINKS, view, &tm);
 		if (res < 0)
 			break;
 		if (tm->n_links == 0) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		if (tm->n_links > 1) {
 			/* Only take into account the first link (there
 			 * should not be more than one) */
 			res = -EPROTO;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		link = tm->links[0];
 		if (link->protocol_case !=
 		    VMETA__LINK_METADATA__PROTOCOL_WIFI) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*goodput = link->wifi->goodput;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1525,7 +1812,19 @@ int vmeta_frame_get_link_goodput(struct vmeta_frame *meta, uint32_t *goodput)
 }
 
 
-int vmeta_frame_get_link_quality(struct vmeta_frame *meta, uint8_t *quality)
+int vmeta_frame_get_link_goodput(struct vmeta_frame *meta, uint32_t *goodput)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_link_goodput_view(meta, &view, goodput);
+}
+
+
+static int
+vmeta_frame_get_link_quality_view(struct vmeta_frame *meta,
+				  struct vmeta_frame_proto_view *view,
+				  uint8_t *quality)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1548,19 +1847,20 @@ int vmeta_frame_get_link_quality(struct vmeta_frame *meta, uint8_t *quality)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_LINKS, view, &tm);
 		if (res < 0)
 			break;
 		if (tm->n_links == 0) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		if (tm->n_links > 1) {
 			/* Only take into account the first link (there
 			 * should not be more than one) */
 			res = -EPROTO;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		link = tm->links[0];
@@ -1575,7 +1875,7 @@ int vmeta_frame_get_link_quality(struct vmeta_frame *meta, uint8_t *quality)
 			res = -ENOENT;
 			break;
 		}
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1588,7 +1888,18 @@ int vmeta_frame_get_link_quality(struct vmeta_frame *meta, uint8_t *quality)
 }
 
 
-int vmeta_frame_get_wifi_rssi(struct vmeta_frame *meta, int8_t *rssi)
+int vmeta_frame_get_link_quality(struct vmeta_frame *meta, uint8_t *quality)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_link_quality_view(meta, &view, quality);
+}
+
+
+static int vmeta_frame_get_wifi_rssi_view(struct vmeta_frame *meta,
+					  struct vmeta_frame_proto_view *view,
+					  int8_t *rssi)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1623,30 +1934,31 @@ int vmeta_frame_get_wifi_rssi(struct vmeta_frame *meta, int8_t *rssi)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_LINKS, view, &tm);
 		if (res < 0)
 			break;
 		if (tm->n_links == 0) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		if (tm->n_links > 1) {
 			/* Only take into account the first link (there
 			 * should not be more than one) */
 			res = -EPROTO;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		link = tm->links[0];
 		if (link->protocol_case !=
 		    VMETA__LINK_METADATA__PROTOCOL_WIFI) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*rssi = link->wifi->rssi;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1659,7 +1971,19 @@ int vmeta_frame_get_wifi_rssi(struct vmeta_frame *meta, int8_t *rssi)
 }
 
 
-int vmeta_frame_get_battery_percentage(struct vmeta_frame *meta, uint8_t *bat)
+int vmeta_frame_get_wifi_rssi(struct vmeta_frame *meta, int8_t *rssi)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_wifi_rssi_view(meta, &view, rssi);
+}
+
+
+static int
+vmeta_frame_get_battery_percentage_view(struct vmeta_frame *meta,
+					struct vmeta_frame_proto_view *view,
+					uint8_t *bat)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1693,16 +2017,17 @@ int vmeta_frame_get_battery_percentage(struct vmeta_frame *meta, uint8_t *bat)
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*bat = tm->drone->battery_percentage;
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1715,8 +2040,19 @@ int vmeta_frame_get_battery_percentage(struct vmeta_frame *meta, uint8_t *bat)
 }
 
 
-int vmeta_frame_get_flying_state(struct vmeta_frame *meta,
-				 enum vmeta_flying_state *state)
+int vmeta_frame_get_battery_percentage(struct vmeta_frame *meta, uint8_t *bat)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_battery_percentage_view(meta, &view, bat);
+}
+
+
+static int
+vmeta_frame_get_flying_state_view(struct vmeta_frame *meta,
+				  struct vmeta_frame_proto_view *view,
+				  enum vmeta_flying_state *state)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -1747,17 +2083,18 @@ int vmeta_frame_get_flying_state(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*state = vmeta_frame_flying_state_proto_to_vmeta(
 			tm->drone->flying_state);
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -1770,11 +2107,22 @@ int vmeta_frame_get_flying_state(struct vmeta_frame *meta,
 }
 
 
+int vmeta_frame_get_flying_state(struct vmeta_frame *meta,
+				 enum vmeta_flying_state *state)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_flying_state_view(meta, &view, state);
+}
+
+
 int vmeta_frame_get_camera_spectrum(struct vmeta_frame *meta,
 				    enum vmeta_camera_spectrum *spectrum)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(spectrum == NULL, EINVAL);
 	*spectrum = VMETA_CAMERA_SPECTRUM_UNKNOWN;
@@ -1790,17 +2138,18 @@ int vmeta_frame_get_camera_spectrum(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		*spectrum = vmeta_frame_camera_spectrum_proto_to_vmeta(
 			tm->camera->spectrum);
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
@@ -2193,8 +2542,10 @@ int vmeta_frame_get_tracking_box(struct vmeta_frame *meta,
 }
 
 
-int vmeta_frame_get_piloting_mode(struct vmeta_frame *meta,
-				  enum vmeta_piloting_mode *mode)
+static int
+vmeta_frame_get_piloting_mode_view(struct vmeta_frame *meta,
+				   struct vmeta_frame_proto_view *view,
+				   enum vmeta_piloting_mode *mode)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
@@ -2225,17 +2576,18 @@ int vmeta_frame_get_piloting_mode(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_DRONE, view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->drone) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, view, tm);
 			break;
 		}
 		*mode = vmeta_frame_piloting_mode_proto_to_vmeta(
 			tm->drone->piloting_mode);
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, view, tm);
 		break;
 
 	default:
@@ -2248,11 +2600,127 @@ int vmeta_frame_get_piloting_mode(struct vmeta_frame *meta,
 }
 
 
+int vmeta_frame_get_piloting_mode(struct vmeta_frame *meta,
+				  enum vmeta_piloting_mode *mode)
+{
+	struct vmeta_frame_proto_view view;
+
+	view.held = NULL;
+	return vmeta_frame_get_piloting_mode_view(meta, &view, mode);
+}
+
+
+/* Fields of the protobuf-based metadata drone and camera parts */
+#define VMETA_FRAME_FIELDS_DRONE                                               \
+	(VMETA_FRAME_FIELD_LOCATION | VMETA_FRAME_FIELD_SPEED_NED |            \
+	 VMETA_FRAME_FIELD_GROUND_DISTANCE | VMETA_FRAME_FIELD_ALTITUDE_ATO |  \
+	 VMETA_FRAME_FIELD_DRONE_QUAT | VMETA_FRAME_FIELD_BATTERY_PERCENTAGE | \
+	 VMETA_FRAME_FIELD_FLYING_STATE | VMETA_FRAME_FIELD_PILOTING_MODE)
+#define VMETA_FRAME_FIELDS_LINKS                                               \
+	(VMETA_FRAME_FIELD_LINK_GOODPUT | VMETA_FRAME_FIELD_LINK_QUALITY |     \
+	 VMETA_FRAME_FIELD_WIFI_RSSI)
+#define VMETA_FRAME_FIELDS_CAMERA                                              \
+	(VMETA_FRAME_FIELD_ALL &                                               \
+	 ~(VMETA_FRAME_FIELDS_DRONE | VMETA_FRAME_FIELDS_LINKS))
+
+
+/* Get a field with its getter, using the meta, view, mask and out variables
+ * of vmeta_frame_get_fields() */
+#define VMETA_FRAME_GET_FIELD(_field, _name, _member)                          \
+	do {                                                                   \
+		if ((mask & VMETA_FRAME_FIELD_##_field) &&                     \
+		    vmeta_frame_get_##_name##_view(                            \
+			    meta, &view, &out->_member) == 0)                  \
+			out->present |= VMETA_FRAME_FIELD_##_field;            \
+	} while (0)
+
+
+int vmeta_frame_get_fields(struct vmeta_frame *meta,
+			   uint32_t mask,
+			   struct vmeta_frame_flat *out)
+{
+	int res;
+	unsigned int parts = 0;
+	const Vmeta__TimedMetadata *tm = NULL;
+	struct vmeta_frame_proto_view view;
+	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out == NULL, EINVAL);
+	memset(out, 0, sizeof(*out));
+	view.held = NULL;
+
+	switch (meta->type) {
+	case VMETA_FRAME_TYPE_NONE:
+	case VMETA_FRAME_TYPE_V1_STREAMING_BASIC:
+	case VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED:
+	case VMETA_FRAME_TYPE_V1_RECORDING:
+	case VMETA_FRAME_TYPE_V2:
+	case VMETA_FRAME_TYPE_V3:
+		break;
+
+	case VMETA_FRAME_TYPE_PROTO:
+		/* Get the metadata only once for all the getters */
+		if (mask & VMETA_FRAME_FIELDS_DRONE)
+			parts |= VMETA_FRAME_PROTO_VIEW_DRONE;
+		if (mask & VMETA_FRAME_FIELDS_CAMERA)
+			parts |= VMETA_FRAME_PROTO_VIEW_CAMERA;
+		if (mask & VMETA_FRAME_FIELDS_LINKS)
+			parts |= VMETA_FRAME_PROTO_VIEW_LINKS;
+		if (parts == 0)
+			return 0;
+		res = vmeta_frame_proto_get_view(meta, parts, &view, &tm);
+		if (res < 0)
+			return res;
+		view.held = tm;
+		break;
+
+	default:
+		ULOGE("unknown metadata type: %u", meta->type);
+		return -ENOSYS;
+	}
+
+	VMETA_FRAME_GET_FIELD(TIMESTAMP, frame_timestamp, timestamp);
+	VMETA_FRAME_GET_FIELD(
+		UTC_TIMESTAMP, frame_utc_timestamp, utc_timestamp);
+	VMETA_FRAME_GET_FIELD(LOCATION, location, location);
+	VMETA_FRAME_GET_FIELD(SPEED_NED, speed_ned, speed);
+	VMETA_FRAME_GET_FIELD(
+		GROUND_DISTANCE, ground_distance, ground_distance);
+	VMETA_FRAME_GET_FIELD(
+		ALTITUDE_ATO, altitude_above_takeoff, altitude_ato);
+	VMETA_FRAME_GET_FIELD(DRONE_QUAT, drone_quat, drone_quat);
+	VMETA_FRAME_GET_FIELD(FRAME_QUAT, frame_quat, frame_quat);
+	VMETA_FRAME_GET_FIELD(
+		FRAME_BASE_QUAT, frame_base_quat, frame_base_quat);
+	VMETA_FRAME_GET_FIELD(EXPOSURE_TIME, exposure_time, exposure_time);
+	VMETA_FRAME_GET_FIELD(GAIN, gain, gain);
+	VMETA_FRAME_GET_FIELD(AWB_R_GAIN, awb_r_gain, awb_r_gain);
+	VMETA_FRAME_GET_FIELD(AWB_B_GAIN, awb_b_gain, awb_b_gain);
+	VMETA_FRAME_GET_FIELD(PICTURE_H_FOV, picture_h_fov, picture_h_fov);
+	VMETA_FRAME_GET_FIELD(PICTURE_V_FOV, picture_v_fov, picture_v_fov);
+	VMETA_FRAME_GET_FIELD(ZOOM_LEVEL, camera_zoom_level, zoom_level);
+	VMETA_FRAME_GET_FIELD(
+		BATTERY_PERCENTAGE, battery_percentage, battery_percentage);
+	VMETA_FRAME_GET_FIELD(FLYING_STATE, flying_state, flying_state);
+	VMETA_FRAME_GET_FIELD(PILOTING_MODE, piloting_mode, piloting_mode);
+	VMETA_FRAME_GET_FIELD(LINK_GOODPUT, link_goodput, link_goodput);
+	VMETA_FRAME_GET_FIELD(LINK_QUALITY, link_quality, link_quality);
+	VMETA_FRAME_GET_FIELD(WIFI_RSSI, wifi_rssi, wifi_rssi);
+
+	if (tm != NULL) {
+		view.held = NULL;
+		vmeta_frame_proto_release_view(meta, &view, tm);
+	}
+
+	return 0;
+}
+
+
 int vmeta_frame_get_camera_subtype(struct vmeta_frame *meta,
 				   enum vmeta_camera_subtype *subtype)
 {
 	int res = 0;
 	const Vmeta__TimedMetadata *tm;
+	struct vmeta_frame_proto_view view = {0};
 	ULOG_ERRNO_RETURN_ERR_IF(meta == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(subtype == NULL, EINVAL);
 	*subtype = VMETA_CAMERA_SUBTYPE_UNKNOWN;
@@ -2268,17 +2736,18 @@ int vmeta_frame_get_camera_subtype(struct vmeta_frame *meta,
 		break;
 
 	case VMETA_FRAME_TYPE_PROTO:
-		res = vmeta_frame_proto_get_unpacked(meta, &tm);
+		res = vmeta_frame_proto_get_view(
+			meta, VMETA_FRAME_PROTO_VIEW_CAMERA, &view, &tm);
 		if (res < 0)
 			break;
 		if (!tm->camera) {
 			res = -ENOENT;
-			vmeta_frame_proto_release_unpacked(meta, tm);
+			vmeta_frame_proto_release_view(meta, &view, tm);
 			break;
 		}
 		*subtype = vmeta_camera_subtype_proto_to_vmeta(
 			tm->camera->subtype);
-		vmeta_frame_proto_release_unpacked(meta, tm);
+		vmeta_frame_proto_release_view(meta, &view, tm);
 		break;
 
 	default:
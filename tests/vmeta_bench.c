@@ -0,0 +1,564 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vmeta_bench.h"
+
+#include <ctype.h>
+#include <getopt.h>
+#include <limits.h>
+
+ULOG_DECLARE_TAG(ULOG_TAG);
+
+
+#define DEFAULT_SAMPLE_COUNT 200
+#define DEFAULT_SAMPLE_TIME_US 100
+#define MAX_BATCH_SIZE (1u << 24)
+
+
+enum bench_format {
+	BENCH_FORMAT_TEXT = 0,
+	BENCH_FORMAT_CSV,
+	BENCH_FORMAT_JSON,
+};
+
+
+struct vmeta_bench {
+	/* Options */
+	unsigned int sample_count;
+	uint64_t sample_time_ns;
+	enum bench_format format;
+	int list;
+	char **filters;
+	int filter_count;
+	FILE *out;
+
+	/* Duration of each sample in ns (sample_count entries) */
+	uint64_t *samples;
+	int header_written;
+	unsigned int case_count;
+	unsigned int error_count;
+};
+
+
+/* Memory allocation counters; the standard allocation functions are
+ * replaced by wrappers around the glibc ones, so that the allocations made
+ * by the library (and its dependencies) are counted. The benchmark is
+ * single-threaded, so the counters are not atomic. */
+static struct {
+	uint64_t count;
+	uint64_t bytes;
+} s_alloc;
+
+
+#ifdef __GLIBC__
+
+#	define HAVE_ALLOC_COUNT 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+
+void *malloc(size_t size)
+{
+	s_alloc.count++;
+	s_alloc.bytes += size;
+	return __libc_malloc(size);
+}
+
+
+void *calloc(size_t nmemb, size_t size)
+{
+	s_alloc.count++;
+	s_alloc.bytes += nmemb * size;
+	return __libc_calloc(nmemb, size);
+}
+
+
+void *realloc(void *ptr, size_t size)
+{
+	s_alloc.count++;
+	s_alloc.bytes += size;
+	return __libc_realloc(ptr, size);
+}
+
+#else /* !__GLIBC__ */
+
+#	define HAVE_ALLOC_COUNT 0
+
+#endif /* !__GLIBC__ */
+
+
+static uint64_t bench_time_ns(void)
+{
+	struct timespec ts = {0, 0};
+	time_get_monotonic(&ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static int bench_u64_cmp(const void *a, const void *b)
+{
+	uint64_t va = *(const uint64_t *)a;
+	uint64_t vb = *(const uint64_t *)b;
+	return (va > vb) - (va < vb);
+}
+
+
+static int bench_match(struct vmeta_bench *bench, const char *name)
+{
+	if (bench->filter_count == 0)
+		return 1;
+	for (int i = 0; i < bench->filter_count; i++) {
+		if (strstr(name, bench->filters[i]) != NULL)
+			return 1;
+	}
+	return 0;
+}
+
+
+/* Duration in ns of a batch of operations, or negative errno value in case
+ * of error */
+static int64_t bench_batch(vmeta_bench_op_t op, void *userdata, uint32_t size)
+{
+	int res;
+	uint64_t start = bench_time_ns();
+
+	for (uint32_t i = 0; i < size; i++) {
+		res = op(userdata);
+		if (res < 0)
+			return res;
+	}
+
+	return (int64_t)(bench_time_ns() - start);
+}
+
+
+static void bench_header(struct vmeta_bench *bench)
+{
+	switch (bench->format) {
+	case BENCH_FORMAT_TEXT:
+		fprintf(bench->out,
+			"%-36s %12s %10s %10s %10s %10s %10s %8s %10s\n",
+			"case",
+			"ops/s",
+			"MB/s",
+			"mean(ns)",
+			"p50(ns)",
+			"p90(ns)",
+			"p99(ns)",
+			"allocs",
+			"alloc(B)");
+		break;
+	case BENCH_FORMAT_CSV:
+		fprintf(bench->out,
+			"name,ops,batch,ops_per_s,mb_per_s,mean_ns,min_ns,"
+			"p50_ns,p90_ns,p99_ns,max_ns,allocs_per_op,"
+			"alloc_bytes_per_op\n");
+		break;
+	default:
+		break;
+	}
+}
+
+
+static void bench_report(struct vmeta_bench *bench,
+			 const char *name,
+			 uint64_t ops,
+			 uint32_t batch,
+			 size_t bytes,
+			 uint64_t total_ns,
+			 uint64_t allocs,
+			 uint64_t alloc_bytes)
+{
+	const uint64_t *s = bench->samples;
+	unsigned int n = bench->sample_count;
+	double ops_per_s = (total_ns > 0) ? 1e9 * ops / total_ns : 0.;
+	double mb_per_s = ops_per_s * bytes / 1e6;
+	double mean = (double)total_ns / ops;
+	double min = (double)s[0] / batch;
+	double p50 = (double)s[n * 50 / 100] / batch;
+	double p90 = (double)s[n * 90 / 100] / batch;
+	double p99 = (double)s[n * 99 / 100] / batch;
+	double max = (double)s[n - 1] / batch;
+	double allocs_per_op = HAVE_ALLOC_COUNT ? (double)allocs / ops : -1.;
+	double alloc_bytes_per_op =
+		HAVE_ALLOC_COUNT ? (double)alloc_bytes / ops : -1.;
+
+	switch (bench->format) {
+	case BENCH_FORMAT_TEXT:
+		fprintf(bench->out,
+			"%-36s %12.0f %10.1f %10.1f %10.1f %10.1f %10.1f "
+			"%8.2f %10.1f\n",
+			name,
+			ops_per_s,
+			mb_per_s,
+			mean,
+			p50,
+			p90,
+			p99,
+			allocs_per_op,
+			alloc_bytes_per_op);
+		break;
+	case BENCH_FORMAT_CSV:
+		fprintf(bench->out,
+			"%s,%" PRIu64 ",%" PRIu32
+			",%.0f,%.3f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f,%.1f\n",
+			name,
+			ops,
+			batch,
+			ops_per_s,
+			mb_per_s,
+			mean,
+			min,
+			p50,
+			p90,
+			p99,
+			max,
+			allocs_per_op,
+			alloc_bytes_per_op);
+		break;
+	case BENCH_FORMAT_JSON:
+		/* One object per line (newline-delimited JSON); the
+		 * allocation counts are null when not available */
+		fprintf(bench->out,
+			"{\"name\": \"%s\", \"ops\": %" PRIu64
+			", \"batch\": %" PRIu32
+			", \"ops_per_s\": %.0f, \"mb_per_s\": %.3f"
+			", \"mean_ns\": %.2f, \"min_ns\": %.2f"
+			", \"p50_ns\": %.2f, \"p90_ns\": %.2f"
+			", \"p99_ns\": %.2f, \"max_ns\": %.2f",
+			name,
+			ops,
+			batch,
+			ops_per_s,
+			mb_per_s,
+			mean,
+			min,
+			p50,
+			p90,
+			p99,
+			max);
+		if (HAVE_ALLOC_COUNT) {
+			fprintf(bench->out,
+				", \"allocs_per_op\": %.3f"
+				", \"alloc_bytes_per_op\": %.1f}\n",
+				allocs_per_op,
+				alloc_bytes_per_op);
+		} else {
+			fprintf(bench->out,
+				", \"allocs_per_op\": null"
+				", \"alloc_bytes_per_op\": null}\n");
+		}
+		break;
+	default:
+		break;
+	}
+	fflush(bench->out);
+}
+
+
+int vmeta_bench_run(struct vmeta_bench *bench,
+		    const char *name,
+		    vmeta_bench_op_t op,
+		    size_t bytes,
+		    void *userdata)
+{
+	int64_t res;
+	uint32_t batch = 1;
+	uint64_t total_ns = 0, allocs, alloc_bytes;
+
+	ULOG_ERRNO_RETURN_ERR_IF(bench == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(name == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(op == NULL, EINVAL);
+
+	if (!bench_match(bench, name))
+		return 0;
+	bench->case_count++;
+
+	if (bench->list) {
+		fprintf(bench->out, "%s\n", name);
+		return 0;
+	}
+
+	if (!bench->header_written) {
+		bench_header(bench);
+		bench->header_written = 1;
+	}
+
+	/* Calibration (and warm-up): find the batch size for which a sample
+	 * lasts at least the sample duration */
+	do {
+		res = bench_batch(op, userdata, batch);
+		if (res < 0)
+			goto error;
+		if ((uint64_t)res >= bench->sample_time_ns)
+			break;
+		batch *= 2;
+	} while (batch < MAX_BATCH_SIZE);
+
+	/* Measurement */
+	allocs = s_alloc.count;
+	alloc_bytes = s_alloc.bytes;
+	for (unsigned int i = 0; i < bench->sample_count; i++) {
+		res = bench_batch(op, userdata, batch);
+		if (res < 0)
+			goto error;
+		bench->samples[i] = (uint64_t)res;
+		total_ns += (uint64_t)res;
+	}
+	allocs = s_alloc.count - allocs;
+	alloc_bytes = s_alloc.bytes - alloc_bytes;
+
+	qsort(bench->samples,
+	      bench->sample_count,
+	      sizeof(bench->samples[0]),
+	      &bench_u64_cmp);
+
+	bench_report(bench,
+		     name,
+		     (uint64_t)bench->sample_count * batch,
+		     batch,
+		     bytes,
+		     total_ns,
+		     allocs,
+		     alloc_bytes);
+
+	return 0;
+
+error:
+	ULOG_ERRNO("%s", (int)-res, name);
+	fprintf(stderr, "%s: failed (%s)\n", name, strerror((int)-res));
+	bench->error_count++;
+	return (int)res;
+}
+
+
+enum args_id {
+	ARGS_ID_SAMPLES = 256,
+	ARGS_ID_SAMPLE_TIME,
+	ARGS_ID_FORMAT,
+	ARGS_ID_OUTPUT,
+	ARGS_ID_LIST,
+};
+
+
+static const char short_options[] = "h";
+
+
+static const struct option long_options[] = {
+	{"help", no_argument, NULL, 'h'},
+	{"samples", required_argument, NULL, ARGS_ID_SAMPLES},
+	{"sample-time", required_argument, NULL, ARGS_ID_SAMPLE_TIME},
+	{"format", required_argument, NULL, ARGS_ID_FORMAT},
+	{"output", required_argument, NULL, ARGS_ID_OUTPUT},
+	{"list", no_argument, NULL, ARGS_ID_LIST},
+	{0, 0, 0, 0},
+};
+
+
+/* Parse a decimal unsigned integer argument in [min, max] */
+static int parse_uint(const char *str,
+		      unsigned long long min,
+		      unsigned long long max,
+		      unsigned long long *value)
+{
+	char *end = NULL;
+
+	/* strtoull() silently negates negative values */
+	while (isspace((unsigned char)*str))
+		str++;
+	if ((*str == '\0') || (*str == '-'))
+		return -EINVAL;
+
+	errno = 0;
+	*value = strtoull(str, &end, 10);
+	if ((end == str) || (*end != '\0'))
+		return -EINVAL;
+	if ((errno != 0) || (*value < min) || (*value > max))
+		return -ERANGE;
+
+	return 0;
+}
+
+
+static void usage(char *prog_name)
+{
+	printf("Usage: %s [options] [<filter>...]\n"
+	       "\n"
+	       "Run the benchmark cases whose name contains one of the "
+	       "filters (all cases\n"
+	       "if no filter is given).\n"
+	       "\n"
+	       "Options:\n"
+	       "-h | --help                        Print this message\n"
+	       "     --samples <n>                 Number of samples per "
+	       "case (default is %d)\n"
+	       "     --sample-time <us>            Minimum duration of a "
+	       "sample (default is %d)\n"
+	       "     --format <text|csv|json>      Output format "
+	       "(default is text;\n"
+	       "                                   json is one object "
+	       "per line)\n"
+	       "     --output <file>               Output to file "
+	       "(default is stdout)\n"
+	       "     --list                        List the cases without "
+	       "running them\n"
+	       "\n"
+	       "Latencies are per operation: the p50/p90/p99 percentiles "
+	       "are computed over\n"
+	       "the samples (batches of operations).\n"
+	       "\n",
+	       prog_name,
+	       DEFAULT_SAMPLE_COUNT,
+	       DEFAULT_SAMPLE_TIME_US);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int status = EXIT_SUCCESS;
+	int idx, c;
+	unsigned long long value;
+	const char *output = NULL;
+	struct vmeta_bench bench;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.sample_count = DEFAULT_SAMPLE_COUNT;
+	bench.sample_time_ns = DEFAULT_SAMPLE_TIME_US * 1000;
+	bench.format = BENCH_FORMAT_TEXT;
+	bench.out = stdout;
+
+	/* Command-line parameters */
+	while ((c = getopt_long(
+			argc, argv, short_options, long_options, &idx)) != -1) {
+		switch (c) {
+		case 0:
+			break;
+
+		case 'h':
+			usage(argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+
+		case ARGS_ID_SAMPLES:
+			if (parse_uint(optarg, 1, UINT_MAX, &value) < 0) {
+				fprintf(stderr,
+					"invalid number of samples: '%s'\n",
+					optarg);
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			bench.sample_count = value;
+			break;
+
+		case ARGS_ID_SAMPLE_TIME:
+			if (parse_uint(optarg,
+				       0,
+				       UINT64_MAX / 1000,
+				       &value) < 0) {
+				fprintf(stderr,
+					"invalid sample time: '%s'\n",
+					optarg);
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			bench.sample_time_ns = (uint64_t)value * 1000;
+			break;
+
+		case ARGS_ID_FORMAT:
+			if (strcmp(optarg, "text") == 0) {
+				bench.format = BENCH_FORMAT_TEXT;
+			} else if (strcmp(optarg, "csv") == 0) {
+				bench.format = BENCH_FORMAT_CSV;
+			} else if (strcmp(optarg, "json") == 0) {
+				bench.format = BENCH_FORMAT_JSON;
+			} else {
+				fprintf(stderr,
+					"invalid output format: '%s'\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+
+		case ARGS_ID_OUTPUT:
+			output = optarg;
+			break;
+
+		case ARGS_ID_LIST:
+			bench.list = 1;
+			break;
+
+		default:
+			usage(argv[0]);
+			exit(EXIT_FAILURE);
+			break;
+		}
+	}
+
+	bench.filters = argv + optind;
+	bench.filter_count = argc - optind;
+
+	bench.samples = calloc(bench.sample_count, sizeof(*bench.samples));
+	if (bench.samples == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		exit(EXIT_FAILURE);
+	}
+
+	if (output != NULL) {
+		bench.out = fopen(output, "w");
+		if (bench.out == NULL) {
+			fprintf(stderr, "failed to open file '%s'\n", output);
+			status = EXIT_FAILURE;
+			goto cleanup;
+		}
+	}
+
+	/* Errors of the cases are reported by vmeta_bench_run() (the
+	 * following cases are run anyway); the suites only return the errors
+	 * of their setup */
+	if (vmeta_bench_frame(&bench) < 0)
+		status = EXIT_FAILURE;
+	if (vmeta_bench_session(&bench) < 0)
+		status = EXIT_FAILURE;
+
+	if (bench.case_count == 0) {
+		fprintf(stderr, "no benchmark case matches the filters\n");
+		status = EXIT_FAILURE;
+	} else if (bench.error_count > 0) {
+		fprintf(stderr,
+			"%u benchmark case(s) failed\n",
+			bench.error_count);
+		status = EXIT_FAILURE;
+	}
+
+cleanup:
+	if ((bench.out != NULL) && (bench.out != stdout))
+		fclose(bench.out);
+	free(bench.samples);
+
+	return status;
+}
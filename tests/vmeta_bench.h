@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VMETA_BENCH_H_
+#define _VMETA_BENCH_H_
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <futils/futils.h>
+#include <json-c/json.h>
+
+#include <video-metadata/vmeta.h>
+
+#define ULOG_TAG vmeta_bench
+#include <ulog.h>
+
+
+struct vmeta_bench;
+
+
+/**
+ * Benchmark operation function.
+ * The function performs one operation of a benchmark case (e.g. writing one
+ * frame metadata); it is called repeatedly by vmeta_bench_run().
+ * @param userdata: benchmark case user data pointer
+ * @return 0 on success, negative errno value in case of error
+ */
+typedef int (*vmeta_bench_op_t)(void *userdata);
+
+
+/**
+ * Run a benchmark case and report its results.
+ * The op function is first called in batches of increasing size until a
+ * batch lasts at least the configured sample duration (which also warms up
+ * the caches); the configured number of samples of that batch size are then
+ * measured. Cases whose name does not match the command-line filters are
+ * skipped.
+ * @param bench: pointer to the benchmark context
+ * @param name: benchmark case name ("<object>/<operation>")
+ * @param op: benchmark operation function
+ * @param bytes: size in bytes of the data processed by one operation, used
+ *               for the throughput in MB/s (0 if not applicable)
+ * @param userdata: benchmark operation function user data pointer
+ * @return 0 on success (or if the case is skipped), negative errno value in
+ *         case of error
+ */
+int vmeta_bench_run(struct vmeta_bench *bench,
+		    const char *name,
+		    vmeta_bench_op_t op,
+		    size_t bytes,
+		    void *userdata);
+
+
+/* Benchmark suites; each function runs all the cases of the suite */
+int vmeta_bench_frame(struct vmeta_bench *bench);
+int vmeta_bench_session(struct vmeta_bench *bench);
+
+
+#endif /* !_VMETA_BENCH_H_ */
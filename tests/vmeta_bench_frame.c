@@ -0,0 +1,632 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vmeta_bench.h"
+
+
+#define FRAME_BUF_SIZE 8192
+#define FRAME_STR_SIZE 32768
+#define FRAME_USER_DATA_SIZE 64
+
+
+/* Benchmarked frame metadata */
+struct frame_desc {
+	/* Name of the frame metadata in the case names */
+	const char *name;
+
+	/* Frame metadata type */
+	enum vmeta_frame_type type;
+
+	/* Number of links, LFIC and user metadata (protobuf-based metadata
+	 * only) */
+	unsigned int link_count;
+	unsigned int lfic_count;
+	unsigned int user_count;
+};
+
+
+static const struct frame_desc s_frames[] = {
+	{"v1_strm_basic", VMETA_FRAME_TYPE_V1_STREAMING_BASIC, 0, 0, 0},
+	{"v1_strm_ext", VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED, 0, 0, 0},
+	{"v1_rec", VMETA_FRAME_TYPE_V1_RECORDING, 0, 0, 0},
+	{"v2", VMETA_FRAME_TYPE_V2, 0, 0, 0},
+	{"v3", VMETA_FRAME_TYPE_V3, 0, 0, 0},
+	{"proto", VMETA_FRAME_TYPE_PROTO, 1, 0, 0},
+	{"proto_links4", VMETA_FRAME_TYPE_PROTO, 4, 0, 0},
+	{"proto_lfic4", VMETA_FRAME_TYPE_PROTO, 1, 4, 0},
+	{"proto_users4", VMETA_FRAME_TYPE_PROTO, 1, 0, 4},
+	{"proto_full", VMETA_FRAME_TYPE_PROTO, 8, 8, 8},
+};
+
+
+struct frame_ctx {
+	const struct frame_desc *desc;
+	const char *mime_type;
+
+	/* Frame metadata built by the benchmark (written) */
+	struct vmeta_frame *src;
+
+	/* Frame metadata read back from the serialized data (converted
+	 * to JSON, CSV and through the getters) */
+	struct vmeta_frame *frame;
+
+	/* Serialized data */
+	uint8_t *buf;
+	size_t len;
+
+	/* Output of the write, JSON and CSV cases */
+	uint8_t *out;
+	char *str;
+	struct vmeta_csv_buf csv;
+};
+
+
+static const struct vmeta_location s_location = {
+	.latitude = 48.878,
+	.longitude = 2.367,
+	.altitude_wgs84ellipsoid = 142.,
+	.altitude_egm96amsl = 95.5,
+	.horizontal_accuracy = 1.5f,
+	.vertical_accuracy = 3.f,
+	.sv_count = 15,
+	.valid = 1,
+};
+
+
+static const struct vmeta_quaternion s_quat = {
+	.w = 0.8f,
+	.x = 0.2f,
+	.y = 0.5f,
+	.z = 0.2f,
+};
+
+
+static const struct vmeta_euler s_euler = {
+	.yaw = 1.2f,
+	.pitch = -0.1f,
+	.roll = 0.05f,
+};
+
+
+static void frame_fill_v1_strm_basic(struct vmeta_frame_v1_streaming_basic *v1)
+{
+	v1->drone_attitude = s_euler;
+	v1->frame_quat = s_quat;
+	v1->camera_pan = 0.1f;
+	v1->camera_tilt = -0.4f;
+	v1->exposure_time = 4.5f;
+	v1->gain = 200;
+	v1->wifi_rssi = -60;
+	v1->battery_percentage = 75;
+}
+
+
+static void frame_fill_v1_strm_ext(struct vmeta_frame_v1_streaming_extended *v1)
+{
+	v1->drone_attitude = s_euler;
+	v1->location = s_location;
+	v1->altitude = 47.;
+	v1->distance_from_home = 120.;
+	v1->speed.x = 1.5f;
+	v1->speed.y = -2.f;
+	v1->speed.z = 0.1f;
+	v1->frame_quat = s_quat;
+	v1->camera_pan = 0.1f;
+	v1->camera_tilt = -0.4f;
+	v1->exposure_time = 4.5f;
+	v1->gain = 200;
+	v1->wifi_rssi = -60;
+	v1->battery_percentage = 75;
+	v1->state = VMETA_FLYING_STATE_FLYING;
+	v1->mode = VMETA_PILOTING_MODE_MANUAL;
+}
+
+
+static void frame_fill_v1_rec(struct vmeta_frame_v1_recording *v1)
+{
+	v1->drone_attitude = s_euler;
+	v1->location = s_location;
+	v1->altitude = 47.;
+	v1->distance_from_home = 120.;
+	v1->speed.x = 1.5f;
+	v1->speed.y = -2.f;
+	v1->speed.z = 0.1f;
+	v1->frame_timestamp = 123456789;
+	v1->frame_quat = s_quat;
+	v1->camera_pan = 0.1f;
+	v1->camera_tilt = -0.4f;
+	v1->exposure_time = 4.5f;
+	v1->gain = 200;
+	v1->wifi_rssi = -60;
+	v1->battery_percentage = 75;
+	v1->state = VMETA_FLYING_STATE_FLYING;
+	v1->mode = VMETA_PILOTING_MODE_MANUAL;
+}
+
+
+static void frame_fill_v2(struct vmeta_frame_v2 *v2)
+{
+	v2->base.drone_quat = s_quat;
+	v2->base.location = s_location;
+	v2->base.ground_distance = 47.;
+	v2->base.speed.north = 1.5f;
+	v2->base.speed.east = -2.f;
+	v2->base.speed.down = 0.1f;
+	v2->base.air_speed = 3.f;
+	v2->base.frame_quat = s_quat;
+	v2->base.camera_pan = 0.1f;
+	v2->base.camera_tilt = -0.4f;
+	v2->base.exposure_time = 4.5f;
+	v2->base.gain = 200;
+	v2->base.wifi_rssi = -60;
+	v2->base.battery_percentage = 75;
+	v2->base.state = VMETA_FLYING_STATE_FLYING;
+	v2->base.mode = VMETA_PILOTING_MODE_MANUAL;
+	v2->has_timestamp = 1;
+	v2->timestamp.frame_timestamp = 123456789;
+}
+
+
+static void frame_fill_v3(struct vmeta_frame_v3 *v3)
+{
+	v3->base.drone_quat = s_quat;
+	v3->base.location = s_location;
+	v3->base.ground_distance = 47.;
+	v3->base.speed.north = 1.5f;
+	v3->base.speed.east = -2.f;
+	v3->base.speed.down = 0.1f;
+	v3->base.air_speed = 3.f;
+	v3->base.frame_base_quat = s_quat;
+	v3->base.frame_quat = s_quat;
+	v3->base.exposure_time = 4.5f;
+	v3->base.gain = 200;
+	v3->base.awb_r_gain = 1.8f;
+	v3->base.awb_b_gain = 1.5f;
+	v3->base.picture_hfov = 69.f;
+	v3->base.picture_vfov = 43.f;
+	v3->base.link_goodput = 10000;
+	v3->base.link_quality = 4;
+	v3->base.wifi_rssi = -60;
+	v3->base.battery_percentage = 75;
+	v3->base.state = VMETA_FLYING_STATE_FLYING;
+	v3->base.mode = VMETA_PILOTING_MODE_MANUAL;
+	v3->has_timestamp = 1;
+	v3->timestamp.frame_timestamp = 123456789;
+	v3->has_lfic = 1;
+	v3->lfic.target_x = 0.5f;
+	v3->lfic.target_y = 0.5f;
+	v3->lfic.target_location = s_location;
+	v3->lfic.estimated_precision = 2.;
+	v3->lfic.grid_precision = 1.;
+}
+
+
+static void frame_fill_proto_location(Vmeta__Location *loc)
+{
+	loc->latitude = s_location.latitude;
+	loc->longitude = s_location.longitude;
+	loc->altitude_wgs84ellipsoid = s_location.altitude_wgs84ellipsoid;
+	loc->altitude_egm96amsl = s_location.altitude_egm96amsl;
+	loc->horizontal_accuracy = s_location.horizontal_accuracy;
+	loc->vertical_accuracy = s_location.vertical_accuracy;
+	loc->sv_count = s_location.sv_count;
+}
+
+
+static void frame_fill_proto_quat(Vmeta__Quaternion *quat)
+{
+	quat->w = s_quat.w;
+	quat->x = s_quat.x;
+	quat->y = s_quat.y;
+	quat->z = s_quat.z;
+}
+
+
+static int frame_fill_proto(struct vmeta_frame *frame,
+			    const struct frame_desc *desc)
+{
+	int res;
+	Vmeta__TimedMetadata *meta;
+	Vmeta__DroneMetadata *drone;
+	Vmeta__CameraMetadata *camera;
+	Vmeta__Location *loc;
+	Vmeta__Quaternion *quat;
+	Vmeta__NED *speed;
+	Vmeta__WifiLinkMetadata *wifi;
+	Vmeta__LFICMetadata *lfic;
+	Vmeta__UserMetadata *user;
+
+	res = vmeta_frame_proto_get_unpacked_rw(frame, &meta);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_frame_proto_get_unpacked_rw", -res);
+		return res;
+	}
+
+	res = -ENOMEM;
+
+	drone = vmeta_frame_proto_get_drone(meta);
+	if (drone == NULL)
+		goto out;
+	drone->flying_state = VMETA__FLYING_STATE__FS_FLYING;
+	drone->piloting_mode = VMETA__PILOTING_MODE__PM_MANUAL;
+	drone->ground_distance = 47.;
+	drone->altitude_ato = 45.;
+	drone->battery_percentage = 75;
+	loc = vmeta_frame_proto_get_drone_location(drone);
+	quat = vmeta_frame_proto_get_drone_quat(drone);
+	speed = vmeta_frame_proto_get_drone_speed(drone);
+	if ((loc == NULL) || (quat == NULL) || (speed == NULL))
+		goto out;
+	frame_fill_proto_location(loc);
+	frame_fill_proto_quat(quat);
+	speed->north = 1.5f;
+	speed->east = -2.f;
+	speed->down = 0.1f;
+
+	camera = vmeta_frame_proto_get_camera(meta);
+	if (camera == NULL)
+		goto out;
+	camera->timestamp = 123456789;
+	camera->utc_timestamp = 1600000000000000;
+	camera->exposure_time = 4.5f;
+	camera->iso_gain = 200;
+	camera->awb_r_gain = 1.8f;
+	camera->awb_b_gain = 1.5f;
+	camera->hfov = 69.f;
+	camera->vfov = 43.f;
+	quat = vmeta_frame_proto_get_camera_base_quat(camera);
+	if (quat == NULL)
+		goto out;
+	frame_fill_proto_quat(quat);
+	quat = vmeta_frame_proto_get_camera_quat(camera);
+	if (quat == NULL)
+		goto out;
+	frame_fill_proto_quat(quat);
+
+	for (unsigned int i = 0; i < desc->link_count; i++) {
+		wifi = vmeta_frame_proto_add_wifi_link(meta);
+		if (wifi == NULL)
+			goto out;
+		wifi->goodput = 10000 + i;
+		wifi->quality = 4;
+		wifi->rssi = -60;
+	}
+
+	for (unsigned int i = 0; i < desc->lfic_count; i++) {
+		lfic = vmeta_frame_proto_get_lfic_by_index(meta, i);
+		if (lfic == NULL)
+			goto out;
+		lfic->x = 0.1f * (i + 1);
+		lfic->y = 0.5f;
+		lfic->grid_precision = 1.;
+		lfic->type = VMETA__LFIC_TYPE__LFIC_TYPE_USER;
+		loc = vmeta_frame_proto_get_lfic_location(lfic);
+		if (loc == NULL)
+			goto out;
+		frame_fill_proto_location(loc);
+	}
+
+	for (unsigned int i = 0; i < desc->user_count; i++) {
+		user = vmeta_frame_proto_get_user_by_index(meta, i);
+		if (user == NULL)
+			goto out;
+		user->uid_hash = 0x42 + i;
+		user->timestamp = 123456789;
+		user->data.data = calloc(1, FRAME_USER_DATA_SIZE);
+		if (user->data.data == NULL)
+			goto out;
+		user->data.len = FRAME_USER_DATA_SIZE;
+		for (size_t j = 0; j < user->data.len; j++)
+			user->data.data[j] = (uint8_t)(i + j);
+	}
+
+	res = 0;
+
+out:
+	if (res < 0)
+		ULOG_ERRNO("frame_fill_proto", -res);
+	vmeta_frame_proto_release_unpacked_rw(frame, meta);
+	return res;
+}
+
+
+static int frame_ctx_init(struct frame_ctx *ctx, const struct frame_desc *desc)
+{
+	int res;
+	struct vmeta_buffer buf;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->desc = desc;
+	ctx->mime_type = vmeta_frame_get_mime_type(desc->type);
+
+	ctx->buf = malloc(FRAME_BUF_SIZE);
+	ctx->out = malloc(FRAME_BUF_SIZE);
+	ctx->str = malloc(FRAME_STR_SIZE);
+	if ((ctx->buf == NULL) || (ctx->out == NULL) || (ctx->str == NULL)) {
+		ULOG_ERRNO("malloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	res = vmeta_frame_new(desc->type, &ctx->src);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_frame_new", -res);
+		return res;
+	}
+
+	switch (desc->type) {
+	case VMETA_FRAME_TYPE_V1_STREAMING_BASIC:
+		frame_fill_v1_strm_basic(&ctx->src->v1_strm_basic);
+		break;
+	case VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED:
+		frame_fill_v1_strm_ext(&ctx->src->v1_strm_ext);
+		break;
+	case VMETA_FRAME_TYPE_V1_RECORDING:
+		frame_fill_v1_rec(&ctx->src->v1_rec);
+		break;
+	case VMETA_FRAME_TYPE_V2:
+		frame_fill_v2(&ctx->src->v2);
+		break;
+	case VMETA_FRAME_TYPE_V3:
+		frame_fill_v3(&ctx->src->v3);
+		break;
+	case VMETA_FRAME_TYPE_PROTO:
+		res = frame_fill_proto(ctx->src, desc);
+		if (res < 0)
+			return res;
+		break;
+	default:
+		return -ENOSYS;
+	}
+
+	/* Serialized data */
+	vmeta_buffer_set_data(&buf, ctx->buf, FRAME_BUF_SIZE, 0);
+	res = vmeta_frame_write(&buf, ctx->src);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_frame_write", -res);
+		return res;
+	}
+	ctx->len = buf.pos;
+
+	/* Frame metadata as received (not converted) */
+	vmeta_buffer_set_cdata(&buf, ctx->buf, ctx->len, 0);
+	res = vmeta_frame_read2(&buf, ctx->mime_type, 0, &ctx->frame);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_frame_read2", -res);
+		return res;
+	}
+
+	return 0;
+}
+
+
+static void frame_ctx_clear(struct frame_ctx *ctx)
+{
+	if (ctx->frame != NULL)
+		vmeta_frame_unref(ctx->frame);
+	if (ctx->src != NULL)
+		vmeta_frame_unref(ctx->src);
+	free(ctx->buf);
+	free(ctx->out);
+	free(ctx->str);
+	free(ctx->csv.str);
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+
+static int frame_write(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+	struct vmeta_buffer buf;
+
+	vmeta_buffer_set_data(&buf, ctx->out, FRAME_BUF_SIZE, 0);
+	return vmeta_frame_write(&buf, ctx->src);
+}
+
+
+static int frame_read_internal(struct frame_ctx *ctx, int convert)
+{
+	int res;
+	struct vmeta_buffer buf;
+	struct vmeta_frame *frame = NULL;
+
+	vmeta_buffer_set_cdata(&buf, ctx->buf, ctx->len, 0);
+	res = vmeta_frame_read2(&buf, ctx->mime_type, convert, &frame);
+	if (res < 0)
+		return res;
+	return vmeta_frame_unref(frame);
+}
+
+
+static int frame_read(void *userdata)
+{
+	return frame_read_internal(userdata, 0);
+}
+
+
+static int frame_read_convert(void *userdata)
+{
+	return frame_read_internal(userdata, 1);
+}
+
+
+static int frame_v3_write_proto(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+	struct vmeta_buffer buf;
+
+	vmeta_buffer_set_data(&buf, ctx->out, FRAME_BUF_SIZE, 0);
+	return vmeta_frame_v3_write_proto(&buf, &ctx->src->v3);
+}
+
+
+static int frame_to_json(void *userdata)
+{
+	int res;
+	struct frame_ctx *ctx = userdata;
+	struct json_object *jobj;
+
+	jobj = json_object_new_object();
+	if (jobj == NULL)
+		return -ENOMEM;
+	res = vmeta_frame_to_json(ctx->frame, jobj);
+	json_object_put(jobj);
+	return res;
+}
+
+
+static int frame_to_json_str(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+
+	return vmeta_frame_to_json_str(ctx->frame, ctx->str, FRAME_STR_SIZE);
+}
+
+
+static int frame_to_json_buf(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+	ssize_t res;
+
+	res = vmeta_frame_to_json_buf(ctx->frame, ctx->str, FRAME_STR_SIZE);
+	return (res < 0) ? (int)res : 0;
+}
+
+
+static int frame_to_csv(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+	ssize_t res;
+
+	res = vmeta_frame_to_csv(ctx->frame, ctx->str, FRAME_STR_SIZE);
+	return (res < 0) ? (int)res : 0;
+}
+
+
+static int frame_csv_append(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+	ssize_t res;
+
+	ctx->csv.len = 0;
+	res = vmeta_frame_csv_append(ctx->frame, &ctx->csv);
+	return (res < 0) ? (int)res : 0;
+}
+
+
+static int frame_getters(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+	struct vmeta_frame *frame = ctx->frame;
+	struct vmeta_location loc;
+	struct vmeta_ned speed;
+	struct vmeta_quaternion quat;
+	uint64_t ts;
+	float val;
+	uint16_t gain;
+	uint8_t u8;
+
+	/* The getters of the fields that are not available in the metadata
+	 * type return an error, which is not a benchmark error */
+	(void)vmeta_frame_get_location(frame, &loc);
+	(void)vmeta_frame_get_speed_ned(frame, &speed);
+	(void)vmeta_frame_get_drone_quat(frame, &quat);
+	(void)vmeta_frame_get_frame_quat(frame, &quat);
+	(void)vmeta_frame_get_frame_timestamp(frame, &ts);
+	(void)vmeta_frame_get_exposure_time(frame, &val);
+	(void)vmeta_frame_get_gain(frame, &gain);
+	(void)vmeta_frame_get_picture_h_fov(frame, &val);
+	(void)vmeta_frame_get_link_quality(frame, &u8);
+	(void)vmeta_frame_get_battery_percentage(frame, &u8);
+
+	return 0;
+}
+
+
+static int frame_get_fields(void *userdata)
+{
+	struct frame_ctx *ctx = userdata;
+	struct vmeta_frame_flat flat;
+
+	return vmeta_frame_get_fields(ctx->frame, VMETA_FRAME_FIELD_ALL, &flat);
+}
+
+
+static int frame_run(struct vmeta_bench *bench,
+		     struct frame_ctx *ctx,
+		     const char *op_name,
+		     vmeta_bench_op_t op)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "frame/%s/%s", ctx->desc->name, op_name);
+	return vmeta_bench_run(bench, name, op, ctx->len, ctx);
+}
+
+
+int vmeta_bench_frame(struct vmeta_bench *bench)
+{
+	int res = 0, err;
+	struct frame_ctx ctx;
+
+	for (size_t i = 0; i < SIZEOF_ARRAY(s_frames); i++) {
+		const struct frame_desc *desc = &s_frames[i];
+
+		err = frame_ctx_init(&ctx, desc);
+		if (err < 0) {
+			fprintf(stderr,
+				"frame/%s: failed to create the frame "
+				"metadata (%s)\n",
+				desc->name,
+				strerror(-err));
+			res = err;
+			frame_ctx_clear(&ctx);
+			continue;
+		}
+
+		/* Errors are reported for each case by vmeta_bench_run() */
+		frame_run(bench, &ctx, "write", &frame_write);
+		frame_run(bench, &ctx, "read", &frame_read);
+		if (desc->type == VMETA_FRAME_TYPE_V3) {
+			frame_run(bench, &ctx, "convert", &frame_read_convert);
+			frame_run(bench,
+				  &ctx,
+				  "write_proto",
+				  &frame_v3_write_proto);
+		}
+		frame_run(bench, &ctx, "to_json", &frame_to_json);
+		frame_run(bench, &ctx, "to_json_str", &frame_to_json_str);
+		frame_run(bench, &ctx, "to_json_buf", &frame_to_json_buf);
+		if (desc->type != VMETA_FRAME_TYPE_PROTO)
+			frame_run(bench, &ctx, "to_csv", &frame_to_csv);
+		frame_run(bench, &ctx, "csv_append", &frame_csv_append);
+		frame_run(bench, &ctx, "getters", &frame_getters);
+		frame_run(bench, &ctx, "get_fields", &frame_get_fields);
+
+		frame_ctx_clear(&ctx);
+	}
+
+	return res;
+}
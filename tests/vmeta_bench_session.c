@@ -0,0 +1,510 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vmeta_bench.h"
+
+
+#define SESSION_MAX_ITEMS 64
+#define SESSION_STR_SIZE 8192
+
+
+/* Session metadata item, as written by the vmeta_session_*_write()
+ * functions and given to the vmeta_session_*_read() functions */
+struct session_item {
+	int type;
+	int has_key;
+	char key[64];
+	char value[512];
+};
+
+
+struct session_items {
+	struct session_item item[SESSION_MAX_ITEMS];
+	unsigned int count;
+
+	/* Total length of the keys and values */
+	size_t bytes;
+};
+
+
+struct session_ctx {
+	struct vmeta_session meta;
+	struct vmeta_session copy;
+	struct vmeta_session_serialized *ser;
+
+	/* Items written for the session metadata */
+	struct session_items sdes;
+	struct session_items sdp;
+	struct session_items recording;
+
+	/* Number and length of the items written by the write cases */
+	unsigned int sink_count;
+	size_t sink_bytes;
+
+	char str[SESSION_STR_SIZE];
+};
+
+
+static void session_fill(struct vmeta_session *meta)
+{
+	memset(meta, 0, sizeof(*meta));
+	strcpy(meta->friendly_name, "ANAFI Ai-123456");
+	strcpy(meta->maker, "Parrot");
+	strcpy(meta->model, "ANAFI Ai");
+	strcpy(meta->model_id, "091b");
+	strcpy(meta->serial_number, "PI040443AA1A123456");
+	strcpy(meta->software_version, "7.6.0");
+	strcpy(meta->build_id, "anafi2-classic-7.6.0");
+	strcpy(meta->title, "Inspection flight");
+	strcpy(meta->comment, "Bridge pillar, east side");
+	strcpy(meta->copyright, "Parrot Drones SAS");
+	meta->media_date = 1600000000000000;
+	meta->media_date_gmtoff = 7200;
+	meta->run_date = 1599999000000000;
+	meta->run_date_gmtoff = 7200;
+	strcpy(meta->run_id, "B0A8D4E3C0A1F2E3D4C5B6A7F8E9D0C1");
+	meta->boot_date = 1599998000000000;
+	meta->boot_date_gmtoff = 7200;
+	strcpy(meta->boot_id, "0F1E2D3C4B5A69788796A5B4C3D2E1F0");
+	meta->flight_date = 1599999500000000;
+	meta->flight_date_gmtoff = 7200;
+	strcpy(meta->flight_id, "1A2B3C4D5E6F708192A3B4C5D6E7F809");
+	strcpy(meta->custom_id, "mission-42");
+	meta->takeoff_loc.latitude = 48.878;
+	meta->takeoff_loc.longitude = 2.367;
+	meta->takeoff_loc.altitude_wgs84ellipsoid = 95.;
+	meta->takeoff_loc.altitude_egm96amsl = 48.;
+	meta->takeoff_loc.valid = 1;
+	meta->location = meta->takeoff_loc;
+	meta->location.altitude_wgs84ellipsoid = 142.;
+	meta->picture_fov.horz = 69.f;
+	meta->picture_fov.vert = 43.f;
+	meta->picture_fov.has_horz = 1;
+	meta->picture_fov.has_vert = 1;
+	meta->has_thermal = 1;
+	meta->thermal.metaversion = 2;
+	strcpy(meta->thermal.camserial, "TH123456");
+	meta->thermal.alignment.rotation.yaw = 0.01f;
+	meta->thermal.alignment.rotation.pitch = -0.02f;
+	meta->thermal.alignment.rotation.roll = 0.005f;
+	meta->thermal.alignment.valid = 1;
+	meta->thermal.conv_low.r = 400000.f;
+	meta->thermal.conv_low.b = 1400.f;
+	meta->thermal.conv_low.f = 1.f;
+	meta->thermal.conv_low.valid = 1;
+	meta->thermal.scale_factor = 1.5;
+	meta->default_media = 1;
+	meta->camera_type = VMETA_CAMERA_TYPE_FRONT;
+	meta->camera_subtype = VMETA_CAMERA_SUBTYPE_WIDE;
+	meta->camera_spectrum = VMETA_CAMERA_SPECTRUM_VISIBLE;
+	strcpy(meta->camera_serial_number, "CAM123456");
+	meta->camera_model.type = VMETA_CAMERA_MODEL_TYPE_PERSPECTIVE;
+	meta->camera_model.perspective.distortion.r1 = 0.1f;
+	meta->camera_model.perspective.distortion.r2 = -0.05f;
+	meta->camera_model.perspective.distortion.r3 = 0.01f;
+	meta->overlay.type = VMETA_OVERLAY_TYPE_HEADER_FOOTER;
+	meta->overlay.header_footer.header_height = 0.05f;
+	meta->overlay.header_footer.footer_height = 0.05f;
+	meta->principal_point.position.x = 0.5f;
+	meta->principal_point.position.y = 0.5f;
+	meta->principal_point.valid = 1;
+	meta->video_mode = VMETA_VIDEO_MODE_STANDARD;
+	meta->dynamic_range = VMETA_DYNAMIC_RANGE_SDR;
+	meta->tone_mapping = VMETA_TONE_MAPPING_STANDARD;
+	meta->first_frame_capture_ts = 123456789;
+	meta->first_frame_sample_index = 1;
+	meta->media_id = 42;
+	meta->resource_index = 1;
+}
+
+
+static void session_items_add(struct session_items *items,
+			      int type,
+			      const char *key,
+			      const char *value)
+{
+	struct session_item *item;
+
+	if (items->count >= SESSION_MAX_ITEMS) {
+		ULOGW("too many session metadata items");
+		return;
+	}
+	item = &items->item[items->count++];
+	item->type = type;
+	item->has_key = (key != NULL);
+	snprintf(item->key, sizeof(item->key), "%s", key ? key : "");
+	snprintf(item->value, sizeof(item->value), "%s", value);
+	items->bytes += strlen(item->key) + strlen(item->value);
+}
+
+
+static void session_items_sdes_cb(enum vmeta_stream_sdes_type type,
+				  const char *value,
+				  const char *prefix,
+				  void *userdata)
+{
+	session_items_add(userdata, type, prefix, value);
+}
+
+
+static void session_items_sdp_cb(enum vmeta_stream_sdp_type type,
+				 const char *value,
+				 const char *key,
+				 void *userdata)
+{
+	session_items_add(userdata, type, key, value);
+}
+
+
+static void session_items_recording_cb(enum vmeta_record_type type,
+				       const char *key,
+				       const char *value,
+				       void *userdata)
+{
+	session_items_add(userdata, type, key, value);
+}
+
+
+/* Item sinks of the write cases: the items are only counted, as a stream
+ * sender or muxer would copy them */
+static void session_sink(struct session_ctx *ctx, const char *value)
+{
+	ctx->sink_count++;
+	ctx->sink_bytes += strlen(value);
+}
+
+
+static void session_sdes_sink_cb(enum vmeta_stream_sdes_type type,
+				 const char *value,
+				 const char *prefix,
+				 void *userdata)
+{
+	session_sink(userdata, value);
+}
+
+
+static void session_sdp_sink_cb(enum vmeta_stream_sdp_type type,
+				const char *value,
+				const char *key,
+				void *userdata)
+{
+	session_sink(userdata, value);
+}
+
+
+static void session_recording_sink_cb(enum vmeta_record_type type,
+				      const char *key,
+				      const char *value,
+				      void *userdata)
+{
+	session_sink(userdata, value);
+}
+
+
+static int session_ctx_init(struct session_ctx *ctx)
+{
+	int res;
+
+	session_fill(&ctx->meta);
+	ctx->copy = ctx->meta;
+
+	res = vmeta_session_streaming_sdes_write(
+		&ctx->meta, &session_items_sdes_cb, &ctx->sdes);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_session_streaming_sdes_write", -res);
+		return res;
+	}
+
+	for (int media_level = 0; media_level < 2; media_level++) {
+		res = vmeta_session_streaming_sdp_write(&ctx->meta,
+							media_level,
+							&session_items_sdp_cb,
+							&ctx->sdp);
+		if (res < 0) {
+			ULOG_ERRNO("vmeta_session_streaming_sdp_write", -res);
+			return res;
+		}
+	}
+
+	res = vmeta_session_recording_write(
+		&ctx->meta, &session_items_recording_cb, &ctx->recording);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_session_recording_write", -res);
+		return res;
+	}
+
+	res = vmeta_session_serialized_new(&ctx->ser);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_session_serialized_new", -res);
+		return res;
+	}
+
+	res = vmeta_session_serialized_update(ctx->ser, &ctx->meta);
+	if (res < 0) {
+		ULOG_ERRNO("vmeta_session_serialized_update", -res);
+		return res;
+	}
+
+	return 0;
+}
+
+
+static int session_sdes_write(void *userdata)
+{
+	struct session_ctx *ctx = userdata;
+
+	return vmeta_session_streaming_sdes_write(
+		&ctx->meta, &session_sdes_sink_cb, ctx);
+}
+
+
+static int session_sdes_read(void *userdata)
+{
+	int res;
+	struct session_ctx *ctx = userdata;
+	struct vmeta_session meta;
+
+	memset(&meta, 0, sizeof(meta));
+	for (unsigned int i = 0; i < ctx->sdes.count; i++) {
+		const struct session_item *item = &ctx->sdes.item[i];
+		res = vmeta_session_streaming_sdes_read(
+			item->type,
+			item->value,
+			item->has_key ? item->key : NULL,
+			&meta);
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+static int session_sdp_write(void *userdata)
+{
+	int res;
+	struct session_ctx *ctx = userdata;
+
+	res = vmeta_session_streaming_sdp_write(
+		&ctx->meta, 0, &session_sdp_sink_cb, ctx);
+	if (res < 0)
+		return res;
+	return vmeta_session_streaming_sdp_write(
+		&ctx->meta, 1, &session_sdp_sink_cb, ctx);
+}
+
+
+static int session_sdp_read(void *userdata)
+{
+	int res;
+	struct session_ctx *ctx = userdata;
+	struct vmeta_session meta;
+
+	memset(&meta, 0, sizeof(meta));
+	for (unsigned int i = 0; i < ctx->sdp.count; i++) {
+		const struct session_item *item = &ctx->sdp.item[i];
+		res = vmeta_session_streaming_sdp_read(
+			item->type,
+			item->value,
+			item->has_key ? item->key : NULL,
+			&meta);
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+static int session_recording_write(void *userdata)
+{
+	struct session_ctx *ctx = userdata;
+
+	return vmeta_session_recording_write(
+		&ctx->meta, &session_recording_sink_cb, ctx);
+}
+
+
+static int session_recording_read(void *userdata)
+{
+	int res;
+	struct session_ctx *ctx = userdata;
+	struct vmeta_session meta;
+
+	memset(&meta, 0, sizeof(meta));
+	for (unsigned int i = 0; i < ctx->recording.count; i++) {
+		const struct session_item *item = &ctx->recording.item[i];
+		res = vmeta_session_recording_read(
+			item->key, item->value, &meta);
+		if (res < 0)
+			return res;
+	}
+
+	return 0;
+}
+
+
+static int session_serialized_update(void *userdata)
+{
+	struct session_ctx *ctx = userdata;
+	int res;
+
+	/* Steady state: only the location changes */
+	ctx->meta.location.latitude += 1e-7;
+	res = vmeta_session_serialized_update(ctx->ser, &ctx->meta);
+	return (res < 0) ? res : 0;
+}
+
+
+static int session_serialized_sdes_write(void *userdata)
+{
+	struct session_ctx *ctx = userdata;
+
+	return vmeta_session_serialized_sdes_write(
+		ctx->ser, &session_sdes_sink_cb, ctx);
+}
+
+
+static int session_to_json(void *userdata)
+{
+	int res;
+	struct session_ctx *ctx = userdata;
+	struct json_object *jobj;
+
+	jobj = json_object_new_object();
+	if (jobj == NULL)
+		return -ENOMEM;
+	res = vmeta_session_to_json(&ctx->meta, jobj);
+	json_object_put(jobj);
+	return res;
+}
+
+
+static int session_to_str(void *userdata)
+{
+	struct session_ctx *ctx = userdata;
+
+	return vmeta_session_to_str(&ctx->meta, ctx->str, sizeof(ctx->str));
+}
+
+
+static int session_cmp(void *userdata)
+{
+	struct session_ctx *ctx = userdata;
+
+	/* Worst case: equal session metadata */
+	return vmeta_session_cmp(&ctx->meta, &ctx->copy) ? 0 : -EPROTO;
+}
+
+
+static int session_fingerprint(void *userdata)
+{
+	struct session_ctx *ctx = userdata;
+	struct vmeta_session_fingerprint fp;
+
+	return vmeta_session_fingerprint(&ctx->meta, &fp);
+}
+
+
+int vmeta_bench_session(struct vmeta_bench *bench)
+{
+	int res;
+	struct session_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	res = session_ctx_init(ctx);
+	if (res < 0) {
+		fprintf(stderr,
+			"session: failed to create the session metadata (%s)\n",
+			strerror(-res));
+		goto out;
+	}
+
+	/* Errors are reported for each case by vmeta_bench_run() */
+	vmeta_bench_run(bench,
+			"session/sdes_write",
+			&session_sdes_write,
+			ctx->sdes.bytes,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/sdes_read",
+			&session_sdes_read,
+			ctx->sdes.bytes,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/sdp_write",
+			&session_sdp_write,
+			ctx->sdp.bytes,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/sdp_read",
+			&session_sdp_read,
+			ctx->sdp.bytes,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/recording_write",
+			&session_recording_write,
+			ctx->recording.bytes,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/recording_read",
+			&session_recording_read,
+			ctx->recording.bytes,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/to_json",
+			&session_to_json,
+			0,
+			ctx);
+	vmeta_bench_run(bench, "session/to_str", &session_to_str, 0, ctx);
+	vmeta_bench_run(bench, "session/cmp", &session_cmp, 0, ctx);
+	vmeta_bench_run(bench,
+			"session/fingerprint",
+			&session_fingerprint,
+			0,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/serialized_sdes_write",
+			&session_serialized_sdes_write,
+			ctx->sdes.bytes,
+			ctx);
+	vmeta_bench_run(bench,
+			"session/serialized_update",
+			&session_serialized_update,
+			0,
+			ctx);
+
+out:
+	if (ctx->ser != NULL)
+		vmeta_session_serialized_destroy(ctx->ser);
+	free(ctx);
+	return res;
+}
@@ -33,6 +33,7 @@ static CU_SuiteInfo s_suites[] = {
 	{(char *)"vmeta frame v3", NULL, NULL, s_v3_tests},
 	{(char *)"vmeta session", NULL, NULL, s_session_tests},
 	{(char *)"vmeta utils", NULL, NULL, s_utils_tests},
+	{(char *)"vmeta extract", NULL, NULL, s_extract_tests},
 	CU_SUITE_INFO_NULL,
 };
 
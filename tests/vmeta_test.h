@@ -54,6 +54,7 @@
 #define MONKEY_TEST_COUNT 1000
 
 extern CU_TestInfo s_utils_tests[];
+extern CU_TestInfo s_extract_tests[];
 extern CU_TestInfo s_proto_tests[];
 extern CU_TestInfo s_proto_monkey[];
 extern CU_TestInfo s_proto_gen[];
@@ -121,6 +122,8 @@ void compare_vmeta_frame_getters(struct vmeta_frame *f1,
 				 struct vmeta_frame *f2);
 void compare_vmeta_frame_v3_getters(struct vmeta_frame *f);
 void compare_vmeta_frame_proto_getters(struct vmeta_frame *f);
+void compare_vmeta_frame_json(struct vmeta_frame *frame);
+unsigned int count_csv_values(const char *str, size_t len);
 
 
 #endif /* _FUTILS_TEST_H_ */
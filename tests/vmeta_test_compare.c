@@ -26,6 +26,8 @@
 
 #include "vmeta_test.h"
 
+#include <json-c/json.h>
+
 
 void compare_vmeta_quaternion(struct vmeta_quaternion *q1,
 			      struct vmeta_quaternion *q2)
@@ -1286,3 +1288,117 @@ void compare_vmeta_frame_proto_getters(struct vmeta_frame *f)
 
 	vmeta_frame_proto_release_unpacked(f, proto);
 }
+
+
+unsigned int count_csv_values(const char *str, size_t len)
+{
+	unsigned int count = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (str[i] != ' ' && str[i] != '\n' &&
+		    (i == 0 || str[i - 1] == ' '))
+			count++;
+	}
+	return count;
+}
+
+
+static void compare_json(struct json_object *j1, struct json_object *j2)
+{
+	enum json_type type = json_object_get_type(j1);
+	struct json_object *val2;
+	double d1, d2;
+	size_t i, len;
+
+	CU_ASSERT_EQUAL(json_object_get_type(j2), type);
+	if (json_object_get_type(j2) != type)
+		return;
+
+	switch (type) {
+	case json_type_null:
+		break;
+	case json_type_boolean:
+		CU_ASSERT_EQUAL(json_object_get_boolean(j1),
+				json_object_get_boolean(j2));
+		break;
+	case json_type_int:
+		CU_ASSERT_EQUAL(json_object_get_int64(j1),
+				json_object_get_int64(j2));
+		break;
+	case json_type_double:
+		/* The text output must read back to the exact same value */
+		d1 = json_object_get_double(j1);
+		d2 = json_object_get_double(j2);
+		if (isnan(d1)) {
+			CU_ASSERT(isnan(d2));
+		} else {
+			CU_ASSERT_EQUAL(d1, d2);
+		}
+		break;
+	case json_type_string:
+		CU_ASSERT_STRING_EQUAL(json_object_get_string(j1),
+				       json_object_get_string(j2));
+		break;
+	case json_type_array:
+		len = json_object_array_length(j1);
+		CU_ASSERT_EQUAL(json_object_array_length(j2), len);
+		if (json_object_array_length(j2) != len)
+			break;
+		for (i = 0; i < len; i++) {
+			compare_json(json_object_array_get_idx(j1, i),
+				     json_object_array_get_idx(j2, i));
+		}
+		break;
+	case json_type_object:
+		CU_ASSERT_EQUAL(json_object_object_length(j2),
+				json_object_object_length(j1));
+		json_object_object_foreach(j1, key, val1)
+		{
+			CU_ASSERT(json_object_object_get_ex(j2, key, &val2));
+			if (json_object_object_get_ex(j2, key, &val2))
+				compare_json(val1, val2);
+		}
+		break;
+	default:
+		CU_FAIL("unknown JSON type");
+		break;
+	}
+}
+
+
+void compare_vmeta_frame_json(struct vmeta_frame *frame)
+{
+	struct json_object *jobj, *parsed;
+	const size_t maxlen = 256 * 1024;
+	char *str;
+	ssize_t len;
+	int err;
+
+	jobj = json_object_new_object();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(jobj);
+	err = vmeta_frame_to_json(frame, jobj);
+	CU_ASSERT_EQUAL(err, 0);
+	str = malloc(maxlen);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(str);
+
+	/* The text output parses back to the json-c object, field by field */
+	len = vmeta_frame_to_json_buf(frame, str, maxlen);
+	CU_ASSERT(len > 0);
+	parsed = json_tokener_parse(str);
+	CU_ASSERT_PTR_NOT_NULL(parsed);
+	if (parsed != NULL)
+		compare_json(jobj, parsed);
+	json_object_put(parsed);
+
+	err = vmeta_frame_to_json_str(frame, str, maxlen);
+	CU_ASSERT_EQUAL(err, 0);
+	parsed = json_tokener_parse(str);
+	CU_ASSERT_PTR_NOT_NULL(parsed);
+	if (parsed != NULL)
+		compare_json(jobj, parsed);
+	json_object_put(parsed);
+
+	free(str);
+	json_object_put(jobj);
+}
@@ -0,0 +1,663 @@
+/**
+ * Copyright (c) 2016 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vmeta_test.h"
+
+#include <unistd.h>
+
+#include <video-metadata/vmeta_extract.h>
+
+
+#define INDEX_HEADER_SIZE 32
+#define INDEX_ENTRY_SIZE 64
+#define INDEX_TRACK_ID 7
+#define INDEX_COUNT 64
+
+
+static void put_u16(uint8_t *p, uint16_t val)
+{
+	p[0] = val & 0xff;
+	p[1] = val >> 8;
+}
+
+
+static void put_u32(uint8_t *p, uint32_t val)
+{
+	put_u16(p, val & 0xffff);
+	put_u16(p + 2, val >> 16);
+}
+
+
+static void put_u64(uint8_t *p, uint64_t val)
+{
+	put_u32(p, val & 0xffffffff);
+	put_u32(p + 4, val >> 32);
+}
+
+
+static void put_f64(uint8_t *p, double val)
+{
+	uint64_t u;
+
+	memcpy(&u, &val, sizeof(u));
+	put_u64(p, u);
+}
+
+
+/* Entries every 33.333ms, every other sample, with a location for 3 of 4
+ * entries; the longitude crosses the 180th meridian */
+static void fill_entries(struct vmeta_extract_index_entry *entries,
+			 unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++) {
+		struct vmeta_extract_index_entry *e = &entries[i];
+		memset(e, 0, sizeof(*e));
+		e->sample = 2 * i;
+		e->flags = VMETA_EXTRACT_INDEX_FLAG_FRAME_TIMESTAMP;
+		e->dts = 1000 + 33333 * (uint64_t)i;
+		e->offset = 4096 + 1000 * (uint64_t)i;
+		e->size = 200 + i;
+		e->frame_timestamp = 5000000 + 33333 * (uint64_t)i;
+		if ((i % 4) == 3) {
+			e->latitude = NAN;
+			e->longitude = NAN;
+			e->altitude = NAN;
+			continue;
+		}
+		e->flags |= VMETA_EXTRACT_INDEX_FLAG_LOCATION;
+		e->latitude = -10. + 0.3 * i;
+		e->longitude = 178.5 + 0.05 * i;
+		if (e->longitude > 180.)
+			e->longitude -= 360.;
+		e->altitude = 100. + i;
+	}
+}
+
+
+/* Build a sidecar file in the documented format, with optional extra bytes
+ * at the end of the entries */
+static size_t build_sidecar(uint8_t *buf,
+			    const struct vmeta_extract_index_entry *entries,
+			    unsigned int count,
+			    unsigned int entry_size)
+{
+	uint8_t *p = buf + INDEX_HEADER_SIZE;
+
+	memset(buf, 0, INDEX_HEADER_SIZE + count * entry_size);
+	memcpy(buf, "VMXI", 4);
+	put_u16(buf + 4, 1);
+	put_u16(buf + 6, entry_size);
+	put_u32(buf + 8, INDEX_TRACK_ID);
+	put_u32(buf + 12, count);
+	for (unsigned int i = 0; i < count; i++, p += entry_size) {
+		const struct vmeta_extract_index_entry *e = &entries[i];
+		put_u32(p, e->sample);
+		put_u32(p + 4, e->flags);
+		put_u64(p + 8, e->dts);
+		put_u64(p + 16, e->offset);
+		put_u32(p + 24, e->size);
+		put_u64(p + 32, e->frame_timestamp);
+		put_f64(p + 40, e->latitude);
+		put_f64(p + 48, e->longitude);
+		put_f64(p + 56, e->altitude);
+	}
+	return INDEX_HEADER_SIZE + count * entry_size;
+}
+
+
+static void write_file(const char *path, const uint8_t *data, size_t len)
+{
+	FILE *f = fopen(path, "wb");
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT_EQUAL(fwrite(data, 1, len, f), len);
+	fclose(f);
+}
+
+
+static void compare_double(double d1, double d2)
+{
+	if (isnan(d1)) {
+		CU_ASSERT(isnan(d2));
+	} else {
+		CU_ASSERT_EQUAL(d1, d2);
+	}
+}
+
+
+static void compare_index(struct vmeta_extract_index *index,
+			  const struct vmeta_extract_index_entry *entries,
+			  unsigned int count)
+{
+	CU_ASSERT_EQUAL(vmeta_extract_index_get_track_id(index),
+			INDEX_TRACK_ID);
+	CU_ASSERT_EQUAL_FATAL(vmeta_extract_index_get_count(index), count);
+	CU_ASSERT_PTR_NULL(vmeta_extract_index_get_entry(index, count));
+
+	for (unsigned int i = 0; i < count; i++) {
+		const struct vmeta_extract_index_entry *e1 = &entries[i];
+		const struct vmeta_extract_index_entry *e2 =
+			vmeta_extract_index_get_entry(index, i);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(e2);
+		CU_ASSERT_EQUAL(e1->sample, e2->sample);
+		CU_ASSERT_EQUAL(e1->flags, e2->flags);
+		CU_ASSERT_EQUAL(e1->dts, e2->dts);
+		CU_ASSERT_EQUAL(e1->offset, e2->offset);
+		CU_ASSERT_EQUAL(e1->size, e2->size);
+		CU_ASSERT_EQUAL(e1->frame_timestamp, e2->frame_timestamp);
+		compare_double(e1->latitude, e2->latitude);
+		compare_double(e1->longitude, e2->longitude);
+		compare_double(e1->altitude, e2->altitude);
+	}
+}
+
+
+static void test_index_save_load(void)
+{
+	struct vmeta_extract_index_entry entries[INDEX_COUNT];
+	static uint8_t buf[INDEX_HEADER_SIZE + INDEX_COUNT * 72];
+	static uint8_t saved[sizeof(buf)];
+	struct vmeta_extract_index *index, *index2;
+	char path[] = "/tmp/vmeta_test_index_XXXXXX";
+	size_t len;
+	FILE *f;
+	int err, fd;
+
+	fd = mkstemp(path);
+	CU_ASSERT_FATAL(fd >= 0);
+	close(fd);
+	fill_entries(entries, INDEX_COUNT);
+
+	err = vmeta_extract_index_load(NULL, &index);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_extract_index_load(path, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	len = build_sidecar(buf, entries, INDEX_COUNT, INDEX_ENTRY_SIZE);
+	write_file(path, buf, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	compare_index(index, entries, INDEX_COUNT);
+
+	/* The saved file is identical to the loaded one */
+	err = vmeta_extract_index_save(index, path);
+	CU_ASSERT_EQUAL(err, 0);
+	f = fopen(path, "rb");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT_EQUAL(fread(saved, 1, sizeof(saved), f), len);
+	fclose(f);
+	CU_ASSERT_EQUAL(memcmp(saved, buf, len), 0);
+	err = vmeta_extract_index_load(path, &index2);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	compare_index(index2, entries, INDEX_COUNT);
+	vmeta_extract_index_destroy(index2);
+	vmeta_extract_index_destroy(index);
+
+	/* Larger entries of later versions: the extra bytes are skipped */
+	len = build_sidecar(buf, entries, INDEX_COUNT, 72);
+	write_file(path, buf, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	compare_index(index, entries, INDEX_COUNT);
+	vmeta_extract_index_destroy(index);
+
+	/* Empty index */
+	len = build_sidecar(buf, entries, 0, INDEX_ENTRY_SIZE);
+	write_file(path, buf, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	compare_index(index, entries, 0);
+	vmeta_extract_index_destroy(index);
+
+	unlink(path);
+}
+
+
+static void test_index_find_by_time(void)
+{
+	struct vmeta_extract_index_entry entries[INDEX_COUNT];
+	static uint8_t buf[INDEX_HEADER_SIZE + INDEX_COUNT * INDEX_ENTRY_SIZE];
+	struct vmeta_extract_index *index;
+	char path[] = "/tmp/vmeta_test_index_XXXXXX";
+	uint64_t last;
+	size_t len;
+	int err, fd;
+
+	fd = mkstemp(path);
+	CU_ASSERT_FATAL(fd >= 0);
+	close(fd);
+	fill_entries(entries, INDEX_COUNT);
+	len = build_sidecar(buf, entries, INDEX_COUNT, INDEX_ENTRY_SIZE);
+	write_file(path, buf, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+
+	err = vmeta_extract_index_find_by_time(NULL, 0);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	/* Before the first entry */
+	err = vmeta_extract_index_find_by_time(index, 0);
+	CU_ASSERT_EQUAL(err, -ENOENT);
+	err = vmeta_extract_index_find_by_time(index, entries[0].dts - 1);
+	CU_ASSERT_EQUAL(err, -ENOENT);
+
+	/* On and between the entries */
+	for (int i = 0; i < INDEX_COUNT; i++) {
+		err = vmeta_extract_index_find_by_time(index, entries[i].dts);
+		CU_ASSERT_EQUAL(err, i);
+		err = vmeta_extract_index_find_by_time(index,
+						       entries[i].dts + 1);
+		CU_ASSERT_EQUAL(err, i);
+		if (i + 1 < INDEX_COUNT) {
+			err = vmeta_extract_index_find_by_time(
+				index, entries[i + 1].dts - 1);
+			CU_ASSERT_EQUAL(err, i);
+		}
+	}
+
+	/* After the last entry */
+	last = entries[INDEX_COUNT - 1].dts;
+	err = vmeta_extract_index_find_by_time(index, last + 1000000);
+	CU_ASSERT_EQUAL(err, INDEX_COUNT - 1);
+	err = vmeta_extract_index_find_by_time(index, UINT64_MAX);
+	CU_ASSERT_EQUAL(err, INDEX_COUNT - 1);
+	vmeta_extract_index_destroy(index);
+
+	/* Empty index */
+	len = build_sidecar(buf, entries, 0, INDEX_ENTRY_SIZE);
+	write_file(path, buf, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	err = vmeta_extract_index_find_by_time(index, last);
+	CU_ASSERT_EQUAL(err, -ENOENT);
+	vmeta_extract_index_destroy(index);
+
+	unlink(path);
+}
+
+
+static bool in_bbox(const struct vmeta_extract_index_entry *e,
+		    const struct vmeta_extract_bbox *bbox)
+{
+	if (!(e->flags & VMETA_EXTRACT_INDEX_FLAG_LOCATION))
+		return false;
+	if (e->latitude < bbox->min_latitude ||
+	    e->latitude > bbox->max_latitude)
+		return false;
+	if (bbox->min_longitude <= bbox->max_longitude)
+		return e->longitude >= bbox->min_longitude &&
+		       e->longitude <= bbox->max_longitude;
+	return e->longitude >= bbox->min_longitude ||
+	       e->longitude <= bbox->max_longitude;
+}
+
+
+static void check_bbox(struct vmeta_extract_index *index,
+		       const struct vmeta_extract_index_entry *entries,
+		       const struct vmeta_extract_bbox *bbox,
+		       int expected)
+{
+	unsigned int idx[INDEX_COUNT];
+	bool found[INDEX_COUNT] = {0};
+	int count = 0;
+	int ret;
+
+	ret = vmeta_extract_index_find_in_bbox(index, bbox, idx, INDEX_COUNT);
+	CU_ASSERT_EQUAL_FATAL(ret, expected);
+	for (int i = 0; i < ret; i++) {
+		CU_ASSERT_FATAL(idx[i] < INDEX_COUNT);
+		CU_ASSERT_FALSE(found[idx[i]]);
+		found[idx[i]] = true;
+	}
+	for (unsigned int i = 0; i < INDEX_COUNT; i++) {
+		CU_ASSERT_EQUAL(found[i], in_bbox(&entries[i], bbox));
+		count += in_bbox(&entries[i], bbox);
+	}
+	CU_ASSERT_EQUAL(count, expected);
+
+	/* The total is returned even if the array is too small */
+	ret = vmeta_extract_index_find_in_bbox(index, bbox, NULL, 0);
+	CU_ASSERT_EQUAL(ret, expected);
+	if (expected > 1) {
+		ret = vmeta_extract_index_find_in_bbox(index, bbox, idx, 1);
+		CU_ASSERT_EQUAL(ret, expected);
+	}
+}
+
+
+static void test_index_find_in_bbox(void)
+{
+	struct vmeta_extract_index_entry entries[INDEX_COUNT];
+	static uint8_t buf[INDEX_HEADER_SIZE + INDEX_COUNT * INDEX_ENTRY_SIZE];
+	struct vmeta_extract_index *index;
+	struct vmeta_extract_bbox bbox;
+	char path[] = "/tmp/vmeta_test_index_XXXXXX";
+	unsigned int idx[INDEX_COUNT];
+	size_t len;
+	int err, fd;
+
+	fd = mkstemp(path);
+	CU_ASSERT_FATAL(fd >= 0);
+	close(fd);
+	fill_entries(entries, INDEX_COUNT);
+	len = build_sidecar(buf, entries, INDEX_COUNT, INDEX_ENTRY_SIZE);
+	write_file(path, buf, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+
+	err = vmeta_extract_index_find_in_bbox(index, NULL, idx, INDEX_COUNT);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	bbox.min_latitude = -90.;
+	bbox.max_latitude = 90.;
+	bbox.min_longitude = -180.;
+	bbox.max_longitude = 180.;
+	err = vmeta_extract_index_find_in_bbox(index, &bbox, NULL, 1);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	/* Whole world: all the entries with a location */
+	check_bbox(index, entries, &bbox, INDEX_COUNT - INDEX_COUNT / 4);
+
+	/* Crossing the 180th meridian, on each side and on both sides */
+	bbox.min_longitude = 179.;
+	bbox.max_longitude = -179.;
+	check_bbox(index, entries, &bbox, 31);
+	bbox.min_longitude = 179.;
+	bbox.max_longitude = -179.9;
+	check_bbox(index, entries, &bbox, 17);
+	bbox.min_longitude = 179.95;
+	bbox.max_longitude = -179.;
+	check_bbox(index, entries, &bbox, 17);
+
+	/* Crossing the 180th meridian with a latitude range */
+	bbox.min_latitude = -2.;
+	bbox.max_latitude = 2.;
+	bbox.min_longitude = 179.5;
+	bbox.max_longitude = -179.5;
+	check_bbox(index, entries, &bbox, 10);
+
+	/* Outside of the locations */
+	bbox.min_latitude = 20.;
+	bbox.max_latitude = 30.;
+	bbox.min_longitude = 179.;
+	bbox.max_longitude = -179.;
+	check_bbox(index, entries, &bbox, 0);
+	vmeta_extract_index_destroy(index);
+
+	unlink(path);
+}
+
+
+static void check_load_error(const char *path,
+			     const uint8_t *data,
+			     size_t len,
+			     int expected)
+{
+	struct vmeta_extract_index *index = NULL;
+	int err;
+
+	write_file(path, data, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL(err, expected);
+	CU_ASSERT_PTR_NULL(index);
+}
+
+
+static void test_index_corrupt(void)
+{
+	struct vmeta_extract_index_entry entries[INDEX_COUNT];
+	static uint8_t buf[INDEX_HEADER_SIZE + INDEX_COUNT * INDEX_ENTRY_SIZE];
+	struct vmeta_extract_index *index;
+	char path[] = "/tmp/vmeta_test_index_XXXXXX";
+	uint8_t *e;
+	size_t len;
+	int err, fd;
+
+	fd = mkstemp(path);
+	CU_ASSERT_FATAL(fd >= 0);
+	close(fd);
+	fill_entries(entries, INDEX_COUNT);
+	len = build_sidecar(buf, entries, INDEX_COUNT, INDEX_ENTRY_SIZE);
+
+	/* Empty file and truncated header */
+	check_load_error(path, buf, 0, -EPROTO);
+	check_load_error(path, buf, INDEX_HEADER_SIZE - 1, -EPROTO);
+
+	/* Truncated entries */
+	check_load_error(path, buf, len - 1, -EPROTO);
+	check_load_error(path, buf, INDEX_HEADER_SIZE, -EPROTO);
+
+	/* Entry count larger than the file */
+	put_u32(buf + 12, INDEX_COUNT + 1);
+	check_load_error(path, buf, len, -EPROTO);
+	put_u32(buf + 12, UINT32_MAX);
+	check_load_error(path, buf, len, -EPROTO);
+	put_u32(buf + 12, INDEX_COUNT);
+
+	/* Entry size too small or overflowing the file */
+	put_u16(buf + 6, INDEX_ENTRY_SIZE - 1);
+	check_load_error(path, buf, len, -EPROTO);
+	put_u16(buf + 6, UINT16_MAX);
+	check_load_error(path, buf, len, -EPROTO);
+	put_u16(buf + 6, INDEX_ENTRY_SIZE);
+
+	/* Invalid magic and version */
+	buf[0] = 'X';
+	check_load_error(path, buf, len, -EPROTO);
+	buf[0] = 'V';
+	put_u16(buf + 4, 2);
+	check_load_error(path, buf, len, -EPROTO);
+	put_u16(buf + 4, 1);
+
+	/* Unsorted entries */
+	e = buf + INDEX_HEADER_SIZE + (INDEX_COUNT / 2) * INDEX_ENTRY_SIZE;
+	put_u64(e + 8, entries[0].dts - 1);
+	check_load_error(path, buf, len, -EPROTO);
+	put_u64(e + 8, entries[INDEX_COUNT / 2].dts);
+
+	/* Restored file */
+	write_file(path, buf, len);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	compare_index(index, entries, INDEX_COUNT);
+	vmeta_extract_index_destroy(index);
+
+	/* Missing file */
+	unlink(path);
+	err = vmeta_extract_index_load(path, &index);
+	CU_ASSERT_EQUAL(err, -ENOENT);
+}
+
+
+/* Read the remaining frames of an iterator; returns the number of frames
+ * and fills the first max_count timestamps */
+static unsigned int read_frames(struct vmeta_extract_frame_iter *iter,
+				uint64_t *timestamps,
+				unsigned int max_count)
+{
+	int err;
+	unsigned int count = 0;
+	uint64_t ts;
+	struct vmeta_frame *meta;
+
+	while ((err = vmeta_extract_frame_iter_next(iter, &ts, &meta)) == 0) {
+		CU_ASSERT_PTR_NOT_NULL_FATAL(meta);
+		vmeta_frame_unref(meta);
+		if (count < max_count)
+			timestamps[count] = ts;
+		count++;
+	}
+	CU_ASSERT_EQUAL(err, -ENOENT);
+
+	/* The end of the track is sticky */
+	err = vmeta_extract_frame_iter_next(iter, &ts, &meta);
+	CU_ASSERT_EQUAL(err, -ENOENT);
+
+	return count;
+}
+
+
+/* Index of the last reference timestamp lower than or equal to ts */
+static unsigned int find_timestamp(const uint64_t *ref,
+				   unsigned int count,
+				   uint64_t ts)
+{
+	unsigned int i = 0;
+
+	while ((i + 1 < count) && (ref[i + 1] <= ts))
+		i++;
+	return i;
+}
+
+
+static void check_frame_iter(const char *path,
+			     unsigned int flags,
+			     struct vmeta_extract_index *index,
+			     const uint64_t *ref,
+			     unsigned int count)
+{
+	int err;
+	unsigned int n, mid;
+	uint64_t ts, *timestamps;
+	struct vmeta_extract_frame_iter *iter;
+	struct vmeta_frame *first, *meta;
+	const struct vmeta_extract_index_entry *entry;
+
+	timestamps = calloc(count, sizeof(*timestamps));
+	CU_ASSERT_PTR_NOT_NULL_FATAL(timestamps);
+
+	err = vmeta_extract_frame_iter_new(path, NULL, flags, &iter);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+
+	/* Same frames as the reference, the first one being kept across
+	 * the whole iteration */
+	err = vmeta_extract_frame_iter_next(iter, &ts, &first);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	CU_ASSERT_EQUAL(ts, ref[0]);
+	n = read_frames(iter, timestamps + 1, count - 1);
+	CU_ASSERT_EQUAL(n, count - 1);
+	CU_ASSERT_EQUAL(memcmp(timestamps + 1,
+			       ref + 1,
+			       (count - 1) * sizeof(*ref)),
+			0);
+
+	/* Seek after the end of the track: the seek moves to the previous
+	 * sync sample, so the iteration resumes at or before the target */
+	mid = count / 2;
+	err = vmeta_extract_frame_iter_seek(iter, ref[mid]);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_extract_frame_iter_next(iter, &ts, &meta);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	vmeta_frame_unref(meta);
+	CU_ASSERT(ts <= ref[mid]);
+	n = find_timestamp(ref, count, ts);
+	CU_ASSERT_EQUAL(ts, ref[n]);
+	CU_ASSERT_EQUAL(read_frames(iter, timestamps, count), count - n - 1);
+
+	/* Seek back to the start while frames are pending */
+	err = vmeta_extract_frame_iter_seek(iter, ref[mid]);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_extract_frame_iter_next(iter, &ts, &meta);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	vmeta_frame_unref(meta);
+	err = vmeta_extract_frame_iter_seek(iter, 0);
+	CU_ASSERT_EQUAL(err, 0);
+	n = read_frames(iter, timestamps, count);
+	CU_ASSERT_EQUAL(n, count);
+	CU_ASSERT_EQUAL(memcmp(timestamps, ref, count * sizeof(*ref)), 0);
+
+	err = vmeta_extract_frame_iter_destroy(iter);
+	CU_ASSERT_EQUAL(err, 0);
+
+	/* Frames returned before the destruction are still valid */
+	entry = vmeta_extract_index_get_entry(index, 0);
+	if (entry->flags & VMETA_EXTRACT_INDEX_FLAG_FRAME_TIMESTAMP) {
+		err = vmeta_frame_get_frame_timestamp(first, &ts);
+		CU_ASSERT_EQUAL(err, 0);
+		CU_ASSERT_EQUAL(ts, entry->frame_timestamp);
+	}
+	vmeta_frame_unref(first);
+
+	free(timestamps);
+}
+
+
+static void test_frame_iter(void)
+{
+	int err;
+	unsigned int count;
+	uint64_t ts, *ref;
+	struct vmeta_extract_index *index;
+	struct vmeta_extract_frame_iter *iter;
+	struct vmeta_frame *meta;
+	const char *path = getenv("VMETA_TEST_MP4");
+
+	err = vmeta_extract_frame_iter_new(NULL, NULL, 0, &iter);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_extract_frame_iter_new("test.mp4", NULL, 0, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_extract_frame_iter_next(NULL, &ts, &meta);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_extract_frame_iter_seek(NULL, 0);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_extract_frame_iter_destroy(NULL);
+	CU_ASSERT_EQUAL(err, 0);
+
+	/* The other checks need an MP4 recording with frame metadata */
+	if (path == NULL)
+		return;
+
+	/* Reference timestamps from an index of the same recording, which
+	 * reads the samples independently of the iterator */
+	err = vmeta_extract_index_new(path, NULL, &index);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	err = vmeta_extract_index_get_count(index);
+	CU_ASSERT_FATAL(err > 0);
+	count = err;
+	ref = calloc(count, sizeof(*ref));
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ref);
+	for (unsigned int i = 0; i < count; i++)
+		ref[i] = vmeta_extract_index_get_entry(index, i)->dts;
+
+	check_frame_iter(path, 0, index, ref, count);
+	check_frame_iter(path,
+			 VMETA_EXTRACT_FRAME_ITER_FLAG_PREFETCH,
+			 index,
+			 ref,
+			 count);
+
+	vmeta_extract_index_destroy(index);
+	free(ref);
+}
+
+
+CU_TestInfo s_extract_tests[] = {
+	{(char *)"index save/load", &test_index_save_load},
+	{(char *)"index find by time", &test_index_find_by_time},
+	{(char *)"index find in bbox", &test_index_find_in_bbox},
+	{(char *)"index corrupt sidecar", &test_index_corrupt},
+	{(char *)"frame iterator", &test_frame_iter},
+	CU_TEST_INFO_NULL,
+};
@@ -26,6 +26,10 @@
 
 #include "vmeta_test.h"
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
 
 /**
  * This array can be generated by using the test executable with the 'dump'
@@ -968,11 +972,83 @@ static void test_api(void)
 }
 
 
+#define CONCURRENT_READERS_THREADS 4
+#define CONCURRENT_READERS_LOOPS 10000
+
+
+static void *concurrent_reader_thread(void *userdata)
+{
+	struct vmeta_frame *frame = userdata;
+	const Vmeta__TimedMetadata *ctm;
+	const uint8_t *buf;
+	size_t len;
+	uintptr_t errors = 0;
+	int res;
+
+	for (int i = 0; i < CONCURRENT_READERS_LOOPS; i++) {
+		res = vmeta_frame_proto_get_unpacked(frame, &ctm);
+		if (res != 0 || ctm == NULL) {
+			errors++;
+			continue;
+		}
+		res = vmeta_frame_proto_get_buffer(frame, &buf, &len);
+		if (res == 0)
+			res = vmeta_frame_proto_release_buffer(frame, buf);
+		if (res != 0)
+			errors++;
+		res = vmeta_frame_proto_release_unpacked(frame, ctm);
+		if (res != 0)
+			errors++;
+	}
+
+	return (void *)errors;
+}
+
+
+static void test_concurrent_readers(void)
+{
+	int res;
+	struct vmeta_frame *frame;
+	pthread_t threads[CONCURRENT_READERS_THREADS];
+	Vmeta__TimedMetadata *tm;
+	struct vmeta_buffer vb;
+	void *errors;
+
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	res = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+
+	/* The first readers race to unpack the metadata */
+	for (int i = 0; i < CONCURRENT_READERS_THREADS; i++) {
+		res = pthread_create(
+			&threads[i], NULL, &concurrent_reader_thread, frame);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+	}
+	for (int i = 0; i < CONCURRENT_READERS_THREADS; i++) {
+		res = pthread_join(threads[i], &errors);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT_EQUAL((uintptr_t)errors, 0);
+	}
+
+	/* All read locks are released */
+	res = vmeta_frame_proto_get_unpacked_rw(frame, &tm);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vmeta_frame_proto_release_unpacked_rw(frame, tm);
+	CU_ASSERT_EQUAL(res, 0);
+
+	res = vmeta_frame_unref(frame);
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
 static void test_write(void)
 {
 	struct vmeta_frame *frame = NULL;
 	const size_t buflen = 1024;
 	uint8_t *buf = NULL;
+	const uint8_t *data;
+	size_t len;
 	struct vmeta_buffer vb;
 	int res;
 
@@ -983,6 +1059,33 @@ static void test_write(void)
 	CU_ASSERT_PTR_NOT_NULL(buf);
 	vmeta_buffer_set_data(&vb, buf, buflen, 0);
 
+	/* Too small buffer */
+	vmeta_buffer_set_data(&vb, buf, sizeof(packed_meta) - 1, 0);
+	res = vmeta_frame_write(&vb, frame);
+	CU_ASSERT_EQUAL(res, -ENOBUFS);
+	CU_ASSERT_EQUAL(vb.pos, 0);
+
+	vmeta_buffer_set_data(&vb, buf, buflen, 0);
+	res = vmeta_frame_write(&vb, frame);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(vb.pos, sizeof(packed_meta));
+	CU_ASSERT_EQUAL(memcmp(buf, packed_meta, sizeof(packed_meta)), 0);
+
+	/* Write after existing data, keeping the packed data in the frame */
+	vmeta_buffer_set_data(&vb, buf, buflen, 3);
+	res = vmeta_frame_write2(&vb, frame, 1);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(vb.pos, sizeof(packed_meta) + 3);
+	CU_ASSERT_EQUAL(memcmp(buf + 3, packed_meta, sizeof(packed_meta)), 0);
+	res = vmeta_frame_proto_get_buffer(frame, &data, &len);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(len, sizeof(packed_meta));
+	CU_ASSERT_EQUAL(memcmp(data, packed_meta, sizeof(packed_meta)), 0);
+	res = vmeta_frame_proto_release_buffer(frame, data);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Write from the packed data */
+	vmeta_buffer_set_data(&vb, buf, buflen, 0);
 	res = vmeta_frame_write(&vb, frame);
 	CU_ASSERT_EQUAL(res, 0);
 	CU_ASSERT_EQUAL(vb.pos, sizeof(packed_meta));
@@ -1028,6 +1131,800 @@ static void test_read(void)
 }
 
 
+static void borrowed_release_cb(const uint8_t *data, void *userdata)
+{
+	unsigned int *count = userdata;
+
+	CU_ASSERT_PTR_EQUAL(data, packed_meta);
+	(*count)++;
+}
+
+
+static void test_read_borrowed(void)
+{
+	struct vmeta_frame *frame, *ref;
+	struct vmeta_buffer vb;
+	const uint8_t *buf;
+	size_t len;
+	unsigned int count = 0;
+	int err;
+
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+
+	ref = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL(ref);
+	err = vmeta_frame_read_borrowed(&vb,
+					VMETA_FRAME_PROTO_MIME_TYPE,
+					1,
+					&borrowed_release_cb,
+					&count,
+					&frame);
+	CU_ASSERT_PTR_NOT_NULL(frame);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(count, 0);
+
+	/* The packed buffer must be the caller data */
+	err = vmeta_frame_proto_get_buffer(frame, &buf, &len);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_EQUAL(buf, packed_meta);
+	CU_ASSERT_EQUAL(len, sizeof(packed_meta));
+	err = vmeta_frame_proto_release_buffer(frame, buf);
+	CU_ASSERT_EQUAL(err, 0);
+
+	meta_compare(ref, frame);
+	compare_vmeta_frame_getters(ref, frame);
+
+	vmeta_frame_unref(frame);
+	CU_ASSERT_EQUAL(count, 1);
+	vmeta_frame_unref(ref);
+}
+
+
+static void test_pool(void)
+{
+	struct vmeta_frame_pool *pool;
+	struct vmeta_frame *frame, *frame2, *ref;
+	struct vmeta_frame_proto *proto;
+	struct vmeta_buffer vb;
+	unsigned int count = 0;
+	int err;
+
+	err = vmeta_frame_pool_new(0, &pool);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_frame_pool_new(1, &pool);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_NOT_NULL(pool);
+
+	ref = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL(ref);
+
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_pool_frame_read(
+		pool, &vb, VMETA_FRAME_PROTO_MIME_TYPE, 1, &frame);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_NOT_NULL(frame);
+	CU_ASSERT_EQUAL(frame->type, VMETA_FRAME_TYPE_PROTO);
+	meta_compare(ref, frame);
+	proto = frame->proto;
+	vmeta_frame_unref(frame);
+
+	/* The structures must be reused */
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_pool_frame_read_borrowed(pool,
+						   &vb,
+						   VMETA_FRAME_PROTO_MIME_TYPE,
+						   1,
+						   &borrowed_release_cb,
+						   &count,
+						   &frame2);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_EQUAL(frame2, frame);
+	CU_ASSERT_PTR_EQUAL(frame2->proto, proto);
+	CU_ASSERT_EQUAL(vmeta_frame_get_ref_count(frame2), 1);
+	meta_compare(ref, frame2);
+	compare_vmeta_frame_getters(ref, frame2);
+	vmeta_frame_unref(frame2);
+	CU_ASSERT_EQUAL(count, 1);
+
+	err = vmeta_frame_pool_frame_new(pool, VMETA_FRAME_TYPE_PROTO, &frame);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_EQUAL(frame, frame2);
+	CU_ASSERT_PTR_EQUAL(frame->proto, proto);
+
+	/* Frames outlive the pool */
+	err = vmeta_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(err, 0);
+	meta_compare(frame, frame);
+	vmeta_frame_unref(frame);
+
+	vmeta_frame_unref(ref);
+}
+
+
+static void test_read_batch(void)
+{
+	struct vmeta_frame_reader *reader;
+	struct vmeta_frame *ref, *frames[3];
+	struct vmeta_buffer bufs[3];
+	uint64_t empty_cookie = VMETA_FRAME_PROTO_EMPTY_COOKIE;
+	ssize_t count;
+	int err;
+
+	err = vmeta_frame_reader_new("application/unknown", 1, NULL, &reader);
+	CU_ASSERT_EQUAL(err, -ENOSYS);
+
+	err = vmeta_frame_reader_new(
+		VMETA_FRAME_PROTO_MIME_TYPE, 1, NULL, &reader);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+
+	ref = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL(ref);
+
+	vmeta_buffer_set_cdata(&bufs[0], packed_meta, sizeof(packed_meta), 0);
+	vmeta_buffer_set_cdata(&bufs[1],
+			       (const uint8_t *)&empty_cookie,
+			       sizeof(empty_cookie),
+			       0);
+	vmeta_buffer_set_cdata(&bufs[2], packed_meta, sizeof(packed_meta), 0);
+
+	count = vmeta_frame_read_batch(reader, bufs, 3, frames);
+	CU_ASSERT_EQUAL(count, 2);
+	CU_ASSERT_PTR_NOT_NULL(frames[0]);
+	CU_ASSERT_PTR_NULL(frames[1]);
+	CU_ASSERT_PTR_NOT_NULL(frames[2]);
+	meta_compare(ref, frames[0]);
+	meta_compare(ref, frames[2]);
+
+	vmeta_frame_unref(frames[0]);
+	vmeta_frame_unref(frames[2]);
+	vmeta_frame_unref(ref);
+	err = vmeta_frame_reader_destroy(reader);
+	CU_ASSERT_EQUAL(err, 0);
+}
+
+
+static void test_read_packed_getters(void)
+{
+	struct vmeta_frame *frame, *in;
+	uint8_t *buf;
+	const size_t buflen = 1 * 1024 * 1024;
+	struct vmeta_buffer vb;
+	struct vmeta_location loc;
+	uint64_t ts;
+	int err;
+
+	/* Getters on packed-only metadata (decoded from the packed buffer) */
+	in = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL(in);
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL(err, 0);
+	compare_vmeta_frame_getters(in, frame);
+	vmeta_frame_unref(frame);
+	vmeta_frame_unref(in);
+
+	buf = malloc(buflen);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+	for (int i = 0; i < 100; i++) {
+		vmeta_buffer_set_data(&vb, buf, buflen, 0);
+		in = unpacked_meta(1);
+		CU_ASSERT_PTR_NOT_NULL(in);
+		err = vmeta_frame_write(&vb, in);
+		CU_ASSERT_EQUAL(err, 0);
+		vb.len = vb.pos;
+		vb.pos = 0;
+		err = vmeta_frame_read(
+			&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+		CU_ASSERT_EQUAL(err, 0);
+		compare_vmeta_frame_getters(in, frame);
+		vmeta_frame_unref(frame);
+		vmeta_frame_unref(in);
+	}
+	free(buf);
+
+	/* Truncated buffer */
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta) / 2, 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_get_location(frame, &loc);
+	CU_ASSERT_EQUAL(err, -EPROTO);
+	err = vmeta_frame_get_frame_timestamp(frame, &ts);
+	CU_ASSERT_EQUAL(err, -EPROTO);
+	vmeta_frame_unref(frame);
+}
+
+
+#define CHECK_FIELD(_field, _name, _type, _member)                             \
+	do {                                                                   \
+		_type __val;                                                   \
+		int __err = vmeta_frame_get_##_name(frame, &__val);            \
+		CU_ASSERT_EQUAL(!!(flat.present & VMETA_FRAME_FIELD_##_field), \
+				__err == 0);                                   \
+		if (__err == 0)                                                \
+			CU_ASSERT_EQUAL(memcmp(&__val,                         \
+					       &flat._member,                  \
+					       sizeof(__val)),                 \
+					0);                                    \
+	} while (0)
+
+
+static void check_frame_fields(struct vmeta_frame *frame)
+{
+	struct vmeta_frame_flat flat;
+	int err;
+
+	err = vmeta_frame_get_fields(frame, VMETA_FRAME_FIELD_ALL, &flat);
+	CU_ASSERT_EQUAL(err, 0);
+
+	CHECK_FIELD(TIMESTAMP, frame_timestamp, uint64_t, timestamp);
+	CHECK_FIELD(
+		UTC_TIMESTAMP, frame_utc_timestamp, uint64_t, utc_timestamp);
+	CHECK_FIELD(LOCATION, location, struct vmeta_location, location);
+	CHECK_FIELD(SPEED_NED, speed_ned, struct vmeta_ned, speed);
+	CHECK_FIELD(GROUND_DISTANCE, ground_distance, double, ground_distance);
+	CHECK_FIELD(ALTITUDE_ATO, altitude_above_takeoff, double, altitude_ato);
+	CHECK_FIELD(
+		DRONE_QUAT, drone_quat, struct vmeta_quaternion, drone_quat);
+	CHECK_FIELD(
+		FRAME_QUAT, frame_quat, struct vmeta_quaternion, frame_quat);
+	CHECK_FIELD(FRAME_BASE_QUAT,
+		    frame_base_quat,
+		    struct vmeta_quaternion,
+		    frame_base_quat);
+	CHECK_FIELD(EXPOSURE_TIME, exposure_time, float, exposure_time);
+	CHECK_FIELD(GAIN, gain, uint16_t, gain);
+	CHECK_FIELD(AWB_R_GAIN, awb_r_gain, float, awb_r_gain);
+	CHECK_FIELD(AWB_B_GAIN, awb_b_gain, float, awb_b_gain);
+	CHECK_FIELD(PICTURE_H_FOV, picture_h_fov, float, picture_h_fov);
+	CHECK_FIELD(PICTURE_V_FOV, picture_v_fov, float, picture_v_fov);
+	CHECK_FIELD(ZOOM_LEVEL, camera_zoom_level, float, zoom_level);
+	CHECK_FIELD(BATTERY_PERCENTAGE,
+		    battery_percentage,
+		    uint8_t,
+		    battery_percentage);
+	CHECK_FIELD(FLYING_STATE,
+		    flying_state,
+		    enum vmeta_flying_state,
+		    flying_state);
+	CHECK_FIELD(PILOTING_MODE,
+		    piloting_mode,
+		    enum vmeta_piloting_mode,
+		    piloting_mode);
+	CHECK_FIELD(LINK_GOODPUT, link_goodput, uint32_t, link_goodput);
+	CHECK_FIELD(LINK_QUALITY, link_quality, uint8_t, link_quality);
+	CHECK_FIELD(WIFI_RSSI, wifi_rssi, int8_t, wifi_rssi);
+
+	/* Only the requested fields are filled */
+	err = vmeta_frame_get_fields(frame,
+				     VMETA_FRAME_FIELD_TIMESTAMP |
+					     VMETA_FRAME_FIELD_LOCATION,
+				     &flat);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(flat.present & ~(VMETA_FRAME_FIELD_TIMESTAMP |
+					 VMETA_FRAME_FIELD_LOCATION),
+			0);
+	CHECK_FIELD(TIMESTAMP, frame_timestamp, uint64_t, timestamp);
+	CHECK_FIELD(LOCATION, location, struct vmeta_location, location);
+}
+
+
+static void test_get_fields(void)
+{
+	struct vmeta_frame *frame, *in;
+	uint8_t *buf;
+	const size_t buflen = 1 * 1024 * 1024;
+	struct vmeta_buffer vb;
+	struct vmeta_frame_flat flat;
+	int err;
+
+	err = vmeta_frame_get_fields(NULL, VMETA_FRAME_FIELD_ALL, &flat);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	/* Packed-only and unpacked metadata */
+	in = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL(in);
+	err = vmeta_frame_get_fields(in, VMETA_FRAME_FIELD_ALL, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	check_frame_fields(in);
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL(err, 0);
+	check_frame_fields(frame);
+	vmeta_frame_unref(frame);
+	vmeta_frame_unref(in);
+
+	buf = malloc(buflen);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+	for (int i = 0; i < 100; i++) {
+		vmeta_buffer_set_data(&vb, buf, buflen, 0);
+		in = unpacked_meta(1);
+		CU_ASSERT_PTR_NOT_NULL(in);
+		err = vmeta_frame_write(&vb, in);
+		CU_ASSERT_EQUAL(err, 0);
+		vb.len = vb.pos;
+		vb.pos = 0;
+		err = vmeta_frame_read(
+			&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+		CU_ASSERT_EQUAL(err, 0);
+		check_frame_fields(frame);
+		vmeta_frame_unref(frame);
+		vmeta_frame_unref(in);
+	}
+	free(buf);
+
+	/* Truncated buffer */
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta) / 2, 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_get_fields(frame, VMETA_FRAME_FIELD_ALL, &flat);
+	CU_ASSERT_EQUAL(err, -EPROTO);
+	vmeta_frame_unref(frame);
+}
+
+
+/* Fill the stack area used by the next call with non-zero garbage, so that a
+ * getter reading an uninitialized local sees it */
+static __attribute__((noinline)) void dirty_stack(void)
+{
+	volatile uint8_t junk[16 * 1024];
+
+	for (size_t i = 0; i < sizeof(junk); i++)
+		junk[i] = 0xff;
+}
+
+
+#define CHECK_DIRTY_GETTER(_name, _type)                                       \
+	do {                                                                   \
+		_type __ref, __val;                                            \
+		int __ref_err, __err;                                          \
+		memset(&__ref, 0, sizeof(__ref));                              \
+		memset(&__val, 0, sizeof(__val));                              \
+		__ref_err = vmeta_frame_get_##_name(frame, &__ref);            \
+		dirty_stack();                                                 \
+		__err = vmeta_frame_get_##_name(frame, &__val);                \
+		CU_ASSERT_EQUAL(__err, __ref_err);                             \
+		if (__err == 0 && __ref_err == 0)                              \
+			CU_ASSERT_EQUAL(                                       \
+				memcmp(&__val, &__ref, sizeof(__val)), 0);     \
+	} while (0)
+
+
+static void check_dirty_getters(struct vmeta_frame *frame)
+{
+	CHECK_DIRTY_GETTER(drone_euler, struct vmeta_euler);
+	CHECK_DIRTY_GETTER(frame_euler, struct vmeta_euler);
+	CHECK_DIRTY_GETTER(frame_local_quat, struct vmeta_quaternion);
+	CHECK_DIRTY_GETTER(frame_base_euler, struct vmeta_euler);
+	CHECK_DIRTY_GETTER(camera_location, struct vmeta_location);
+	CHECK_DIRTY_GETTER(camera_principal_point, struct vmeta_xy);
+	CHECK_DIRTY_GETTER(camera_spectrum, enum vmeta_camera_spectrum);
+	CHECK_DIRTY_GETTER(camera_subtype, enum vmeta_camera_subtype);
+}
+
+
+static void test_dirty_stack_getters(void)
+{
+	struct vmeta_frame *frame, *in;
+	uint8_t *buf;
+	const size_t buflen = 1 * 1024 * 1024;
+	struct vmeta_buffer vb;
+	int err;
+
+	/* Unpacked and packed-only metadata */
+	in = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(in);
+	check_dirty_getters(in);
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	check_dirty_getters(frame);
+	vmeta_frame_unref(frame);
+	vmeta_frame_unref(in);
+
+	buf = malloc(buflen);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+	for (int i = 0; i < 100; i++) {
+		vmeta_buffer_set_data(&vb, buf, buflen, 0);
+		in = unpacked_meta(1);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(in);
+		check_dirty_getters(in);
+		err = vmeta_frame_write(&vb, in);
+		CU_ASSERT_EQUAL(err, 0);
+		vb.len = vb.pos;
+		vb.pos = 0;
+		err = vmeta_frame_read(
+			&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+		CU_ASSERT_EQUAL_FATAL(err, 0);
+		check_dirty_getters(frame);
+		vmeta_frame_unref(frame);
+		vmeta_frame_unref(in);
+	}
+	free(buf);
+}
+
+
+static void test_json_parity(void)
+{
+	struct vmeta_frame *frame, *in;
+	Vmeta__TimedMetadata *tm;
+	struct vmeta_buffer vb;
+	int err;
+
+	/* Unpacked and packed-only metadata, with LFIC and user entries */
+	in = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(in);
+	compare_vmeta_frame_json(in);
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	compare_vmeta_frame_json(frame);
+	vmeta_frame_unref(frame);
+
+	/* NaN and infinite values */
+	err = vmeta_frame_proto_get_unpacked_rw(in, &tm);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(tm->drone);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(tm->camera);
+	CU_ASSERT_FATAL(tm->n_lfic > 0);
+	tm->drone->ground_distance = NAN;
+	tm->drone->altitude_ato = -INFINITY;
+	tm->camera->exposure_time = INFINITY;
+	tm->camera->zoom_level = NAN;
+	tm->lfic[0]->grid_precision = NAN;
+	tm->lfic[0]->x = 1e-45f;
+	err = vmeta_frame_proto_release_unpacked_rw(in, tm);
+	CU_ASSERT_EQUAL(err, 0);
+	compare_vmeta_frame_json(in);
+	vmeta_frame_unref(in);
+
+	for (int i = 0; i < 100; i++) {
+		in = unpacked_meta(1);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(in);
+		compare_vmeta_frame_json(in);
+		vmeta_frame_unref(in);
+	}
+}
+
+
+static void test_to_csv(void)
+{
+	struct vmeta_frame *frame, *in;
+	struct vmeta_csv_buf csv = {0};
+	struct vmeta_buffer vb;
+	struct vmeta_frame_flat flat;
+	char header[2048];
+	char str[2048];
+	unsigned int count;
+	ssize_t res;
+	int err;
+
+	res = vmeta_frame_csv_header(VMETA_FRAME_TYPE_PROTO,
+				     header,
+				     sizeof(header));
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_EQUAL(strlen(header), (size_t)res);
+	count = count_csv_values(header, res);
+	CU_ASSERT_NOT_EQUAL(count, 0);
+
+	/* Same columns as the header, for unpacked and packed-only metadata */
+	in = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(in);
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+
+	res = vmeta_frame_to_csv(in, str, sizeof(str));
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_EQUAL(count_csv_values(str, res), count);
+	err = vmeta_frame_get_fields(in, VMETA_FRAME_FIELD_TIMESTAMP, &flat);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(strtoull(str, NULL, 10), flat.timestamp);
+
+	res = vmeta_frame_to_csv(frame, header, sizeof(header));
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_STRING_EQUAL(header, str);
+
+	res = vmeta_frame_csv_append(frame, &csv);
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_EQUAL(count_csv_values(csv.str, res), count);
+
+	/* Truncated buffer */
+	vmeta_frame_unref(frame);
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta) / 2, 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	res = vmeta_frame_to_csv(frame, str, sizeof(str));
+	CU_ASSERT_EQUAL(res, -EPROTO);
+
+	free(csv.str);
+	vmeta_frame_unref(frame);
+	vmeta_frame_unref(in);
+}
+
+
+static void test_frame_table(void)
+{
+	struct vmeta_frame_table *table;
+	struct vmeta_frame *frames[10];
+	struct vmeta_frame_flat flat;
+	struct vmeta_buffer vb;
+	const uint64_t *ts;
+	const double *lat;
+	const float *quat_w;
+	const uint8_t *ts_presence, *lat_presence, *quat_presence;
+	size_t count;
+	int err;
+
+	err = vmeta_frame_table_new(0, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_frame_table_destroy(NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	/* The column sizes must not overflow */
+	err = vmeta_frame_table_new(SIZE_MAX / 2 + 1, &table);
+	CU_ASSERT_EQUAL(err, -ENOMEM);
+
+	/* Small capacity to force the columns to grow */
+	err = vmeta_frame_table_new(3, &table);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &frames[0]);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	for (size_t i = 1; i < SIZEOF_ARRAY(frames); i++) {
+		frames[i] = unpacked_meta(1);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(frames[i]);
+	}
+	for (size_t i = 0; i < SIZEOF_ARRAY(frames); i++) {
+		err = vmeta_frame_table_append(table, frames[i]);
+		CU_ASSERT_EQUAL(err, 0);
+	}
+	err = vmeta_frame_table_get_count(table, &count);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(count, SIZEOF_ARRAY(frames));
+
+	err = vmeta_frame_table_get_column(table,
+					   VMETA_FRAME_TABLE_COLUMN_TIMESTAMP,
+					   (const void **)&ts,
+					   &ts_presence);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_table_get_column(table,
+					   VMETA_FRAME_TABLE_COLUMN_LATITUDE,
+					   (const void **)&lat,
+					   &lat_presence);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_table_get_column(
+		table,
+		VMETA_FRAME_TABLE_COLUMN_DRONE_QUAT_W,
+		(const void **)&quat_w,
+		&quat_presence);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_table_get_column(
+		table, VMETA_FRAME_TABLE_COLUMN_COUNT, NULL, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	for (size_t i = 0; i < count; i++) {
+		err = vmeta_frame_get_fields(
+			frames[i], VMETA_FRAME_FIELD_ALL, &flat);
+		CU_ASSERT_EQUAL(err, 0);
+		CU_ASSERT_EQUAL(VMETA_FRAME_TABLE_IS_PRESENT(ts_presence, i),
+				!!(flat.present & VMETA_FRAME_FIELD_TIMESTAMP));
+		if (flat.present & VMETA_FRAME_FIELD_TIMESTAMP)
+			CU_ASSERT_EQUAL(ts[i], flat.timestamp);
+		CU_ASSERT_EQUAL(VMETA_FRAME_TABLE_IS_PRESENT(lat_presence, i),
+				!!(flat.present & VMETA_FRAME_FIELD_LOCATION));
+		if (flat.present & VMETA_FRAME_FIELD_LOCATION) {
+			CU_ASSERT_EQUAL(lat[i], flat.location.latitude);
+		} else {
+			CU_ASSERT_TRUE(isnan(lat[i]));
+		}
+		CU_ASSERT_EQUAL(
+			VMETA_FRAME_TABLE_IS_PRESENT(quat_presence, i),
+			!!(flat.present & VMETA_FRAME_FIELD_DRONE_QUAT));
+		if (flat.present & VMETA_FRAME_FIELD_DRONE_QUAT) {
+			CU_ASSERT_EQUAL(quat_w[i], flat.drone_quat.w);
+		} else {
+			CU_ASSERT_TRUE(isnan(quat_w[i]));
+		}
+	}
+
+	for (size_t i = 0; i < SIZEOF_ARRAY(frames); i++)
+		vmeta_frame_unref(frames[i]);
+
+	err = vmeta_frame_table_clear(table);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_table_get_count(table, &count);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(count, 0);
+
+	err = vmeta_frame_table_destroy(table);
+	CU_ASSERT_EQUAL(err, 0);
+}
+
+static void check_frame_archive(struct vmeta_frame_archive *archive,
+				struct vmeta_frame **frames,
+				size_t frame_count)
+{
+	const uint64_t *ts;
+	const double *lat;
+	const uint8_t *ts_presence, *lat_presence;
+	struct vmeta_frame_flat flat;
+	size_t count, block_rows, rows, row;
+	int err;
+
+	err = vmeta_frame_archive_get_count(archive, &count, &block_rows);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	CU_ASSERT_EQUAL_FATAL(count, frame_count);
+	CU_ASSERT_NOT_EQUAL_FATAL(block_rows, 0);
+
+	for (size_t i = 0; i < count; i++) {
+		row = i % block_rows;
+		err = vmeta_frame_archive_get_column(
+			archive,
+			i / block_rows,
+			VMETA_FRAME_TABLE_COLUMN_TIMESTAMP,
+			(const void **)&ts,
+			&ts_presence,
+			&rows);
+		CU_ASSERT_EQUAL_FATAL(err, 0);
+		CU_ASSERT_TRUE(row < rows);
+		err = vmeta_frame_archive_get_column(
+			archive,
+			i / block_rows,
+			VMETA_FRAME_TABLE_COLUMN_LATITUDE,
+			(const void **)&lat,
+			&lat_presence,
+			NULL);
+		CU_ASSERT_EQUAL_FATAL(err, 0);
+
+		err = vmeta_frame_get_fields(
+			frames[i], VMETA_FRAME_FIELD_ALL, &flat);
+		CU_ASSERT_EQUAL(err, 0);
+		CU_ASSERT_EQUAL(VMETA_FRAME_TABLE_IS_PRESENT(ts_presence, row),
+				!!(flat.present & VMETA_FRAME_FIELD_TIMESTAMP));
+		if (flat.present & VMETA_FRAME_FIELD_TIMESTAMP)
+			CU_ASSERT_EQUAL(ts[row], flat.timestamp);
+		CU_ASSERT_EQUAL(VMETA_FRAME_TABLE_IS_PRESENT(lat_presence, row),
+				!!(flat.present & VMETA_FRAME_FIELD_LOCATION));
+		if (flat.present & VMETA_FRAME_FIELD_LOCATION)
+			CU_ASSERT_EQUAL(lat[row], flat.location.latitude);
+	}
+
+	err = vmeta_frame_archive_get_column(
+		archive,
+		count / block_rows + 1,
+		VMETA_FRAME_TABLE_COLUMN_TIMESTAMP,
+		NULL,
+		NULL,
+		NULL);
+	CU_ASSERT_EQUAL(err, -ENOENT);
+}
+
+
+/* Replace a 64-bit header field of an archive file; returns the previous
+ * value */
+static uint64_t patch_archive_header(const char *path,
+				     off_t offset,
+				     uint64_t value)
+{
+	uint64_t prev = 0;
+	int fd;
+
+	fd = open(path, O_RDWR);
+	CU_ASSERT_FATAL(fd >= 0);
+	CU_ASSERT_EQUAL(pread(fd, &prev, sizeof(prev), offset), sizeof(prev));
+	CU_ASSERT_EQUAL(pwrite(fd, &value, sizeof(value), offset),
+			sizeof(value));
+	close(fd);
+	return prev;
+}
+
+
+static void test_frame_archive(void)
+{
+	struct vmeta_frame_archive_writer *writer;
+	struct vmeta_frame_archive *archive;
+	struct vmeta_frame *frames[15];
+	struct vmeta_session session, session_out;
+	char path[] = "/tmp/vmeta_test_archive_XXXXXX";
+	uint64_t block_size;
+	int err, fd;
+
+	fd = mkstemp(path);
+	CU_ASSERT_FATAL(fd >= 0);
+	close(fd);
+
+	for (size_t i = 0; i < SIZEOF_ARRAY(frames); i++) {
+		frames[i] = unpacked_meta(1);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(frames[i]);
+	}
+	memset(&session, 0, sizeof(session));
+	snprintf(session.friendly_name,
+		 sizeof(session.friendly_name),
+		 "%s",
+		 "test friendly name");
+	snprintf(session.maker, sizeof(session.maker), "%s", "test maker");
+
+	err = vmeta_frame_archive_writer_new(path, &session, 0, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	/* Small blocks to span several of them */
+	err = vmeta_frame_archive_writer_new(path, &session, 4, &writer);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	for (size_t i = 0; i < 10; i++) {
+		err = vmeta_frame_archive_writer_append(writer, frames[i]);
+		CU_ASSERT_EQUAL(err, 0);
+	}
+	err = vmeta_frame_archive_writer_flush(writer);
+	CU_ASSERT_EQUAL(err, 0);
+
+	err = vmeta_frame_archive_open(path, &archive);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	check_frame_archive(archive, frames, 10);
+	err = vmeta_frame_archive_get_session(archive, &session_out);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(session_out.friendly_name,
+			       session.friendly_name);
+	CU_ASSERT_STRING_EQUAL(session_out.maker, session.maker);
+
+	/* Rows appended while the archive is open are seen after a refresh */
+	for (size_t i = 10; i < 12; i++) {
+		err = vmeta_frame_archive_writer_append(writer, frames[i]);
+		CU_ASSERT_EQUAL(err, 0);
+	}
+	err = vmeta_frame_archive_writer_destroy(writer);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_archive_refresh(archive);
+	CU_ASSERT_EQUAL(err, 0);
+	check_frame_archive(archive, frames, 12);
+
+	/* Reopen the archive for appending */
+	err = vmeta_frame_archive_writer_open(path, &writer);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	for (size_t i = 12; i < SIZEOF_ARRAY(frames); i++) {
+		err = vmeta_frame_archive_writer_append(writer, frames[i]);
+		CU_ASSERT_EQUAL(err, 0);
+	}
+	err = vmeta_frame_archive_writer_destroy(writer);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_archive_refresh(archive);
+	CU_ASSERT_EQUAL(err, 0);
+	check_frame_archive(archive, frames, SIZEOF_ARRAY(frames));
+
+	err = vmeta_frame_archive_close(archive);
+	CU_ASSERT_EQUAL(err, 0);
+
+	/* Offsets past the end of the file must not overflow the layout
+	 * checks (header offsets: block_size 24, schema_offset 32,
+	 * session_offset 40) */
+	for (off_t offset = 32; offset <= 40; offset += 8) {
+		uint64_t prev = patch_archive_header(path, offset, UINT64_MAX);
+		err = vmeta_frame_archive_open(path, &archive);
+		CU_ASSERT_EQUAL(err, -EPROTO);
+		err = vmeta_frame_archive_writer_open(path, &writer);
+		CU_ASSERT_EQUAL(err, -EPROTO);
+		patch_archive_header(path, offset, prev);
+	}
+
+	/* A block size that does not match the column layout is rejected
+	 * when reopening for appending */
+	block_size = patch_archive_header(path, 24, 0);
+	patch_archive_header(path, 24, block_size + 64);
+	err = vmeta_frame_archive_writer_open(path, &writer);
+	CU_ASSERT_EQUAL(err, -EPROTO);
+	patch_archive_header(path, 24, block_size);
+	err = vmeta_frame_archive_writer_open(path, &writer);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	err = vmeta_frame_archive_writer_destroy(writer);
+	CU_ASSERT_EQUAL(err, 0);
+
+	for (size_t i = 0; i < SIZEOF_ARRAY(frames); i++)
+		vmeta_frame_unref(frames[i]);
+	unlink(path);
+}
+
+
 static void test_write_read_once(void)
 {
 	struct vmeta_frame *in, *out;
@@ -1098,6 +1995,233 @@ static void test_read_write(void)
 }
 
 
+static void test_read_modify(void)
+{
+	struct vmeta_frame *frame, *out;
+	const Vmeta__TimedMetadata *ro;
+	Vmeta__TimedMetadata *rw;
+	Vmeta__CameraMetadata *camera;
+	uint8_t *buf;
+	const size_t buflen = 1024;
+	struct vmeta_buffer in, vb;
+	int err;
+
+	buf = malloc(buflen);
+	CU_ASSERT_PTR_NOT_NULL(buf);
+	vmeta_buffer_set_data(&vb, buf, buflen, 0);
+	vmeta_buffer_set_cdata(&in, packed_meta, sizeof(packed_meta), 0);
+
+	err = vmeta_frame_read(&in, VMETA_FRAME_PROTO_MIME_TYPE, &frame);
+	CU_ASSERT_PTR_NOT_NULL(frame);
+	CU_ASSERT_EQUAL(err, 0);
+
+	/* Read-only view first (arena-backed) */
+	err = vmeta_frame_proto_get_unpacked(frame, &ro);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_NOT_NULL(ro);
+	err = vmeta_frame_proto_release_unpacked(frame, ro);
+	CU_ASSERT_EQUAL(err, 0);
+
+	/* Then modify the structure */
+	err = vmeta_frame_proto_get_unpacked_rw(frame, &rw);
+	CU_ASSERT_EQUAL(err, 0);
+	camera = vmeta_frame_proto_get_camera(rw);
+	CU_ASSERT_PTR_NOT_NULL(camera);
+	camera->timestamp = 123456789;
+	camera->zoom_level = 2.5f;
+	err = vmeta_frame_proto_release_unpacked_rw(frame, rw);
+	CU_ASSERT_EQUAL(err, 0);
+
+	err = vmeta_frame_write(&vb, frame);
+	CU_ASSERT_EQUAL(err, 0);
+
+	vb.len = vb.pos;
+	vb.pos = 0;
+	err = vmeta_frame_read(&vb, VMETA_FRAME_PROTO_MIME_TYPE, &out);
+	CU_ASSERT_PTR_NOT_NULL(out);
+	CU_ASSERT_EQUAL(err, 0);
+
+	meta_compare(frame, out);
+	err = vmeta_frame_proto_get_unpacked(out, &ro);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_NOT_NULL(ro->camera);
+	CU_ASSERT_EQUAL(ro->camera->timestamp, 123456789);
+	CU_ASSERT_EQUAL(ro->camera->zoom_level, 2.5f);
+	err = vmeta_frame_proto_release_unpacked(out, ro);
+	CU_ASSERT_EQUAL(err, 0);
+
+	free(buf);
+	vmeta_frame_unref(frame);
+	vmeta_frame_unref(out);
+}
+
+
+static void test_modify_parts(void)
+{
+	struct vmeta_frame *frame, *ref;
+	Vmeta__TimedMetadata *rw;
+	Vmeta__CameraMetadata *camera;
+	const uint8_t *data, *data2;
+	size_t len;
+	ssize_t size;
+	uint8_t buf[1024], ref_buf[1024];
+	struct vmeta_buffer vb, ref_vb;
+	int err;
+
+	frame = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+	ref = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ref);
+
+	size = vmeta_frame_proto_get_packed_size(frame);
+	CU_ASSERT_EQUAL(size, sizeof(packed_meta));
+
+	/* Unmodified metadata: the packed data is kept */
+	err = vmeta_frame_proto_get_buffer(frame, &data, &len);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_proto_release_buffer(frame, data);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_proto_get_unpacked_rw(frame, &rw);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_proto_release_unpacked_rw2(frame, rw, 0);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_frame_proto_get_buffer(frame, &data2, &len);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_PTR_EQUAL(data2, data);
+	CU_ASSERT_EQUAL(len, sizeof(packed_meta));
+	err = vmeta_frame_proto_release_buffer(frame, data2);
+	CU_ASSERT_EQUAL(err, 0);
+
+	/* Update a few fields, several times */
+	for (int i = 0; i < 10; i++) {
+		err = vmeta_frame_proto_get_unpacked_rw(frame, &rw);
+		CU_ASSERT_EQUAL(err, 0);
+		camera = vmeta_frame_proto_get_camera(rw);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(camera);
+		camera->timestamp = 1000000 * (i + 1);
+		camera->exposure_time = 0.5f * i;
+		err = vmeta_frame_proto_release_unpacked_rw2(
+			frame, rw, VMETA_FRAME_PROTO_PART_CAMERA);
+		CU_ASSERT_EQUAL(err, 0);
+
+		err = vmeta_frame_proto_get_unpacked_rw(ref, &rw);
+		CU_ASSERT_EQUAL(err, 0);
+		camera = vmeta_frame_proto_get_camera(rw);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(camera);
+		camera->timestamp = 1000000 * (i + 1);
+		camera->exposure_time = 0.5f * i;
+		err = vmeta_frame_proto_release_unpacked_rw(ref, rw);
+		CU_ASSERT_EQUAL(err, 0);
+
+		vmeta_buffer_set_data(&vb, buf, sizeof(buf), 0);
+		err = vmeta_frame_write2(&vb, frame, i & 1);
+		CU_ASSERT_EQUAL(err, 0);
+		vmeta_buffer_set_data(&ref_vb, ref_buf, sizeof(ref_buf), 0);
+		err = vmeta_frame_write(&ref_vb, ref);
+		CU_ASSERT_EQUAL(err, 0);
+		CU_ASSERT_EQUAL(vb.pos, ref_vb.pos);
+		CU_ASSERT_EQUAL(memcmp(buf, ref_buf, ref_vb.pos), 0);
+		size = vmeta_frame_proto_get_packed_size(frame);
+		CU_ASSERT_EQUAL(size, (ssize_t)ref_vb.pos);
+	}
+
+	vmeta_frame_unref(frame);
+	vmeta_frame_unref(ref);
+}
+
+static void test_delta(void)
+{
+	struct vmeta_frame *frame, *out;
+	struct vmeta_frame_proto_delta_enc *enc = NULL;
+	struct vmeta_frame_proto_delta_dec *dec = NULL, *late = NULL;
+	Vmeta__TimedMetadata *rw;
+	Vmeta__CameraMetadata *camera;
+	const uint8_t *data, *out_data;
+	size_t len, out_len;
+	uint8_t buf[1024];
+	struct vmeta_buffer vb;
+	const size_t hdr_size = VMETA_FRAME_PROTO_DELTA_HEADER_SIZE;
+	int err;
+
+	err = vmeta_frame_proto_delta_enc_new(4, &enc);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	err = vmeta_frame_proto_delta_dec_new(&dec);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	err = vmeta_frame_proto_delta_dec_new(&late);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	frame = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+
+	for (int i = 0; i < 10; i++) {
+		err = vmeta_frame_proto_get_unpacked_rw(frame, &rw);
+		CU_ASSERT_EQUAL(err, 0);
+		camera = vmeta_frame_proto_get_camera(rw);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(camera);
+		camera->timestamp = 1000000 * (i + 1);
+		err = vmeta_frame_proto_release_unpacked_rw2(
+			frame, rw, VMETA_FRAME_PROTO_PART_CAMERA);
+		CU_ASSERT_EQUAL(err, 0);
+
+		vmeta_buffer_set_data(&vb, buf, sizeof(buf), 0);
+		err = vmeta_frame_proto_delta_enc_write(enc, &vb, frame);
+		CU_ASSERT_EQUAL(err, 0);
+
+		err = vmeta_frame_proto_get_buffer(frame, &data, &len);
+		CU_ASSERT_EQUAL(err, 0);
+		if (i % 4 == 0) {
+			/* Keyframe */
+			CU_ASSERT_EQUAL(vb.pos, len + hdr_size);
+		} else {
+			/* Delta frame: only the camera part is sent */
+			CU_ASSERT_TRUE(vb.pos < len);
+		}
+
+		/* A decoder starting on the second frame has to wait for the
+		 * next keyframe */
+		vb.len = vb.pos;
+		vb.pos = 0;
+		if (i > 0) {
+			err = vmeta_frame_proto_delta_dec_read(late, &vb, &out);
+			if (i < 4) {
+				CU_ASSERT_EQUAL(err, -EAGAIN);
+			} else {
+				CU_ASSERT_EQUAL(err, 0);
+				vmeta_frame_unref(out);
+			}
+		}
+
+		err = vmeta_frame_proto_delta_dec_read(dec, &vb, &out);
+		CU_ASSERT_EQUAL(err, 0);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(out);
+		err = vmeta_frame_proto_get_buffer(out, &out_data, &out_len);
+		CU_ASSERT_EQUAL(err, 0);
+		CU_ASSERT_EQUAL(out_len, len);
+		CU_ASSERT_EQUAL(memcmp(out_data, data, len), 0);
+		vmeta_frame_proto_release_buffer(out, out_data);
+		vmeta_frame_proto_release_buffer(frame, data);
+		vmeta_frame_unref(out);
+	}
+
+	/* Metadata without the delta header */
+	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
+	err = vmeta_frame_proto_delta_dec_read(dec, &vb, &out);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(vmeta_frame_proto_get_packed_size(out),
+			sizeof(packed_meta));
+	vmeta_frame_unref(out);
+
+	/* Buffer too small */
+	vmeta_buffer_set_data(&vb, buf, 4, 0);
+	err = vmeta_frame_proto_delta_enc_write(enc, &vb, frame);
+	CU_ASSERT_EQUAL(err, -ENOBUFS);
+	CU_ASSERT_EQUAL(vb.pos, 0);
+
+	vmeta_frame_unref(frame);
+	vmeta_frame_proto_delta_enc_destroy(enc);
+	vmeta_frame_proto_delta_dec_destroy(dec);
+	vmeta_frame_proto_delta_dec_destroy(late);
+}
+
 static void gen_packed_meta(void)
 {
 	int res = 0;
@@ -1127,9 +2251,23 @@ static void gen_packed_meta(void)
 
 CU_TestInfo s_proto_tests[] = {
 	{(char *)"vmeta api", &test_api},
+	{(char *)"vmeta concurrent readers", &test_concurrent_readers},
 	{(char *)"vmeta write", &test_write},
 	{(char *)"vmeta read", &test_read},
+	{(char *)"vmeta read borrowed", &test_read_borrowed},
+	{(char *)"vmeta frame pool", &test_pool},
+	{(char *)"vmeta read batch", &test_read_batch},
+	{(char *)"vmeta read packed getters", &test_read_packed_getters},
+	{(char *)"vmeta get fields", &test_get_fields},
+	{(char *)"vmeta getters on a dirty stack", &test_dirty_stack_getters},
+	{(char *)"vmeta json parity", &test_json_parity},
+	{(char *)"vmeta to csv", &test_to_csv},
+	{(char *)"vmeta frame table", &test_frame_table},
+	{(char *)"vmeta frame archive", &test_frame_archive},
 	{(char *)"vmeta read->write", &test_read_write},
+	{(char *)"vmeta read->modify->write", &test_read_modify},
+	{(char *)"vmeta modify parts", &test_modify_parts},
+	{(char *)"vmeta delta encoding", &test_delta},
 	CU_TEST_INFO_NULL,
 };
 
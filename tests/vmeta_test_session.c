@@ -59,6 +59,7 @@ static struct vmeta_session_test_size {
 	struct vmeta_thermal thermal;
 	uint32_t has_thermal : 1;
 	uint32_t default_media : 1;
+	uint32_t proto_delta : 1;
 	enum vmeta_camera_type camera_type;
 	enum vmeta_camera_subtype camera_subtype;
 	enum vmeta_camera_spectrum camera_spectrum;
@@ -143,6 +144,75 @@ static void test_session_cmp()
 }
 
 
+static void test_session_fingerprint(void)
+{
+	int err;
+	uint32_t diff;
+	struct vmeta_session meta_a = {0};
+	struct vmeta_session meta_b = {0};
+	struct vmeta_session_fingerprint fp_a, fp_b, fp_c;
+
+	/* Invalid use */
+	err = vmeta_session_fingerprint(NULL, &fp_a);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_session_fingerprint(&meta_a, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+	err = vmeta_session_fingerprint_update(&meta_a, 0, NULL);
+	CU_ASSERT_EQUAL(err, -EINVAL);
+
+	/* Equal session metadata, with different bytes after the string
+	 * terminators, in an invalid location and in NaN altitudes */
+	fill_vmeta_with(&meta_a, 1);
+	fill_vmeta_with(&meta_b, 1);
+	meta_a.title[3] = '\0';
+	meta_b.title[3] = '\0';
+	meta_b.title[4] = 2;
+	meta_a.location.valid = 0;
+	meta_b.location.valid = 0;
+	meta_b.location.latitude = 45.;
+	meta_a.takeoff_loc.altitude_egm96amsl = NAN;
+	meta_b.takeoff_loc.altitude_egm96amsl = -NAN;
+	CU_ASSERT_EQUAL(vmeta_session_cmp(&meta_a, &meta_b), true);
+	err = vmeta_session_fingerprint(&meta_a, &fp_a);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_session_fingerprint(&meta_b, &fp_b);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(vmeta_session_fingerprint_cmp(&fp_a, &fp_b), true);
+	CU_ASSERT_EQUAL(vmeta_session_fingerprint_diff(&fp_a, &fp_b), 0);
+
+	/* Different values: only the modified groups differ */
+	meta_b.camera_type = VMETA_CAMERA_TYPE_FRONT_STEREO_LEFT;
+	meta_b.media_date++;
+	err = vmeta_session_fingerprint(&meta_b, &fp_b);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(vmeta_session_cmp(&meta_a, &meta_b), false);
+	CU_ASSERT_EQUAL(vmeta_session_fingerprint_cmp(&fp_a, &fp_b), false);
+	diff = vmeta_session_fingerprint_diff(&fp_a, &fp_b);
+	CU_ASSERT_EQUAL(diff,
+			(1 << VMETA_SESSION_GROUP_CAMERA_MODEL) |
+				(1 << VMETA_SESSION_GROUP_DATES));
+
+	/* Updating the modified groups gives the full fingerprint */
+	fp_c = fp_a;
+	err = vmeta_session_fingerprint_update(&meta_b, diff, &fp_c);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(vmeta_session_fingerprint_cmp(&fp_c, &fp_b), true);
+	CU_ASSERT_EQUAL(memcmp(&fp_c, &fp_b, sizeof(fp_c)), 0);
+
+	/* Strings that only differ by their split between fields */
+	memset(&meta_a, 0, sizeof(meta_a));
+	memset(&meta_b, 0, sizeof(meta_b));
+	strcpy(meta_a.maker, "ab");
+	strcpy(meta_b.maker, "a");
+	strcpy(meta_b.model, "b");
+	vmeta_session_fingerprint(&meta_a, &fp_a);
+	vmeta_session_fingerprint(&meta_b, &fp_b);
+	CU_ASSERT_EQUAL(vmeta_session_fingerprint_cmp(&fp_a, &fp_b), false);
+	CU_ASSERT_EQUAL(vmeta_session_fingerprint_diff(&fp_a, &fp_b),
+			1 << VMETA_SESSION_GROUP_IDENTITY);
+}
+
+
 static void test_session_merge_metadata(void)
 {
 	int err = 0;
@@ -211,6 +281,30 @@ static void test_session_merge_metadata(void)
 	CU_ASSERT_EQUAL(vmeta_session_cmp(metas[0], &meta_b), true);
 	CU_ASSERT_EQUAL(vmeta_session_cmp(metas[1], &meta_c), true);
 
+	/* More than two session metadata, with NULL entries */
+	struct vmeta_session *list[4] = {NULL, &meta_a, &meta_b, &meta_c};
+	memset(&meta_a, 0, sizeof(meta_a));
+	memset(&meta_b, 0, sizeof(meta_b));
+	memset(&meta_c, 0, sizeof(meta_c));
+	strcpy(meta_a.maker, "Parrot");
+	strcpy(meta_b.maker, "Parrot");
+	strcpy(meta_c.maker, "Parrot");
+	strcpy(meta_a.serial_number, "a");
+	strcpy(meta_b.serial_number, "b");
+	strcpy(meta_c.serial_number, "a");
+	meta_a.has_thermal = meta_b.has_thermal = meta_c.has_thermal = 1;
+	meta_c.thermal.metaversion = 2;
+	err = vmeta_session_merge_metadata(list, 4, &common);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(common.maker, "Parrot");
+	CU_ASSERT_STRING_EQUAL(common.serial_number, "");
+	CU_ASSERT_EQUAL(common.has_thermal, 0);
+	CU_ASSERT_STRING_EQUAL(meta_a.maker, "");
+	CU_ASSERT_STRING_EQUAL(meta_c.maker, "");
+	CU_ASSERT_STRING_EQUAL(meta_a.serial_number, "a");
+	CU_ASSERT_STRING_EQUAL(meta_b.serial_number, "b");
+	CU_ASSERT_EQUAL(meta_c.has_thermal, 1);
+
 	free(metas[0]);
 	free(metas[1]);
 	free(metas);
@@ -251,6 +345,238 @@ static void test_session_is_valid()
 }
 
 
+static void test_session_read_keys(void)
+{
+	int err;
+	struct vmeta_session meta = {0};
+
+	/* Recording: the udta keys do not override the meta keys */
+	err = vmeta_session_recording_read(
+		VMETA_REC_META_KEY_MAKER, "maker", &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(meta.maker, "maker");
+	err = vmeta_session_recording_read(
+		VMETA_REC_UDTA_KEY_MAKER, "other", &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(meta.maker, "maker");
+	err = vmeta_session_recording_read(
+		VMETA_REC_UDTA_KEY_MODEL, "model", &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(meta.model, "model");
+	err = vmeta_session_recording_read(
+		VMETA_REC_META_KEY_MEDIA_ID, "42", &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(meta.media_id, 42);
+
+	/* Unknown keys and keys of other readers are ignored */
+	err = vmeta_session_recording_read("com.parrot.unknown", "x", &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_session_recording_read(
+		VMETA_STRM_SDP_KEY_MODEL, "x", &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(meta.model, "model");
+
+	/* RTCP SDES PRIV items */
+	memset(&meta, 0, sizeof(meta));
+	err = vmeta_session_streaming_sdes_read(
+		VMETA_STRM_SDES_TYPE_PRIV,
+		"serial",
+		VMETA_STRM_SDES_KEY_CAMERA_SERIAL_NUMBER,
+		&meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(meta.camera_serial_number, "serial");
+	err = vmeta_session_streaming_sdes_read(
+		VMETA_STRM_SDES_TYPE_PRIV,
+		"1",
+		VMETA_STRM_SDES_KEY_THERMAL_METAVERSION,
+		&meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(meta.thermal.metaversion, 1);
+	CU_ASSERT_EQUAL(meta.has_thermal, 1);
+
+	/* SDP: session-level keys are ignored in media-level attributes */
+	memset(&meta, 0, sizeof(meta));
+	err = vmeta_session_streaming_sdp_read(VMETA_STRM_SDP_TYPE_MEDIA_ATTR,
+					       "maker",
+					       VMETA_STRM_SDP_KEY_MAKER,
+					       &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(meta.maker, "");
+	err = vmeta_session_streaming_sdp_read(
+		VMETA_STRM_SDP_TYPE_SESSION_ATTR,
+		"maker",
+		VMETA_STRM_SDP_KEY_MAKER,
+		&meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(meta.maker, "maker");
+	err = vmeta_session_streaming_sdp_read(VMETA_STRM_SDP_TYPE_MEDIA_ATTR,
+					       "",
+					       VMETA_STRM_SDP_KEY_DEFAULT_MEDIA,
+					       &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_EQUAL(meta.default_media, 1);
+}
+
+
+/* Concatenation of the written items */
+struct session_items {
+	char str[4096];
+	size_t len;
+};
+
+
+static void session_items_add(struct session_items *items,
+			      int type,
+			      const char *key,
+			      const char *value)
+{
+	int len = snprintf(items->str + items->len,
+			   sizeof(items->str) - items->len,
+			   "%d:%s=%s;",
+			   type,
+			   (key != NULL) ? key : "",
+			   value);
+	CU_ASSERT_FATAL(len > 0);
+	CU_ASSERT_FATAL(items->len + len < sizeof(items->str));
+	items->len += len;
+}
+
+
+static void session_items_sdes_cb(enum vmeta_stream_sdes_type type,
+				  const char *value,
+				  const char *prefix,
+				  void *userdata)
+{
+	session_items_add(userdata, type, prefix, value);
+}
+
+
+static void session_items_sdp_cb(enum vmeta_stream_sdp_type type,
+				 const char *value,
+				 const char *key,
+				 void *userdata)
+{
+	session_items_add(userdata, type, key, value);
+}
+
+
+static void session_items_recording_cb(enum vmeta_record_type type,
+				       const char *key,
+				       const char *value,
+				       void *userdata)
+{
+	session_items_add(userdata, type, key, value);
+}
+
+
+static void check_session_serialized(struct vmeta_session_serialized *ser,
+				     const struct vmeta_session *meta)
+{
+	int err;
+	struct session_items expected = {0};
+	struct session_items items = {0};
+
+	err = vmeta_session_streaming_sdes_write(
+		meta, &session_items_sdes_cb, &expected);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_session_serialized_sdes_write(
+		ser, &session_items_sdes_cb, &items);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(items.str, expected.str);
+
+	for (int media_level = 0; media_level < 2; media_level++) {
+		memset(&expected, 0, sizeof(expected));
+		memset(&items, 0, sizeof(items));
+		err = vmeta_session_streaming_sdp_write(
+			meta, media_level, &session_items_sdp_cb, &expected);
+		CU_ASSERT_EQUAL(err, 0);
+		err = vmeta_session_serialized_sdp_write(
+			ser, media_level, &session_items_sdp_cb, &items);
+		CU_ASSERT_EQUAL(err, 0);
+		CU_ASSERT_STRING_EQUAL(items.str, expected.str);
+	}
+
+	memset(&expected, 0, sizeof(expected));
+	memset(&items, 0, sizeof(items));
+	err = vmeta_session_recording_write(
+		meta, &session_items_recording_cb, &expected);
+	CU_ASSERT_EQUAL(err, 0);
+	err = vmeta_session_serialized_recording_write(
+		ser, &session_items_recording_cb, &items);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_STRING_EQUAL(items.str, expected.str);
+}
+
+
+static void test_session_serialized(void)
+{
+	int err;
+	struct vmeta_session meta = {0};
+	struct vmeta_session_serialized *ser = NULL;
+
+	err = vmeta_session_serialized_new(&ser);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ser);
+
+	/* Empty cache */
+	check_session_serialized(ser, &meta);
+
+	strcpy(meta.friendly_name, "friendly_name");
+	strcpy(meta.maker, "maker");
+	strcpy(meta.model, "model");
+	strcpy(meta.serial_number, "serial_number");
+	strcpy(meta.title, "title");
+	meta.media_date = 1600000000;
+	meta.media_date_gmtoff = 7200;
+	meta.location.valid = 1;
+	meta.location.latitude = 48.878;
+	meta.location.longitude = 2.367;
+	meta.location.altitude_wgs84ellipsoid = 42.;
+	meta.picture_fov.has_horz = 1;
+	meta.picture_fov.horz = 69.;
+	meta.picture_fov.has_vert = 1;
+	meta.picture_fov.vert = 43.;
+	meta.camera_model.type = VMETA_CAMERA_MODEL_TYPE_PERSPECTIVE;
+	meta.camera_model.perspective.distortion.r1 = 0.1;
+	meta.has_thermal = 1;
+	meta.thermal.metaversion = 2;
+	meta.thermal.conv_low.valid = 1;
+	meta.thermal.conv_low.r = 1.5;
+	meta.default_media = 1;
+	meta.media_id = 42;
+	err = vmeta_session_serialized_update(ser, &meta);
+	CU_ASSERT_EQUAL(err, 12);
+	check_session_serialized(ser, &meta);
+
+	/* No change */
+	err = vmeta_session_serialized_update(ser, &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	check_session_serialized(ser, &meta);
+
+	/* Bytes after a string terminator are not part of the value */
+	meta.title[strlen(meta.title) + 1] = 'x';
+	err = vmeta_session_serialized_update(ser, &meta);
+	CU_ASSERT_EQUAL(err, 0);
+	check_session_serialized(ser, &meta);
+
+	/* Only the changed fields are rendered again */
+	meta.location.latitude = 48.879;
+	meta.media_id = 0;
+	meta.default_media = 0;
+	err = vmeta_session_serialized_update(ser, &meta);
+	CU_ASSERT_EQUAL(err, 3);
+	check_session_serialized(ser, &meta);
+
+	memset(&meta, 0, sizeof(meta));
+	err = vmeta_session_serialized_update(ser, &meta);
+	CU_ASSERT_EQUAL(err, 10);
+	check_session_serialized(ser, &meta);
+
+	err = vmeta_session_serialized_destroy(ser);
+	CU_ASSERT_EQUAL(err, 0);
+}
+
+
 static void compare_session_proto(const Vmeta__SessionMetadata *proto,
 				  struct vmeta_session *meta)
 {
@@ -470,8 +796,11 @@ static void test_session_proto_api()
 CU_TestInfo s_session_tests[] = {
 	{(char *)"session_size", &test_session_size},
 	{(char *)"session_cmp", &test_session_cmp},
+	{(char *)"session_fingerprint", &test_session_fingerprint},
 	{(char *)"session_merge_metadata", &test_session_merge_metadata},
 	{(char *)"session_is_valid", &test_session_is_valid},
+	{(char *)"session_read_keys", &test_session_read_keys},
+	{(char *)"session_serialized", &test_session_serialized},
 	{(char *)"session_proto_api", &test_session_proto_api},
 	CU_TEST_INFO_NULL,
 };
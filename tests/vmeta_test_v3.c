@@ -570,6 +570,7 @@ static void test_read(void)
 {
 	struct vmeta_frame *frame, *ref;
 	struct vmeta_buffer vb;
+	struct vmeta_frame_flat flat;
 	int err;
 
 	vmeta_buffer_set_cdata(&vb, packed_meta, sizeof(packed_meta), 0);
@@ -584,8 +585,22 @@ static void test_read(void)
 	compare_vmeta_frame_getters(ref, frame);
 	compare_vmeta_frame_v3_getters(frame);
 
+	err = vmeta_frame_get_fields(frame, VMETA_FRAME_FIELD_ALL, &flat);
+	CU_ASSERT_EQUAL(err, 0);
+	CU_ASSERT_TRUE(flat.present & VMETA_FRAME_FIELD_LINK_GOODPUT);
+	CU_ASSERT_EQUAL(flat.link_goodput, ref->v3.base.link_goodput);
+	CU_ASSERT_TRUE(flat.present & VMETA_FRAME_FIELD_BATTERY_PERCENTAGE);
+	CU_ASSERT_EQUAL(flat.battery_percentage,
+			ref->v3.base.battery_percentage);
+	CU_ASSERT_FALSE(flat.present & VMETA_FRAME_FIELD_ALTITUDE_ATO);
+
 	vmeta_frame_unref(frame);
 	vmeta_frame_unref(ref);
+
+	/* Truncated base fields */
+	vmeta_buffer_set_cdata(&vb, packed_meta, 40, 0);
+	err = vmeta_frame_read2(&vb, VMETA_FRAME_V3_MIME_TYPE, 0, &frame);
+	CU_ASSERT_TRUE(err < 0);
 }
 
 
@@ -730,6 +745,312 @@ static void test_read_write(void)
 }
 
 
+static void test_write_proto_once(bool random)
+{
+	struct vmeta_frame *in, *v3, *proto;
+	uint8_t packed[1024], buf[1024], ref[1024];
+	struct vmeta_buffer vb, vb_ref;
+	int res;
+
+	in = unpacked_meta(random);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(in);
+	vmeta_buffer_set_data(&vb, packed, sizeof(packed), 0);
+	res = vmeta_frame_write(&vb, in);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Reference: read with conversion to a proto frame, then packing */
+	vb.len = vb.pos;
+	vb.pos = 0;
+	res = vmeta_frame_read2(&vb, VMETA_FRAME_V3_MIME_TYPE, 0, &v3);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	vb.pos = 0;
+	res = vmeta_frame_read(&vb, VMETA_FRAME_V3_MIME_TYPE, &proto);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	vmeta_buffer_set_data(&vb_ref, ref, sizeof(ref), 0);
+	res = vmeta_frame_write(&vb_ref, proto);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Direct write, after some existing data */
+	vmeta_buffer_set_data(&vb, buf, sizeof(buf), 3);
+	res = vmeta_frame_v3_write_proto(&vb, &v3->v3);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(vb.pos - 3, vb_ref.pos);
+	CU_ASSERT_EQUAL(memcmp(buf + 3, ref, vb_ref.pos), 0);
+
+	/* Buffer too small */
+	vmeta_buffer_set_data(&vb, buf, vb_ref.pos - 1, 0);
+	res = vmeta_frame_v3_write_proto(&vb, &v3->v3);
+	CU_ASSERT_EQUAL(res, -ENOBUFS);
+	CU_ASSERT_EQUAL(vb.pos, 0);
+
+	vmeta_frame_unref(in);
+	vmeta_frame_unref(v3);
+	vmeta_frame_unref(proto);
+}
+
+
+static void test_write_proto(void)
+{
+	test_write_proto_once(false);
+}
+
+
+static void test_write_proto_monkey(void)
+{
+	/* Since write_proto test is random, do it multiple times */
+	for (int i = 0; i < MONKEY_TEST_COUNT; i++)
+		test_write_proto_once(true);
+}
+
+struct json_sink_ctx {
+	char buf[4096];
+	size_t len;
+};
+
+
+static int json_sink(const char *data, size_t len, void *userdata)
+{
+	struct json_sink_ctx *ctx = userdata;
+
+	if (ctx->len + len > sizeof(ctx->buf))
+		return -ENOSPC;
+	memcpy(&ctx->buf[ctx->len], data, len);
+	ctx->len += len;
+	return 0;
+}
+
+
+static void test_to_json(void)
+{
+	struct vmeta_frame *frame = NULL;
+	struct json_sink_ctx ctx = {0};
+	char str[4096];
+	char *small = NULL;
+	ssize_t len, res;
+
+	frame = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+
+	len = vmeta_frame_to_json_buf(frame, str, sizeof(str));
+	CU_ASSERT_FATAL(len > 0);
+	CU_ASSERT_EQUAL((size_t)len, strlen(str));
+	CU_ASSERT_EQUAL(str[0], '{');
+	CU_ASSERT_EQUAL(str[len - 1], '}');
+
+	/* Floating-point values use the shortest round-trip form */
+	CU_ASSERT_PTR_NOT_NULL(strstr(str, "\"ground_distance\": 0.1,"));
+
+	/* Streaming output is identical to the buffer output */
+	res = vmeta_frame_to_json_stream(frame, &json_sink, &ctx);
+	CU_ASSERT_EQUAL(res, len);
+	CU_ASSERT_EQUAL(ctx.len, (size_t)len);
+	CU_ASSERT_EQUAL(memcmp(ctx.buf, str, len), 0);
+
+	/* The buffer must also hold the null terminator */
+	small = malloc(len + 1);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(small);
+	res = vmeta_frame_to_json_buf(frame, small, len);
+	CU_ASSERT_EQUAL(res, -ENOBUFS);
+	res = vmeta_frame_to_json_buf(frame, small, len + 1);
+	CU_ASSERT_EQUAL(res, len);
+	CU_ASSERT_STRING_EQUAL(small, str);
+
+	/* Sink errors are forwarded */
+	ctx.len = sizeof(ctx.buf) - 8;
+	res = vmeta_frame_to_json_stream(frame, &json_sink, &ctx);
+	CU_ASSERT_EQUAL(res, -ENOSPC);
+
+	free(small);
+	vmeta_frame_unref(frame);
+}
+
+
+static void test_json_parity(void)
+{
+	static const enum vmeta_frame_type v1_types[] = {
+		VMETA_FRAME_TYPE_V1_RECORDING,
+		VMETA_FRAME_TYPE_V1_STREAMING_BASIC,
+		VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED,
+	};
+	struct vmeta_frame *frame;
+	int err;
+
+	/* V3, including NaN and infinite values */
+	frame = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+	compare_vmeta_frame_json(frame);
+	frame->v3.base.ground_distance = NAN;
+	frame->v3.base.air_speed = INFINITY;
+	frame->v3.base.exposure_time = -INFINITY;
+	frame->v3.base.location.altitude_egm96amsl = NAN;
+	frame->v3.lfic.estimated_precision = 1e300;
+	compare_vmeta_frame_json(frame);
+	vmeta_frame_unref(frame);
+	for (int i = 0; i < 100; i++) {
+		frame = unpacked_meta(1);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+		compare_vmeta_frame_json(frame);
+		vmeta_frame_unref(frame);
+	}
+
+	/* V2 */
+	err = vmeta_frame_new(VMETA_FRAME_TYPE_V2, &frame);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	frame->v2.base.location.valid = 1;
+	frame->v2.base.location.latitude = 48.8785;
+	frame->v2.base.location.longitude = 2.3677;
+	frame->v2.base.ground_distance = 0.1;
+	frame->v2.base.camera_pan = NAN;
+	frame->v2.base.exposure_time = INFINITY;
+	frame->v2.has_followme = 1;
+	frame->v2.followme.target.valid = 1;
+	frame->v2.followme.target.latitude = -0.3;
+	compare_vmeta_frame_json(frame);
+	vmeta_frame_unref(frame);
+
+	/* V1 */
+	for (size_t i = 0; i < SIZEOF_ARRAY(v1_types); i++) {
+		err = vmeta_frame_new(v1_types[i], &frame);
+		CU_ASSERT_EQUAL_FATAL(err, 0);
+		compare_vmeta_frame_json(frame);
+		vmeta_frame_unref(frame);
+	}
+	err = vmeta_frame_new(VMETA_FRAME_TYPE_V1_RECORDING, &frame);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	frame->v1_rec.drone_attitude.yaw = 0.1f;
+	frame->v1_rec.location.valid = 1;
+	frame->v1_rec.location.latitude = 1. / 3.;
+	frame->v1_rec.altitude = NAN;
+	frame->v1_rec.camera_pan = -INFINITY;
+	frame->v1_rec.frame_timestamp = UINT64_C(42000000);
+	compare_vmeta_frame_json(frame);
+	vmeta_frame_unref(frame);
+}
+
+
+static void test_to_csv(void)
+{
+	struct vmeta_frame *frame = NULL;
+	struct vmeta_csv_buf buf = {0};
+	char str[2048];
+	size_t header_len;
+	unsigned int count;
+	ssize_t res;
+
+	frame = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+
+	res = vmeta_frame_csv_header_append(VMETA_FRAME_TYPE_V3, &buf);
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_EQUAL((size_t)res, buf.len);
+	CU_ASSERT_EQUAL(buf.str[buf.len - 1], '\n');
+	header_len = buf.len;
+	count = count_csv_values(buf.str, header_len);
+
+	/* Same columns as the header, in both formats */
+	res = vmeta_frame_csv_append(frame, &buf);
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_EQUAL(header_len + res, buf.len);
+	CU_ASSERT_EQUAL(strlen(buf.str), buf.len);
+	CU_ASSERT_EQUAL(buf.str[buf.len - 1], '\n');
+	CU_ASSERT_EQUAL(count_csv_values(buf.str + header_len, res), count);
+
+	res = vmeta_frame_to_csv(frame, str, sizeof(str));
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_EQUAL(count_csv_values(str, res), count);
+
+	/* Floating-point values use the shortest round-trip form */
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf.str + header_len, " 0.1 "));
+
+	/* The buffer can be reused */
+	buf.len = 0;
+	res = vmeta_frame_csv_append(frame, &buf);
+	CU_ASSERT_EQUAL((size_t)res, buf.len);
+
+	free(buf.str);
+	vmeta_frame_unref(frame);
+}
+
+
+static void check_csv_layout(struct vmeta_frame *frame)
+{
+	char header[4096];
+	char str[4096];
+	ssize_t res;
+
+	res = vmeta_frame_csv_header(frame->type, header, sizeof(header));
+	CU_ASSERT_FATAL(res > 0);
+	res = vmeta_frame_to_csv(frame, str, sizeof(str));
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_EQUAL(count_csv_values(str, res),
+			count_csv_values(header, strlen(header)));
+}
+
+
+static void test_csv_layout(void)
+{
+	static const char *const v3_columns[] = {
+		"automation_framing_target_horizontal_accuracy",
+		"automation_framing_target_vertical_accuracy",
+		"automation_flight_destination_horizontal_accuracy",
+		"automation_flight_destination_vertical_accuracy",
+		"thermal_min_value",
+		"thermal_max_value",
+		"thermal_probe_value",
+		"lfic_target_location_horizontal_accuracy",
+		"lfic_target_location_vertical_accuracy",
+	};
+	struct vmeta_frame *frame;
+	char str[4096];
+	ssize_t res;
+	int err;
+
+	/* All the locations have accuracy columns and all the thermal spots
+	 * have a value column */
+	res = vmeta_frame_csv_header(VMETA_FRAME_TYPE_V3, str, sizeof(str));
+	CU_ASSERT_FATAL(res > 0);
+	for (size_t i = 0; i < SIZEOF_ARRAY(v3_columns); i++)
+		CU_ASSERT_PTR_NOT_NULL(strstr(str, v3_columns[i]));
+	res = vmeta_frame_csv_header(VMETA_FRAME_TYPE_V2, str, sizeof(str));
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_PTR_NOT_NULL(
+		strstr(str, "followme_target_horizontal_accuracy"));
+	CU_ASSERT_PTR_NOT_NULL(
+		strstr(str, "followme_target_vertical_accuracy"));
+
+	/* V3 lines match the header with and without the extensions and
+	 * with invalid locations */
+	frame = unpacked_meta(0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frame);
+	check_csv_layout(frame);
+	frame->v3.base.location.valid = 0;
+	frame->v3.automation.framing_target.valid = 0;
+	check_csv_layout(frame);
+	frame->v3.has_automation = 0;
+	frame->v3.has_thermal = 0;
+	frame->v3.has_lfic = 0;
+	check_csv_layout(frame);
+
+	/* Link goodput is unsigned */
+	frame->v3.base.link_goodput = UINT32_MAX;
+	res = vmeta_frame_to_csv(frame, str, sizeof(str));
+	CU_ASSERT_FATAL(res > 0);
+	CU_ASSERT_PTR_NOT_NULL(strstr(str, " 4294967295 "));
+	vmeta_frame_unref(frame);
+
+	/* V2 lines match the header with and without the follow-me
+	 * extension */
+	err = vmeta_frame_new(VMETA_FRAME_TYPE_V2, &frame);
+	CU_ASSERT_EQUAL_FATAL(err, 0);
+	check_csv_layout(frame);
+	frame->v2.base.location.valid = 1;
+	frame->v2.has_followme = 1;
+	frame->v2.followme.target.valid = 1;
+	check_csv_layout(frame);
+	vmeta_frame_unref(frame);
+}
+
+
 static void gen_packed_meta(void)
 {
 	int res = 0;
@@ -768,12 +1089,18 @@ CU_TestInfo s_v3_tests[] = {
 	{(char *)"vmeta read", &test_read},
 	{(char *)"vmeta convert", &test_read_proto},
 	{(char *)"vmeta read->write", &test_read_write},
+	{(char *)"vmeta write proto", &test_write_proto},
+	{(char *)"vmeta to json", &test_to_json},
+	{(char *)"vmeta json parity", &test_json_parity},
+	{(char *)"vmeta to csv", &test_to_csv},
+	{(char *)"vmeta csv layout", &test_csv_layout},
 	CU_TEST_INFO_NULL,
 };
 
 CU_TestInfo s_v3_monkey[] = {
 	{(char *)"vmeta write->read monkey tests", &test_write_read},
 	{(char *)"vmeta convert monkey tests", &test_write_read_proto},
+	{(char *)"vmeta write proto monkey tests", &test_write_proto_monkey},
 	CU_TEST_INFO_NULL,
 };
 
@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <getopt.h>
 #include <json-c/json.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -62,7 +63,6 @@ ULOG_DECLARE_TAG(ULOG_TAG);
 
 
 #define BUF_SIZE 1024
-#define STR_SIZE 2000
 #define RTP_DEFAULT_PORT 55004
 #define RTCP_DEFAULT_PORT 55005
 
@@ -72,11 +72,32 @@ enum args_id {
 	ARGS_ID_KML,
 	ARGS_ID_JSON,
 	ARGS_ID_JSON_PRETTY,
+	ARGS_ID_NDJSON,
+	ARGS_ID_JOBS,
 	ARGS_ID_RTP_PORT,
 	ARGS_ID_RTCP_PORT,
 };
 
 
+/* Formatted outputs of a frame metadata */
+struct frame_output {
+	uint64_t ts;
+	enum vmeta_frame_type type;
+
+	/* CSV line, without the time column */
+	struct vmeta_csv_buf csv;
+
+	/* KML location and vmeta_frame_get_location() result */
+	struct vmeta_location loc;
+	int loc_res;
+
+	/* JSON frame object and its NDJSON serialization (owned by the
+	 * object) */
+	json_object *json;
+	const char *ndjson;
+};
+
+
 struct vmeta_extract {
 	char *input_file_name;
 	int is_first;
@@ -89,6 +110,7 @@ struct vmeta_extract {
 	char *csv_file_name;
 	FILE *csv_file;
 	enum vmeta_frame_type type_for_csv;
+	struct vmeta_csv_buf csv_header;
 
 	char *kml_file_name;
 	FILE *kml_file;
@@ -99,6 +121,16 @@ struct vmeta_extract {
 	int json_pretty;
 	json_object *json_data;
 
+	char *ndjson_file_name;
+	FILE *ndjson_file;
+
+	/* Number of decoding threads (pipelined extraction if greater
+	 * than 1) */
+	int jobs;
+
+	/* Frame outputs, when not using the pipelined extraction */
+	struct frame_output output;
+
 	struct vstrm_receiver *receiver;
 };
 
@@ -149,117 +181,209 @@ static void kml_footer(struct vmeta_extract *self)
 }
 
 
-static int process_vmeta_frame(struct vmeta_extract *self,
+static int ndjson_write(struct vmeta_extract *self, const char *str)
+{
+	if (str == NULL) {
+		ULOG_ERRNO("json_object_to_json_string_ext", ENOMEM);
+		return -ENOMEM;
+	}
+	if ((fputs(str, self->ndjson_file) < 0) ||
+	    (fputc('\n', self->ndjson_file) < 0)) {
+		ULOG_ERRNO("fputs", EIO);
+		return -EIO;
+	}
+	return 0;
+}
+
+
+static void frame_output_clear(struct frame_output *out)
+{
+	if (out->json != NULL)
+		json_object_put(out->json);
+	out->json = NULL;
+	out->ndjson = NULL;
+}
+
+
+static void frame_output_release(struct frame_output *out)
+{
+	frame_output_clear(out);
+	free(out->csv.str);
+	memset(&out->csv, 0, sizeof(out->csv));
+}
+
+
+/* Format the outputs of a frame metadata; the output files are not
+ * accessed, so that this function can be called from any thread */
+static int frame_output_format(struct vmeta_extract *self,
 			       struct vmeta_frame *meta,
 			       uint64_t ts,
-			       const char *mime_format)
+			       struct frame_output *out)
 {
-	int ret = 0;
+	int ret;
+
+	out->ts = ts;
+	out->type = meta->type;
 
 	/* CSV output */
 	if (self->csv_file) {
 		ssize_t err;
-		size_t len = 0;
-		char *str = malloc(STR_SIZE);
-		if (str == NULL) {
-			ret = -ENOMEM;
-			ULOG_ERRNO("malloc(%d)", -ret, STR_SIZE);
-			goto out;
+		out->csv.len = 0;
+		err = vmeta_frame_csv_append(meta, &out->csv);
+		if (err < 0) {
+			ULOG_ERRNO("vmeta_frame_csv_append", (int)-err);
+			return err;
 		}
+	}
+
+	/* KML output */
+	if (self->kml_file)
+		out->loc_res = vmeta_frame_get_location(meta, &out->loc);
+
+	/* JSON output */
+	if (self->json_file_name || self->ndjson_file) {
+		json_object *jobj = json_object_new_object();
+		json_object *jobj_meta = json_object_new_object();
+
+		ret = vmeta_frame_to_json(meta, jobj_meta);
+		if (ret < 0) {
+			ULOG_ERRNO("vmeta_frame_to_json", -ret);
+			json_object_put(jobj);
+			json_object_put(jobj_meta);
+			return ret;
+		}
+
+		json_object_object_add(jobj, "time", json_object_new_int64(ts));
+		json_object_object_add(jobj, "metadata", jobj_meta);
+		out->json = jobj;
+
+		/* NDJSON output: the frame line has the same content as the
+		 * frame object in the JSON output */
+		if (self->ndjson_file) {
+			out->ndjson = json_object_to_json_string_ext(
+				jobj, JSON_C_TO_STRING_PLAIN);
+			if (out->ndjson == NULL) {
+				ULOG_ERRNO("json_object_to_json_string_ext",
+					   ENOMEM);
+				return -ENOMEM;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+/* Write the formatted outputs of a frame metadata; this function must be
+ * called in the frames order */
+static int frame_output_write(struct vmeta_extract *self,
+			      struct frame_output *out)
+{
+	int ret = 0;
+
+	/* CSV output */
+	if (self->csv_file) {
+		ssize_t err;
 		if (self->type_for_csv == VMETA_FRAME_TYPE_NONE) {
 			self->type_for_csv =
-				(meta->type ==
+				(out->type ==
 				 VMETA_FRAME_TYPE_V1_STREAMING_BASIC)
 					? VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED
-					: meta->type;
-			vmeta_frame_csv_header(
-				self->type_for_csv, str, STR_SIZE);
-			fprintf(self->csv_file, "time %s\n", str);
-			str[0] = '\0';
-		} else if ((self->type_for_csv != meta->type) &&
-			   (meta->type !=
+					: out->type;
+			self->csv_header.len = 0;
+			err = vmeta_frame_csv_header_append(
+				self->type_for_csv, &self->csv_header);
+			if (err < 0) {
+				ULOG_ERRNO("vmeta_frame_csv_header_append",
+					   (int)-err);
+				return err;
+			}
+			fprintf(self->csv_file, "time ");
+			fwrite(self->csv_header.str,
+			       1,
+			       self->csv_header.len,
+			       self->csv_file);
+		} else if ((self->type_for_csv != out->type) &&
+			   (out->type !=
 			    VMETA_FRAME_TYPE_V1_STREAMING_BASIC)) {
 			ULOGE("unsupported change of metadata "
 			      "type (found:%s expected:%s)\n",
-			      vmeta_frame_type_str(meta->type),
+			      vmeta_frame_type_str(out->type),
 			      vmeta_frame_type_str(self->type_for_csv));
-			free(str);
-			ret = -EPROTO;
-			goto out;
+			return -EPROTO;
 		}
 
-		err = vmeta_frame_to_csv(meta, str, STR_SIZE);
-		if (err < 0) {
-			ULOG_ERRNO("vmeta_frame_to_csv", (int)-err);
-			free(str);
-			ret = err;
-			goto out;
-		}
-		len += err;
-		fprintf(self->csv_file, "%" PRIu64 " %s\n", ts, str);
-		free(str);
+		fprintf(self->csv_file, "%" PRIu64 " ", out->ts);
+		fwrite(out->csv.str, 1, out->csv.len, self->csv_file);
 	}
 
 	/* KML output */
 	if (self->kml_file) {
-		struct vmeta_location loc;
-
 		if (self->type_for_kml == VMETA_FRAME_TYPE_NONE) {
 			self->type_for_kml =
-				(meta->type ==
+				(out->type ==
 				 VMETA_FRAME_TYPE_V1_STREAMING_BASIC)
 					? VMETA_FRAME_TYPE_V1_STREAMING_EXTENDED
-					: meta->type;
+					: out->type;
 			kml_header(
 				self,
 				((self->type_for_kml == VMETA_FRAME_TYPE_V2) ||
 				 (self->type_for_kml == VMETA_FRAME_TYPE_V3))
 					? 1
 					: 0);
-		} else if ((self->type_for_kml != meta->type) &&
-			   (meta->type !=
+		} else if ((self->type_for_kml != out->type) &&
+			   (out->type !=
 			    VMETA_FRAME_TYPE_V1_STREAMING_BASIC)) {
 			ULOGE("unsupported change of metadata "
 			      "type (found:%s expected:%s)\n",
-			      vmeta_frame_type_str(meta->type),
+			      vmeta_frame_type_str(out->type),
 			      vmeta_frame_type_str(self->type_for_kml));
-			ret = -ENOSYS;
-			goto out;
+			return -ENOSYS;
 		}
 
-		ret = vmeta_frame_get_location(meta, &loc);
+		ret = out->loc_res;
 		if (ret == 0)
-			kml_coord(self, &loc);
-		if (ret == -ENOENT)
-			ret = 0;
+			kml_coord(self, &out->loc);
+		else if (ret != -ENOENT)
+			return ret;
+		ret = 0;
+	}
+
+	/* NDJSON output */
+	if (self->ndjson_file) {
+		ret = ndjson_write(self, out->ndjson);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* JSON output */
 	if (self->json_file_name) {
-		json_object *jobj = json_object_new_object();
-		json_object *jobj_meta = json_object_new_object();
-
-		ret = vmeta_frame_to_json(meta, jobj_meta);
-		if (ret < 0) {
-			ULOG_ERRNO("vmeta_frame_to_json", -ret);
-			json_object_put(jobj);
-			json_object_put(jobj_meta);
-			goto out;
-		}
-
-		json_object_object_add(jobj, "time", json_object_new_int64(ts));
-		json_object_object_add(jobj, "metadata", jobj_meta);
-
 		json_object *jarray;
 		if (json_object_object_get_ex(
-			    self->json_data, "frame", &jarray))
-			json_object_array_add(jarray, jobj);
-		else
-			json_object_put(jobj);
+			    self->json_data, "frame", &jarray)) {
+			/* The frame object is now owned by the array */
+			json_object_array_add(jarray, out->json);
+			out->json = NULL;
+		}
 	}
 
 	self->is_first = 0;
-out:
+	return ret;
+}
+
+
+static int process_vmeta_frame(struct vmeta_extract *self,
+			       struct vmeta_frame *meta,
+			       uint64_t ts,
+			       const char *mime_format)
+{
+	int ret;
+
+	ret = frame_output_format(self, meta, ts, &self->output);
+	if (ret == 0)
+		ret = frame_output_write(self, &self->output);
+	frame_output_clear(&self->output);
+
 	return ret;
 }
 
@@ -306,7 +430,7 @@ static int session_output(struct vmeta_extract *self)
 	printf("%s\n", session_meta_str);
 
 	/* JSON output */
-	if (self->json_file_name) {
+	if (self->json_file_name || self->ndjson_file) {
 		json_object *jobj = json_object_new_object();
 
 		ret = vmeta_session_to_json(&self->session_meta, jobj);
@@ -315,7 +439,29 @@ static int session_output(struct vmeta_extract *self)
 			json_object_put(jobj);
 			return ret;
 		}
-		json_object_object_add(self->json_data, "session", jobj);
+
+		/* NDJSON output: {"session":{...}} line */
+		if (self->ndjson_file) {
+			json_object *jline = json_object_new_object();
+			const char *str;
+			json_object_object_add(
+				jline, "session", json_object_get(jobj));
+			str = json_object_to_json_string_ext(
+				jline, JSON_C_TO_STRING_PLAIN);
+			ret = ndjson_write(self, str);
+			json_object_put(jline);
+			if (ret < 0) {
+				json_object_put(jobj);
+				return ret;
+			}
+		}
+
+		if (self->json_file_name) {
+			json_object_object_add(
+				self->json_data, "session", jobj);
+		} else {
+			json_object_put(jobj);
+		}
 	}
 
 	return 0;
@@ -411,16 +557,477 @@ cleanup:
 
 #ifdef BUILD_LIBMP4
 
+/* Pipelined extraction (see the --jobs option): the demux stage (calling
+ * thread) copies the samples into jobs, a pool of worker threads decodes the
+ * metadata and formats the outputs, and a writer thread writes the outputs in
+ * the samples order. The number of jobs is fixed, which bounds the memory
+ * used whatever the input size; the demux stage blocks until a job is
+ * released by the writer. */
+
+/* Number of jobs per worker thread */
+#	define EXTRACT_JOBS_PER_WORKER 4
+
+
+struct extract_job {
+	/* Sample sequence number */
+	unsigned int seq;
+	uint64_t ts;
+	uint8_t *data;
+	size_t size;
+	unsigned int capacity;
+
+	/* Decoding and formatting status: 0 on success, -ENODATA for empty
+	 * metadata, negative errno value in case of error */
+	int res;
+	struct frame_output out;
+};
+
+
+/* Bounded FIFO of jobs; the capacity is the total number of jobs, so pushing
+ * never blocks */
+struct extract_queue {
+	struct extract_job **jobs;
+	unsigned int capacity;
+	unsigned int head;
+	unsigned int count;
+	int closed;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+
+struct extract_pipeline {
+	struct vmeta_extract *self;
+	const char *mime_format;
+	struct vmeta_frame_pool *pool;
+
+	struct extract_job *jobs;
+	unsigned int job_count;
+	unsigned int next_seq;
+
+	/* Jobs available to the demux stage, to the workers and to the
+	 * writer */
+	struct extract_queue free_jobs;
+	struct extract_queue work;
+	struct extract_queue done;
+
+	pthread_t *workers;
+	unsigned int worker_count;
+	pthread_t writer;
+	int writer_started;
+
+	/* Writer state: jobs waiting for their turn, indexed by sequence
+	 * number modulo job_count, and first error */
+	struct extract_job **pending;
+	int err;
+};
+
+
+static int extract_queue_init(struct extract_queue *q, unsigned int capacity)
+{
+	int ret;
+
+	q->jobs = calloc(capacity, sizeof(*q->jobs));
+	if (q->jobs == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	q->capacity = capacity;
+	ret = pthread_mutex_init(&q->mutex, NULL);
+	if (ret != 0) {
+		ULOG_ERRNO("pthread_mutex_init", ret);
+		free(q->jobs);
+		q->jobs = NULL;
+		return -ret;
+	}
+	ret = pthread_cond_init(&q->cond, NULL);
+	if (ret != 0) {
+		ULOG_ERRNO("pthread_cond_init", ret);
+		pthread_mutex_destroy(&q->mutex);
+		free(q->jobs);
+		q->jobs = NULL;
+		return -ret;
+	}
+	return 0;
+}
+
+
+static void extract_queue_clear(struct extract_queue *q)
+{
+	if (q->jobs == NULL)
+		return;
+	pthread_cond_destroy(&q->cond);
+	pthread_mutex_destroy(&q->mutex);
+	free(q->jobs);
+	q->jobs = NULL;
+}
+
+
+static void extract_queue_push(struct extract_queue *q, struct extract_job *job)
+{
+	pthread_mutex_lock(&q->mutex);
+	q->jobs[(q->head + q->count) % q->capacity] = job;
+	q->count++;
+	pthread_cond_signal(&q->cond);
+	pthread_mutex_unlock(&q->mutex);
+}
+
+
+/* Returns NULL once the queue is closed and empty */
+static struct extract_job *extract_queue_pop(struct extract_queue *q)
+{
+	struct extract_job *job = NULL;
+
+	pthread_mutex_lock(&q->mutex);
+	while ((q->count == 0) && (!q->closed))
+		pthread_cond_wait(&q->cond, &q->mutex);
+	if (q->count > 0) {
+		job = q->jobs[q->head];
+		q->head = (q->head + 1) % q->capacity;
+		q->count--;
+	}
+	pthread_mutex_unlock(&q->mutex);
+
+	return job;
+}
+
+
+static void extract_queue_close(struct extract_queue *q)
+{
+	pthread_mutex_lock(&q->mutex);
+	q->closed = 1;
+	pthread_cond_broadcast(&q->cond);
+	pthread_mutex_unlock(&q->mutex);
+}
+
+
+static void *extract_worker(void *userdata)
+{
+	struct extract_pipeline *p = userdata;
+	struct extract_job *job;
+	struct vmeta_frame *meta;
+	struct vmeta_buffer buf;
+
+	while ((job = extract_queue_pop(&p->work)) != NULL) {
+		/* The job data outlives the frame, no copy is needed */
+		vmeta_buffer_set_cdata(&buf, job->data, job->size, 0);
+		job->res = vmeta_frame_pool_frame_read_borrowed(p->pool,
+								&buf,
+								p->mime_format,
+								0,
+								NULL,
+								NULL,
+								&meta);
+		if (job->res == 0) {
+			job->res = frame_output_format(
+				p->self, meta, job->ts, &job->out);
+			vmeta_frame_unref(meta);
+		} else if (job->res != -ENODATA) {
+			ULOG_ERRNO("vmeta_frame_pool_frame_read_borrowed",
+				   -job->res);
+		}
+		extract_queue_push(&p->done, job);
+	}
+
+	return NULL;
+}
+
+
+static void extract_writer_output(struct extract_pipeline *p,
+				  struct extract_job *job)
+{
+	int res = job->res;
+
+	if (p->err == 0) {
+		if (res == 0) {
+			res = frame_output_write(p->self, &job->out);
+			if (res < 0)
+				ULOG_ERRNO("frame_output_write", -res);
+		} else if (res == -ENODATA) {
+			/* Empty metadata */
+			res = 0;
+		}
+		if (res < 0) {
+			/* Stop the demux stage once the free jobs have been
+			 * used; the remaining jobs are discarded */
+			p->err = res;
+			extract_queue_close(&p->free_jobs);
+		}
+	}
+
+	frame_output_clear(&job->out);
+	if (p->err == 0)
+		extract_queue_push(&p->free_jobs, job);
+}
+
+
+static void *extract_writer(void *userdata)
+{
+	struct extract_pipeline *p = userdata;
+	struct extract_job *job;
+	unsigned int next = 0, idx;
+
+	while ((job = extract_queue_pop(&p->done)) != NULL) {
+		/* At most job_count sequence numbers are in flight, so that
+		 * there is no collision */
+		p->pending[job->seq % p->job_count] = job;
+		idx = next % p->job_count;
+		while ((p->pending[idx] != NULL) &&
+		       (p->pending[idx]->seq == next)) {
+			job = p->pending[idx];
+			p->pending[idx] = NULL;
+			extract_writer_output(p, job);
+			next++;
+			idx = next % p->job_count;
+		}
+	}
+
+	return NULL;
+}
+
+
+static void extract_pipeline_destroy(struct extract_pipeline *p)
+{
+	unsigned int i;
+
+	if (p->jobs != NULL) {
+		for (i = 0; i < p->job_count; i++) {
+			frame_output_release(&p->jobs[i].out);
+			free(p->jobs[i].data);
+		}
+	}
+	if (p->pool != NULL)
+		vmeta_frame_pool_destroy(p->pool);
+	extract_queue_clear(&p->free_jobs);
+	extract_queue_clear(&p->work);
+	extract_queue_clear(&p->done);
+	free(p->pending);
+	free(p->workers);
+	free(p->jobs);
+	free(p);
+}
+
+
+/* Wait for the jobs in flight and stop the threads; returns the first
+ * error */
+static int extract_pipeline_finish(struct extract_pipeline *p)
+{
+	unsigned int i;
+
+	extract_queue_close(&p->work);
+	for (i = 0; i < p->worker_count; i++)
+		pthread_join(p->workers[i], NULL);
+	p->worker_count = 0;
+	extract_queue_close(&p->done);
+	if (p->writer_started)
+		pthread_join(p->writer, NULL);
+	p->writer_started = 0;
+
+	return p->err;
+}
+
+
+static int extract_pipeline_new(struct vmeta_extract *self,
+				const char *mime_format,
+				struct extract_pipeline **ret_obj)
+{
+	int ret;
+	unsigned int i, workers = self->jobs;
+	struct extract_pipeline *p;
+
+	p = calloc(1, sizeof(*p));
+	if (p == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	p->self = self;
+	p->mime_format = mime_format;
+	p->job_count = workers * EXTRACT_JOBS_PER_WORKER;
+
+	p->jobs = calloc(p->job_count, sizeof(*p->jobs));
+	p->pending = calloc(p->job_count, sizeof(*p->pending));
+	p->workers = calloc(workers, sizeof(*p->workers));
+	if ((p->jobs == NULL) || (p->pending == NULL) ||
+	    (p->workers == NULL)) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		goto error;
+	}
+
+	ret = vmeta_frame_pool_new(p->job_count, &p->pool);
+	if (ret < 0) {
+		ULOG_ERRNO("vmeta_frame_pool_new", -ret);
+		goto error;
+	}
+
+	ret = extract_queue_init(&p->free_jobs, p->job_count);
+	if (ret < 0)
+		goto error;
+	ret = extract_queue_init(&p->work, p->job_count);
+	if (ret < 0)
+		goto error;
+	ret = extract_queue_init(&p->done, p->job_count);
+	if (ret < 0)
+		goto error;
+	for (i = 0; i < p->job_count; i++)
+		extract_queue_push(&p->free_jobs, &p->jobs[i]);
+
+	ret = pthread_create(&p->writer, NULL, extract_writer, p);
+	if (ret != 0) {
+		ULOG_ERRNO("pthread_create", ret);
+		ret = -ret;
+		goto error;
+	}
+	p->writer_started = 1;
+	for (i = 0; i < workers; i++) {
+		ret = pthread_create(
+			&p->workers[i], NULL, extract_worker, p);
+		if (ret != 0) {
+			ULOG_ERRNO("pthread_create", ret);
+			ret = -ret;
+			goto error;
+		}
+		p->worker_count++;
+	}
+
+	*ret_obj = p;
+	return 0;
+
+error:
+	if (p->writer_started)
+		extract_pipeline_finish(p);
+	extract_pipeline_destroy(p);
+	return ret;
+}
+
+
+/* Sequential extraction: the frame metadata iterator reads and decodes the
+ * samples ahead on its own thread while the outputs are written */
+static int mp4_extract_frames(struct vmeta_extract *self,
+			      struct mp4_demux *demux,
+			      const char *mime_format)
+{
+	int ret, err;
+	struct vmeta_extract_frame_iter *iter;
+	struct vmeta_frame *meta;
+	uint64_t ts;
+
+	ret = vmeta_extract_frame_iter_new(
+		NULL, demux, VMETA_EXTRACT_FRAME_ITER_FLAG_PREFETCH, &iter);
+	if (ret < 0) {
+		ULOG_ERRNO("vmeta_extract_frame_iter_new", -ret);
+		return ret;
+	}
+
+	while ((err = vmeta_extract_frame_iter_next(iter, &ts, &meta)) == 0) {
+		ret = process_vmeta_frame(self, meta, ts, mime_format);
+		vmeta_frame_unref(meta);
+		if (ret < 0) {
+			ULOG_ERRNO("process_vmeta_frame", -ret);
+			break;
+		}
+	}
+	if ((ret == 0) && (err != -ENOENT)) {
+		ULOG_ERRNO("vmeta_extract_frame_iter_next", -err);
+		ret = err;
+	}
+
+	vmeta_extract_frame_iter_destroy(iter);
+	return ret;
+}
+
+
+/* Pipelined extraction: the samples are copied into the pipeline jobs */
+static int mp4_extract_pipelined(struct vmeta_extract *self,
+				 struct mp4_demux *demux,
+				 const struct mp4_track_info *tk)
+{
+	int ret, err;
+	struct mp4_track_sample sample;
+	struct extract_pipeline *pipeline = NULL;
+	struct extract_job *job;
+
+	ret = extract_pipeline_new(self, tk->metadata_mime_format, &pipeline);
+	if (ret < 0)
+		return ret;
+
+	/* Each sample is peeked once without advancing, then read or skipped
+	 * with exactly one advancing call: advancing again after the read
+	 * would skip the next sample */
+	for (;;) {
+		/* Retrieve the metadata size */
+		ret = mp4_demux_get_track_sample(
+			demux, tk->id, 0, NULL, 0, NULL, 0, &sample);
+		if (ret < 0) {
+			ULOG_ERRNO("mp4_demux_get_track_sample", -ret);
+			break;
+		}
+		if (sample.size == 0)
+			break;
+		if (sample.metadata_size == 0) {
+			/* Skip the sample */
+			ret = mp4_demux_get_track_sample(
+				demux, tk->id, 1, NULL, 0, NULL, 0, &sample);
+			if (ret < 0) {
+				ULOG_ERRNO("mp4_demux_get_track_sample", -ret);
+				break;
+			}
+			continue;
+		}
+		/* Wait for a free job; the sample is read into the job
+		 * buffer */
+		job = extract_queue_pop(&pipeline->free_jobs);
+		if (job == NULL) {
+			/* Writer error */
+			break;
+		}
+		if (job->capacity < sample.metadata_size) {
+			uint8_t *tmp = realloc(job->data, sample.metadata_size);
+			if (tmp == NULL) {
+				ret = -ENOMEM;
+				ULOG_ERRNO("realloc", -ret);
+				extract_queue_push(&pipeline->free_jobs, job);
+				break;
+			}
+			job->data = tmp;
+			job->capacity = sample.metadata_size;
+		}
+		/* Read the metadata and advance to the next sample */
+		ret = mp4_demux_get_track_sample(demux,
+						 tk->id,
+						 1,
+						 NULL,
+						 0,
+						 job->data,
+						 job->capacity,
+						 &sample);
+		if (ret < 0) {
+			ULOG_ERRNO("mp4_demux_get_track_sample", -ret);
+			extract_queue_push(&pipeline->free_jobs, job);
+			break;
+		}
+		job->seq = pipeline->next_seq++;
+		job->ts = mp4_sample_time_to_usec(sample.dts, tk->timescale);
+		job->size = sample.metadata_size;
+		extract_queue_push(&pipeline->work, job);
+	}
+
+	err = extract_pipeline_finish(pipeline);
+	if (err < 0)
+		ret = err;
+	extract_pipeline_destroy(pipeline);
+
+	return ret;
+}
+
+
 static int mp4_extract(struct vmeta_extract *self)
 {
 	struct mp4_demux *demux = NULL;
 	struct mp4_track_info tk;
-	struct mp4_track_sample sample;
-	int ret = 0, i, count, err, found = 0, meta_found = 0;
-	unsigned int id, data_capacity = 0;
-	uint8_t *data = NULL;
-	struct vmeta_buffer buf;
-	char *mime_format = NULL;
+	int ret = 0, i, count, err, found = 0;
 	uint64_t duration_us = 0;
 
 	/* Read the MP4 file */
@@ -450,11 +1057,6 @@ static int mp4_extract(struct vmeta_extract *self)
 	for (i = 0; i < count; i++) {
 		err = mp4_demux_get_track_info(demux, i, &tk);
 		if ((err == 0) && (tk.type == MP4_TRACK_TYPE_VIDEO)) {
-			if ((tk.has_metadata) && (tk.metadata_mime_format)) {
-				mime_format = strdup(tk.metadata_mime_format);
-				meta_found = 1;
-			}
-			id = tk.id;
 			found = 1;
 			break;
 		}
@@ -468,7 +1070,7 @@ static int mp4_extract(struct vmeta_extract *self)
 		goto cleanup;
 	}
 
-	if (!meta_found)
+	if ((!tk.has_metadata) || (!tk.metadata_mime_format))
 		goto cleanup;
 
 	/* JSON output */
@@ -478,63 +1080,14 @@ static int mp4_extract(struct vmeta_extract *self)
 	}
 
 	/* Get the samples and process them */
-	i = 0;
-	do {
-		/* Retrieve metadata size */
-		err = mp4_demux_get_track_sample(
-			demux, id, 0, NULL, 0, NULL, 0, &sample);
-		if (err < 0) {
-			ULOG_ERRNO("mp4_demux_get_track_sample", -err);
-			break;
-		}
-		if (sample.metadata_size == 0)
-			goto next_sample;
-		/* Allocate or realloc meta buffer */
-		if (data_capacity < sample.metadata_size) {
-			uint8_t *tmp = realloc(data, sample.metadata_size);
-			if (tmp == NULL) {
-				err = -ENOMEM;
-				ULOG_ERRNO("realloc", -err);
-				break;
-			}
-			data = tmp;
-			data_capacity = sample.metadata_size;
-		}
-		err = mp4_demux_get_track_sample(
-			demux, id, 1, NULL, 0, data, data_capacity, &sample);
-		if (err < 0) {
-			ULOG_ERRNO("mp4_demux_get_track_sample", -err);
-			break;
-		}
-		if (sample.metadata_size == 0)
-			goto next_sample;
-		vmeta_buffer_set_cdata(&buf, data, sample.metadata_size, 0);
-		err = frame_extract(
-			self,
-			&buf,
-			mp4_sample_time_to_usec(sample.dts, tk.timescale),
-			mime_format);
-		if (err < 0) {
-			ret = err;
-			break;
-		}
-		/* clang-format off */
-next_sample:
-		/* clang-format on */
-		err = mp4_demux_get_track_sample(
-			demux, id, 1, NULL, 0, NULL, 0, &sample);
-		if (err < 0) {
-			ULOG_ERRNO("mp4_demux_get_track_sample", -err);
-			break;
-		}
-		i++;
-	} while (sample.size);
+	if (self->jobs > 1)
+		ret = mp4_extract_pipelined(self, demux, &tk);
+	else
+		ret = mp4_extract_frames(self, demux, tk.metadata_mime_format);
 
 cleanup:
 	if (demux)
 		mp4_demux_close(demux);
-	free(mime_format);
-	free(data);
 
 	return ret;
 }
@@ -883,6 +1436,8 @@ static const struct option long_options[] = {
 	{"kml", required_argument, NULL, ARGS_ID_KML},
 	{"json", required_argument, NULL, ARGS_ID_JSON},
 	{"pretty", no_argument, NULL, ARGS_ID_JSON_PRETTY},
+	{"ndjson", required_argument, NULL, ARGS_ID_NDJSON},
+	{"jobs", required_argument, NULL, ARGS_ID_JOBS},
 	{"rtp-port", required_argument, NULL, ARGS_ID_RTP_PORT},
 	{"rtcp-port", required_argument, NULL, ARGS_ID_RTCP_PORT},
 	{0, 0, 0, 0},
@@ -908,6 +1463,16 @@ static void usage(char *prog_name)
 	       "     --json <file>                 Output to JSON file\n"
 	       "     --pretty                      Pretty output for "
 	       "JSON file\n"
+	       "     --ndjson <file>               Output to newline-delimited "
+	       "JSON file\n"
+	       "                                   (one line per frame, "
+	       "written as the\n"
+	       "                                   input is processed)\n"
+#ifdef BUILD_LIBMP4
+	       "     --jobs <n>                    Number of decoding threads "
+	       "(.mp4 files only,\n"
+	       "                                   default is 1)\n"
+#endif /* BUILD_LIBMP4 */
 #ifdef BUILD_LIBPCAP
 	       "     --rtp-port <port>             RTP destination port "
 	       "(.pcap files only, default is 55004)\n"
@@ -945,6 +1510,7 @@ int main(int argc, char *argv[])
 	self->is_first = 1;
 	self->rtp_port = RTP_DEFAULT_PORT;
 	self->rtcp_port = RTCP_DEFAULT_PORT;
+	self->jobs = 1;
 
 	welcome(argv[0]);
 
@@ -982,6 +1548,20 @@ int main(int argc, char *argv[])
 			self->json_pretty = 1;
 			break;
 
+		case ARGS_ID_NDJSON:
+			self->ndjson_file_name = optarg;
+			break;
+
+		case ARGS_ID_JOBS:
+			self->jobs = atoi(optarg);
+			if (self->jobs < 1) {
+				fprintf(stderr,
+					"invalid number of jobs: '%s'\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+
 		case ARGS_ID_RTP_PORT:
 			self->rtp_port = atoi(optarg);
 			break;
@@ -1021,6 +1601,17 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (self->ndjson_file_name) {
+		self->ndjson_file = fopen(self->ndjson_file_name, "w");
+		if (self->ndjson_file == NULL) {
+			fprintf(stderr,
+				"failed to open NDJSON file '%s'\n",
+				self->ndjson_file_name);
+			status = EXIT_FAILURE;
+			goto cleanup;
+		}
+	}
+
 	if (self->kml_file_name) {
 		self->kml_file = fopen(self->kml_file_name, "w");
 		if (self->kml_file == NULL) {
@@ -1112,6 +1703,8 @@ int main(int argc, char *argv[])
 cleanup:
 	if (self->csv_file)
 		fclose(self->csv_file);
+	free(self->csv_header.str);
+	frame_output_release(&self->output);
 	if (self->kml_file) {
 		if (!self->is_first)
 			kml_footer(self);
@@ -1119,6 +1712,13 @@ cleanup:
 	}
 	if (self->json_file_name)
 		json_object_put(self->json_data);
+	if (self->ndjson_file) {
+		if ((fclose(self->ndjson_file) != 0) &&
+		    (status == EXIT_SUCCESS)) {
+			ULOG_ERRNO("fclose", errno);
+			status = EXIT_FAILURE;
+		}
+	}
 
 	if (self->receiver)
 		vstrm_receiver_destroy(self->receiver);